@@ -32,6 +32,36 @@ Compression ratio: 186.26 GB -> 3906.29 KB (49999.5x)
 Compression time: 0.00311 s, 58.5 TB/s
 Decompression time: 0.0101 s, 18516.4 GB/s
 
+*** Appending to *contiguous* super-chunk (in-memory)
+nchunks:    20000, time per append: 23.1 us
+nchunks:    40000, time per append: 17.8 us
+...
+nchunks:   180000, time per append: 29.6 us
+nchunks:   200000, time per append: 31.2 us
+
+*** Appending to *contiguous* super-chunk (append_frame.b2frame)
+nchunks:    20000, time per append: 48.1 us
+nchunks:    40000, time per append: 37.2 us
+...
+nchunks:   180000, time per append: 51.1 us
+nchunks:   200000, time per append: 54.5 us
+
+*** Appending to *sparse* super-chunk (append_frame.b2frame)
+nchunks:    20000, time per append: 242 us
+nchunks:    40000, time per append: 224 us
+...
+nchunks:   180000, time per append: 296 us
+nchunks:   200000, time per append: 228 us
+
+Only the tail of the offsets chunk is compressed again on every append.  Before
+that, the time per append grew with the number of chunks (from 322 us at 20000
+chunks to 2400 us at 200000 for the contiguous frame on disk, and from 200 us to
+1760 us for the sparse one).  Sparse frames also keep the sealed part of the
+offsets chunk where it is on disk, and write just the rest.  Contiguous frames
+on disk cannot do that, because the offsets chunk goes right after the new
+chunk: all of it is written again, so appends still get a bit slower as the
+frame grows.  Setting `write_buffer_size` in the storage amortizes that.
+
 Process finished with exit code 0
 
  */
@@ -53,6 +83,10 @@ Process finished with exit code 0
 #define CREATE_FILL
 //#define CREATE_LOOP
 
+// Params for the append benchmark
+#define APPEND_CHUNKSHAPE (1000)
+#define APPEND_NCHUNKS (200 * 1000)
+
 int create_cframe(const char* compname, bool contiguous) {
   int32_t isize = CHUNKSHAPE * sizeof(int32_t);
   int32_t* data = malloc(isize);
@@ -178,6 +212,51 @@ int create_cframe(const char* compname, bool contiguous) {
 }
 
 
+/* Append many small chunks and report the time per append as the number of chunks grows */
+int append_cframe(bool contiguous, const char* urlpath) {
+  int32_t data[APPEND_CHUNKSHAPE];
+  int32_t isize = APPEND_CHUNKSHAPE * sizeof(int32_t);
+  blosc_timestamp_t last, current;
+  printf("\n*** Appending to *%s* super-chunk (%s)\n",
+         contiguous ? "contiguous" : "sparse", urlpath == NULL ? "in-memory" : urlpath);
+
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = sizeof(int32_t);
+  cparams.nthreads = NTHREADS;
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  dparams.nthreads = NTHREADS;
+  blosc2_storage storage = {.cparams=&cparams, .dparams=&dparams,
+                            .urlpath=(char*)urlpath, .contiguous=contiguous};
+  blosc2_remove_urlpath(urlpath);
+  blosc2_schunk* schunk = blosc2_schunk_new(&storage);
+
+  for (int i = 0; i < APPEND_CHUNKSHAPE; i++) {
+    data[i] = i;
+  }
+  int step = APPEND_NCHUNKS / 10;
+  blosc_set_timestamp(&last);
+  for (int nchunk = 0; nchunk < APPEND_NCHUNKS; nchunk++) {
+    data[0] = nchunk;
+    int nchunks = blosc2_schunk_append_buffer(schunk, data, isize);
+    if (nchunks != nchunk + 1) {
+      printf("Compression error appending in schunk.  Error code: %d\n", nchunks);
+      return nchunks;
+    }
+    if ((nchunk + 1) % step == 0) {
+      blosc_set_timestamp(&current);
+      double ttotal = blosc_elapsed_secs(last, current);
+      printf("nchunks: %8d, time per append: %.3g us\n", nchunk + 1, ttotal * 1e6 / step);
+      blosc_set_timestamp(&last);
+    }
+  }
+
+  blosc2_schunk_free(schunk);
+  blosc2_remove_urlpath(urlpath);
+
+  return 0;
+}
+
+
 int main(void) {
 #ifdef CREATE_ZEROS
   printf("\n   ***  Creating zeros   ***\n");
@@ -196,4 +275,8 @@ int main(void) {
   create_cframe("blosclz", false);
   create_cframe("lz4", true);
   create_cframe("lz4", false);
+
+  append_cframe(true, NULL);
+  append_cframe(true, "append_frame.b2frame");
+  append_cframe(false, "append_frame.b2frame");
 }
@@ -0,0 +1,195 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Benchmark for counting the I/O calls made when reading chunks out of
+  on-disk frames at random.  A user-defined I/O backend is used for
+  counting the calls that end up being (at least) a system call.  The
+  same reads are timed with the mmap backend too.
+
+  To run:
+
+  $ ./frame_io_bench
+
+*** Random reads from *contiguous* frame (frame_io_bench.b2frame) via stdio
+Time per read: 41.1 us
+I/O calls per read: open: 0.00, close: 0.00, seek: 3.00, read: 3.00
+
+*** Random reads from *sparse* frame (frame_io_bench.b2frame) via stdio
+Time per read: 41.3 us
+I/O calls per read: open: 0.98, close: 0.98, seek: 3.00, read: 3.00
+
+*** Random reads from *contiguous* frame (frame_io_bench.b2frame) via mmap
+Time per read: 37.2 us
+
+*** Random reads from *sparse* frame (frame_io_bench.b2frame) via mmap
+Time per read: 46.6 us
+
+  Before file handles were cached in frames, each read took 3 open() and
+  3 close() calls for both kinds of frames (50 us per read on the same box).
+  Also, the header is not read again on each access anymore (4 -> 3 reads).
+  Sparse frames keep just a few chunk files open, so fully random reads over
+  many chunks still need to open (most of) them.  The mmap backend does not
+  copy the chunks of contiguous frames; chunk files of sparse frames are
+  just pread() (mapping small files that are read once does not pay off).
+
+*/
+
+#include <stdio.h>
+#include <blosc2.h>
+
+#define CHUNKSHAPE (50 * 1000)
+#define NCHUNKS 1000
+#define NREADS (10 * 1000)
+#define NTHREADS 1
+
+
+typedef struct {
+  int64_t open;
+  int64_t close;
+  int64_t seek;
+  int64_t read;
+} io_counters;
+
+typedef struct {
+  blosc2_stdio_file *bfile;
+  io_counters *counters;
+} counted_file;
+
+
+void* counted_open(const char *urlpath, const char *mode, void *params) {
+  counted_file *my = malloc(sizeof(counted_file));
+  my->counters = params;
+  my->counters->open++;
+  my->bfile = blosc2_stdio_open(urlpath, mode, NULL);
+  if (my->bfile == NULL) {
+    free(my);
+    return NULL;
+  }
+  return my;
+}
+
+int counted_close(void *stream) {
+  counted_file *my = (counted_file *) stream;
+  my->counters->close++;
+  int err = blosc2_stdio_close(my->bfile);
+  free(my);
+  return err;
+}
+
+int64_t counted_tell(void *stream) {
+  counted_file *my = (counted_file *) stream;
+  return blosc2_stdio_tell(my->bfile);
+}
+
+int counted_seek(void *stream, int64_t offset, int whence) {
+  counted_file *my = (counted_file *) stream;
+  my->counters->seek++;
+  return blosc2_stdio_seek(my->bfile, offset, whence);
+}
+
+int64_t counted_write(const void *ptr, int64_t size, int64_t nitems, void *stream) {
+  counted_file *my = (counted_file *) stream;
+  return blosc2_stdio_write(ptr, size, nitems, my->bfile);
+}
+
+int64_t counted_read(void *ptr, int64_t size, int64_t nitems, void *stream) {
+  counted_file *my = (counted_file *) stream;
+  my->counters->read++;
+  return blosc2_stdio_read(ptr, size, nitems, my->bfile);
+}
+
+int64_t counted_truncate(void *stream, int64_t size) {
+  counted_file *my = (counted_file *) stream;
+  return blosc2_stdio_truncate(my->bfile, size);
+}
+
+
+int random_reads(bool contiguous, char* urlpath, uint8_t io_id) {
+  int32_t isize = CHUNKSHAPE * sizeof(int32_t);
+  int32_t* data = malloc(isize);
+  int32_t* data_dest = malloc(isize);
+  blosc_timestamp_t last, current;
+  printf("\n*** Random reads from *%s* frame (%s) via %s\n",
+         contiguous ? "contiguous" : "sparse", urlpath,
+         io_id == BLOSC2_IO_FILESYSTEM_MMAP ? "mmap" : "stdio");
+
+  /* Create the frame on-disk */
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = sizeof(int32_t);
+  cparams.nthreads = NTHREADS;
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  dparams.nthreads = NTHREADS;
+  io_counters counters = {0};
+  blosc2_io io = {.id = io_id, .params = io_id == 244 ? &counters : NULL};
+  blosc2_storage storage = {.cparams=&cparams, .dparams=&dparams,
+                            .urlpath=urlpath, .contiguous=contiguous, .io=&io};
+  blosc2_remove_urlpath(urlpath);
+  blosc2_schunk* schunk = blosc2_schunk_new(&storage);
+  for (int nchunk = 0; nchunk < NCHUNKS; nchunk++) {
+    for (int i = 0; i < CHUNKSHAPE; i++) {
+      data[i] = i * nchunk;
+    }
+    int nchunks = blosc2_schunk_append_buffer(schunk, data, isize);
+    if (nchunks != nchunk + 1) {
+      printf("Compression error appending in schunk.  Error code: %d\n", nchunks);
+      return nchunks;
+    }
+  }
+  blosc2_schunk_free(schunk);
+
+  /* Reopen it and read chunks at random */
+  schunk = blosc2_schunk_open_udio(urlpath, &io);
+  memset(&counters, 0, sizeof(counters));
+  srand(0);
+  blosc_set_timestamp(&last);
+  for (int i = 0; i < NREADS; i++) {
+    int nchunk = rand() % NCHUNKS;
+    int dsize = blosc2_schunk_decompress_chunk(schunk, nchunk, data_dest, isize);
+    if (dsize != isize) {
+      printf("Decompression error in schunk.  Error code: %d\n", dsize);
+      return dsize;
+    }
+  }
+  blosc_set_timestamp(&current);
+  double ttotal = blosc_elapsed_secs(last, current);
+  printf("Time per read: %.3g us\n", ttotal * 1e6 / NREADS);
+  if (io_id == 244) {
+    printf("I/O calls per read: open: %.2f, close: %.2f, seek: %.2f, read: %.2f\n",
+           (double)counters.open / NREADS, (double)counters.close / NREADS,
+           (double)counters.seek / NREADS, (double)counters.read / NREADS);
+  }
+
+  /* Free resources */
+  blosc2_schunk_free(schunk);
+  blosc2_remove_urlpath(urlpath);
+  free(data);
+  free(data_dest);
+
+  return 0;
+}
+
+
+int main(void) {
+  blosc_init();
+
+  blosc2_io_cb io_cb;
+  io_cb.id = 244;
+  io_cb.open = (blosc2_open_cb) counted_open;
+  io_cb.close = (blosc2_close_cb) counted_close;
+  io_cb.tell = (blosc2_tell_cb) counted_tell;
+  io_cb.seek = (blosc2_seek_cb) counted_seek;
+  io_cb.write = (blosc2_write_cb) counted_write;
+  io_cb.read = (blosc2_read_cb) counted_read;
+  io_cb.truncate = (blosc2_truncate_cb) counted_truncate;
+  blosc2_register_io_cb(&io_cb);
+
+  random_reads(true, "frame_io_bench.b2frame", 244);
+  random_reads(false, "frame_io_bench.b2frame", 244);
+  random_reads(true, "frame_io_bench.b2frame", BLOSC2_IO_FILESYSTEM_MMAP);
+  random_reads(false, "frame_io_bench.b2frame", BLOSC2_IO_FILESYSTEM_MMAP);
+
+  blosc_destroy();
+  return 0;
+}
@@ -0,0 +1,112 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Benchmark for reading small chunks at random out of frames with many chunks,
+  keeping the chunk offsets decompressed in memory or not.
+
+  To run:
+
+  $ ./frame_offsets_bench
+
+*** Random reads from frame in memory with 100000 chunks
+Offsets mode: compressed	Time per read: 4.24 us
+Offsets mode: resident	Time per read: 0.4 us
+Offsets mode: auto	Time per read: 0.449 us
+
+*** Random reads from frame on disk (frame_offsets_bench.b2frame) with 100000 chunks
+Offsets mode: compressed	Time per read: 7.78 us
+Offsets mode: resident	Time per read: 2.73 us
+Offsets mode: auto	Time per read: 2.18 us
+
+*/
+
+#include <stdio.h>
+#include <blosc2.h>
+
+#define CHUNKSHAPE (100)
+#define NCHUNKS (100 * 1000)
+#define NREADS (200 * 1000)
+#define NTHREADS 1
+
+
+int random_reads(char* urlpath) {
+  int32_t isize = CHUNKSHAPE * sizeof(int32_t);
+  int32_t data[CHUNKSHAPE];
+  int32_t data_dest[CHUNKSHAPE];
+  blosc_timestamp_t last, current;
+  int modes[] = {BLOSC2_OFFSETS_COMPRESSED, BLOSC2_OFFSETS_RESIDENT, BLOSC2_OFFSETS_AUTO};
+  char* mode_names[] = {"compressed", "resident", "auto"};
+  printf("\n*** Random reads from frame %s%s%s with %d chunks\n",
+         urlpath == NULL ? "in memory" : "on disk (", urlpath == NULL ? "" : urlpath,
+         urlpath == NULL ? "" : ")", NCHUNKS);
+
+  /* Create the frame */
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = sizeof(int32_t);
+  cparams.nthreads = NTHREADS;
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  dparams.nthreads = NTHREADS;
+  blosc2_storage storage = {.cparams=&cparams, .dparams=&dparams,
+                            .urlpath=urlpath, .contiguous=true};
+  blosc2_remove_urlpath(urlpath);
+  blosc2_schunk* schunk = blosc2_schunk_new(&storage);
+  for (int nchunk = 0; nchunk < NCHUNKS; nchunk++) {
+    for (int i = 0; i < CHUNKSHAPE; i++) {
+      data[i] = i * nchunk;
+    }
+    int nchunks = blosc2_schunk_append_buffer(schunk, data, isize);
+    if (nchunks != nchunk + 1) {
+      printf("Compression error appending in schunk.  Error code: %d\n", nchunks);
+      return nchunks;
+    }
+  }
+
+  for (int m = 0; m < sizeof(modes) / sizeof(int); m++) {
+    /* Open a new view of the frame, so that no offsets are resident yet */
+    blosc2_schunk* schunk_read;
+    if (urlpath == NULL) {
+      uint8_t* cframe;
+      bool cframe_needs_free;
+      int64_t cframe_len = blosc2_schunk_to_buffer(schunk, &cframe, &cframe_needs_free);
+      schunk_read = blosc2_schunk_from_buffer(cframe, cframe_len, false);
+    }
+    else {
+      schunk_read = blosc2_schunk_open(urlpath);
+    }
+    schunk_read->storage->offsets_mode = modes[m];
+
+    srand(0);
+    blosc_set_timestamp(&last);
+    for (int i = 0; i < NREADS; i++) {
+      int nchunk = rand() % NCHUNKS;
+      int dsize = blosc2_schunk_decompress_chunk(schunk_read, nchunk, data_dest, isize);
+      if (dsize != isize) {
+        printf("Decompression error in schunk.  Error code: %d\n", dsize);
+        return dsize;
+      }
+    }
+    blosc_set_timestamp(&current);
+    double ttotal = blosc_elapsed_secs(last, current);
+    printf("Offsets mode: %s\tTime per read: %.3g us\n", mode_names[m], ttotal * 1e6 / NREADS);
+    blosc2_schunk_free(schunk_read);
+  }
+
+  /* Free resources */
+  blosc2_schunk_free(schunk);
+  blosc2_remove_urlpath(urlpath);
+
+  return 0;
+}
+
+
+int main(void) {
+  blosc_init();
+
+  random_reads(NULL);
+  random_reads("frame_offsets_bench.b2frame");
+
+  blosc_destroy();
+  return 0;
+}
@@ -0,0 +1,92 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Benchmark for reading ranges of items out of a large chunk with
+  blosc2_getitem_ctx().  The blocks with items are spread among the threads
+  of the context, and the blocks fully covered by the range are decompressed
+  straight into the destination.
+
+  To run:
+
+  $ ./getitem_bench
+
+*** Times for reading ranges of items out of a chunk of 64 MB (ms)
+nthreads    4 MB range   256 KB range
+       1         0.517          0.056
+       4         0.566          0.063
+       8         0.628          0.067
+
+  These figures come from a machine with a single core, where threads
+  cannot run in parallel.  The same machine gave 0.657-0.673 ms for the
+  4 MB ranges when every block went through a temporary and the caller did
+  all of them; on several cores, large ranges go faster with nthreads.
+
+*/
+
+#include <stdio.h>
+#include <blosc2.h>
+
+#define CHUNKSIZE (16 * 1024 * 1024)
+#define NROUNDS 5
+
+
+/* The best time of a few rounds for reading `nitems` at every `step` items */
+double time_getitem(blosc2_context* dctx, uint8_t* chunk, int32_t cbytes,
+                    int32_t nitems, int32_t step, int32_t* dest) {
+  blosc_timestamp_t last, current;
+  double tbest = 1e9;
+  for (int round = 0; round < NROUNDS; round++) {
+    int nreads = 0;
+    blosc_set_timestamp(&last);
+    for (int32_t start = 3; start + nitems <= CHUNKSIZE; start += step) {
+      blosc2_getitem_ctx(dctx, chunk, cbytes, start, nitems, dest, nitems * sizeof(int32_t));
+      nreads++;
+    }
+    blosc_set_timestamp(&current);
+    double t = blosc_elapsed_secs(last, current) / nreads;
+    tbest = t < tbest ? t : tbest;
+  }
+  return tbest;
+}
+
+
+int main(void) {
+  int32_t nbytes = CHUNKSIZE * sizeof(int32_t);
+  blosc_init();
+
+  int32_t* data = malloc(nbytes);
+  int32_t* dest = malloc(nbytes);
+  uint8_t* chunk = malloc(nbytes + BLOSC_MAX_OVERHEAD);
+  for (int i = 0; i < CHUNKSIZE; i++) {
+    data[i] = i / 3 + (i % 1013) * 7 % 11;
+  }
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = sizeof(int32_t);
+  cparams.clevel = 5;
+  cparams.blocksize = 256 * 1024;
+  blosc2_context* cctx = blosc2_create_cctx(cparams);
+  int32_t cbytes = blosc2_compress_ctx(cctx, data, nbytes, chunk, nbytes + BLOSC_MAX_OVERHEAD);
+  blosc2_free_ctx(cctx);
+
+  printf("\n*** Times for reading ranges of items out of a chunk of %d MB (ms)\n",
+         nbytes / (1024 * 1024));
+  printf("nthreads    4 MB range   256 KB range\n");
+  int16_t nthreads[] = {1, 4, 8};
+  for (int i = 0; i < 3; i++) {
+    blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+    dparams.nthreads = nthreads[i];
+    blosc2_context* dctx = blosc2_create_dctx(dparams);
+    double t_large = time_getitem(dctx, chunk, cbytes, 1024 * 1024, 3 * 1024 * 1024, dest);
+    double t_small = time_getitem(dctx, chunk, cbytes, 64 * 1024, 1000 * 1000, dest);
+    printf("%8d %13.3f %14.3f\n", nthreads[i], t_large * 1e3, t_small * 1e3);
+    blosc2_free_ctx(dctx);
+  }
+
+  free(data);
+  free(dest);
+  free(chunk);
+  blosc_destroy();
+  return 0;
+}
@@ -0,0 +1,128 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Benchmark for several threads calling blosc_compress() and
+  blosc_decompress() at once.  Every caller (de)compresses buffers of its
+  own, and the aggregate time per buffer should go down with the number of
+  callers, up to the number of cores.
+
+  To run:
+
+  $ ./global_api_scaling_bench
+
+*** Aggregate times per buffer of 256 KB (us), blosc_set_nthreads(1)
+ncallers 1:	compr:   38.0 us	decompr:   19.8 us
+ncallers 2:	compr:   35.2 us	decompr:   20.4 us
+ncallers 4:	compr:   40.2 us	decompr:   23.3 us
+ncallers 8:	compr:   38.1 us	decompr:   21.1 us
+
+  These figures come from a machine with a single core, where callers
+  cannot run in parallel, so they only show that callers do not get in the
+  way of each other.  When every call took a global mutex, the same machine
+  gave 41.7-51.5 us for compression and 19.6-23.6 us for decompression (and
+  52.7-60.6 us / 26.9-29.7 us with BLOSC_NOLOCK, which created a context per
+  call); on several cores, callers were serialized by the mutex.
+
+*/
+
+#include <stdio.h>
+#include <blosc2.h>
+#if !defined(_WIN32)
+#include <pthread.h>
+#endif
+
+#define NBYTES (256 * 1024)
+#define NREPS 200
+#define NROUNDS 5
+#define MAX_CALLERS 8
+
+
+#if !defined(_WIN32)
+typedef struct {
+  int32_t* data;
+  int32_t* data_dest;
+  uint8_t* chunk;
+  int csize;
+  bool compress;
+} caller_data;
+
+
+static void* caller(void* arg) {
+  caller_data* my = (caller_data*)arg;
+  for (int n = 0; n < NREPS; n++) {
+    if (my->compress) {
+      my->csize = blosc_compress(5, BLOSC_SHUFFLE, sizeof(int32_t), NBYTES, my->data,
+                                 my->chunk, NBYTES + BLOSC_MAX_OVERHEAD);
+    }
+    else {
+      blosc_decompress(my->chunk, my->data_dest, NBYTES);
+    }
+  }
+  return NULL;
+}
+
+
+/* The time per buffer for all the callers together */
+double time_callers(caller_data* callers, int ncallers, bool compress) {
+  blosc_timestamp_t last, current;
+  pthread_t threads[MAX_CALLERS];
+
+  blosc_set_timestamp(&last);
+  for (int i = 0; i < ncallers; i++) {
+    callers[i].compress = compress;
+    pthread_create(&threads[i], NULL, caller, &callers[i]);
+  }
+  for (int i = 0; i < ncallers; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  blosc_set_timestamp(&current);
+  return blosc_elapsed_secs(last, current) / (NREPS * ncallers);
+}
+#endif
+
+
+int main(void) {
+#if defined(_WIN32)
+  printf("This benchmark needs POSIX threads\n");
+#else
+  caller_data callers[MAX_CALLERS];
+
+  blosc_init();
+  blosc_set_nthreads(1);
+
+  for (int i = 0; i < MAX_CALLERS; i++) {
+    callers[i].data = malloc(NBYTES);
+    callers[i].data_dest = malloc(NBYTES);
+    callers[i].chunk = malloc(NBYTES + BLOSC_MAX_OVERHEAD);
+    for (int j = 0; j < NBYTES / (int)sizeof(int32_t); j++) {
+      callers[i].data[j] = j + i;
+    }
+  }
+
+  printf("\n*** Aggregate times per buffer of %d KB (us), blosc_set_nthreads(1)\n", NBYTES / 1024);
+  int ncallers[] = {1, 2, 4, MAX_CALLERS};
+  for (int i = 0; i < 4; i++) {
+    /* The best of a few rounds, as other processes may get in the way */
+    double tcompr = 1e9;
+    double tdecompr = 1e9;
+    for (int round = 0; round < NROUNDS; round++) {
+      double t = time_callers(callers, ncallers[i], true);
+      tcompr = t < tcompr ? t : tcompr;
+      t = time_callers(callers, ncallers[i], false);
+      tdecompr = t < tdecompr ? t : tdecompr;
+    }
+    printf("ncallers %d:\tcompr: %6.1f us\tdecompr: %6.1f us\n",
+           ncallers[i], tcompr * 1e6, tdecompr * 1e6);
+  }
+
+  for (int i = 0; i < MAX_CALLERS; i++) {
+    free(callers[i].data);
+    free(callers[i].data_dest);
+    free(callers[i].chunk);
+  }
+  blosc_destroy();
+#endif
+  return 0;
+}
@@ -0,0 +1,128 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Benchmark for choosing the minimum of bytes for a thread to take part in a
+  (de)compression (see blosc2_set_parallel_min_nbytes).  For a sweep of
+  buffer sizes and numbers of threads, it times the serial (de)compression,
+  the one with every thread that has a block (parallel_min_nbytes < 0) and the
+  one with the default threshold (BLOSC2_PARALLEL_MIN_NBYTES), which should be
+  close to the best of the other two.
+
+  To run:
+
+  $ ./parallel_threshold_bench
+
+*** Times per buffer (us) for compression / decompression, blocks of 16 KB
+   size  nthreads         serial     all threads         default
+  32 KB         2    11.4 /   3.0    18.3 /  10.4    11.4 /   3.0
+  32 KB         8    11.7 /   3.0    18.4 /  10.2    11.4 /   3.1
+  64 KB         2    22.6 /   5.7    29.3 /  12.9    22.5 /   5.7
+  64 KB         8    22.5 /   5.7    39.0 /  21.1    22.5 /   5.7
+ 128 KB         2    44.9 /  11.0    51.6 /  18.5    51.6 /  18.1
+ 128 KB         8    44.9 /  10.9    78.7 /  36.8    51.6 /  18.5
+ 256 KB         2    88.9 /  21.5    96.8 /  29.4    97.2 /  29.1
+ 256 KB         8    91.1 /  21.8   129.9 /  48.5   106.0 /  40.0
+1024 KB         2   363.7 / 102.8   381.2 / 104.8   361.7 /  99.7
+1024 KB         8   358.8 /  92.7   287.7 / 107.0   273.3 /  98.3
+4096 KB         2  1522.5 / 531.7  1005.3 / 380.3   985.2 / 368.1
+4096 KB         8   943.2 / 350.3  1013.9 / 395.2  1071.5 / 406.8
+
+  These figures come from a (busy) machine with a single core, where threads
+  can only add overhead, so they just show what is saved by not handing the
+  blocks of small buffers off to threads (and by using fewer threads for
+  mid-sized ones).  On several cores, compare the serial and "all threads"
+  columns to find the size where threads start paying off.
+
+*/
+
+#include <stdio.h>
+#include <blosc2.h>
+
+#define BLOCKSIZE (16 * 1024)
+#define NBYTES_MAX (4 * 1024 * 1024)
+#define NROUNDS 5
+
+
+/* The best time per (de)compression out of a few rounds */
+void time_buffer(int32_t nbytes, int16_t nthreads, int32_t min_nbytes, double* tcompr, double* tdecompr,
+                 int32_t* data, int32_t* data_dest, uint8_t* chunk) {
+  blosc_timestamp_t last, current;
+  int nreps = 20 * NBYTES_MAX / nbytes / 16;
+
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = sizeof(int32_t);
+  cparams.clevel = 5;
+  cparams.blocksize = BLOCKSIZE;
+  cparams.nthreads = nthreads;
+  cparams.parallel_min_nbytes = min_nbytes;
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  dparams.nthreads = nthreads;
+  dparams.parallel_min_nbytes = min_nbytes;
+  blosc2_context* cctx = blosc2_create_cctx(cparams);
+  blosc2_context* dctx = blosc2_create_dctx(dparams);
+
+  /* Warm the threads up */
+  int csize = blosc2_compress_ctx(cctx, data, nbytes, chunk, nbytes + BLOSC_MAX_OVERHEAD);
+  blosc2_decompress_ctx(dctx, chunk, csize, data_dest, nbytes);
+
+  *tcompr = 1e9;
+  *tdecompr = 1e9;
+  for (int round = 0; round < NROUNDS; round++) {
+    blosc_set_timestamp(&last);
+    for (int n = 0; n < nreps; n++) {
+      csize = blosc2_compress_ctx(cctx, data, nbytes, chunk, nbytes + BLOSC_MAX_OVERHEAD);
+    }
+    blosc_set_timestamp(&current);
+    double t = blosc_elapsed_secs(last, current) / nreps;
+    *tcompr = t < *tcompr ? t : *tcompr;
+
+    blosc_set_timestamp(&last);
+    for (int n = 0; n < nreps; n++) {
+      blosc2_decompress_ctx(dctx, chunk, csize, data_dest, nbytes);
+    }
+    blosc_set_timestamp(&current);
+    t = blosc_elapsed_secs(last, current) / nreps;
+    *tdecompr = t < *tdecompr ? t : *tdecompr;
+  }
+
+  blosc2_free_ctx(cctx);
+  blosc2_free_ctx(dctx);
+}
+
+
+int main(void) {
+  blosc_init();
+
+  int32_t* data = malloc(NBYTES_MAX);
+  int32_t* data_dest = malloc(NBYTES_MAX);
+  uint8_t* chunk = malloc(NBYTES_MAX + BLOSC_MAX_OVERHEAD);
+  for (int i = 0; i < NBYTES_MAX / (int)sizeof(int32_t); i++) {
+    data[i] = i;
+  }
+
+  printf("\n*** Times per buffer (us) for compression / decompression, blocks of %d KB\n", BLOCKSIZE / 1024);
+  printf("   size  nthreads         serial     all threads         default\n");
+  int32_t nbytes[] = {32 * 1024, 64 * 1024, 128 * 1024, 256 * 1024, 1024 * 1024, NBYTES_MAX};
+  int16_t nthreads[] = {2, 8};
+  for (int i = 0; i < 6; i++) {
+    for (int j = 0; j < 2; j++) {
+      double tcompr[3], tdecompr[3];
+      time_buffer(nbytes[i], 1, 0, &tcompr[0], &tdecompr[0], data, data_dest, chunk);
+      time_buffer(nbytes[i], nthreads[j], -1, &tcompr[1], &tdecompr[1], data, data_dest, chunk);
+      time_buffer(nbytes[i], nthreads[j], 0, &tcompr[2], &tdecompr[2], data, data_dest, chunk);
+      printf("%4d KB  %8d", nbytes[i] / 1024, nthreads[j]);
+      for (int k = 0; k < 3; k++) {
+        printf("  %6.1f / %5.1f", tcompr[k] * 1e6, tdecompr[k] * 1e6);
+      }
+      printf("\n");
+    }
+  }
+
+  free(data);
+  free(data_dest);
+  free(chunk);
+  blosc_destroy();
+  return 0;
+}
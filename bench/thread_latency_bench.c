@@ -0,0 +1,116 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Benchmark for the latency of compressing and decompressing small chunks
+  with the threads of a context, for several chunk sizes and numbers of
+  threads.  Small chunks have just a few blocks, so most of the time goes to
+  handing the blocks off to the threads and waiting for them.
+
+  To run:
+
+  $ ./thread_latency_bench
+
+*** Compressing and decompressing chunks of 32 KB blocks (times are per chunk)
+chunk of   64 KB, nthreads 1:	compr:   10.2 us	decompr:    3.6 us
+chunk of   64 KB, nthreads 2:	compr:   15.2 us	decompr:    9.0 us
+chunk of   64 KB, nthreads 4:	compr:   14.9 us	decompr:    8.8 us
+chunk of   64 KB, nthreads 8:	compr:   15.7 us	decompr:    8.8 us
+chunk of  256 KB, nthreads 1:	compr:   41.5 us	decompr:   15.0 us
+chunk of  256 KB, nthreads 2:	compr:   52.2 us	decompr:   21.3 us
+chunk of  256 KB, nthreads 4:	compr:   54.8 us	decompr:   25.7 us
+chunk of  256 KB, nthreads 8:	compr:   68.0 us	decompr:   31.9 us
+chunk of 1024 KB, nthreads 1:	compr:  170.1 us	decompr:   64.1 us
+chunk of 1024 KB, nthreads 2:	compr:  183.6 us	decompr:   68.0 us
+chunk of 1024 KB, nthreads 4:	compr:  241.2 us	decompr:   77.4 us
+chunk of 1024 KB, nthreads 8:	compr:  257.9 us	decompr:   93.3 us
+
+  These figures come from a machine with a single core, so no thread runs in
+  parallel and they show the cost of the handoff itself.  When threads were
+  started and finished with barriers, the chunks of 64 KB (2 blocks) took
+  33.3 us to compress and 26.0 us to decompress with 8 threads, as every
+  thread had to wake up; now the ones without a block are left alone.
+
+*/
+
+#include <stdio.h>
+#include <blosc2.h>
+
+#define BLOCKSIZE (32 * 1024)
+#define NREPS 500
+#define NROUNDS 5
+
+
+void time_chunk(int32_t nbytes, int16_t nthreads) {
+  int32_t* data = malloc(nbytes);
+  int32_t* data_dest = malloc(nbytes);
+  uint8_t* chunk = malloc(nbytes + BLOSC_MAX_OVERHEAD);
+  blosc_timestamp_t last, current;
+
+  for (int i = 0; i < nbytes / (int32_t)sizeof(int32_t); i++) {
+    data[i] = i;
+  }
+
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = sizeof(int32_t);
+  cparams.clevel = 5;
+  cparams.blocksize = BLOCKSIZE;
+  cparams.nthreads = nthreads;
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  dparams.nthreads = nthreads;
+  blosc2_context* cctx = blosc2_create_cctx(cparams);
+  blosc2_context* dctx = blosc2_create_dctx(dparams);
+
+  /* Warm the threads up */
+  int csize = blosc2_compress_ctx(cctx, data, nbytes, chunk, nbytes + BLOSC_MAX_OVERHEAD);
+  blosc2_decompress_ctx(dctx, chunk, csize, data_dest, nbytes);
+
+  /* The best of a few rounds, as other processes may get in the way */
+  double tcompr = 1e9;
+  double tdecompr = 1e9;
+  for (int round = 0; round < NROUNDS; round++) {
+    blosc_set_timestamp(&last);
+    for (int n = 0; n < NREPS; n++) {
+      csize = blosc2_compress_ctx(cctx, data, nbytes, chunk, nbytes + BLOSC_MAX_OVERHEAD);
+    }
+    blosc_set_timestamp(&current);
+    double t = blosc_elapsed_secs(last, current) / NREPS;
+    tcompr = t < tcompr ? t : tcompr;
+
+    blosc_set_timestamp(&last);
+    for (int n = 0; n < NREPS; n++) {
+      blosc2_decompress_ctx(dctx, chunk, csize, data_dest, nbytes);
+    }
+    blosc_set_timestamp(&current);
+    t = blosc_elapsed_secs(last, current) / NREPS;
+    tdecompr = t < tdecompr ? t : tdecompr;
+  }
+
+  printf("chunk of %4d KB, nthreads %d:\tcompr: %6.1f us\tdecompr: %6.1f us\n",
+         nbytes / 1024, nthreads, tcompr * 1e6, tdecompr * 1e6);
+
+  blosc2_free_ctx(cctx);
+  blosc2_free_ctx(dctx);
+  free(data);
+  free(data_dest);
+  free(chunk);
+}
+
+
+int main(void) {
+  blosc_init();
+
+  printf("\n*** Compressing and decompressing chunks of %d KB blocks (times are per chunk)\n",
+         BLOCKSIZE / 1024);
+  int32_t nbytes[] = {64 * 1024, 256 * 1024, 1024 * 1024};
+  int16_t nthreads[] = {1, 2, 4, 8};
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 4; j++) {
+      time_chunk(nbytes[i], nthreads[j]);
+    }
+  }
+
+  blosc_destroy();
+  return 0;
+}
@@ -0,0 +1,289 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "blosc2.h"
+#include "blosc-private.h"
+#include "blockcache.h"
+
+/* The initial number of buckets; they are doubled when there are more entries */
+#define BLOCK_CACHE_NBUCKETS 256
+
+
+static inline uint32_t bucket_hash(int64_t nchunk, int32_t nblock, int32_t nbuckets) {
+  uint64_t key = ((uint64_t)nchunk << 20) ^ (uint64_t)(uint32_t)nblock;
+  key *= 0x9E3779B97F4A7C15ULL;
+  return (uint32_t)(key >> 32) & (uint32_t)(nbuckets - 1);
+}
+
+
+blosc2_block_cache* block_cache_new(int64_t capacity) {
+  blosc2_block_cache* cache = calloc(1, sizeof(blosc2_block_cache));
+  BLOSC_ERROR_NULL(cache, NULL);
+  cache->buckets = calloc(BLOCK_CACHE_NBUCKETS, sizeof(block_cache_entry*));
+  if (cache->buckets == NULL) {
+    BLOSC_TRACE_ERROR("Error allocating memory for the block cache.");
+    free(cache);
+    return NULL;
+  }
+  cache->nbuckets = BLOCK_CACHE_NBUCKETS;
+  cache->capacity = capacity;
+  pthread_mutex_init(&cache->mutex, NULL);
+  return cache;
+}
+
+
+void block_cache_free(blosc2_block_cache* cache) {
+  block_cache_entry* entry = cache->head;
+  while (entry != NULL) {
+    block_cache_entry* next = entry->next;
+    free(entry);
+    entry = next;
+  }
+  pthread_mutex_destroy(&cache->mutex);
+  free(cache->buckets);
+  free(cache->layouts);
+  free(cache);
+}
+
+
+/* The entry of a block, or NULL.  The mutex must be held. */
+static block_cache_entry* lookup_entry(blosc2_block_cache* cache, int64_t nchunk, int32_t nblock) {
+  block_cache_entry* entry = cache->buckets[bucket_hash(nchunk, nblock, cache->nbuckets)];
+  while (entry != NULL && (entry->nchunk != nchunk || entry->nblock != nblock)) {
+    entry = entry->hnext;
+  }
+  return entry;
+}
+
+
+/* Take an entry out of the LRU list.  The mutex must be held. */
+static void unlink_entry(blosc2_block_cache* cache, block_cache_entry* entry) {
+  if (entry->prev != NULL) {
+    entry->prev->next = entry->next;
+  }
+  else {
+    cache->head = entry->next;
+  }
+  if (entry->next != NULL) {
+    entry->next->prev = entry->prev;
+  }
+  else {
+    cache->tail = entry->prev;
+  }
+}
+
+
+/* Take an entry out of the buckets and the LRU list.  The mutex must be held. */
+static void remove_entry(blosc2_block_cache* cache, block_cache_entry* entry) {
+  block_cache_entry** link = &cache->buckets[bucket_hash(entry->nchunk, entry->nblock, cache->nbuckets)];
+  while (*link != entry) {
+    link = &(*link)->hnext;
+  }
+  *link = entry->hnext;
+  unlink_entry(cache, entry);
+  cache->nentries--;
+  cache->nbytes -= entry->nbytes;
+}
+
+
+/* Make an entry the most recently used one.  The mutex must be held. */
+static void push_front(blosc2_block_cache* cache, block_cache_entry* entry) {
+  entry->prev = NULL;
+  entry->next = cache->head;
+  if (cache->head != NULL) {
+    cache->head->prev = entry;
+  }
+  cache->head = entry;
+  if (cache->tail == NULL) {
+    cache->tail = entry;
+  }
+}
+
+
+/* Double the number of buckets, keeping the old ones if that is not possible. */
+static void grow_buckets(blosc2_block_cache* cache) {
+  int32_t nbuckets = cache->nbuckets * 2;
+  block_cache_entry** buckets = calloc(nbuckets, sizeof(block_cache_entry*));
+  if (buckets == NULL) {
+    return;
+  }
+  for (block_cache_entry* entry = cache->head; entry != NULL; entry = entry->next) {
+    uint32_t nbucket = bucket_hash(entry->nchunk, entry->nblock, nbuckets);
+    entry->hnext = buckets[nbucket];
+    buckets[nbucket] = entry;
+  }
+  free(cache->buckets);
+  cache->buckets = buckets;
+  cache->nbuckets = nbuckets;
+}
+
+
+bool block_cache_get_layout(blosc2_block_cache* cache, int64_t nchunk, int32_t* nbytes, int32_t* blocksize) {
+  bool found = false;
+  pthread_mutex_lock(&cache->mutex);
+  if (nchunk < cache->nlayouts && cache->layouts[nchunk].blocksize > 0) {
+    *nbytes = cache->layouts[nchunk].nbytes;
+    *blocksize = cache->layouts[nchunk].blocksize;
+    found = true;
+  }
+  pthread_mutex_unlock(&cache->mutex);
+  return found;
+}
+
+
+int64_t block_cache_generation(blosc2_block_cache* cache) {
+  pthread_mutex_lock(&cache->mutex);
+  int64_t generation = cache->generation;
+  pthread_mutex_unlock(&cache->mutex);
+  return generation;
+}
+
+
+int block_cache_set_layout(blosc2_block_cache* cache, int64_t nchunk, int32_t nbytes, int32_t blocksize,
+                           int64_t generation) {
+  int rc = BLOSC2_ERROR_SUCCESS;
+  pthread_mutex_lock(&cache->mutex);
+  if (generation != cache->generation) {
+    // The chunk may have changed since it was read
+    goto end;
+  }
+  if (nchunk >= cache->nlayouts) {
+    int64_t nlayouts = cache->nlayouts > 0 ? cache->nlayouts : 64;
+    while (nlayouts <= nchunk) {
+      nlayouts *= 2;
+    }
+    block_cache_layout* layouts = realloc(cache->layouts, nlayouts * sizeof(block_cache_layout));
+    if (layouts == NULL) {
+      BLOSC_TRACE_ERROR("Error allocating memory for the block cache.");
+      rc = BLOSC2_ERROR_MEMORY_ALLOC;
+      goto end;
+    }
+    memset(layouts + cache->nlayouts, 0, (nlayouts - cache->nlayouts) * sizeof(block_cache_layout));
+    cache->layouts = layouts;
+    cache->nlayouts = nlayouts;
+  }
+  cache->layouts[nchunk].nbytes = nbytes;
+  cache->layouts[nchunk].blocksize = blocksize;
+
+  end:
+  pthread_mutex_unlock(&cache->mutex);
+  return rc;
+}
+
+
+bool block_cache_get(blosc2_block_cache* cache, int64_t nchunk, int32_t nblock,
+                     int32_t offset, int32_t nbytes, uint8_t* dest, bool count) {
+  pthread_mutex_lock(&cache->mutex);
+  block_cache_entry* entry = lookup_entry(cache, nchunk, nblock);
+  if (entry == NULL || offset + nbytes > entry->nbytes) {
+    if (count) {
+      cache->misses++;
+    }
+    pthread_mutex_unlock(&cache->mutex);
+    return false;
+  }
+  if (count) {
+    cache->hits++;
+  }
+  memcpy(dest, entry->data + offset, nbytes);
+  if (entry != cache->head) {
+    unlink_entry(cache, entry);
+    push_front(cache, entry);
+  }
+  pthread_mutex_unlock(&cache->mutex);
+  return true;
+}
+
+
+void block_cache_count(blosc2_block_cache* cache, int64_t hits, int64_t misses) {
+  pthread_mutex_lock(&cache->mutex);
+  cache->hits += hits;
+  cache->misses += misses;
+  pthread_mutex_unlock(&cache->mutex);
+}
+
+
+int block_cache_put(blosc2_block_cache* cache, int64_t nchunk, int32_t nblock,
+                    const uint8_t* src, int32_t nbytes, int64_t generation) {
+  if (nbytes > cache->capacity) {
+    return BLOSC2_ERROR_SUCCESS;
+  }
+  block_cache_entry* entry = malloc(sizeof(block_cache_entry) + nbytes);
+  BLOSC_ERROR_NULL(entry, BLOSC2_ERROR_MEMORY_ALLOC);
+  entry->nchunk = nchunk;
+  entry->nblock = nblock;
+  entry->nbytes = nbytes;
+  memcpy(entry->data, src, nbytes);
+
+  pthread_mutex_lock(&cache->mutex);
+  if (generation != cache->generation) {
+    // The chunk may have changed since the block was read
+    pthread_mutex_unlock(&cache->mutex);
+    free(entry);
+    return BLOSC2_ERROR_SUCCESS;
+  }
+  // Another thread may have put the same block meanwhile
+  block_cache_entry* old = lookup_entry(cache, nchunk, nblock);
+  if (old != NULL) {
+    remove_entry(cache, old);
+    free(old);
+  }
+  while (cache->nbytes + nbytes > cache->capacity) {
+    block_cache_entry* lru = cache->tail;
+    remove_entry(cache, lru);
+    free(lru);
+  }
+  if (cache->nentries >= 2 * cache->nbuckets) {
+    grow_buckets(cache);
+  }
+  uint32_t nbucket = bucket_hash(nchunk, nblock, cache->nbuckets);
+  entry->hnext = cache->buckets[nbucket];
+  cache->buckets[nbucket] = entry;
+  cache->nentries++;
+  cache->nbytes += nbytes;
+  push_front(cache, entry);
+  pthread_mutex_unlock(&cache->mutex);
+
+  return BLOSC2_ERROR_SUCCESS;
+}
+
+
+void block_cache_invalidate(blosc2_block_cache* cache, int64_t nchunk, bool following) {
+  pthread_mutex_lock(&cache->mutex);
+  cache->generation++;
+  block_cache_entry* entry = cache->head;
+  while (entry != NULL) {
+    block_cache_entry* next = entry->next;
+    if (entry->nchunk == nchunk || (following && entry->nchunk > nchunk)) {
+      remove_entry(cache, entry);
+      free(entry);
+    }
+    entry = next;
+  }
+  if (nchunk < cache->nlayouts) {
+    int64_t nlayouts = following ? cache->nlayouts - nchunk : 1;
+    memset(cache->layouts + nchunk, 0, nlayouts * sizeof(block_cache_layout));
+  }
+  pthread_mutex_unlock(&cache->mutex);
+}
+
+
+void block_cache_stats(blosc2_block_cache* cache, int64_t* hits, int64_t* misses) {
+  pthread_mutex_lock(&cache->mutex);
+  if (hits != NULL) {
+    *hits = cache->hits;
+  }
+  if (misses != NULL) {
+    *misses = cache->misses;
+  }
+  pthread_mutex_unlock(&cache->mutex);
+}
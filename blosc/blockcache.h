@@ -0,0 +1,99 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+#ifndef BLOSC_BLOCKCACHE_H
+#define BLOSC_BLOCKCACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#if defined(_WIN32) && !defined(__GNUC__)
+  #include "win32/pthread.h"
+#else
+  #include <pthread.h>
+#endif
+
+#include "blosc2.h"
+
+
+/* A decompressed block in the cache */
+typedef struct block_cache_entry_s {
+  int64_t nchunk;
+  int32_t nblock;
+  int32_t nbytes;
+  struct block_cache_entry_s* hnext;  //!< Next entry in the same bucket
+  struct block_cache_entry_s* prev;   //!< Entry used more recently
+  struct block_cache_entry_s* next;   //!< Entry used less recently
+  uint8_t data[];
+} block_cache_entry;
+
+/* The sizes of a chunk, needed to find its blocks */
+typedef struct {
+  int32_t nbytes;
+  int32_t blocksize;  //!< 0 if the chunk has not been seen yet
+} block_cache_layout;
+
+/* A size-bounded cache of decompressed blocks, keyed by (nchunk, nblock),
+   that evicts the least recently used blocks first */
+struct blosc2_block_cache_s {
+  pthread_mutex_t mutex;
+  int64_t capacity;  //!< Maximum number of bytes of the blocks in the cache
+  int64_t nbytes;    //!< Bytes of the blocks in the cache
+  int64_t hits;
+  int64_t misses;
+  int64_t generation;  //!< Bumped on every invalidation (see block_cache_generation)
+  block_cache_entry** buckets;
+  int32_t nbuckets;  //!< Always a power of 2
+  int32_t nentries;
+  block_cache_entry* head;  //!< The most recently used entry
+  block_cache_entry* tail;  //!< The least recently used entry
+  block_cache_layout* layouts;  //!< Indexed by nchunk
+  int64_t nlayouts;
+};
+
+
+/* Create a cache for up to `capacity` bytes of blocks.  Return NULL on failure. */
+blosc2_block_cache* block_cache_new(int64_t capacity);
+
+/* Free a cache and its blocks. */
+void block_cache_free(blosc2_block_cache* cache);
+
+/* Get the sizes of a chunk.  Return false if they are unknown. */
+bool block_cache_get_layout(blosc2_block_cache* cache, int64_t nchunk, int32_t* nbytes, int32_t* blocksize);
+
+/* Get the generation of the cache, to be taken before reading the chunks whose blocks
+   (or sizes) are put in the cache; they are not put if it has been invalidated since. */
+int64_t block_cache_generation(blosc2_block_cache* cache);
+
+/* Remember the sizes of a chunk, read at `generation`. */
+int block_cache_set_layout(blosc2_block_cache* cache, int64_t nchunk, int32_t nbytes, int32_t blocksize,
+                           int64_t generation);
+
+/* Copy `nbytes` from `offset` of a cached block into `dest`, counting a hit or a miss
+   if `count`.  Return false if the block is not in the cache. */
+bool block_cache_get(blosc2_block_cache* cache, int64_t nchunk, int32_t nblock,
+                     int32_t offset, int32_t nbytes, uint8_t* dest, bool count);
+
+/* Count hits and misses of lookups done with block_cache_get() without counting. */
+void block_cache_count(blosc2_block_cache* cache, int64_t hits, int64_t misses);
+
+/* Put a copy of a block read at `generation` in the cache, evicting the least recently
+   used ones if needed. */
+int block_cache_put(blosc2_block_cache* cache, int64_t nchunk, int32_t nblock,
+                    const uint8_t* src, int32_t nbytes, int64_t generation);
+
+/* Drop the blocks of chunk `nchunk`, and the ones of the following chunks too
+   if `following` (e.g. when chunks are inserted or deleted). */
+void block_cache_invalidate(blosc2_block_cache* cache, int64_t nchunk, bool following);
+
+/* Get the number of block lookups that hit and missed the cache. */
+void block_cache_stats(blosc2_block_cache* cache, int64_t* hits, int64_t* misses);
+
+#endif //BLOSC_BLOCKCACHE_H
@@ -175,6 +175,32 @@ int register_filter_private(blosc2_filter *filter);
  */
 int register_codec_private(blosc2_codec *codec);
 
+/**
+ * @brief The work on an item of a batch (see #run_batch).
+ *
+ * @param context A context with a single thread, made after the one of the batch.
+ * @param batch_data The data passed to #run_batch.
+ * @param nitem The item to work on (0 indexed).
+ *
+ * @return A non-negative value if succeeds. Else a negative code is returned.
+ */
+typedef int (*batch_func)(blosc2_context* context, void* batch_data, int32_t nitem);
+
+/**
+ * @brief Run @p func on every item of a batch, with as many items at once as
+ * threads has @p context (this is the engine of #blosc2_compress_batch).
+ *
+ * @param context The context of the batch; its threads are used for the items.
+ * @param func The work on every item.
+ * @param batch_data The data passed to @p func.
+ * @param nitems The number of items.
+ * @param results Where the values returned by @p func go (@p nitems of them).
+ *
+ * @return 0 if every item succeeds. Else the first negative result is returned.
+ */
+int run_batch(blosc2_context* context, batch_func func, void* batch_data,
+              int32_t nitems, int32_t* results);
+
 #ifdef __cplusplus
 }
 #endif
@@ -8,8 +8,13 @@
   See LICENSE.txt for details about copyright and rights to use.
 **********************************************************************/
 
+#if defined(__linux__)
+  /* For O_DIRECT */
+  #define _GNU_SOURCE
+#endif
 
 #include "blosc2/blosc2-stdio.h"
+#include "config.h"
 
 void *blosc2_stdio_open(const char *urlpath, const char *mode, void *params) {
   FILE *file = fopen(urlpath, mode);
@@ -72,3 +77,1383 @@ int blosc2_stdio_truncate(void *stream, int64_t size) {
 #endif
   return rc;
 }
+
+
+/* Positional reads.  These do not move the position of the stream, so they can be
+ * issued by several threads on the same stream at once. */
+#if !defined(_WIN32)
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/uio.h>
+
+#define READV_MAX_IOV 64  // the maximum number of adjacent segments merged in a single preadv()
+
+static int64_t pread_full(int fd, void *ptr, int64_t size, int64_t offset) {
+  int64_t rbytes = 0;
+  while (rbytes < size) {
+    ssize_t rbytes_ = pread(fd, (uint8_t *) ptr + rbytes, (size_t) (size - rbytes),
+                            (off_t) (offset + rbytes));
+    if (rbytes_ < 0) {
+      return rbytes > 0 ? rbytes : -1;
+    }
+    if (rbytes_ == 0) {
+      break;  // end of file
+    }
+    rbytes += rbytes_;
+  }
+  return rbytes;
+}
+
+static int64_t pwrite_full(int fd, const void *ptr, int64_t size, int64_t offset) {
+  int64_t wbytes = 0;
+  while (wbytes < size) {
+    ssize_t wbytes_ = pwrite(fd, (const uint8_t *) ptr + wbytes, (size_t) (size - wbytes),
+                             (off_t) (offset + wbytes));
+    if (wbytes_ <= 0) {
+      break;
+    }
+    wbytes += wbytes_;
+  }
+  return wbytes;
+}
+
+/* The flags for open() that correspond to a fopen() mode; the descriptor is always readable */
+static int open_flags(const char *mode) {
+  if (mode[0] == 'r') {
+    return strchr(mode, '+') != NULL ? O_RDWR : O_RDONLY;
+  }
+  if (mode[0] == 'w') {
+    return O_RDWR | O_CREAT | O_TRUNC;
+  }
+  if (mode[0] == 'a') {
+    return O_RDWR | O_CREAT | O_APPEND;
+  }
+  return -1;
+}
+
+static int64_t preadv_full(int fd, const blosc2_io_segment *segments, int64_t nsegments) {
+  int64_t total = 0;
+  int64_t i = 0;
+  while (i < nsegments) {
+    // Merge the segments that are adjacent in the file into a single system call
+    int64_t j = i + 1;
+    int64_t size = segments[i].size;
+    while (j < nsegments && j - i < READV_MAX_IOV &&
+           segments[j].offset == segments[j - 1].offset + segments[j - 1].size) {
+      size += segments[j].size;
+      j++;
+    }
+#if defined(__linux__) || defined(__FreeBSD__)
+    if (j - i > 1) {
+      struct iovec iov[READV_MAX_IOV];
+      for (int64_t k = i; k < j; k++) {
+        iov[k - i].iov_base = segments[k].ptr;
+        iov[k - i].iov_len = (size_t) segments[k].size;
+      }
+      ssize_t rbytes = preadv(fd, iov, (int) (j - i), (off_t) segments[i].offset);
+      if (rbytes < 0) {
+        return -1;
+      }
+      total += rbytes;
+      if (rbytes < size) {
+        // Short read (e.g. end of file or a signal); finish segment by segment
+        int64_t done = rbytes;
+        for (int64_t k = i; k < j; k++) {
+          if (done >= segments[k].size) {
+            done -= segments[k].size;
+            continue;
+          }
+          int64_t rbytes_ = pread_full(fd, (uint8_t *) segments[k].ptr + done, segments[k].size - done,
+                                       segments[k].offset + done);
+          if (rbytes_ < 0) {
+            return -1;
+          }
+          total += rbytes_;
+          if (rbytes_ < segments[k].size - done) {
+            return total;
+          }
+          done = 0;
+        }
+      }
+      i = j;
+      continue;
+    }
+#endif
+    for (; i < j; i++) {
+      int64_t rbytes = pread_full(fd, segments[i].ptr, segments[i].size, segments[i].offset);
+      if (rbytes < 0) {
+        return -1;
+      }
+      total += rbytes;
+      if (rbytes < segments[i].size) {
+        return total;
+      }
+    }
+  }
+  return total;
+}
+
+int64_t blosc2_stdio_read_at(void *stream, int64_t offset, int64_t size, void *ptr) {
+  blosc2_stdio_file *my_fp = (blosc2_stdio_file *) stream;
+  if (offset < 0 || size < 0) {
+    return -1;
+  }
+  return pread_full(fileno(my_fp->file), ptr, size, offset);
+}
+
+int64_t blosc2_stdio_readv_at(void *stream, const blosc2_io_segment *segments, int64_t nsegments) {
+  blosc2_stdio_file *my_fp = (blosc2_stdio_file *) stream;
+  for (int64_t i = 0; i < nsegments; i++) {
+    if (segments[i].offset < 0 || segments[i].size < 0) {
+      return -1;
+    }
+  }
+  return preadv_full(fileno(my_fp->file), segments, nsegments);
+}
+
+#else  // _WIN32
+
+#include <windows.h>
+
+/* ReadFile() with an explicit offset does not depend on the file position either */
+int64_t blosc2_stdio_read_at(void *stream, int64_t offset, int64_t size, void *ptr) {
+  blosc2_stdio_file *my_fp = (blosc2_stdio_file *) stream;
+  if (offset < 0 || size < 0) {
+    return -1;
+  }
+  HANDLE handle = (HANDLE) _get_osfhandle(_fileno(my_fp->file));
+  int64_t rbytes = 0;
+  while (rbytes < size) {
+    OVERLAPPED overlapped = {0};
+    overlapped.Offset = (DWORD) ((offset + rbytes) & 0xFFFFFFFF);
+    overlapped.OffsetHigh = (DWORD) ((offset + rbytes) >> 32);
+    int64_t remaining = size - rbytes;
+    DWORD nbytes = remaining > 0x40000000 ? 0x40000000 : (DWORD) remaining;
+    DWORD rbytes_ = 0;
+    if (!ReadFile(handle, (uint8_t *) ptr + rbytes, nbytes, &rbytes_, &overlapped)) {
+      if (GetLastError() == ERROR_HANDLE_EOF) {
+        break;
+      }
+      return rbytes > 0 ? rbytes : -1;
+    }
+    if (rbytes_ == 0) {
+      break;
+    }
+    rbytes += rbytes_;
+  }
+  return rbytes;
+}
+
+int64_t blosc2_stdio_readv_at(void *stream, const blosc2_io_segment *segments, int64_t nsegments) {
+  int64_t total = 0;
+  for (int64_t i = 0; i < nsegments; i++) {
+    int64_t rbytes = blosc2_stdio_read_at(stream, segments[i].offset, segments[i].size, segments[i].ptr);
+    if (rbytes < 0) {
+      return -1;
+    }
+    total += rbytes;
+    if (rbytes < segments[i].size) {
+      break;
+    }
+  }
+  return total;
+}
+
+#endif  // _WIN32
+
+
+/* The mmap backend.  Files are mapped read-only (on the first request of an address)
+ * and written with pwrite(), so that the mapping (which is shared) always sees the
+ * last contents.  Reads are served from the mapping when there is one. */
+#if !defined(_WIN32)
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static int mmap_remap(blosc2_stdio_mmap *my_fp, int64_t size) {
+  if (my_fp->addr != NULL) {
+    munmap(my_fp->addr, (size_t) my_fp->mapped_size);
+    my_fp->addr = NULL;
+    my_fp->mapped_size = 0;
+  }
+  if (size <= 0) {
+    return 0;
+  }
+  void *addr = mmap(NULL, (size_t) size, PROT_READ, MAP_SHARED, my_fp->fd, 0);
+  if (addr == MAP_FAILED) {
+    return -1;
+  }
+  switch (my_fp->access) {
+    case BLOSC2_MMAP_ACCESS_SEQUENTIAL:
+      madvise(addr, (size_t) size, MADV_SEQUENTIAL);
+      break;
+    case BLOSC2_MMAP_ACCESS_RANDOM:
+      madvise(addr, (size_t) size, MADV_RANDOM);
+      break;
+    default:
+      break;
+  }
+  my_fp->addr = addr;
+  my_fp->mapped_size = size;
+  return 0;
+}
+
+/* Make sure that [offset, offset + size) is mapped, growing the mapping if the file did */
+static int mmap_ensure(blosc2_stdio_mmap *my_fp, int64_t offset, int64_t size) {
+  if (offset < 0 || size < 0) {
+    return -1;
+  }
+  if (offset + size <= my_fp->mapped_size) {
+    return 0;
+  }
+  if (offset + size > my_fp->file_size) {
+    // The file may have been extended by other handles
+    struct stat st;
+    if (fstat(my_fp->fd, &st) < 0) {
+      return -1;
+    }
+    my_fp->file_size = st.st_size;
+    if (offset + size > my_fp->file_size) {
+      return -1;
+    }
+  }
+  return mmap_remap(my_fp, my_fp->file_size);
+}
+
+void *blosc2_stdio_mmap_open(const char *urlpath, const char *mode, void *params) {
+  // The descriptor has to be readable for mapping the file
+  int flags = open_flags(mode);
+  if (flags < 0) {
+    return NULL;
+  }
+  int fd = open(urlpath, flags, 0666);
+  if (fd < 0) {
+    return NULL;
+  }
+  struct stat st;
+  if (fstat(fd, &st) < 0) {
+    close(fd);
+    return NULL;
+  }
+  blosc2_stdio_mmap *my_fp = calloc(1, sizeof(blosc2_stdio_mmap));
+  my_fp->fd = fd;
+  my_fp->file_size = st.st_size;
+  my_fp->pos = (mode[0] == 'a') ? st.st_size : 0;
+  if (params != NULL) {
+    my_fp->access = ((blosc2_stdio_mmap_params *) params)->access;
+  }
+  // The file is mapped on demand; small files that are just read once are cheaper to pread()
+  return my_fp;
+}
+
+int blosc2_stdio_mmap_close(void *stream) {
+  blosc2_stdio_mmap *my_fp = (blosc2_stdio_mmap *) stream;
+  mmap_remap(my_fp, 0);
+  int err = close(my_fp->fd);
+  free(my_fp);
+  return err;
+}
+
+int64_t blosc2_stdio_mmap_tell(void *stream) {
+  blosc2_stdio_mmap *my_fp = (blosc2_stdio_mmap *) stream;
+  return my_fp->pos;
+}
+
+int blosc2_stdio_mmap_seek(void *stream, int64_t offset, int whence) {
+  blosc2_stdio_mmap *my_fp = (blosc2_stdio_mmap *) stream;
+  int64_t pos;
+  switch (whence) {
+    case SEEK_SET:
+      pos = offset;
+      break;
+    case SEEK_CUR:
+      pos = my_fp->pos + offset;
+      break;
+    case SEEK_END: {
+      struct stat st;
+      if (fstat(my_fp->fd, &st) < 0) {
+        return -1;
+      }
+      my_fp->file_size = st.st_size;
+      pos = my_fp->file_size + offset;
+      break;
+    }
+    default:
+      return -1;
+  }
+  if (pos < 0) {
+    return -1;
+  }
+  my_fp->pos = pos;
+  return 0;
+}
+
+int64_t blosc2_stdio_mmap_write(const void *ptr, int64_t size, int64_t nitems, void *stream) {
+  blosc2_stdio_mmap *my_fp = (blosc2_stdio_mmap *) stream;
+  int64_t written = pwrite_full(my_fp->fd, ptr, size * nitems, my_fp->pos);
+  my_fp->pos += written;
+  if (my_fp->pos > my_fp->file_size) {
+    // The mapping will be extended when needed
+    my_fp->file_size = my_fp->pos;
+  }
+  return size > 0 ? written / size : 0;
+}
+
+int64_t blosc2_stdio_mmap_read(void *ptr, int64_t size, int64_t nitems, void *stream) {
+  blosc2_stdio_mmap *my_fp = (blosc2_stdio_mmap *) stream;
+  if (size <= 0) {
+    return 0;
+  }
+  int64_t nbytes = size * nitems;
+  if (my_fp->addr == NULL || mmap_ensure(my_fp, my_fp->pos, nbytes) < 0) {
+    // Not mapped (or past the end of the file)
+    int64_t rbytes = pread_full(my_fp->fd, ptr, nbytes, my_fp->pos);
+    if (rbytes < 0) {
+      return 0;
+    }
+    nbytes = rbytes - rbytes % size;
+  }
+  else {
+    memcpy(ptr, my_fp->addr + my_fp->pos, (size_t) nbytes);
+  }
+  my_fp->pos += nbytes;
+  return nbytes / size;
+}
+
+int blosc2_stdio_mmap_truncate(void *stream, int64_t size) {
+  blosc2_stdio_mmap *my_fp = (blosc2_stdio_mmap *) stream;
+  if (size < my_fp->mapped_size) {
+    // Accessing the mapping past the end of the file would raise SIGBUS
+    mmap_remap(my_fp, 0);
+  }
+  int rc = ftruncate(my_fp->fd, size);
+  if (rc == 0) {
+    my_fp->file_size = size;
+  }
+  return rc;
+}
+
+/* Positional reads do not go through the mapping, as it may be moved by other threads */
+int64_t blosc2_stdio_mmap_read_at(void *stream, int64_t offset, int64_t size, void *ptr) {
+  blosc2_stdio_mmap *my_fp = (blosc2_stdio_mmap *) stream;
+  if (offset < 0 || size < 0) {
+    return -1;
+  }
+  return pread_full(my_fp->fd, ptr, size, offset);
+}
+
+int64_t blosc2_stdio_mmap_readv_at(void *stream, const blosc2_io_segment *segments, int64_t nsegments) {
+  blosc2_stdio_mmap *my_fp = (blosc2_stdio_mmap *) stream;
+  for (int64_t i = 0; i < nsegments; i++) {
+    if (segments[i].offset < 0 || segments[i].size < 0) {
+      return -1;
+    }
+  }
+  return preadv_full(my_fp->fd, segments, nsegments);
+}
+
+void *blosc2_stdio_mmap_addr(void *stream, int64_t offset, int64_t size) {
+  blosc2_stdio_mmap *my_fp = (blosc2_stdio_mmap *) stream;
+  if (mmap_ensure(my_fp, offset, size) < 0 || my_fp->addr == NULL) {
+    return NULL;
+  }
+  return my_fp->addr + offset;
+}
+
+#else  // _WIN32
+
+/* No mmap() here; just forward to the stdio backend */
+
+void *blosc2_stdio_mmap_open(const char *urlpath, const char *mode, void *params) {
+  void *file = blosc2_stdio_open(urlpath, mode, params);
+  if (file == NULL) {
+    return NULL;
+  }
+  blosc2_stdio_mmap *my_fp = calloc(1, sizeof(blosc2_stdio_mmap));
+  my_fp->file = file;
+  return my_fp;
+}
+
+int blosc2_stdio_mmap_close(void *stream) {
+  blosc2_stdio_mmap *my_fp = (blosc2_stdio_mmap *) stream;
+  int err = blosc2_stdio_close(my_fp->file);
+  free(my_fp);
+  return err;
+}
+
+int64_t blosc2_stdio_mmap_tell(void *stream) {
+  return blosc2_stdio_tell(((blosc2_stdio_mmap *) stream)->file);
+}
+
+int blosc2_stdio_mmap_seek(void *stream, int64_t offset, int whence) {
+  return blosc2_stdio_seek(((blosc2_stdio_mmap *) stream)->file, offset, whence);
+}
+
+int64_t blosc2_stdio_mmap_write(const void *ptr, int64_t size, int64_t nitems, void *stream) {
+  return blosc2_stdio_write(ptr, size, nitems, ((blosc2_stdio_mmap *) stream)->file);
+}
+
+int64_t blosc2_stdio_mmap_read(void *ptr, int64_t size, int64_t nitems, void *stream) {
+  return blosc2_stdio_read(ptr, size, nitems, ((blosc2_stdio_mmap *) stream)->file);
+}
+
+int blosc2_stdio_mmap_truncate(void *stream, int64_t size) {
+  return blosc2_stdio_truncate(((blosc2_stdio_mmap *) stream)->file, size);
+}
+
+int64_t blosc2_stdio_mmap_read_at(void *stream, int64_t offset, int64_t size, void *ptr) {
+  return blosc2_stdio_read_at(((blosc2_stdio_mmap *) stream)->file, offset, size, ptr);
+}
+
+int64_t blosc2_stdio_mmap_readv_at(void *stream, const blosc2_io_segment *segments, int64_t nsegments) {
+  return blosc2_stdio_readv_at(((blosc2_stdio_mmap *) stream)->file, segments, nsegments);
+}
+
+void *blosc2_stdio_mmap_addr(void *stream, int64_t offset, int64_t size) {
+  return NULL;
+}
+
+#endif  // _WIN32
+
+
+/* The io_uring backend.  Files are read and written with pread()/pwrite() (like in the
+ * mmap backend), but batches of reads can also be submitted at once, so that the device
+ * works on all of them while the caller is busy with the ones already done. */
+#if !defined(_WIN32)
+
+#include <sys/stat.h>
+
+#if defined(HAVE_IO_URING)
+
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#define URING_ENTRIES 16  // the maximum number of reads in flight in a batch
+
+typedef struct uring_s {
+  int fd;
+  unsigned *sq_tail;
+  unsigned *sq_mask;
+  unsigned *sq_array;
+  unsigned *cq_head;
+  unsigned *cq_tail;
+  unsigned *cq_mask;
+  struct io_uring_sqe *sqes;
+  struct io_uring_cqe *cqes;
+  void *sq_ptr;
+  size_t sq_size;
+  void *cq_ptr;
+  size_t cq_size;
+  size_t sqes_size;
+  unsigned entries;
+  struct uring_s *next;  // the next free ring in the pool
+} uring;
+
+/* The rings of a file; each batch of reads takes one for itself */
+typedef struct {
+  pthread_mutex_t mutex;
+  uring *free_rings;
+  bool unavailable;  // io_uring cannot be used (e.g. old kernels or seccomp filters)
+} uring_pool;
+
+enum {
+  SEGMENT_QUEUED = 0,
+  SEGMENT_INFLIGHT = 1,
+  SEGMENT_DONE = 2,
+};
+
+typedef struct {
+  blosc2_stdio_uring *stream;
+  uring *ring;
+  blosc2_io_segment *segments;
+  struct iovec *iovecs;
+  int64_t *results;
+  uint8_t *states;
+  int64_t nsegments;
+  int64_t nsubmitted;  // the segments before this one are in flight (or done)
+  int64_t ninflight;
+  bool broken;         // submitting failed; the segments left are read synchronously
+  pthread_mutex_t mutex;
+} uring_batch;
+
+static void uring_free(uring *ring) {
+  if (ring->sqes != NULL) {
+    munmap(ring->sqes, ring->sqes_size);
+  }
+  if (ring->cq_ptr != NULL && ring->cq_ptr != ring->sq_ptr) {
+    munmap(ring->cq_ptr, ring->cq_size);
+  }
+  if (ring->sq_ptr != NULL) {
+    munmap(ring->sq_ptr, ring->sq_size);
+  }
+  close(ring->fd);
+  free(ring);
+}
+
+static uring *uring_new(void) {
+  struct io_uring_params p;
+  memset(&p, 0, sizeof(p));
+  int fd = (int) syscall(__NR_io_uring_setup, URING_ENTRIES, &p);
+  if (fd < 0) {
+    return NULL;
+  }
+  uring *ring = calloc(1, sizeof(uring));
+  if (ring == NULL) {
+    close(fd);
+    return NULL;
+  }
+  ring->fd = fd;
+  ring->entries = p.sq_entries;
+  ring->sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  ring->cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  bool single_mmap = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    ring->sq_size = ring->cq_size > ring->sq_size ? ring->cq_size : ring->sq_size;
+    ring->cq_size = ring->sq_size;
+  }
+
+  void *sq_ptr = mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      fd, IORING_OFF_SQ_RING);
+  if (sq_ptr == MAP_FAILED) {
+    uring_free(ring);
+    return NULL;
+  }
+  ring->sq_ptr = sq_ptr;
+  if (single_mmap) {
+    ring->cq_ptr = sq_ptr;
+  }
+  else {
+    void *cq_ptr = mmap(NULL, ring->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        fd, IORING_OFF_CQ_RING);
+    if (cq_ptr == MAP_FAILED) {
+      uring_free(ring);
+      return NULL;
+    }
+    ring->cq_ptr = cq_ptr;
+  }
+  ring->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+  void *sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    fd, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    uring_free(ring);
+    return NULL;
+  }
+  ring->sqes = sqes;
+
+  uint8_t *sq = ring->sq_ptr;
+  ring->sq_tail = (unsigned *) (sq + p.sq_off.tail);
+  ring->sq_mask = (unsigned *) (sq + p.sq_off.ring_mask);
+  ring->sq_array = (unsigned *) (sq + p.sq_off.array);
+  uint8_t *cq = ring->cq_ptr;
+  ring->cq_head = (unsigned *) (cq + p.cq_off.head);
+  ring->cq_tail = (unsigned *) (cq + p.cq_off.tail);
+  ring->cq_mask = (unsigned *) (cq + p.cq_off.ring_mask);
+  ring->cqes = (struct io_uring_cqe *) (cq + p.cq_off.cqes);
+
+  return ring;
+}
+
+/* Queue as many reads as fit in the ring and submit them; the batch must be locked */
+static void batch_push(uring_batch *batch) {
+  uring *ring = batch->ring;
+  unsigned tail = *ring->sq_tail;  // only we write to this ring
+  unsigned nqueued = 0;
+  int64_t first = batch->nsubmitted;
+  while (batch->nsubmitted < batch->nsegments && batch->ninflight + nqueued < ring->entries) {
+    int64_t i = batch->nsubmitted++;
+    blosc2_io_segment *segment = &batch->segments[i];
+    if (segment->size == 0) {
+      batch->results[i] = 0;
+      batch->states[i] = SEGMENT_DONE;
+      continue;
+    }
+    unsigned index = tail & *ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    batch->iovecs[i].iov_base = segment->ptr;
+    batch->iovecs[i].iov_len = (size_t) segment->size;
+    sqe->opcode = IORING_OP_READV;
+    sqe->fd = batch->stream->fd;
+    sqe->off = (uint64_t) segment->offset;
+    sqe->addr = (uint64_t) (uintptr_t) &batch->iovecs[i];
+    sqe->len = 1;
+    sqe->user_data = (uint64_t) i;
+    ring->sq_array[index] = index;
+    batch->states[i] = SEGMENT_INFLIGHT;
+    tail++;
+    nqueued++;
+  }
+  if (nqueued == 0) {
+    return;
+  }
+
+  unsigned old_tail = *ring->sq_tail;
+  __atomic_store_n(ring->sq_tail, tail, __ATOMIC_RELEASE);
+  int rc;
+  do {
+    rc = (int) syscall(__NR_io_uring_enter, ring->fd, nqueued, 0, 0, NULL, 0);
+  } while (rc < 0 && errno == EINTR);
+  unsigned nconsumed = rc < 0 ? 0 : (unsigned) rc;
+  if (nconsumed < nqueued) {
+    // The kernel did not take all the reads (or none, on errors); take the rest back so
+    // that they are pushed again, or done synchronously if nothing could be submitted
+    __atomic_store_n(ring->sq_tail, old_tail + nconsumed, __ATOMIC_RELEASE);
+    unsigned n = 0;
+    int64_t resume = batch->nsubmitted;
+    for (int64_t i = first; i < batch->nsubmitted; i++) {
+      if (batch->states[i] != SEGMENT_INFLIGHT) {
+        continue;
+      }
+      if (n == nconsumed) {
+        resume = i;
+        break;
+      }
+      n++;
+    }
+    for (int64_t i = resume; i < batch->nsubmitted; i++) {
+      if (batch->states[i] == SEGMENT_INFLIGHT) {
+        batch->states[i] = SEGMENT_QUEUED;
+      }
+    }
+    batch->nsubmitted = resume;
+    if (nconsumed == 0) {
+      batch->broken = true;
+    }
+  }
+  batch->ninflight += nconsumed;
+}
+
+/* Collect the reads completed so far; the batch must be locked */
+static void batch_reap(uring_batch *batch) {
+  uring *ring = batch->ring;
+  unsigned head = *ring->cq_head;
+  unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+  while (head != tail) {
+    struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cq_mask];
+    int64_t i = (int64_t) cqe->user_data;
+    batch->results[i] = cqe->res;
+    batch->states[i] = SEGMENT_DONE;
+    batch->ninflight--;
+    head++;
+  }
+  __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+}
+
+/* Wait for (at least) one read in flight; the batch must be locked */
+static void batch_wait_one(uring_batch *batch) {
+  batch_reap(batch);
+  if (batch->ninflight == 0) {
+    return;
+  }
+  int rc = (int) syscall(__NR_io_uring_enter, batch->ring->fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+  if (rc < 0 && errno != EINTR) {
+    sched_yield();
+  }
+  batch_reap(batch);
+}
+
+void *blosc2_stdio_uring_submit(void *stream, const blosc2_io_segment *segments, int64_t nsegments) {
+  blosc2_stdio_uring *my_fp = (blosc2_stdio_uring *) stream;
+  uring_pool *pool = (uring_pool *) my_fp->rings;
+  if (nsegments <= 0) {
+    return NULL;
+  }
+
+  uring *ring = NULL;
+  pthread_mutex_lock(&pool->mutex);
+  if (pool->free_rings != NULL) {
+    ring = pool->free_rings;
+    pool->free_rings = ring->next;
+  }
+  else if (!pool->unavailable) {
+    ring = uring_new();
+    if (ring == NULL) {
+      pool->unavailable = true;
+    }
+  }
+  pthread_mutex_unlock(&pool->mutex);
+  if (ring == NULL) {
+    return NULL;
+  }
+
+  uring_batch *batch = calloc(1, sizeof(uring_batch));
+  if (batch != NULL) {
+    batch->segments = malloc(nsegments * sizeof(blosc2_io_segment));
+    batch->iovecs = malloc(nsegments * sizeof(struct iovec));
+    batch->results = malloc(nsegments * sizeof(int64_t));
+    batch->states = calloc(nsegments, sizeof(uint8_t));
+  }
+  if (batch == NULL || batch->segments == NULL || batch->iovecs == NULL ||
+      batch->results == NULL || batch->states == NULL) {
+    // Give the ring back; the caller reads the segments on demand instead
+    pthread_mutex_lock(&pool->mutex);
+    ring->next = pool->free_rings;
+    pool->free_rings = ring;
+    pthread_mutex_unlock(&pool->mutex);
+    if (batch != NULL) {
+      free(batch->segments);
+      free(batch->iovecs);
+      free(batch->results);
+      free(batch->states);
+      free(batch);
+    }
+    return NULL;
+  }
+  batch->stream = my_fp;
+  batch->ring = ring;
+  batch->nsegments = nsegments;
+  memcpy(batch->segments, segments, nsegments * sizeof(blosc2_io_segment));
+  pthread_mutex_init(&batch->mutex, NULL);
+
+  pthread_mutex_lock(&batch->mutex);
+  batch_push(batch);
+  pthread_mutex_unlock(&batch->mutex);
+
+  return batch;
+}
+
+int64_t blosc2_stdio_uring_wait(void *batch_, int64_t nsegment) {
+  uring_batch *batch = (uring_batch *) batch_;
+  if (nsegment < 0 || nsegment >= batch->nsegments) {
+    return -1;
+  }
+  blosc2_io_segment *segment = &batch->segments[nsegment];
+
+  pthread_mutex_lock(&batch->mutex);
+  while (batch->states[nsegment] != SEGMENT_DONE) {
+    if (batch->states[nsegment] == SEGMENT_QUEUED && batch->broken) {
+      batch->results[nsegment] = pread_full(batch->stream->fd, segment->ptr, segment->size,
+                                            segment->offset);
+      batch->states[nsegment] = SEGMENT_DONE;
+      break;
+    }
+    batch_wait_one(batch);
+    if (!batch->broken) {
+      // Keep the ring full
+      batch_push(batch);
+    }
+  }
+  int64_t rbytes = batch->results[nsegment];
+  if (rbytes < 0 || rbytes < segment->size) {
+    // Errors (e.g. the kernel not supporting the operation) and short reads are retried synchronously
+    int64_t done = rbytes < 0 ? 0 : rbytes;
+    int64_t rbytes_ = pread_full(batch->stream->fd, (uint8_t *) segment->ptr + done,
+                                 segment->size - done, segment->offset + done);
+    rbytes = rbytes_ < 0 ? (done > 0 ? done : -1) : done + rbytes_;
+    batch->results[nsegment] = rbytes;
+  }
+  pthread_mutex_unlock(&batch->mutex);
+
+  return rbytes;
+}
+
+void blosc2_stdio_uring_release(void *batch_) {
+  uring_batch *batch = (uring_batch *) batch_;
+  if (batch == NULL) {
+    return;
+  }
+  // The buffers cannot be freed while the kernel may still write into them
+  pthread_mutex_lock(&batch->mutex);
+  while (batch->ninflight > 0) {
+    batch_wait_one(batch);
+  }
+  pthread_mutex_unlock(&batch->mutex);
+  pthread_mutex_destroy(&batch->mutex);
+
+  uring_pool *pool = (uring_pool *) batch->stream->rings;
+  pthread_mutex_lock(&pool->mutex);
+  batch->ring->next = pool->free_rings;
+  pool->free_rings = batch->ring;
+  pthread_mutex_unlock(&pool->mutex);
+
+  free(batch->segments);
+  free(batch->iovecs);
+  free(batch->results);
+  free(batch->states);
+  free(batch);
+}
+
+static void *uring_pool_new(void) {
+  uring_pool *pool = calloc(1, sizeof(uring_pool));
+  pthread_mutex_init(&pool->mutex, NULL);
+  return pool;
+}
+
+static void uring_pool_free(void *pool_) {
+  uring_pool *pool = (uring_pool *) pool_;
+  while (pool->free_rings != NULL) {
+    uring *ring = pool->free_rings;
+    pool->free_rings = ring->next;
+    uring_free(ring);
+  }
+  pthread_mutex_destroy(&pool->mutex);
+  free(pool);
+}
+
+#else  // HAVE_IO_URING
+
+/* No io_uring here; the reads are done with pread() */
+
+void *blosc2_stdio_uring_submit(void *stream, const blosc2_io_segment *segments, int64_t nsegments) {
+  return NULL;
+}
+
+int64_t blosc2_stdio_uring_wait(void *batch, int64_t nsegment) {
+  return -1;
+}
+
+void blosc2_stdio_uring_release(void *batch) {
+}
+
+static void *uring_pool_new(void) {
+  return NULL;
+}
+
+static void uring_pool_free(void *pool) {
+}
+
+#endif  // HAVE_IO_URING
+
+void *blosc2_stdio_uring_open(const char *urlpath, const char *mode, void *params) {
+  int flags = open_flags(mode);
+  if (flags < 0) {
+    return NULL;
+  }
+  int fd = open(urlpath, flags, 0666);
+  if (fd < 0) {
+    return NULL;
+  }
+  blosc2_stdio_uring *my_fp = calloc(1, sizeof(blosc2_stdio_uring));
+  my_fp->fd = fd;
+  if (mode[0] == 'a') {
+    my_fp->pos = lseek(fd, 0, SEEK_END);
+  }
+  // The rings are set up on the first batch of reads
+  my_fp->rings = uring_pool_new();
+  return my_fp;
+}
+
+int blosc2_stdio_uring_close(void *stream) {
+  blosc2_stdio_uring *my_fp = (blosc2_stdio_uring *) stream;
+  uring_pool_free(my_fp->rings);
+  int err = close(my_fp->fd);
+  free(my_fp);
+  return err;
+}
+
+int64_t blosc2_stdio_uring_tell(void *stream) {
+  blosc2_stdio_uring *my_fp = (blosc2_stdio_uring *) stream;
+  return my_fp->pos;
+}
+
+int blosc2_stdio_uring_seek(void *stream, int64_t offset, int whence) {
+  blosc2_stdio_uring *my_fp = (blosc2_stdio_uring *) stream;
+  int64_t pos;
+  switch (whence) {
+    case SEEK_SET:
+      pos = offset;
+      break;
+    case SEEK_CUR:
+      pos = my_fp->pos + offset;
+      break;
+    case SEEK_END: {
+      struct stat st;
+      if (fstat(my_fp->fd, &st) < 0) {
+        return -1;
+      }
+      pos = st.st_size + offset;
+      break;
+    }
+    default:
+      return -1;
+  }
+  if (pos < 0) {
+    return -1;
+  }
+  my_fp->pos = pos;
+  return 0;
+}
+
+int64_t blosc2_stdio_uring_write(const void *ptr, int64_t size, int64_t nitems, void *stream) {
+  blosc2_stdio_uring *my_fp = (blosc2_stdio_uring *) stream;
+  int64_t written = pwrite_full(my_fp->fd, ptr, size * nitems, my_fp->pos);
+  my_fp->pos += written;
+  return size > 0 ? written / size : 0;
+}
+
+int64_t blosc2_stdio_uring_read(void *ptr, int64_t size, int64_t nitems, void *stream) {
+  blosc2_stdio_uring *my_fp = (blosc2_stdio_uring *) stream;
+  if (size <= 0) {
+    return 0;
+  }
+  int64_t rbytes = pread_full(my_fp->fd, ptr, size * nitems, my_fp->pos);
+  if (rbytes < 0) {
+    return 0;
+  }
+  rbytes -= rbytes % size;
+  my_fp->pos += rbytes;
+  return rbytes / size;
+}
+
+int blosc2_stdio_uring_truncate(void *stream, int64_t size) {
+  blosc2_stdio_uring *my_fp = (blosc2_stdio_uring *) stream;
+  return ftruncate(my_fp->fd, size);
+}
+
+int64_t blosc2_stdio_uring_read_at(void *stream, int64_t offset, int64_t size, void *ptr) {
+  blosc2_stdio_uring *my_fp = (blosc2_stdio_uring *) stream;
+  if (offset < 0 || size < 0) {
+    return -1;
+  }
+  return pread_full(my_fp->fd, ptr, size, offset);
+}
+
+int64_t blosc2_stdio_uring_readv_at(void *stream, const blosc2_io_segment *segments, int64_t nsegments) {
+  blosc2_stdio_uring *my_fp = (blosc2_stdio_uring *) stream;
+  for (int64_t i = 0; i < nsegments; i++) {
+    if (segments[i].offset < 0 || segments[i].size < 0) {
+      return -1;
+    }
+  }
+  void *batch = blosc2_stdio_uring_submit(stream, segments, nsegments);
+  if (batch == NULL) {
+    return preadv_full(my_fp->fd, segments, nsegments);
+  }
+  int64_t total = 0;
+  for (int64_t i = 0; i < nsegments; i++) {
+    int64_t rbytes = blosc2_stdio_uring_wait(batch, i);
+    if (rbytes < 0) {
+      total = -1;
+      break;
+    }
+    total += rbytes;
+    if (rbytes < segments[i].size) {
+      break;
+    }
+  }
+  blosc2_stdio_uring_release(batch);
+  return total;
+}
+
+#else  // _WIN32
+
+/* No positional reads here; just forward to the stdio backend */
+
+void *blosc2_stdio_uring_open(const char *urlpath, const char *mode, void *params) {
+  void *file = blosc2_stdio_open(urlpath, mode, params);
+  if (file == NULL) {
+    return NULL;
+  }
+  blosc2_stdio_uring *my_fp = calloc(1, sizeof(blosc2_stdio_uring));
+  my_fp->file = file;
+  return my_fp;
+}
+
+int blosc2_stdio_uring_close(void *stream) {
+  blosc2_stdio_uring *my_fp = (blosc2_stdio_uring *) stream;
+  int err = blosc2_stdio_close(my_fp->file);
+  free(my_fp);
+  return err;
+}
+
+int64_t blosc2_stdio_uring_tell(void *stream) {
+  return blosc2_stdio_tell(((blosc2_stdio_uring *) stream)->file);
+}
+
+int blosc2_stdio_uring_seek(void *stream, int64_t offset, int whence) {
+  return blosc2_stdio_seek(((blosc2_stdio_uring *) stream)->file, offset, whence);
+}
+
+int64_t blosc2_stdio_uring_write(const void *ptr, int64_t size, int64_t nitems, void *stream) {
+  return blosc2_stdio_write(ptr, size, nitems, ((blosc2_stdio_uring *) stream)->file);
+}
+
+int64_t blosc2_stdio_uring_read(void *ptr, int64_t size, int64_t nitems, void *stream) {
+  return blosc2_stdio_read(ptr, size, nitems, ((blosc2_stdio_uring *) stream)->file);
+}
+
+int blosc2_stdio_uring_truncate(void *stream, int64_t size) {
+  return blosc2_stdio_truncate(((blosc2_stdio_uring *) stream)->file, size);
+}
+
+int64_t blosc2_stdio_uring_read_at(void *stream, int64_t offset, int64_t size, void *ptr) {
+  return blosc2_stdio_read_at(((blosc2_stdio_uring *) stream)->file, offset, size, ptr);
+}
+
+int64_t blosc2_stdio_uring_readv_at(void *stream, const blosc2_io_segment *segments, int64_t nsegments) {
+  return blosc2_stdio_readv_at(((blosc2_stdio_uring *) stream)->file, segments, nsegments);
+}
+
+void *blosc2_stdio_uring_submit(void *stream, const blosc2_io_segment *segments, int64_t nsegments) {
+  return NULL;
+}
+
+int64_t blosc2_stdio_uring_wait(void *batch, int64_t nsegment) {
+  return -1;
+}
+
+void blosc2_stdio_uring_release(void *batch) {
+}
+
+#endif  // _WIN32
+
+
+/* The direct I/O backend.  Files are read with O_DIRECT, which requires the offsets, sizes
+ * and buffers to be aligned (to the logical block size of the device), so ranges that are
+ * not are read in aligned buffers (taken from a small pool) and then copied.  Writes go
+ * through the page cache with a separate descriptor, as frames are written in small pieces. */
+#if !defined(_WIN32)
+
+#include <errno.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#define DIRECT_ALIGNMENT 4096
+#define DIRECT_BUFFER_SIZE (1024 * 1024)
+#define DIRECT_POOL_SIZE 4  // the maximum number of free buffers kept per file
+
+typedef struct direct_buffer_s {
+  void *ptr;
+  struct direct_buffer_s *next;
+} direct_buffer;
+
+typedef struct {
+  pthread_mutex_t mutex;
+  direct_buffer *free_buffers;
+  int nfree;
+} direct_pool;
+
+static direct_buffer *direct_buffer_get(blosc2_stdio_direct *my_fp) {
+  direct_pool *pool = (direct_pool *) my_fp->buffers;
+  pthread_mutex_lock(&pool->mutex);
+  direct_buffer *buffer = pool->free_buffers;
+  if (buffer != NULL) {
+    pool->free_buffers = buffer->next;
+    pool->nfree--;
+  }
+  pthread_mutex_unlock(&pool->mutex);
+  if (buffer != NULL) {
+    return buffer;
+  }
+  buffer = malloc(sizeof(direct_buffer));
+  if (buffer == NULL) {
+    return NULL;
+  }
+  if (posix_memalign(&buffer->ptr, (size_t) my_fp->alignment, (size_t) my_fp->buffer_size) != 0) {
+    free(buffer);
+    return NULL;
+  }
+  return buffer;
+}
+
+static void direct_buffer_put(blosc2_stdio_direct *my_fp, direct_buffer *buffer) {
+  direct_pool *pool = (direct_pool *) my_fp->buffers;
+  pthread_mutex_lock(&pool->mutex);
+  if (pool->nfree < DIRECT_POOL_SIZE) {
+    buffer->next = pool->free_buffers;
+    pool->free_buffers = buffer;
+    pool->nfree++;
+    buffer = NULL;
+  }
+  pthread_mutex_unlock(&pool->mutex);
+  if (buffer != NULL) {
+    free(buffer->ptr);
+    free(buffer);
+  }
+}
+
+/* Open the descriptor for reading, bypassing the page cache if the filesystem allows it */
+static int direct_open_read(const char *urlpath, int *direct) {
+  int fd;
+#if defined(O_DIRECT)
+  fd = open(urlpath, O_RDONLY | O_DIRECT);
+  if (fd >= 0) {
+    *direct = 1;
+    return fd;
+  }
+  if (errno != EINVAL) {
+    return -1;
+  }
+  // E.g. tmpfs; fall back to regular reads
+#endif
+  *direct = 0;
+  fd = open(urlpath, O_RDONLY);
+#if defined(__APPLE__)
+  // macOS has no O_DIRECT, but the data of reads of uncached descriptors is not kept in the cache
+  // (and there are no alignment requirements)
+  if (fd >= 0) {
+    fcntl(fd, F_NOCACHE, 1);
+  }
+#endif
+  return fd;
+}
+
+void *blosc2_stdio_direct_open(const char *urlpath, const char *mode, void *params) {
+  int flags = open_flags(mode);
+  if (flags < 0) {
+    return NULL;
+  }
+  // Writable files are opened (and maybe created) for writing first
+  int wfd = -1;
+  if (flags != O_RDONLY) {
+    wfd = open(urlpath, flags, 0666);
+    if (wfd < 0) {
+      return NULL;
+    }
+  }
+  int direct;
+  int fd = direct_open_read(urlpath, &direct);
+  if (fd < 0) {
+    if (wfd >= 0) {
+      close(wfd);
+    }
+    return NULL;
+  }
+  blosc2_stdio_direct *my_fp = calloc(1, sizeof(blosc2_stdio_direct));
+  my_fp->fd = fd;
+  my_fp->wfd = wfd;
+  my_fp->direct = direct;
+  my_fp->alignment = DIRECT_ALIGNMENT;
+  my_fp->buffer_size = DIRECT_BUFFER_SIZE;
+  if (params != NULL) {
+    blosc2_stdio_direct_params *direct_params = (blosc2_stdio_direct_params *) params;
+    // The alignment has to be a power of 2 (and a multiple of the size of a pointer)
+    int32_t alignment = direct_params->alignment;
+    if (alignment >= (int32_t) sizeof(void *) && (alignment & (alignment - 1)) == 0) {
+      my_fp->alignment = alignment;
+    }
+    if (direct_params->buffer_size > 0) {
+      my_fp->buffer_size = direct_params->buffer_size;
+    }
+  }
+  // The buffers have room for whole aligned blocks
+  my_fp->buffer_size = (my_fp->buffer_size + my_fp->alignment - 1) & ~(my_fp->alignment - 1);
+  if (mode[0] == 'a') {
+    my_fp->pos = lseek(fd, 0, SEEK_END);
+  }
+  direct_pool *pool = calloc(1, sizeof(direct_pool));
+  pthread_mutex_init(&pool->mutex, NULL);
+  my_fp->buffers = pool;
+  return my_fp;
+}
+
+int blosc2_stdio_direct_close(void *stream) {
+  blosc2_stdio_direct *my_fp = (blosc2_stdio_direct *) stream;
+  direct_pool *pool = (direct_pool *) my_fp->buffers;
+  while (pool->free_buffers != NULL) {
+    direct_buffer *buffer = pool->free_buffers;
+    pool->free_buffers = buffer->next;
+    free(buffer->ptr);
+    free(buffer);
+  }
+  pthread_mutex_destroy(&pool->mutex);
+  free(pool);
+  int err = close(my_fp->fd);
+  if (my_fp->wfd >= 0 && close(my_fp->wfd) != 0) {
+    err = -1;
+  }
+  free(my_fp);
+  return err;
+}
+
+int64_t blosc2_stdio_direct_tell(void *stream) {
+  blosc2_stdio_direct *my_fp = (blosc2_stdio_direct *) stream;
+  return my_fp->pos;
+}
+
+int blosc2_stdio_direct_seek(void *stream, int64_t offset, int whence) {
+  blosc2_stdio_direct *my_fp = (blosc2_stdio_direct *) stream;
+  int64_t pos;
+  switch (whence) {
+    case SEEK_SET:
+      pos = offset;
+      break;
+    case SEEK_CUR:
+      pos = my_fp->pos + offset;
+      break;
+    case SEEK_END: {
+      struct stat st;
+      if (fstat(my_fp->fd, &st) < 0) {
+        return -1;
+      }
+      pos = st.st_size + offset;
+      break;
+    }
+    default:
+      return -1;
+  }
+  if (pos < 0) {
+    return -1;
+  }
+  my_fp->pos = pos;
+  return 0;
+}
+
+int64_t blosc2_stdio_direct_write(const void *ptr, int64_t size, int64_t nitems, void *stream) {
+  blosc2_stdio_direct *my_fp = (blosc2_stdio_direct *) stream;
+  if (my_fp->wfd < 0) {
+    return 0;
+  }
+  int64_t written = pwrite_full(my_fp->wfd, ptr, size * nitems, my_fp->pos);
+  my_fp->pos += written;
+  return size > 0 ? written / size : 0;
+}
+
+int64_t blosc2_stdio_direct_read(void *ptr, int64_t size, int64_t nitems, void *stream) {
+  blosc2_stdio_direct *my_fp = (blosc2_stdio_direct *) stream;
+  if (size <= 0) {
+    return 0;
+  }
+  int64_t rbytes = blosc2_stdio_direct_read_at(stream, my_fp->pos, size * nitems, ptr);
+  if (rbytes < 0) {
+    return 0;
+  }
+  rbytes -= rbytes % size;
+  my_fp->pos += rbytes;
+  return rbytes / size;
+}
+
+int blosc2_stdio_direct_truncate(void *stream, int64_t size) {
+  blosc2_stdio_direct *my_fp = (blosc2_stdio_direct *) stream;
+  if (my_fp->wfd < 0) {
+    return -1;
+  }
+  return ftruncate(my_fp->wfd, size);
+}
+
+int64_t blosc2_stdio_direct_read_at(void *stream, int64_t offset, int64_t size, void *ptr) {
+  blosc2_stdio_direct *my_fp = (blosc2_stdio_direct *) stream;
+  if (offset < 0 || size < 0) {
+    return -1;
+  }
+  if (!my_fp->direct) {
+    int64_t rbytes = pread_full(my_fp->fd, ptr, size, offset);
+#if defined(POSIX_FADV_DONTNEED)
+    if (rbytes > 0) {
+      posix_fadvise(my_fp->fd, (off_t) offset, (off_t) rbytes, POSIX_FADV_DONTNEED);
+    }
+#endif
+    return rbytes;
+  }
+
+  int64_t align = my_fp->alignment;
+  int64_t rbytes = 0;
+  while (rbytes < size) {
+    uint8_t *dest = (uint8_t *) ptr + rbytes;
+    int64_t start = offset + rbytes;
+    int64_t padding = start & (align - 1);
+    if (padding == 0 && ((uintptr_t) dest & (uintptr_t) (align - 1)) == 0 && size - rbytes >= align) {
+      // Everything is aligned, so read straight into the destination
+      int64_t nbytes = (size - rbytes) & ~(align - 1);
+      int64_t rbytes_ = pread_full(my_fp->fd, dest, nbytes, start);
+      if (rbytes_ < 0) {
+        return rbytes > 0 ? rbytes : -1;
+      }
+      rbytes += rbytes_;
+      if (rbytes_ < nbytes) {
+        break;  // end of file
+      }
+      continue;
+    }
+    // Read the aligned blocks around the range in a buffer
+    direct_buffer *buffer = direct_buffer_get(my_fp);
+    if (buffer == NULL) {
+      return rbytes > 0 ? rbytes : -1;
+    }
+    int64_t nbytes = size - rbytes;
+    if (nbytes > my_fp->buffer_size - padding) {
+      nbytes = my_fp->buffer_size - padding;
+    }
+    int64_t aligned_size = (padding + nbytes + align - 1) & ~(align - 1);
+    int64_t rbytes_ = pread_full(my_fp->fd, buffer->ptr, aligned_size, start - padding);
+    if (rbytes_ < 0) {
+      direct_buffer_put(my_fp, buffer);
+      return rbytes > 0 ? rbytes : -1;
+    }
+    rbytes_ -= padding;
+    if (rbytes_ > nbytes) {
+      rbytes_ = nbytes;
+    }
+    if (rbytes_ > 0) {
+      memcpy(dest, (uint8_t *) buffer->ptr + padding, (size_t) rbytes_);
+      rbytes += rbytes_;
+    }
+    direct_buffer_put(my_fp, buffer);
+    if (rbytes_ < nbytes) {
+      break;  // end of file
+    }
+  }
+  return rbytes;
+}
+
+int64_t blosc2_stdio_direct_readv_at(void *stream, const blosc2_io_segment *segments, int64_t nsegments) {
+  int64_t total = 0;
+  for (int64_t i = 0; i < nsegments; i++) {
+    int64_t rbytes = blosc2_stdio_direct_read_at(stream, segments[i].offset, segments[i].size, segments[i].ptr);
+    if (rbytes < 0) {
+      return -1;
+    }
+    total += rbytes;
+    if (rbytes < segments[i].size) {
+      break;
+    }
+  }
+  return total;
+}
+
+#else  // _WIN32
+
+/* No direct reads here; just forward to the stdio backend */
+
+void *blosc2_stdio_direct_open(const char *urlpath, const char *mode, void *params) {
+  void *file = blosc2_stdio_open(urlpath, mode, NULL);
+  if (file == NULL) {
+    return NULL;
+  }
+  blosc2_stdio_direct *my_fp = calloc(1, sizeof(blosc2_stdio_direct));
+  my_fp->file = file;
+  return my_fp;
+}
+
+int blosc2_stdio_direct_close(void *stream) {
+  blosc2_stdio_direct *my_fp = (blosc2_stdio_direct *) stream;
+  int err = blosc2_stdio_close(my_fp->file);
+  free(my_fp);
+  return err;
+}
+
+int64_t blosc2_stdio_direct_tell(void *stream) {
+  return blosc2_stdio_tell(((blosc2_stdio_direct *) stream)->file);
+}
+
+int blosc2_stdio_direct_seek(void *stream, int64_t offset, int whence) {
+  return blosc2_stdio_seek(((blosc2_stdio_direct *) stream)->file, offset, whence);
+}
+
+int64_t blosc2_stdio_direct_write(const void *ptr, int64_t size, int64_t nitems, void *stream) {
+  return blosc2_stdio_write(ptr, size, nitems, ((blosc2_stdio_direct *) stream)->file);
+}
+
+int64_t blosc2_stdio_direct_read(void *ptr, int64_t size, int64_t nitems, void *stream) {
+  return blosc2_stdio_read(ptr, size, nitems, ((blosc2_stdio_direct *) stream)->file);
+}
+
+int blosc2_stdio_direct_truncate(void *stream, int64_t size) {
+  return blosc2_stdio_truncate(((blosc2_stdio_direct *) stream)->file, size);
+}
+
+int64_t blosc2_stdio_direct_read_at(void *stream, int64_t offset, int64_t size, void *ptr) {
+  return blosc2_stdio_read_at(((blosc2_stdio_direct *) stream)->file, offset, size, ptr);
+}
+
+int64_t blosc2_stdio_direct_readv_at(void *stream, const blosc2_io_segment *segments, int64_t nsegments) {
+  return blosc2_stdio_readv_at(((blosc2_stdio_direct *) stream)->file, segments, nsegments);
+}
+
+#endif  // _WIN32
@@ -60,25 +60,73 @@
   #include <malloc.h>
   #include <process.h>
   #define getpid _getpid
+#else
+  #include <unistd.h>
 #endif  /* _WIN32 */
 
 #if defined(_WIN32) && !defined(__GNUC__)
   #include "win32/pthread.c"
 #endif
 
+/* Atomic counters and flags shared by the threads */
+#if defined(_MSC_VER)
+  #include <intrin.h>
+  #define ATOMIC_FETCH_ADD(ptr, value) _InterlockedExchangeAdd((volatile long*)(ptr), (value))
+  #define ATOMIC_SUB_FETCH(ptr, value) (_InterlockedExchangeAdd((volatile long*)(ptr), -(value)) - (value))
+  #define ATOMIC_LOAD(ptr) _InterlockedOr((volatile long*)(ptr), 0)
+  #define ATOMIC_STORE(ptr, value) _InterlockedExchange((volatile long*)(ptr), (value))
+#else
+  #define ATOMIC_FETCH_ADD(ptr, value) __atomic_fetch_add((ptr), (value), __ATOMIC_RELAXED)
+  #define ATOMIC_SUB_FETCH(ptr, value) __atomic_sub_fetch((ptr), (value), __ATOMIC_ACQ_REL)
+  #define ATOMIC_LOAD(ptr) __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+  #define ATOMIC_STORE(ptr, value) __atomic_store_n((ptr), (value), __ATOMIC_RELEASE)
+#endif
+/* Be nice to the other hardware thread of the core while spinning */
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  #define CPU_RELAX() _mm_pause()
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  #define CPU_RELAX() __builtin_ia32_pause()
+#elif defined(__GNUC__) && defined(__aarch64__)
+  #define CPU_RELAX() __asm__ __volatile__("yield")
+#else
+  #define CPU_RELAX()
+#endif
+
 /* Synchronization variables */
 
-/* Global context for non-contextual API */
-static blosc2_context* g_global_context;
+/* Contexts for the non-contextual API.  Every call takes an idle one (or
+   creates it), so that callers in different threads never wait for each other;
+   the mutex only guards the list of idle contexts. */
+static blosc2_context* g_global_contexts = NULL;
+static int g_global_nidle = 0;           /* the idle contexts */
+static int g_global_nidle_threads = 0;   /* the idle contexts with threads of their own */
+/* The idle contexts kept for later calls; the ones released beyond these are freed */
+#define GLOBAL_CONTEXTS_MAX_IDLE 16
 static pthread_mutex_t global_comp_mutex;
 static int g_compressor = BLOSC_BLOSCLZ;
 static int g_delta = 0;
 /* the compressor to use by default */
 static int16_t g_nthreads = 1;
+static int32_t g_parallel_min_nbytes = BLOSC2_PARALLEL_MIN_NBYTES;
 static int32_t g_force_blocksize = 0;
 static int g_initlib = 0;
 static blosc2_schunk* g_schunk = NULL;   /* the pointer to super-chunk */
 
+/* The environment variables for the non-contextual API, read by blosc_init() */
+typedef struct {
+  int clevel;          /* BLOSC_CLEVEL (-1 if not set) */
+  int doshuffle;       /* BLOSC_SHUFFLE (-1 if not set) */
+  int delta;           /* BLOSC_DELTA (-1 if not set) */
+  int32_t typesize;    /* BLOSC_TYPESIZE (0 if not set) */
+  int compcode;        /* BLOSC_COMPRESSOR (-1 if not set, -2 if not supported) */
+  int32_t blocksize;   /* BLOSC_BLOCKSIZE (0 if not set) */
+  int16_t nthreads;    /* BLOSC_NTHREADS (0 if not set) */
+  bool blosc1_compat;  /* BLOSC_BLOSC1_COMPAT */
+  int warnlvl;         /* BLOSC_WARN */
+} blosc_env;
+
+static blosc_env g_env;
+
 blosc2_codec g_codecs[256] = {0};
 uint8_t g_ncodecs = 0;
 
@@ -93,51 +141,99 @@ static uint64_t g_nio = 0;
 int init_threadpool(blosc2_context *context);
 int release_threadpool(blosc2_context *context);
 
-/* Macros for synchronization */
+/* Handing jobs off to the threads of a context */
 
-/* Wait until all threads are initialized */
-#ifdef BLOSC_POSIX_BARRIERS
-#define WAIT_INIT(RET_VAL, CONTEXT_PTR)  \
-  rc = pthread_barrier_wait(&(CONTEXT_PTR)->barr_init); \
-  if (rc != 0 && rc != PTHREAD_BARRIER_SERIAL_THREAD) { \
-    BLOSC_TRACE_ERROR("Could not wait on barrier (init): %d", rc); \
-    return((RET_VAL));                            \
-  }
+/* The time to spin waiting for a job (or for the end of one) before parking the
+ * thread: jobs of small chunks often come one right after the other, but an idle
+ * thread should not keep the core busy for long */
+#define HANDOFF_SPIN_NSECS 5000
+/* The spins between checks of the clock */
+#define HANDOFF_SPIN_CHECKS 16
+
+static int32_t handoff_spin_nsecs(void) {
+  /* On a single core, spinning only delays the thread that is being waited for */
+#if defined(_WIN32)
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return info.dwNumberOfProcessors > 1 ? HANDOFF_SPIN_NSECS : 0;
+#elif defined(_SC_NPROCESSORS_ONLN)
+  return sysconf(_SC_NPROCESSORS_ONLN) > 1 ? HANDOFF_SPIN_NSECS : 0;
 #else
-#define WAIT_INIT(RET_VAL, CONTEXT_PTR)   \
-  pthread_mutex_lock(&(CONTEXT_PTR)->count_threads_mutex); \
-  if ((CONTEXT_PTR)->count_threads < (CONTEXT_PTR)->nthreads) { \
-    (CONTEXT_PTR)->count_threads++;  \
-    pthread_cond_wait(&(CONTEXT_PTR)->count_threads_cv, \
-                      &(CONTEXT_PTR)->count_threads_mutex); \
-  } \
-  else { \
-    pthread_cond_broadcast(&(CONTEXT_PTR)->count_threads_cv); \
-  } \
-  pthread_mutex_unlock(&(CONTEXT_PTR)->count_threads_mutex);
+  return HANDOFF_SPIN_NSECS;
 #endif
+}
 
-/* Wait for all threads to finish */
-#ifdef BLOSC_POSIX_BARRIERS
-#define WAIT_FINISH(RET_VAL, CONTEXT_PTR)   \
-  rc = pthread_barrier_wait(&(CONTEXT_PTR)->barr_finish); \
-  if (rc != 0 && rc != PTHREAD_BARRIER_SERIAL_THREAD) { \
-    BLOSC_TRACE_ERROR("Could not wait on barrier (finish)"); \
-    return((RET_VAL));                              \
+/* Whether to spin once more after `i` spins since `start` */
+static bool keep_spinning(blosc2_context* context, int32_t i, blosc_timestamp_t* start) {
+  if (context->spin_nsecs == 0) {
+    return false;
   }
-#else
-#define WAIT_FINISH(RET_VAL, CONTEXT_PTR)                           \
-  pthread_mutex_lock(&(CONTEXT_PTR)->count_threads_mutex); \
-  if ((CONTEXT_PTR)->count_threads > 0) { \
-    (CONTEXT_PTR)->count_threads--; \
-    pthread_cond_wait(&(CONTEXT_PTR)->count_threads_cv, \
-                      &(CONTEXT_PTR)->count_threads_mutex); \
-  } \
-  else { \
-    pthread_cond_broadcast(&(CONTEXT_PTR)->count_threads_cv); \
-  } \
-  pthread_mutex_unlock(&(CONTEXT_PTR)->count_threads_mutex);
-#endif
+  if (i == 0) {
+    blosc_set_timestamp(start);
+    return true;
+  }
+  if (i % HANDOFF_SPIN_CHECKS != 0) {
+    return true;
+  }
+  blosc_timestamp_t now;
+  blosc_set_timestamp(&now);
+  return blosc_elapsed_nsecs(*start, now) < context->spin_nsecs;
+}
+
+/* Hand the current job off to a thread (or tell it to finish) */
+static void handoff_job(blosc2_context* context, blosc_handoff* handoff) {
+  ATOMIC_STORE(&handoff->job_id, handoff->job_id + 1);
+  pthread_mutex_lock(&context->handoff_mutex);
+  if (handoff->parked) {
+    pthread_cond_signal(&handoff->cv);
+  }
+  pthread_mutex_unlock(&context->handoff_mutex);
+}
+
+/* Wait for a job after job_id, spinning for a while and then parking */
+static void wait_handoff(blosc2_context* context, blosc_handoff* handoff, int32_t job_id) {
+  blosc_timestamp_t start;
+  for (int32_t i = 0; ATOMIC_LOAD(&handoff->job_id) == job_id && keep_spinning(context, i, &start); i++) {
+    CPU_RELAX();
+  }
+  if (ATOMIC_LOAD(&handoff->job_id) == job_id) {
+    pthread_mutex_lock(&context->handoff_mutex);
+    handoff->parked = true;
+    while (ATOMIC_LOAD(&handoff->job_id) == job_id) {
+      pthread_cond_wait(&handoff->cv, &context->handoff_mutex);
+    }
+    handoff->parked = false;
+    pthread_mutex_unlock(&context->handoff_mutex);
+  }
+}
+
+/* Wait for the threads taking part in the current job, spinning for a while and then parking */
+static void wait_job_done(blosc2_context* context) {
+  blosc_timestamp_t start;
+  for (int32_t i = 0; ATOMIC_LOAD(&context->ntasks_left) > 0 && keep_spinning(context, i, &start); i++) {
+    CPU_RELAX();
+  }
+  if (ATOMIC_LOAD(&context->ntasks_left) > 0) {
+    pthread_mutex_lock(&context->handoff_mutex);
+    context->caller_parked = true;
+    while (ATOMIC_LOAD(&context->ntasks_left) > 0) {
+      pthread_cond_wait(&context->done_cv, &context->handoff_mutex);
+    }
+    context->caller_parked = false;
+    pthread_mutex_unlock(&context->handoff_mutex);
+  }
+}
+
+/* Tell the caller that a thread is done with the current job */
+static void job_task_done(blosc2_context* context) {
+  if (ATOMIC_SUB_FETCH(&context->ntasks_left, 1) == 0) {
+    pthread_mutex_lock(&context->handoff_mutex);
+    if (context->caller_parked) {
+      pthread_cond_signal(&context->done_cv);
+    }
+    pthread_mutex_unlock(&context->handoff_mutex);
+  }
+}
 
 
 /* global variable to change threading backend from Blosc-managed to caller-managed */
@@ -153,6 +249,30 @@ void blosc_set_threads_callback(blosc_threads_callback callback, void *callback_
 }
 
 
+/* The pool of threads shared by every context (see blosc2_set_shared_nthreads) */
+typedef struct shared_job_s {
+  blosc2_context* context;
+  int16_t ntasks;        /* one per thread of the context */
+  int16_t next_task;     /* the next task to be claimed */
+  int16_t ndone;         /* the number of finished tasks */
+  struct shared_job_s* next;
+} shared_job;
+
+typedef struct {
+  int16_t nthreads;
+  pthread_t* threads;
+  struct thread_context* thread_contexts;  /* one per worker, for any context */
+  shared_job* jobs;      /* the jobs with tasks left to be claimed, oldest first */
+  bool end_threads;
+  pthread_mutex_t mutex;
+  pthread_cond_t jobs_cv;  /* signaled when there are new jobs */
+  pthread_cond_t done_cv;  /* signaled when the tasks of a job are done */
+} shared_pool;
+
+static shared_pool* g_shared_pool = NULL;
+static int16_t g_shared_nthreads = 0;
+
+
 /* A function for aligned malloc that is portable */
 static uint8_t* my_malloc(size_t size) {
   void* block = NULL;
@@ -1170,8 +1290,8 @@ int pipeline_backward(struct thread_context* thread_context, const int32_t bsize
           }
           break;
         case BLOSC_DELTA:
-          if (context->nthreads == 1) {
-            /* Serial mode */
+          if (context->nthreads == 1 || context->getitem_dest != NULL) {
+            /* Serial mode (getitem does DELTA chunks serially too) */
             delta_decoder(dest, offset, bsize, typesize, _dest);
           } else {
             /* Force the thread in charge of the block 0 to go first */
@@ -1352,6 +1472,70 @@ static int32_t set_values(int32_t typesize, const uint8_t* src, uint8_t* dest, i
 }
 
 
+/* The state of the segments of lazy chunks that have not been read yet */
+#define LAZY_UNREAD INT64_MIN
+#define LAZY_READING (INT64_MIN + 1)
+
+/* Read a segment of the lazy chunk being decompressed, unless another thread has already
+ * done it (or is doing it).  Returns the number of bytes read, or a negative value on errors. */
+static int64_t lazy_read_segment(blosc2_context* context, int32_t nsegment) {
+  if (context->lazy_batch != NULL) {
+    // The read was submitted together with the rest of the chunk
+    return blosc2_stdio_uring_wait(context->lazy_batch, nsegment);
+  }
+  int64_t* rbytes = &context->lazy_rbytes[nsegment];
+  if (context->nthreads > 1) {
+    pthread_mutex_lock(&context->lazy_mutex);
+    while (*rbytes == LAZY_READING) {
+      pthread_cond_wait(&context->lazy_cv, &context->lazy_mutex);
+    }
+    if (*rbytes != LAZY_UNREAD) {
+      pthread_mutex_unlock(&context->lazy_mutex);
+      return *rbytes;
+    }
+    *rbytes = LAZY_READING;
+    pthread_mutex_unlock(&context->lazy_mutex);
+  }
+  else if (*rbytes != LAZY_UNREAD) {
+    return *rbytes;
+  }
+
+  blosc2_frame_s* frame = (blosc2_frame_s*)context->schunk->frame;
+  blosc2_io_segment* segment = &context->lazy_segments[nsegment];
+  int64_t nbytes;
+  if (context->lazy_fp != NULL) {
+    blosc2_io_cb* io_cb = blosc2_get_io_cb(context->schunk->storage->io->id);
+    nbytes = io_cb->read_at(context->lazy_fp, segment->offset, segment->size, segment->ptr);
+  }
+  else {
+    // The (cached) file handle is shared among threads, so it is locked until released
+    const uint8_t* trailer = context->src + BLOSC_EXTENDED_HEADER_LENGTH + context->nblocks * sizeof(int32_t);
+    int64_t fp_nchunk = frame->sframe ? *(int32_t*)trailer : -1;
+    void* fp = frame_acquire_fp(frame, fp_nchunk, context->schunk->storage->io);
+    if (fp == NULL) {
+      BLOSC_TRACE_ERROR("Cannot open the frame for reading the (lazy) blocks.");
+      nbytes = BLOSC2_ERROR_FILE_OPEN;
+    }
+    else {
+      blosc2_io_cb* io_cb = blosc2_get_io_cb(context->schunk->storage->io->id);
+      nbytes = frame_read_at(io_cb, fp, segment->offset, segment->size, segment->ptr);
+      frame_release_fp(frame);
+    }
+  }
+
+  if (context->nthreads > 1) {
+    pthread_mutex_lock(&context->lazy_mutex);
+    *rbytes = nbytes;
+    pthread_cond_broadcast(&context->lazy_cv);
+    pthread_mutex_unlock(&context->lazy_mutex);
+  }
+  else {
+    *rbytes = nbytes;
+  }
+  return nbytes;
+}
+
+
 /* Decompress & unshuffle a single block */
 static int blosc_d(
     struct thread_context* thread_context, int32_t bsize,
@@ -1405,7 +1589,6 @@ static int blosc_d(
       return BLOSC2_ERROR_INVALID_PARAM;
     }
     blosc2_frame_s* frame = (blosc2_frame_s*)context->schunk->frame;
-    char* urlpath = frame->urlpath;
     int32_t trailer_len = sizeof(int32_t) + sizeof(int64_t) + context->nblocks * sizeof(int32_t);
     size_t trailer_offset = BLOSC_EXTENDED_HEADER_LENGTH + context->nblocks * sizeof(int32_t);
     int32_t nchunk;
@@ -1417,36 +1600,50 @@ static int blosc_d(
     int32_t *block_csizes = (int32_t *)(src + trailer_offset + sizeof(int32_t) + sizeof(int64_t));
     int32_t block_csize = block_csizes[nblock];
     // Read the lazy block on disk
-    void* fp = NULL;
     blosc2_io_cb *io_cb = blosc2_get_io_cb(context->schunk->storage->io->id);
     if (io_cb == NULL) {
       BLOSC_TRACE_ERROR("Error getting the input/output API");
       return BLOSC2_ERROR_PLUGIN_IO;
     }
 
-    if (frame->sframe) {
-      // The chunk is not in the frame
-      char* chunkpath = malloc(strlen(frame->urlpath) + 1 + 8 + strlen(".chunk") + 1);
-      BLOSC_ERROR_NULL(chunkpath, BLOSC2_ERROR_MEMORY_ALLOC);
-      sprintf(chunkpath, "%s/%08X.chunk", frame->urlpath, nchunk);
-      fp = io_cb->open(chunkpath, "rb", context->schunk->storage->io->params);
-      free(chunkpath);
-      // The offset of the block is src_offset
-      io_cb->seek(fp, src_offset, SEEK_SET);
+    // The chunk is not in the frame for sframes; the offset of the block is src_offset
+    int64_t block_offset = frame->sframe ? src_offset : chunk_offset + src_offset;
+    int64_t fp_nchunk = frame->sframe ? nchunk : -1;
+    // We can make use of tmp3 because it will be used after src is not needed anymore
+    uint8_t* block = tmp3;
+    int64_t rbytes;
+    if (context->lazy_active) {
+      // The block is read together with its neighbours
+      blosc2_io_segment* segment = &context->lazy_segments[context->lazy_block_segment[nblock]];
+      rbytes = lazy_read_segment(context, context->lazy_block_segment[nblock]);
+      rbytes = rbytes >= block_offset - segment->offset + block_csize ? block_csize : -1;
+      block = segment->ptr + (block_offset - segment->offset);
+    }
+    else if (io_cb->read_at != NULL) {
+      // Positional reads do not move the file position, so threads can share the handle at once
+      void* fp = frame_pin_fp(frame, fp_nchunk, context->schunk->storage->io);
+      if (fp == NULL) {
+        BLOSC_TRACE_ERROR("Cannot open the frame for reading the (lazy) block.");
+        return BLOSC2_ERROR_FILE_OPEN;
+      }
+      rbytes = io_cb->read_at(fp, block_offset, block_csize, tmp3);
+      frame_unpin_fp(frame, fp);
     }
     else {
-      fp = io_cb->open(urlpath, "rb", context->schunk->storage->io->params);
-      // The offset of the block is src_offset
-      io_cb->seek(fp, chunk_offset + src_offset, SEEK_SET);
+      // The (cached) file handle is shared among threads, so it is locked until released
+      void* fp = frame_acquire_fp(frame, fp_nchunk, context->schunk->storage->io);
+      if (fp == NULL) {
+        BLOSC_TRACE_ERROR("Cannot open the frame for reading the (lazy) block.");
+        return BLOSC2_ERROR_FILE_OPEN;
+      }
+      rbytes = frame_read_at(io_cb, fp, block_offset, block_csize, tmp3);
+      frame_release_fp(frame);
     }
-    // We can make use of tmp3 because it will be used after src is not needed anymore
-    int64_t rbytes = io_cb->read(tmp3, 1, block_csize, fp);
-    io_cb->close(fp);
     if ((int32_t)rbytes != block_csize) {
       BLOSC_TRACE_ERROR("Cannot read the (lazy) block out of the fileframe.");
       return BLOSC2_ERROR_READ_BUFFER;
     }
-    src = tmp3;
+    src = block;
     src_offset = 0;
     srcsize = block_csize;
   }
@@ -1684,6 +1881,161 @@ static int blosc_d(
 }
 
 
+/* Group the blocks of a lazy chunk into segments that are read at once (neighbouring blocks,
+ * up to storage->lazy_max_gap bytes apart and storage->lazy_max_read bytes long), and submit
+ * their reads up front if the I/O backend can do them in the background (io_uring).
+ * blosc_d() reads (or waits for) the segment of each block when needed. */
+static int lazy_prepare_blocks(blosc2_context* context) {
+  context->lazy_active = false;
+  bool is_lazy = ((context->header_overhead == BLOSC_EXTENDED_HEADER_LENGTH) &&
+                  (context->blosc2_flags & 0x08u) && !context->special_type);
+  if (!is_lazy || context->schunk == NULL || context->schunk->frame == NULL) {
+    return 0;
+  }
+  blosc2_storage* storage = context->schunk->storage;
+  blosc2_io* io = storage->io;
+  bool uring = io->id == BLOSC2_IO_FILESYSTEM_URING;
+  int64_t max_read = storage->lazy_max_read == 0 ? BLOSC2_LAZY_MAX_READ : storage->lazy_max_read;
+  if (max_read < 0 && !uring) {
+    // The blocks will be read one by one
+    return 0;
+  }
+  blosc2_io_cb* io_cb = blosc2_get_io_cb(io->id);
+  if (io_cb == NULL) {
+    BLOSC_TRACE_ERROR("Error getting the input/output API");
+    return BLOSC2_ERROR_PLUGIN_IO;
+  }
+  blosc2_frame_s* frame = (blosc2_frame_s*)context->schunk->frame;
+  bool memcpyed = context->header_flags & (uint8_t)BLOSC_MEMCPYED;
+  int32_t nblocks = context->nblocks;
+  // The nchunk, the offset and the block csizes of the chunk are in the trailer
+  const uint8_t* trailer = context->src + BLOSC_EXTENDED_HEADER_LENGTH + nblocks * sizeof(int32_t);
+  int32_t nchunk = *(int32_t*)trailer;
+  int64_t chunk_offset = *(int64_t*)(trailer + sizeof(int32_t));
+  int32_t* block_csizes = (int32_t*)(trailer + sizeof(int32_t) + sizeof(int64_t));
+
+  // The buffers are kept in the context for the next chunks
+  if (nblocks > context->lazy_maxsegments) {
+    free(context->lazy_segments);
+    free(context->lazy_rbytes);
+    free(context->lazy_block_segment);
+    context->lazy_segments = malloc(nblocks * sizeof(blosc2_io_segment));
+    context->lazy_rbytes = malloc(nblocks * sizeof(int64_t));
+    context->lazy_block_segment = malloc(2 * nblocks * sizeof(int32_t));
+    if (context->lazy_segments == NULL || context->lazy_rbytes == NULL || context->lazy_block_segment == NULL) {
+      context->lazy_maxsegments = 0;
+      BLOSC_TRACE_ERROR("Error allocating memory for reading the (lazy) blocks.");
+      return BLOSC2_ERROR_MEMORY_ALLOC;
+    }
+    context->lazy_maxsegments = nblocks;
+  }
+  blosc2_io_segment* segments = context->lazy_segments;
+  // The offsets of the blocks go in lazy_rbytes until the segments are set up
+  int64_t* block_offsets = context->lazy_rbytes;
+
+  // Sort the blocks to be read by their offset (they are usually in order already)
+  int32_t* order = context->lazy_block_segment + nblocks;
+  int32_t norder = 0;
+  for (int32_t j = 0; j < nblocks; j++) {
+    if (context->block_maskout != NULL && context->block_maskout[j]) {
+      continue;
+    }
+    int64_t src_offset = memcpyed ? context->header_overhead + (int64_t)j * context->blocksize :
+                         sw32_(context->bstarts + j);
+    block_offsets[j] = frame->sframe ? src_offset : chunk_offset + src_offset;
+    int32_t k = norder++;
+    for (; k > 0 && block_offsets[order[k - 1]] > block_offsets[j]; k--) {
+      order[k] = order[k - 1];
+    }
+    order[k] = j;
+  }
+
+  // Merge the neighbouring blocks (without reading the same bytes twice)
+  int32_t nsegments = 0;
+  int64_t end = 0;
+  int64_t total_size = 0;
+  for (int32_t k = 0; k < norder; k++) {
+    int32_t j = order[k];
+    int64_t offset = block_offsets[j];
+    int64_t block_end = offset + block_csizes[j];
+    if (nsegments > 0 && offset >= end && offset - end <= storage->lazy_max_gap &&
+        block_end - segments[nsegments - 1].offset <= max_read) {
+      total_size += block_end - end;
+      segments[nsegments - 1].size = block_end - segments[nsegments - 1].offset;
+    }
+    else {
+      segments[nsegments].offset = offset;
+      segments[nsegments].size = block_csizes[j];
+      total_size += block_csizes[j];
+      nsegments++;
+    }
+    end = block_end;
+    context->lazy_block_segment[j] = nsegments - 1;
+  }
+  context->lazy_nsegments = nsegments;
+
+  if (total_size > context->lazy_buffer_size) {
+    free(context->lazy_buffer);
+    context->lazy_buffer = malloc((size_t)total_size);
+    if (context->lazy_buffer == NULL) {
+      context->lazy_buffer_size = 0;
+      BLOSC_TRACE_ERROR("Error allocating memory for reading the (lazy) blocks.");
+      return BLOSC2_ERROR_MEMORY_ALLOC;
+    }
+    context->lazy_buffer_size = total_size;
+  }
+  uint8_t* ptr = context->lazy_buffer;
+  for (int32_t i = 0; i < nsegments; i++) {
+    segments[i].ptr = ptr;
+    ptr += segments[i].size;
+    context->lazy_rbytes[i] = LAZY_UNREAD;
+  }
+
+  // Positional reads do not move the file position, so threads can share the handle at once
+  // (but the handle has to stay open until all the reads are done)
+  if (io_cb->read_at != NULL) {
+    context->lazy_fp = frame_pin_fp(frame, frame->sframe ? nchunk : -1, io);
+    if (context->lazy_fp == NULL) {
+      BLOSC_TRACE_ERROR("Cannot open the frame for reading the (lazy) blocks.");
+      return BLOSC2_ERROR_FILE_OPEN;
+    }
+    if (uring && nsegments > 0) {
+      // If io_uring is not available, the segments are read on demand anyway
+      context->lazy_batch = blosc2_stdio_uring_submit(context->lazy_fp, segments, nsegments);
+    }
+  }
+  context->lazy_active = true;
+  return 0;
+}
+
+
+static void lazy_release_blocks(blosc2_context* context) {
+  if (context->lazy_batch != NULL) {
+    blosc2_stdio_uring_release(context->lazy_batch);
+    context->lazy_batch = NULL;
+  }
+  if (context->lazy_fp != NULL) {
+    frame_unpin_fp((blosc2_frame_s*)context->schunk->frame, context->lazy_fp);
+    context->lazy_fp = NULL;
+  }
+  context->lazy_active = false;
+}
+
+
+/* Whether the blocks are just copied (or are all the same) */
+static bool blocks_memcpyed(blosc2_context* context) {
+  if (!context->do_compress && context->special_type) {
+    // Fake a runlen as if its a memcpyed chunk
+    return true;
+  }
+  return context->header_flags & (uint8_t)BLOSC_MEMCPYED;
+}
+
+/* Whether the blocks can be evenly distributed among threads beforehand */
+static bool is_static_schedule(blosc2_context* context) {
+  return (!context->do_compress || blocks_memcpyed(context)) && context->block_maskout == NULL;
+}
+
 /* Serial version for compression/decompression */
 static int serial_blosc(struct thread_context* thread_context) {
   blosc2_context* context = thread_context->parent_context;
@@ -1694,11 +2046,7 @@ static int serial_blosc(struct thread_context* thread_context) {
   uint8_t* tmp = thread_context->tmp;
   uint8_t* tmp2 = thread_context->tmp2;
   int dict_training = context->use_dict && (context->dict_cdict == NULL);
-  bool memcpyed = context->header_flags & (uint8_t)BLOSC_MEMCPYED;
-  if (!context->do_compress && context->special_type) {
-    // Fake a runlen as if its a memcpyed chunk
-    memcpyed = true;
-  }
+  bool memcpyed = blocks_memcpyed(context);
 
   for (j = 0; j < context->nblocks; j++) {
     if (context->do_compress && !memcpyed && !dict_training) {
@@ -1749,26 +2097,96 @@ static int serial_blosc(struct thread_context* thread_context) {
 }
 
 static void t_blosc_do_job(void *ctxt);
+static int shared_pool_do_job(blosc2_context* context);
+static struct thread_context* create_thread_context(blosc2_context* context, int32_t tid);
+
+/* Make room for the compressed blocks of every task (kept for the next chunks) */
+static int init_stagings(blosc2_context* context) {
+  if (context->nblocks > context->max_staged_blocks) {
+    free(context->staged_blocks);
+    context->staged_blocks = malloc(context->nblocks * sizeof(blosc_staged_block));
+    if (context->staged_blocks == NULL) {
+      context->max_staged_blocks = 0;
+      BLOSC_TRACE_ERROR("Error allocating memory for the compressed blocks.");
+      return BLOSC2_ERROR_MEMORY_ALLOC;
+    }
+    context->max_staged_blocks = context->nblocks;
+  }
+  if (context->nthreads > context->nstagings) {
+    blosc_staging* stagings = realloc(context->stagings, context->nthreads * sizeof(blosc_staging));
+    if (stagings == NULL) {
+      BLOSC_TRACE_ERROR("Error allocating memory for the compressed blocks.");
+      return BLOSC2_ERROR_MEMORY_ALLOC;
+    }
+    memset(stagings + context->nstagings, 0, (context->nthreads - context->nstagings) * sizeof(blosc_staging));
+    context->stagings = stagings;
+    context->nstagings = context->nthreads;
+  }
+  return 0;
+}
+
+/* Put the blocks compressed by the tasks in dest, in block order */
+static void copy_staged_blocks(blosc2_context* context, int32_t ntbytes) {
+  bool dict_training = context->use_dict && context->dict_cdict == NULL;
+  for (int32_t j = 0; j < context->nblocks; j++) {
+    blosc_staged_block* staged = &context->staged_blocks[j];
+    if (!dict_training) {
+      _sw32(context->bstarts + j, ntbytes);
+    }
+    memcpy(context->dest + ntbytes, context->stagings[staged->tid].buffer + staged->offset,
+           (unsigned int) staged->cbytes);
+    ntbytes += staged->cbytes;
+  }
+  context->output_bytes = ntbytes;
+}
+
+/* Run the tasks of a job (context->ntasks of them) with the threads of a context */
+static int run_tasks(blosc2_context* context) {
+  if (context->threads_shared) {
+    return shared_pool_do_job(context);
+  }
+  if (threads_callback) {
+    threads_callback(threads_callback_data, t_blosc_do_job,
+                     context->ntasks, sizeof(struct thread_context), (void*) context->thread_contexts);
+    return 0;
+  }
+
+  /* The calling thread runs the first task, and the threads the rest */
+  if (context->serial_context == NULL) {
+    context->serial_context = create_thread_context(context, 0);
+    BLOSC_ERROR_NULL(context->serial_context, BLOSC2_ERROR_THREAD_CREATE);
+  }
+  context->ntasks_left = context->ntasks - 1;
+  for (int16_t tid = 1; tid < context->ntasks; tid++) {
+    handoff_job(context, &context->handoffs[tid]);
+  }
+  context->serial_context->tid = 0;
+  t_blosc_do_job(context->serial_context);
+  wait_job_done(context);
+  return 0;
+}
 
 /* Threaded version for compression/decompression */
 static int parallel_blosc(blosc2_context* context) {
-#ifdef BLOSC_POSIX_BARRIERS
   int rc;
-#endif
+  /* Compressed blocks are staged first, so that they end up in the same
+   * place whatever the number of threads or the timing of them */
+  bool staged = context->do_compress && !blocks_memcpyed(context);
+  int32_t ntbytes = context->output_bytes;
+  if (staged) {
+    rc = init_stagings(context);
+    if (rc < 0) {
+      return rc;
+    }
+  }
+
   /* Set sentinels */
   context->thread_giveup_code = 1;
   context->thread_nblock = -1;
 
-  if (threads_callback) {
-    threads_callback(threads_callback_data, t_blosc_do_job,
-                     context->nthreads, sizeof(struct thread_context), (void*) context->thread_contexts);
-  }
-  else {
-    /* Synchronization point for all threads (wait for initialization) */
-    WAIT_INIT(-1, context);
-
-    /* Synchronization point for all threads (wait for finalization) */
-    WAIT_FINISH(-1, context);
+  rc = run_tasks(context);
+  if (rc < 0) {
+    return rc;
   }
 
   if (context->thread_giveup_code <= 0) {
@@ -1776,6 +2194,16 @@ static int parallel_blosc(blosc2_context* context) {
     return context->thread_giveup_code;
   }
 
+  if (staged) {
+    copy_staged_blocks(context, ntbytes);
+  }
+  else if (is_static_schedule(context)) {
+    context->output_bytes = context->sourcesize;
+    if (context->do_compress) {
+      context->output_bytes += context->header_overhead;
+    }
+  }
+
   /* Return the total bytes (de-)compressed in threads */
   return (int)context->output_bytes;
 }
@@ -1868,6 +2296,11 @@ int check_nthreads(blosc2_context* context) {
     }
     context->nthreads = context->new_nthreads;
   }
+  if (context->threads_started > 0 &&
+      context->threads_shared != (g_shared_pool != NULL && threads_callback == NULL)) {
+    // The shared pool has been switched on or off since the threads were started
+    release_threadpool(context);
+  }
   if (context->new_nthreads > 1 && context->threads_started == 0) {
     init_threadpool(context);
   }
@@ -1875,6 +2308,17 @@ int check_nthreads(blosc2_context* context) {
   return context->nthreads;
 }
 
+/* The number of tasks worth splitting the blocks in: one for every
+   parallel_min_nbytes at most, and never more than threads or blocks */
+static int16_t parallel_ntasks(blosc2_context* context, int32_t nblocks, int32_t nbytes) {
+  int32_t min_nbytes = context->parallel_min_nbytes != 0 ? context->parallel_min_nbytes : g_parallel_min_nbytes;
+  int32_t ntasks = context->nthreads < nblocks ? context->nthreads : nblocks;
+  if (min_nbytes > 0 && ntasks > nbytes / min_nbytes) {
+    ntasks = nbytes / min_nbytes;
+  }
+  return (int16_t)(ntasks > 1 ? ntasks : 1);
+}
+
 /* Do the compression or decompression of the buffer depending on the
    global params. */
 static int do_job(blosc2_context* context) {
@@ -1887,8 +2331,9 @@ static int do_job(blosc2_context* context) {
   check_nthreads(context);
 
   /* Run the serial version when nthreads is 1 or when the buffers are
-     not larger than blocksize */
-  if (context->nthreads == 1 || (context->sourcesize / context->blocksize) <= 1) {
+     not larger than blocksize or too small for threads to pay off */
+  context->ntasks = parallel_ntasks(context, context->nblocks, context->sourcesize);
+  if (context->ntasks <= 1 || (context->sourcesize / context->blocksize) <= 1) {
     /* The context for this 'thread' has no been initialized yet */
     if (context->serial_context == NULL) {
       context->serial_context = create_thread_context(context, 0);
@@ -1949,10 +2394,11 @@ static int initialize_context_compression(
     context->udbtune->btune_next_blocksize(context);
   }
 
-  char* envvar = getenv("BLOSC_WARN");
-  int warnlvl = 0;
-  if (envvar != NULL) {
-    warnlvl = strtol(envvar, NULL, 10);
+  int warnlvl = g_env.warnlvl;
+  if (!g_initlib) {
+    /* The environment has not been read yet */
+    char* envvar = getenv("BLOSC_WARN");
+    warnlvl = envvar != NULL ? strtol(envvar, NULL, 10) : 0;
   }
 
   /* Check buffer size limits */
@@ -2361,150 +2807,161 @@ void build_filters(const int doshuffle, const int delta,
     filters[BLOSC2_MAX_FILTERS - 2] = BLOSC_DELTA;
 }
 
-/* The public secure routine for compression. */
-int blosc2_compress(int clevel, int doshuffle, int32_t typesize,
-                    const void* src, int32_t srcsize, void* dest, int32_t destsize) {
-  int error;
-  int result;
-  char* envvar;
-
-  /* Check whether the library should be initialized */
-  if (!g_initlib) blosc_init();
+/* Whether a context has threads of its own (rather than the ones of the shared pool) */
+static bool owns_threads(blosc2_context* context) {
+  return context->threads_started > 0 && !context->threads_shared;
+}
 
-  /* Check for a BLOSC_CLEVEL environment variable */
-  envvar = getenv("BLOSC_CLEVEL");
-  if (envvar != NULL) {
-    long value;
-    value = strtol(envvar, NULL, 10);
-    if ((value != EINVAL) && (value >= 0)) {
-      clevel = (int)value;
+/* Take an idle context of the non-contextual API, or create a new one */
+static blosc2_context* acquire_global_context(int16_t nthreads) {
+  pthread_mutex_lock(&global_comp_mutex);
+  blosc2_context* context = g_global_contexts;
+  if (context != NULL) {
+    g_global_contexts = context->next_global;
+    g_global_nidle--;
+    if (owns_threads(context)) {
+      g_global_nidle_threads--;
     }
   }
+  pthread_mutex_unlock(&global_comp_mutex);
 
-  /* Check for a BLOSC_SHUFFLE environment variable */
-  envvar = getenv("BLOSC_SHUFFLE");
-  if (envvar != NULL) {
-    if (strcmp(envvar, "NOSHUFFLE") == 0) {
-      doshuffle = BLOSC_NOSHUFFLE;
-    }
-    if (strcmp(envvar, "SHUFFLE") == 0) {
-      doshuffle = BLOSC_SHUFFLE;
-    }
-    if (strcmp(envvar, "BITSHUFFLE") == 0) {
-      doshuffle = BLOSC_BITSHUFFLE;
-    }
+  if (context == NULL) {
+    context = (blosc2_context*)my_malloc(sizeof(blosc2_context));
+    BLOSC_ERROR_NULL(context, NULL);
+    memset(context, 0, sizeof(blosc2_context));
+    context->nthreads = nthreads;
+    context->new_nthreads = nthreads;
   }
+  return context;
+}
 
-  /* Check for a BLOSC_DELTA environment variable */
-  envvar = getenv("BLOSC_DELTA");
-  if (envvar != NULL) {
-    if (strcmp(envvar, "1") == 0) {
-      blosc_set_delta(1);
-    } else {
-      blosc_set_delta(0);
-    }
+/* Give a context of the non-contextual API back.  Only one idle context keeps
+   its threads (and it is the first one to be taken again), so that calls from
+   many threads at once do not leave a pool of threads behind each. */
+static void release_global_context(blosc2_context* context) {
+  pthread_mutex_lock(&global_comp_mutex);
+  while (owns_threads(context) && g_global_nidle_threads > 0) {
+    pthread_mutex_unlock(&global_comp_mutex);
+    release_threadpool(context);
+    pthread_mutex_lock(&global_comp_mutex);
   }
-
-  /* Check for a BLOSC_TYPESIZE environment variable */
-  envvar = getenv("BLOSC_TYPESIZE");
-  if (envvar != NULL) {
-    long value;
-    value = strtol(envvar, NULL, 10);
-    if ((value != EINVAL) && (value > 0)) {
-      typesize = (size_t)value;
-    }
+  if (g_global_nidle >= GLOBAL_CONTEXTS_MAX_IDLE) {
+    pthread_mutex_unlock(&global_comp_mutex);
+    blosc2_free_ctx(context);
+    return;
   }
-
-  /* Check for a BLOSC_COMPRESSOR environment variable */
-  envvar = getenv("BLOSC_COMPRESSOR");
-  if (envvar != NULL) {
-    result = blosc_set_compressor(envvar);
-    if (result < 0) { return result; }
+  if (owns_threads(context) || g_global_contexts == NULL) {
+    context->next_global = g_global_contexts;
+    g_global_contexts = context;
   }
-
-  /* Check for a BLOSC_COMPRESSOR environment variable */
-  envvar = getenv("BLOSC_BLOCKSIZE");
-  if (envvar != NULL) {
-    long blocksize;
-    blocksize = strtol(envvar, NULL, 10);
-    if ((blocksize != EINVAL) && (blocksize > 0)) {
-      blosc_set_blocksize((size_t)blocksize);
+  else {
+    // Behind the contexts with threads
+    blosc2_context* last = g_global_contexts;
+    while (last->next_global != NULL) {
+      last = last->next_global;
     }
+    context->next_global = NULL;
+    last->next_global = context;
   }
+  g_global_nidle++;
+  if (owns_threads(context)) {
+    g_global_nidle_threads++;
+  }
+  pthread_mutex_unlock(&global_comp_mutex);
+}
 
-  /* Check for a BLOSC_NTHREADS environment variable */
-  envvar = getenv("BLOSC_NTHREADS");
-  if (envvar != NULL) {
-    long nthreads;
-    nthreads = strtol(envvar, NULL, 10);
-    if ((nthreads != EINVAL) && (nthreads > 0)) {
-      result = blosc_set_nthreads((int)nthreads);
-      if (result < 0) { return result; }
-    }
+/* The settings of the non-contextual API, which are the ones in the environment (applied
+   once by blosc_init()) unless set again with the blosc_set_*() functions */
+typedef struct {
+  int compcode;
+  int delta;
+  int32_t blocksize;
+  int16_t nthreads;
+} global_settings;
+
+/* Make the settings in the environment prevail over the ones set with the blosc_set_*()
+   functions since blosc_init(), as if these were called before every operation.  The
+   globals are only read here, as calls may come from several threads at once. */
+static int get_global_settings(global_settings* settings) {
+  if (g_env.compcode < -1) {
+    BLOSC_TRACE_ERROR("The compressor in BLOSC_COMPRESSOR is not supported.");
+    return BLOSC2_ERROR_CODEC_SUPPORT;
+  }
+  settings->compcode = g_env.compcode >= 0 ? g_env.compcode : g_compressor;
+  settings->delta = g_env.delta >= 0 ? g_env.delta : g_delta;
+  settings->blocksize = g_env.blocksize > 0 ? g_env.blocksize : g_force_blocksize;
+  settings->nthreads = g_env.nthreads > 0 ? g_env.nthreads : g_nthreads;
+  return 0;
+}
+
+/* Apply the settings in the environment, just once (see blosc_init) */
+static void apply_env_settings(void) {
+  if (g_env.delta >= 0) {
+    g_delta = g_env.delta;
   }
+  if (g_env.compcode >= 0) {
+    g_compressor = g_env.compcode;
+  }
+  if (g_env.blocksize > 0) {
+    g_force_blocksize = g_env.blocksize;
+  }
+  if (g_env.nthreads > 0) {
+    g_nthreads = g_env.nthreads;
+  }
+}
 
-  /* Check for a BLOSC_NOLOCK environment variable.  It is important
-     that this should be the last env var so that it can take the
-     previous ones into account */
-  envvar = getenv("BLOSC_NOLOCK");
-  if (envvar != NULL) {
-    // TODO: here is the only place that returns an extended header from
-    //   a blosc_compress() call.  This should probably be fixed.
-    const char *compname;
-    blosc2_context *cctx;
-    blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
-
-    blosc_compcode_to_compname(g_compressor, &compname);
-    /* Create a context for compression */
-    build_filters(doshuffle, g_delta, typesize, cparams.filters);
-    // TODO: cparams can be shared in a multithreaded environment.  do a copy!
-    cparams.typesize = (uint8_t)typesize;
-    cparams.compcode = (uint8_t)g_compressor;
-    cparams.clevel = (uint8_t)clevel;
-    cparams.nthreads = g_nthreads;
-    cctx = blosc2_create_cctx(cparams);
-    /* Do the actual compression */
-    result = blosc2_compress_ctx(cctx, src, srcsize, dest, destsize);
-    /* Release context resources */
-    blosc2_free_ctx(cctx);
-    return result;
+/* The public secure routine for compression. */
+int blosc2_compress(int clevel, int doshuffle, int32_t typesize,
+                    const void* src, int32_t srcsize, void* dest, int32_t destsize) {
+  int error;
+  int result;
+
+  /* Check whether the library should be initialized */
+  if (!g_initlib) blosc_init();
+
+  /* The environment variables (read by blosc_init()) take precedence */
+  if (g_env.clevel >= 0) {
+    clevel = g_env.clevel;
   }
+  if (g_env.doshuffle >= 0) {
+    doshuffle = g_env.doshuffle;
+  }
+  if (g_env.typesize > 0) {
+    typesize = g_env.typesize;
+  }
+  global_settings settings;
+  result = get_global_settings(&settings);
+  if (result < 0) { return result; }
 
-  pthread_mutex_lock(&global_comp_mutex);
+  blosc2_context* context = acquire_global_context(settings.nthreads);
+  if (context == NULL) {
+    return BLOSC2_ERROR_MEMORY_ALLOC;
+  }
 
   /* Initialize a context compression */
-  uint8_t* filters = calloc(1, BLOSC2_MAX_FILTERS);
-  BLOSC_ERROR_NULL(filters, BLOSC2_ERROR_MEMORY_ALLOC);
-  uint8_t* filters_meta = calloc(1, BLOSC2_MAX_FILTERS);
-  BLOSC_ERROR_NULL(filters_meta, BLOSC2_ERROR_MEMORY_ALLOC);
-  build_filters(doshuffle, g_delta, typesize, filters);
+  uint8_t filters[BLOSC2_MAX_FILTERS] = {0};
+  uint8_t filters_meta[BLOSC2_MAX_FILTERS] = {0};
+  build_filters(doshuffle, settings.delta, typesize, filters);
   error = initialize_context_compression(
-    g_global_context, src, srcsize, dest, destsize, clevel, filters,
-    filters_meta, (int32_t)typesize, g_compressor, g_force_blocksize, g_nthreads, g_nthreads,
+    context, src, srcsize, dest, destsize, clevel, filters,
+    filters_meta, (int32_t)typesize, settings.compcode, settings.blocksize, settings.nthreads,
+    context->nthreads,
     &BTUNE_DEFAULTS, NULL, g_schunk);
-  free(filters);
-  free(filters_meta);
   if (error <= 0) {
-    pthread_mutex_unlock(&global_comp_mutex);
+    release_global_context(context);
     return error;
   }
 
-  envvar = getenv("BLOSC_BLOSC1_COMPAT");
-  if (envvar != NULL) {
-    /* Write chunk header without extended header (Blosc1 compatibility mode) */
-    error = write_compression_header(g_global_context, false);
-  }
-  else {
-    error = write_compression_header(g_global_context, true);
-  }
+  /* Write chunk header without extended header in Blosc1 compatibility mode */
+  error = write_compression_header(context, !g_env.blosc1_compat);
   if (error < 0) {
-    pthread_mutex_unlock(&global_comp_mutex);
+    release_global_context(context);
     return error;
   }
 
-  result = blosc_compress_context(g_global_context);
+  result = blosc_compress_context(context);
 
-  pthread_mutex_unlock(&global_comp_mutex);
+  release_global_context(context);
 
   return result;
 }
@@ -2541,7 +2998,12 @@ int blosc_run_decompression_with_context(blosc2_context* context, const void* sr
   }
 
   /* Do the actual decompression */
+  rc = lazy_prepare_blocks(context);
+  if (rc < 0) {
+    return rc;
+  }
   ntbytes = do_job(context);
+  lazy_release_blocks(context);
   if (ntbytes < 0) {
     return ntbytes;
   }
@@ -2574,45 +3036,348 @@ int blosc2_decompress_ctx(blosc2_context* context, const void* src, int32_t srcs
 }
 
 
-/* The public secure routine for decompression. */
-int blosc2_decompress(const void* src, int32_t srcsize, void* dest, int32_t destsize) {
-  int result;
-  char* envvar;
-  long nthreads;
-  blosc2_context *dctx;
-  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
-
-  /* Check whether the library should be initialized */
-  if (!g_initlib) blosc_init();
-
-  /* Check for a BLOSC_NTHREADS environment variable */
-  envvar = getenv("BLOSC_NTHREADS");
-  if (envvar != NULL) {
-    nthreads = strtol(envvar, NULL, 10);
-    if ((nthreads != EINVAL) && (nthreads > 0)) {
-      result = blosc_set_nthreads((int)nthreads);
-      if (result < 0) { return result; }
-    }
+/* (De)compress a buffer of a batch */
+static int batch_item_blosc(blosc2_context* context, void* batch_data, int32_t nitem) {
+  const blosc2_batch_item* item = (const blosc2_batch_item*)batch_data + nitem;
+  if (context->do_compress) {
+    /* An automatic blocksize is computed for every buffer, whatever the previous ones */
+    context->blocksize = context->user_blocksize;
+    return blosc2_compress_ctx(context, item->src, item->srcsize, item->dest, item->destsize);
   }
+  return blosc2_decompress_ctx(context, item->src, item->srcsize, item->dest, item->destsize);
+}
 
-  /* Check for a BLOSC_NOLOCK environment variable.  It is important
-     that this should be the last env var so that it can take the
-     previous ones into account */
-  envvar = getenv("BLOSC_NOLOCK");
-  if (envvar != NULL) {
-    dparams.nthreads = g_nthreads;
-    dctx = blosc2_create_dctx(dparams);
-    result = blosc2_decompress_ctx(dctx, src, srcsize, dest, destsize);
-    blosc2_free_ctx(dctx);
-    return result;
+/* Create the contexts (with a single thread) for the tasks of a batch; they
+   are kept for the next batches */
+static int init_batch_contexts(blosc2_context* context, int16_t ntasks) {
+  if (ntasks <= context->nbatch_contexts) {
+    return 0;
   }
+  blosc2_context** contexts = realloc(context->batch_contexts, ntasks * sizeof(blosc2_context*));
+  if (contexts == NULL) {
+    BLOSC_TRACE_ERROR("Error allocating memory for the contexts of a batch.");
+    return BLOSC2_ERROR_MEMORY_ALLOC;
+  }
+  context->batch_contexts = contexts;
+  for (int16_t tid = context->nbatch_contexts; tid < ntasks; tid++) {
+    if (context->do_compress) {
+      blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+      blosc2_ctx_get_cparams(context, &cparams);
+      cparams.blocksize = context->user_blocksize;
+      cparams.nthreads = 1;
+      contexts[tid] = blosc2_create_cctx(cparams);
+    }
+    else {
+      blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+      blosc2_ctx_get_dparams(context, &dparams);
+      dparams.nthreads = 1;
+      contexts[tid] = blosc2_create_dctx(dparams);
+    }
+    BLOSC_ERROR_NULL(contexts[tid], BLOSC2_ERROR_MEMORY_ALLOC);
+    context->nbatch_contexts = (int16_t)(tid + 1);
+  }
+  return 0;
+}
+
+/* Run `func` on every item of a batch, each one with a single thread */
+int run_batch(blosc2_context* context, batch_func func, void* batch_data,
+              int32_t nitems, int32_t* results) {
+  int rc = check_nthreads(context);
+  if (rc < 0) {
+    return rc;
+  }
+
+  if (context->nthreads <= 1 || nitems <= 1) {
+    /* The items in turn (the threads of the context share the blocks, if any) */
+    for (int32_t i = 0; i < nitems; i++) {
+      results[i] = func(context, batch_data, i);
+    }
+  }
+  else {
+    context->ntasks = (int16_t)(context->nthreads < nitems ? context->nthreads : nitems);
+    rc = init_batch_contexts(context, context->ntasks);
+    if (rc < 0) {
+      return rc;
+    }
+    context->batch_func = func;
+    context->batch_data = batch_data;
+    context->batch_results = results;
+    context->batch_nitems = nitems;
+    context->batch_next = 0;
+    rc = run_tasks(context);
+    context->batch_func = NULL;
+    if (rc < 0) {
+      return rc;
+    }
+  }
+
+  for (int32_t i = 0; i < nitems; i++) {
+    if (results[i] < 0) {
+      return results[i];
+    }
+  }
+  return 0;
+}
+
+/* (De)compress a batch of buffers, each one with a single thread */
+static int batch_blosc(blosc2_context* context, const blosc2_batch_item* items,
+                       int32_t nitems, int32_t* results) {
+  if (nitems < 0 || (nitems > 0 && (items == NULL || results == NULL))) {
+    BLOSC_TRACE_ERROR("A batch needs its buffers and room for their results.");
+    return BLOSC2_ERROR_INVALID_PARAM;
+  }
+  return run_batch(context, batch_item_blosc, (void*)items, nitems, results);
+}
+
+
+/* The public routine for compression of a batch of buffers with context. */
+int blosc2_compress_batch(blosc2_context* context, const blosc2_batch_item* items,
+                          int32_t nitems, int32_t* results) {
+  if (context->do_compress != 1) {
+    BLOSC_TRACE_ERROR("Context is not meant for compression.  Giving up.");
+    return BLOSC2_ERROR_INVALID_PARAM;
+  }
+  return batch_blosc(context, items, nitems, results);
+}
+
+
+/* The public routine for decompression of a batch of buffers with context. */
+int blosc2_decompress_batch(blosc2_context* context, const blosc2_batch_item* items,
+                            int32_t nitems, int32_t* results) {
+  if (context->do_compress != 0) {
+    BLOSC_TRACE_ERROR("Context is not meant for decompression.  Giving up.");
+    return BLOSC2_ERROR_INVALID_PARAM;
+  }
+  return batch_blosc(context, items, nitems, results);
+}
+
+
+/* Run the (de)compression at the head of the queue of a context.  The async_mutex
+   must be held, and it is released while the (de)compression runs. */
+static void run_async_head(blosc2_context* context) {
+  blosc2_async* handle = context->async_queue;
+  pthread_mutex_unlock(&context->async_mutex);
+
+  if (handle->compress) {
+    handle->result = blosc2_compress_ctx(context, handle->src, handle->srcsize,
+                                         handle->dest, handle->destsize);
+  }
+  else {
+    handle->result = blosc2_decompress_ctx(context, handle->src, handle->srcsize,
+                                           handle->dest, handle->destsize);
+  }
+  if (handle->callback != NULL) {
+    handle->callback(handle->user_data, handle->result);
+  }
+
+  pthread_mutex_lock(&context->async_mutex);
+  context->async_queue = handle->next;
+  handle->done = true;
+  pthread_cond_broadcast(&context->async_done_cv);
+}
+
+/* Run the asynchronous (de)compressions of a context in order */
+static void* t_async(void* ctxt) {
+  blosc2_context* context = (blosc2_context*)ctxt;
+
+  pthread_mutex_lock(&context->async_mutex);
+  while (1) {
+    while (context->async_queue == NULL && !context->async_end) {
+      pthread_cond_wait(&context->async_cv, &context->async_mutex);
+    }
+    if (context->async_queue == NULL) {
+      break;
+    }
+    run_async_head(context);
+  }
+  pthread_mutex_unlock(&context->async_mutex);
+
+  return NULL;
+}
+
+/* Run the queued (de)compressions of a context without a thread of its own from the
+   calling thread, until `handle` is done (or the queue is empty if NULL).  Only one
+   caller runs them at a time, so they are still done in order.  The async_mutex must
+   be held. */
+static void drive_async_queue(blosc2_context* context, blosc2_async* handle) {
+  while (handle != NULL ? !handle->done : context->async_queue != NULL) {
+    if (context->async_running) {
+      pthread_cond_wait(&context->async_done_cv, &context->async_mutex);
+      continue;
+    }
+    context->async_running = true;
+    run_async_head(context);
+    context->async_running = false;
+  }
+}
+
+/* Finish the queued (de)compressions of a context, and its thread if any */
+static void release_async_thread(blosc2_context* context) {
+  if (!context->async_started) {
+    return;
+  }
+  if (context->async_own_thread) {
+    pthread_mutex_lock(&context->async_mutex);
+    context->async_end = true;
+    pthread_cond_signal(&context->async_cv);
+    pthread_mutex_unlock(&context->async_mutex);
+    int rc = pthread_join(context->async_thread, NULL);
+    if (rc) {
+      BLOSC_TRACE_ERROR("Return code from pthread_join() is %d\n"
+                        "\tError detail: %s.", rc, strerror(rc));
+    }
+  }
+  else {
+    pthread_mutex_lock(&context->async_mutex);
+    drive_async_queue(context, NULL);
+    pthread_mutex_unlock(&context->async_mutex);
+  }
+  pthread_mutex_destroy(&context->async_mutex);
+  pthread_cond_destroy(&context->async_cv);
+  pthread_cond_destroy(&context->async_done_cv);
+  context->async_started = false;
+  context->async_end = false;
+}
+
+/* Queue a (de)compression on a context, starting its thread if needed.  With a threads
+   callback, no thread is started and the queue is run by blosc2_async_run/wait. */
+static blosc2_async* queue_async(blosc2_context* context, bool compress, const void* src, int32_t srcsize,
+                                 void* dest, int32_t destsize, blosc2_async_cb callback, void* user_data) {
+  if (!context->async_started) {
+    pthread_mutex_init(&context->async_mutex, NULL);
+    pthread_cond_init(&context->async_cv, NULL);
+    pthread_cond_init(&context->async_done_cv, NULL);
+    context->async_queue = NULL;
+    context->async_running = false;
+    context->async_own_thread = threads_callback == NULL;
+    if (context->async_own_thread) {
+      int rc = pthread_create(&context->async_thread, NULL, t_async, (void*)context);
+      if (rc) {
+        BLOSC_TRACE_ERROR("Return code from pthread_create() is %d.\n"
+                          "\tError detail: %s\n", rc, strerror(rc));
+        pthread_mutex_destroy(&context->async_mutex);
+        pthread_cond_destroy(&context->async_cv);
+        pthread_cond_destroy(&context->async_done_cv);
+        return NULL;
+      }
+    }
+    context->async_started = true;
+  }
+
+  blosc2_async* handle = (blosc2_async*)my_malloc(sizeof(blosc2_async));
+  BLOSC_ERROR_NULL(handle, NULL);
+  handle->context = context;
+  handle->compress = compress;
+  handle->src = src;
+  handle->srcsize = srcsize;
+  handle->dest = dest;
+  handle->destsize = destsize;
+  handle->callback = callback;
+  handle->user_data = user_data;
+  handle->result = 0;
+  handle->done = false;
+  handle->next = NULL;
+
+  pthread_mutex_lock(&context->async_mutex);
+  blosc2_async** last = &context->async_queue;
+  while (*last != NULL) {
+    last = &(*last)->next;
+  }
+  *last = handle;
+  pthread_cond_signal(&context->async_cv);
+  pthread_mutex_unlock(&context->async_mutex);
+
+  return handle;
+}
+
+
+/* The public routine for asynchronous compression with context. */
+blosc2_async* blosc2_compress_ctx_async(blosc2_context* context, const void* src, int32_t srcsize,
+                                        void* dest, int32_t destsize, blosc2_async_cb callback,
+                                        void* user_data) {
+  /* A context for the other direction gives the error of the synchronous function */
+  return queue_async(context, true, src, srcsize, dest, destsize, callback, user_data);
+}
+
+
+/* The public routine for asynchronous decompression with context. */
+blosc2_async* blosc2_decompress_ctx_async(blosc2_context* context, const void* src, int32_t srcsize,
+                                          void* dest, int32_t destsize, blosc2_async_cb callback,
+                                          void* user_data) {
+  /* A context for the other direction gives the error of the synchronous function */
+  return queue_async(context, false, src, srcsize, dest, destsize, callback, user_data);
+}
+
+
+int blosc2_async_poll(blosc2_async* handle, int* result) {
+  blosc2_context* context = handle->context;
+
+  pthread_mutex_lock(&context->async_mutex);
+  bool done = handle->done;
+  pthread_mutex_unlock(&context->async_mutex);
+  if (done && result != NULL) {
+    *result = handle->result;
+  }
+  return done ? 1 : 0;
+}
+
+
+int blosc2_async_wait(blosc2_async* handle) {
+  blosc2_context* context = handle->context;
+
+  pthread_mutex_lock(&context->async_mutex);
+  if (!context->async_own_thread) {
+    drive_async_queue(context, handle);
+  }
+  while (!handle->done) {
+    pthread_cond_wait(&context->async_done_cv, &context->async_mutex);
+  }
+  pthread_mutex_unlock(&context->async_mutex);
+  int result = handle->result;
+  my_free(handle);
+  return result;
+}
+
+
+int blosc2_async_run(blosc2_context* context) {
+  if (!context->async_started) {
+    return BLOSC2_ERROR_SUCCESS;
+  }
+  pthread_mutex_lock(&context->async_mutex);
+  if (context->async_own_thread) {
+    while (context->async_queue != NULL) {
+      pthread_cond_wait(&context->async_done_cv, &context->async_mutex);
+    }
+  }
+  else {
+    drive_async_queue(context, NULL);
+  }
+  pthread_mutex_unlock(&context->async_mutex);
+  return BLOSC2_ERROR_SUCCESS;
+}
+
+
+/* The public secure routine for decompression. */
+int blosc2_decompress(const void* src, int32_t srcsize, void* dest, int32_t destsize) {
+  int result;
+
+  /* Check whether the library should be initialized */
+  if (!g_initlib) blosc_init();
+
+  /* The BLOSC_NTHREADS environment variable (read by blosc_init()) takes precedence */
+  int16_t nthreads = g_env.nthreads > 0 ? g_env.nthreads : g_nthreads;
+
+  blosc2_context* context = acquire_global_context(nthreads);
+  if (context == NULL) {
+    return BLOSC2_ERROR_MEMORY_ALLOC;
+  }
+  context->new_nthreads = nthreads;
+  context->schunk = g_schunk;
 
-  pthread_mutex_lock(&global_comp_mutex);
-
   result = blosc_run_decompression_with_context(
-          g_global_context, src, srcsize, dest, destsize);
+          context, src, srcsize, dest, destsize);
 
-  pthread_mutex_unlock(&global_comp_mutex);
+  release_global_context(context);
 
   return result;
 }
@@ -2624,17 +3389,81 @@ int blosc_decompress(const void* src, void* dest, size_t destsize) {
 }
 
 
-/* Specific routine optimized for decompression a small number of
-   items out of a compressed chunk.  This does not use threads because
-   it would affect negatively to performance. */
+/* Make room in the temporaries of a thread for blocks of `blocksize` bytes */
+static int resize_thread_tmp(struct thread_context* thcontext, int32_t blocksize, int32_t typesize) {
+  if (blocksize <= thcontext->tmp_blocksize) {
+    return 0;
+  }
+  int32_t ebsize = blocksize + typesize * (signed)sizeof(int32_t);
+  my_free(thcontext->tmp);
+  thcontext->tmp_nbytes = (size_t)4 * ebsize;
+  thcontext->tmp = my_malloc(thcontext->tmp_nbytes);
+  BLOSC_ERROR_NULL(thcontext->tmp, BLOSC2_ERROR_MEMORY_ALLOC);
+  thcontext->tmp2 = thcontext->tmp + ebsize;
+  thcontext->tmp3 = thcontext->tmp2 + ebsize;
+  thcontext->tmp4 = thcontext->tmp3 + ebsize;
+  thcontext->tmp_blocksize = blocksize;
+  return 0;
+}
+
+/* Decompress the items of a getitem that are in a block, and return their size */
+static int getitem_block(struct thread_context* thcontext, int32_t nblock, bool memcpyed) {
+  blosc2_context* context = thcontext->parent_context;
+  int32_t bsize = context->blocksize;
+  int32_t leftoverblock = 0;
+  if ((nblock == context->nblocks - 1) && (context->leftover > 0)) {
+    bsize = context->leftover;
+    leftoverblock = 1;
+  }
+
+  /* Compute start & stop for the block */
+  int32_t block_start = nblock * context->blocksize;
+  int32_t startb = context->getitem_start - block_start;
+  int32_t stopb = context->getitem_stop - block_start;
+  if (startb < 0) {
+    startb = 0;
+  }
+  if (stopb > bsize) {
+    stopb = bsize;
+  }
+  int32_t dest_offset = block_start + startb - context->getitem_start;
+
+  // If memcpyed we don't have a bstarts section (because it is not needed)
+  int32_t src_offset = memcpyed ?
+    context->header_overhead + block_start : sw32_(context->bstarts + nblock);
+
+  if (startb == 0 && stopb == bsize && !context->getitem_delta) {
+    // Whole blocks go straight to their place in dest
+    int rc = blosc_d(thcontext, bsize, leftoverblock, memcpyed,
+                     context->src, context->srcsize, src_offset, nblock,
+                     context->getitem_dest, dest_offset, thcontext->tmp, thcontext->tmp3);
+    return rc < 0 ? rc : bsize;
+  }
+
+  // Regular decompression.  Put results in tmp2.
+  int rc = blosc_d(thcontext, bsize, leftoverblock, memcpyed,
+                   context->src, context->srcsize, src_offset, nblock,
+                   thcontext->tmp2, 0, thcontext->tmp, thcontext->tmp3);
+  if (rc < 0) {
+    return rc;
+  }
+  /* Copy to destination */
+  memcpy(context->getitem_dest + dest_offset, thcontext->tmp2 + startb, (unsigned int)(stopb - startb));
+  return stopb - startb;
+}
+
+/* Specific routine optimized for decompressing a range of items out of a
+   compressed chunk.  Only the blocks with items are decompressed.  When the
+   context has several threads and the range spans enough blocks (see
+   parallel_ntasks), the blocks are spread among the threads, each one
+   decompressing its blocks straight into the destination.  Otherwise, and
+   always with DELTA (which needs the blocks in order), the blocks are
+   decompressed one after another by the caller. */
 int _blosc_getitem(blosc2_context* context, blosc_header* header, const void* src, int32_t srcsize,
                    int start, int nitems, void* dest, int32_t destsize) {
   uint8_t* _src = (uint8_t*)(src);  /* current pos for source buffer */
   uint8_t* _dest = (uint8_t*)(dest);
   int32_t ntbytes = 0;              /* the number of uncompressed bytes */
-  int32_t bsize, bsize2, ebsize, leftoverblock;
-  int32_t cbytes;
-  int32_t startb, stopb;
   int32_t stop = start + nitems;
   int j, rc;
 
@@ -2710,69 +3539,62 @@ int _blosc_getitem(blosc2_context* context, blosc_header* header, const void* sr
     return ntbytes;
   }
 
-  ebsize = header->blocksize + header->typesize * (signed)sizeof(int32_t);
-  struct thread_context* scontext = context->serial_context;
-  /* Resize the temporaries in serial context if needed */
-  if (header->blocksize > scontext->tmp_blocksize) {
-    my_free(scontext->tmp);
-    scontext->tmp_nbytes = (size_t)4 * ebsize;
-    scontext->tmp = my_malloc(scontext->tmp_nbytes);
-    BLOSC_ERROR_NULL(scontext->tmp, BLOSC2_ERROR_MEMORY_ALLOC);
-    scontext->tmp2 = scontext->tmp + ebsize;
-    scontext->tmp3 = scontext->tmp2 + ebsize;
-    scontext->tmp4 = scontext->tmp3 + ebsize;
-    scontext->tmp_blocksize = (int32_t)header->blocksize;
-  }
-
-  for (j = 0; j < context->nblocks; j++) {
-    bsize = header->blocksize;
-    leftoverblock = 0;
-    if ((j == context->nblocks - 1) && (context->leftover > 0)) {
-      bsize = context->leftover;
-      leftoverblock = 1;
+  /* Only the blocks with items are decompressed */
+  context->getitem_dest = _dest;
+  context->getitem_start = start * header->typesize;
+  context->getitem_stop = stop * header->typesize;
+  int32_t first_block = context->getitem_start / header->blocksize;
+  int32_t last_block = (context->getitem_stop - 1) / header->blocksize;
+  // DELTA takes the first block as a reference, so the blocks are staged at its place
+  context->getitem_delta = false;
+  for (int i = 0; i < BLOSC2_MAX_FILTERS; i++) {
+    if (context->filters[i] == BLOSC_DELTA) {
+      context->getitem_delta = true;
     }
+  }
 
-    /* Compute start & stop for each block */
-    startb = start * header->typesize - j * header->blocksize;
-    stopb = stop * header->typesize - j * header->blocksize;
-    if (stopb <= 0) {
-      // We can exit as soon as this block is beyond stop
-      break;
+  // The blocks are spread among the threads of the context (but DELTA needs them in order)
+  context->ntasks = 1;
+  if (context->nthreads > 1 && !context->getitem_delta) {
+    rc = check_nthreads(context);
+    if (rc < 0) {
+      context->getitem_dest = NULL;
+      return rc;
     }
-    if (startb >= header->blocksize) {
-      continue;
-    }
-    if (startb < 0) {
-      startb = 0;
+    context->ntasks = parallel_ntasks(context, last_block - first_block + 1, nitems * header->typesize);
+  }
+  if (context->ntasks > 1) {
+    context->thread_giveup_code = 1;
+    context->thread_nblock = first_block - 1;
+    context->getitem_last_block = last_block;
+    rc = run_tasks(context);
+    context->getitem_dest = NULL;
+    if (rc < 0) {
+      return rc;
     }
-    if (stopb > header->blocksize) {
-      stopb = header->blocksize;
+    if (context->thread_giveup_code < 0) {
+      return context->thread_giveup_code;
     }
-    bsize2 = stopb - startb;
-
-    /* Do the actual data copy */
-    // Regular decompression.  Put results in tmp2.
-    // If the block is aligned and the worst case fits in destination, let's avoid a copy
-    bool get_single_block = ((startb == 0) && (bsize == nitems * header->typesize));
-    uint8_t* tmp2 = get_single_block ? dest : scontext->tmp2;
+    return nitems * header->typesize;
+  }
 
-    // If memcpyed we don't have a bstarts section (because it is not needed)
-    int32_t src_offset = memcpyed ?
-      context->header_overhead + j * bsize : sw32_(context->bstarts + j);
+  struct thread_context* scontext = context->serial_context;
+  /* Resize the temporaries in serial context if needed */
+  rc = resize_thread_tmp(scontext, header->blocksize, header->typesize);
+  if (rc < 0) {
+    context->getitem_dest = NULL;
+    return rc;
+  }
 
-    int cbytes = blosc_d(context->serial_context, bsize, leftoverblock, memcpyed,
-                         src, srcsize, src_offset, j,
-                         tmp2, 0, scontext->tmp, scontext->tmp3);
-    if (cbytes < 0) {
-      ntbytes = cbytes;
+  for (j = first_block; j <= last_block; j++) {
+    rc = getitem_block(scontext, j, memcpyed);
+    if (rc < 0) {
+      ntbytes = rc;
       break;
     }
-    if (!get_single_block) {
-      /* Copy to destination */
-      memcpy((uint8_t *) dest + ntbytes, tmp2 + startb, (unsigned int) bsize2);
-    }
-    ntbytes += bsize2;
+    ntbytes += rc;
   }
+  context->getitem_dest = NULL;
 
   return ntbytes;
 }
@@ -2834,13 +3656,52 @@ int blosc2_getitem_ctx(blosc2_context* context, const void* src, int32_t srcsize
   return result;
 }
 
+/* Decompress blocks of a getitem until there are none left (see _blosc_getitem) */
+static void t_blosc_do_getitem(struct thread_context* thcontext) {
+  blosc2_context* context = thcontext->parent_context;
+  bool memcpyed = blocks_memcpyed(context);
+
+  int rc = resize_thread_tmp(thcontext, context->blocksize, context->typesize);
+  int32_t nblock = ATOMIC_FETCH_ADD(&context->thread_nblock, 1) + 1;
+  while (rc >= 0 && nblock <= context->getitem_last_block && context->thread_giveup_code > 0) {
+    rc = getitem_block(thcontext, nblock, memcpyed);
+    nblock = ATOMIC_FETCH_ADD(&context->thread_nblock, 1) + 1;
+  }
+  if (rc < 0) {
+    pthread_mutex_lock(&context->count_mutex);
+    context->thread_giveup_code = rc;
+    pthread_mutex_unlock(&context->count_mutex);
+  }
+}
+
+/* Run items of a batch until there are none left, with the context of the
+   task (see run_batch) */
+static void t_blosc_do_batch(struct thread_context* thcontext) {
+  blosc2_context* context = thcontext->parent_context;
+  blosc2_context* item_context = context->batch_contexts[thcontext->tid];
+
+  int32_t i = ATOMIC_FETCH_ADD(&context->batch_next, 1);
+  while (i < context->batch_nitems) {
+    context->batch_results[i] = context->batch_func(item_context, context->batch_data, i);
+    i = ATOMIC_FETCH_ADD(&context->batch_next, 1);
+  }
+}
+
 /* execute single compression/decompression job for a single thread_context */
 static void t_blosc_do_job(void *ctxt)
 {
   struct thread_context* thcontext = (struct thread_context*)ctxt;
   blosc2_context* context = thcontext->parent_context;
+  if (context->batch_func != NULL) {
+    t_blosc_do_batch(thcontext);
+    return;
+  }
+  if (context->getitem_dest != NULL) {
+    t_blosc_do_getitem(thcontext);
+    return;
+  }
   int32_t cbytes;
-  int32_t ntdest;
+  int32_t ntbytes = 0;           /* bytes (de-)compressed in a dynamic schedule */
   int32_t tblocks;               /* number of blocks per thread */
   int32_t tblock;                /* limit block on a thread */
   int32_t nblock_;              /* private copy of nblock */
@@ -2861,6 +3722,7 @@ static void t_blosc_do_job(void *ctxt)
   uint8_t* tmp;
   uint8_t* tmp2;
   uint8_t* tmp3;
+  blosc_staging* staging = NULL;
 
   /* Get parameters for this thread before entering the main loop */
   blocksize = context->blocksize;
@@ -2874,7 +3736,7 @@ static void t_blosc_do_job(void *ctxt)
   dest = context->dest;
 
   /* Resize the temporaries if needed */
-  if (blocksize > thcontext->tmp_blocksize) {
+  if (blocksize > thcontext->tmp_blocksize || (size_t) 4 * ebsize > thcontext->tmp_nbytes) {
     my_free(thcontext->tmp);
     thcontext->tmp_nbytes = (size_t) 4 * ebsize;
     thcontext->tmp = my_malloc(thcontext->tmp_nbytes);
@@ -2889,17 +3751,12 @@ static void t_blosc_do_job(void *ctxt)
   tmp3 = thcontext->tmp3;
 
   // Determine whether we can do a static distribution of workload among different threads
-  bool memcpyed = context->header_flags & (uint8_t)BLOSC_MEMCPYED;
-  if (!context->do_compress && context->special_type) {
-    // Fake a runlen as if its a memcpyed chunk
-    memcpyed = true;
-  }
-
-  bool static_schedule = (!compress || memcpyed) && context->block_maskout == NULL;
+  bool memcpyed = blocks_memcpyed(context);
+  bool static_schedule = is_static_schedule(context);
   if (static_schedule) {
       /* Blocks per thread */
-      tblocks = nblocks / context->nthreads;
-      leftover2 = nblocks % context->nthreads;
+      tblocks = nblocks / context->ntasks;
+      leftover2 = nblocks % context->ntasks;
       tblocks = (leftover2 > 0) ? tblocks + 1 : tblocks;
       nblock_ = thcontext->tid * tblocks;
       tblock = nblock_ + tblocks;
@@ -2909,12 +3766,13 @@ static void t_blosc_do_job(void *ctxt)
   }
   else {
     // Use dynamic schedule via a queue.  Get the next block.
-    pthread_mutex_lock(&context->count_mutex);
-    context->thread_nblock++;
-    nblock_ = context->thread_nblock;
-    pthread_mutex_unlock(&context->count_mutex);
+    nblock_ = ATOMIC_FETCH_ADD(&context->thread_nblock, 1) + 1;
     tblock = nblocks;
   }
+  if (compress && !memcpyed) {
+    staging = &context->stagings[thcontext->tid];
+    staging->used = 0;
+  }
 
   /* Loop over blocks */
   leftoverblock = 0;
@@ -2943,9 +3801,25 @@ static void t_blosc_do_job(void *ctxt)
         }
       }
       else {
-        /* Regular compression */
+        /* Regular compression, into the staging area of the task */
+        if (staging->used + ebsize > staging->size) {
+          int64_t size = 2 * staging->size;
+          if (size < staging->used + ebsize) {
+            size = staging->used + ebsize;
+          }
+          uint8_t* buffer = realloc(staging->buffer, size);
+          if (buffer == NULL) {
+            BLOSC_TRACE_ERROR("Error allocating memory for the compressed blocks.");
+            pthread_mutex_lock(&context->count_mutex);
+            context->thread_giveup_code = BLOSC2_ERROR_MEMORY_ALLOC;
+            pthread_mutex_unlock(&context->count_mutex);
+            break;
+          }
+          staging->buffer = buffer;
+          staging->size = size;
+        }
         cbytes = blosc_c(thcontext, bsize, leftoverblock, 0,
-                          ebsize, src, nblock_ * blocksize, tmp2, tmp, tmp3);
+                          ebsize, src, nblock_ * blocksize, staging->buffer + staging->used, tmp, tmp3);
       }
     }
     else {
@@ -2980,48 +3854,35 @@ static void t_blosc_do_job(void *ctxt)
     }
 
     if (compress && !memcpyed) {
-      /* Start critical section */
-      pthread_mutex_lock(&context->count_mutex);
-      ntdest = context->output_bytes;
-      // Note: do not use a typical local dict_training variable here
-      // because it is probably cached from previous calls if the number of
-      // threads does not change (the usual thing).
-      if (!(context->use_dict && context->dict_cdict == NULL)) {
-        _sw32(bstarts + nblock_, (int32_t) ntdest);
-      }
-
-      if ((cbytes == 0) || (ntdest + cbytes > maxbytes)) {
+      /* Keep the running total of the chunk, so as to give up as soon as it does not fit */
+      if ((cbytes == 0) || (ATOMIC_FETCH_ADD(&context->output_bytes, cbytes) + cbytes > maxbytes)) {
+        pthread_mutex_lock(&context->count_mutex);
         context->thread_giveup_code = 0;  /* uncompressible buf */
         pthread_mutex_unlock(&context->count_mutex);
         break;
       }
-      context->thread_nblock++;
-      nblock_ = context->thread_nblock;
-      context->output_bytes += cbytes;
-      pthread_mutex_unlock(&context->count_mutex);
-      /* End of critical section */
-
-      /* Copy the compressed buffer to destination */
-      memcpy(dest + ntdest, tmp2, (unsigned int) cbytes);
+      /* The block is copied to its place in dest later on (see copy_staged_blocks) */
+      blosc_staged_block* staged = &context->staged_blocks[nblock_];
+      staged->tid = thcontext->tid;
+      staged->offset = (int32_t) staging->used;
+      staged->cbytes = cbytes;
+      staging->used += cbytes;
+      nblock_ = ATOMIC_FETCH_ADD(&context->thread_nblock, 1) + 1;
     }
     else if (static_schedule) {
       nblock_++;
     }
     else {
-      pthread_mutex_lock(&context->count_mutex);
-      context->thread_nblock++;
-      nblock_ = context->thread_nblock;
-      context->output_bytes += cbytes;
-      pthread_mutex_unlock(&context->count_mutex);
+      ntbytes += cbytes;
+      nblock_ = ATOMIC_FETCH_ADD(&context->thread_nblock, 1) + 1;
     }
 
   } /* closes while (nblock_) */
 
-  if (static_schedule) {
-    context->output_bytes = context->sourcesize;
-    if (compress) {
-      context->output_bytes += context->header_overhead;
-    }
+  if (ntbytes > 0) {
+    pthread_mutex_lock(&context->count_mutex);
+    context->output_bytes += ntbytes;
+    pthread_mutex_unlock(&context->count_mutex);
   }
 
 }
@@ -3030,13 +3891,13 @@ static void t_blosc_do_job(void *ctxt)
 static void* t_blosc(void* ctxt) {
   struct thread_context* thcontext = (struct thread_context*)ctxt;
   blosc2_context* context = thcontext->parent_context;
-#ifdef BLOSC_POSIX_BARRIERS
-  int rc;
-#endif
+  blosc_handoff* handoff = &context->handoffs[thcontext->tid];
+  int32_t job_id = 0;
 
   while (1) {
-    /* Synchronization point for all threads (wait for initialization) */
-    WAIT_INIT(NULL, context);
+    /* Only the threads taking part in a job are handed it off */
+    wait_handoff(context, handoff, job_id);
+    job_id = ATOMIC_LOAD(&handoff->job_id);
 
     if (context->end_threads) {
       break;
@@ -3044,8 +3905,7 @@ static void* t_blosc(void* ctxt) {
 
     t_blosc_do_job(ctxt);
 
-    /* Meeting point for all threads (wait for finalization) */
-    WAIT_FINISH(NULL, context);
+    job_task_done(context);
   }
 
   /* Cleanup our working space and context */
@@ -3063,22 +3923,24 @@ int init_threadpool(blosc2_context *context) {
   pthread_mutex_init(&context->count_mutex, NULL);
   pthread_mutex_init(&context->delta_mutex, NULL);
   pthread_cond_init(&context->delta_cv, NULL);
+  pthread_mutex_init(&context->lazy_mutex, NULL);
+  pthread_cond_init(&context->lazy_cv, NULL);
 
   /* Set context thread sentinels */
   context->thread_giveup_code = 1;
   context->thread_nblock = -1;
 
-  /* Barrier initialization */
-#ifdef BLOSC_POSIX_BARRIERS
-  pthread_barrier_init(&context->barr_init, NULL, context->nthreads + 1);
-  pthread_barrier_init(&context->barr_finish, NULL, context->nthreads + 1);
-#else
-  pthread_mutex_init(&context->count_threads_mutex, NULL);
-  pthread_cond_init(&context->count_threads_cv, NULL);
-  context->count_threads = 0;      /* Reset threads counter */
-#endif
+  /* Handoff initialization */
+  pthread_mutex_init(&context->handoff_mutex, NULL);
+  pthread_cond_init(&context->done_cv, NULL);
+  context->spin_nsecs = handoff_spin_nsecs();
+  context->caller_parked = false;
 
-  if (threads_callback) {
+  context->threads_shared = g_shared_pool != NULL && threads_callback == NULL;
+  if (context->threads_shared) {
+    /* The threads (and their temporaries) are the ones of the shared pool */
+  }
+  else if (threads_callback) {
       /* Create thread contexts to store data for callback threads */
     context->thread_contexts = (struct thread_context *)my_malloc(
             context->nthreads * sizeof(struct thread_context));
@@ -3093,12 +3955,19 @@ int init_threadpool(blosc2_context *context) {
       pthread_attr_setdetachstate(&context->ct_attr, PTHREAD_CREATE_JOINABLE);
     #endif
 
-    /* Make space for thread handlers */
+    /* Make space for thread handlers (the calling thread is the one with tid 0) */
     context->threads = (pthread_t*)my_malloc(
             context->nthreads * sizeof(pthread_t));
     BLOSC_ERROR_NULL(context->threads, BLOSC2_ERROR_MEMORY_ALLOC);
-    /* Finally, create the threads */
+    context->handoffs = (blosc_handoff*)my_malloc(context->nthreads * sizeof(blosc_handoff));
+    BLOSC_ERROR_NULL(context->handoffs, BLOSC2_ERROR_MEMORY_ALLOC);
     for (tid = 0; tid < context->nthreads; tid++) {
+      context->handoffs[tid].job_id = 0;
+      context->handoffs[tid].parked = false;
+      pthread_cond_init(&context->handoffs[tid].cv, NULL);
+    }
+    /* Finally, create the threads */
+    for (tid = 1; tid < context->nthreads; tid++) {
       /* Create a thread context (will destroy when finished) */
       struct thread_context *thread_context = create_thread_context(context, tid);
       BLOSC_ERROR_NULL(thread_context, BLOSC2_ERROR_THREAD_CREATE);
@@ -3124,9 +3993,191 @@ int init_threadpool(blosc2_context *context) {
   return 0;
 }
 
+/* Run a task of a job in the shared pool (with the temporaries of the running thread) */
+static void shared_pool_run_task(struct thread_context* thcontext, blosc2_context* context, int16_t tid) {
+  if (thcontext->tmp == NULL && init_thread_context(thcontext, context, tid) < 0) {
+    pthread_mutex_lock(&context->count_mutex);
+    context->thread_giveup_code = BLOSC2_ERROR_MEMORY_ALLOC;
+    pthread_mutex_unlock(&context->count_mutex);
+    return;
+  }
+  thcontext->parent_context = context;
+  thcontext->tid = tid;
+  t_blosc_do_job(thcontext);
+}
+
+/* Claim the next task of a job; the pool must be locked */
+static int16_t shared_pool_claim(shared_pool* pool, shared_job* job) {
+  int16_t task = job->next_task++;
+  if (job->next_task == job->ntasks) {
+    // Nothing left to claim, so take the job out of the queue
+    shared_job** jobp = &pool->jobs;
+    while (*jobp != job) {
+      jobp = &(*jobp)->next;
+    }
+    *jobp = job->next;
+  }
+  return task;
+}
+
+static void* t_shared_pool(void* ctxt) {
+  struct thread_context* thcontext = (struct thread_context*)ctxt;
+  shared_pool* pool = g_shared_pool;
+
+  pthread_mutex_lock(&pool->mutex);
+  while (1) {
+    while (pool->jobs == NULL && !pool->end_threads) {
+      pthread_cond_wait(&pool->jobs_cv, &pool->mutex);
+    }
+    if (pool->end_threads) {
+      break;
+    }
+    shared_job* job = pool->jobs;
+    int16_t task = shared_pool_claim(pool, job);
+    pthread_mutex_unlock(&pool->mutex);
+
+    shared_pool_run_task(thcontext, job->context, task);
+
+    pthread_mutex_lock(&pool->mutex);
+    job->ndone++;
+    if (job->ndone == job->ntasks) {
+      pthread_cond_broadcast(&pool->done_cv);
+    }
+  }
+  pthread_mutex_unlock(&pool->mutex);
+
+  return NULL;
+}
+
+/* Submit the blocks of a context to the shared pool as one task per thread of
+ * the context.  The calling thread runs tasks too, so the job is done even when
+ * every thread of the pool is busy with other contexts. */
+static int shared_pool_do_job(blosc2_context* context) {
+  shared_pool* pool = g_shared_pool;
+  if (context->serial_context == NULL) {
+    context->serial_context = create_thread_context(context, 0);
+    BLOSC_ERROR_NULL(context->serial_context, BLOSC2_ERROR_THREAD_CREATE);
+  }
+  shared_job job = {.context = context, .ntasks = context->ntasks};
+
+  pthread_mutex_lock(&pool->mutex);
+  shared_job** jobp = &pool->jobs;
+  while (*jobp != NULL) {
+    jobp = &(*jobp)->next;
+  }
+  *jobp = &job;
+  pthread_cond_broadcast(&pool->jobs_cv);
+  while (job.next_task < job.ntasks) {
+    int16_t task = shared_pool_claim(pool, &job);
+    pthread_mutex_unlock(&pool->mutex);
+    shared_pool_run_task(context->serial_context, context, task);
+    pthread_mutex_lock(&pool->mutex);
+    job.ndone++;
+  }
+  while (job.ndone < job.ntasks) {
+    pthread_cond_wait(&pool->done_cv, &pool->mutex);
+  }
+  pthread_mutex_unlock(&pool->mutex);
+  context->serial_context->tid = 0;
+
+  return 0;
+}
+
+static void release_shared_pool(void) {
+  shared_pool* pool = g_shared_pool;
+  if (pool == NULL) {
+    return;
+  }
+  pthread_mutex_lock(&pool->mutex);
+  pool->end_threads = true;
+  pthread_cond_broadcast(&pool->jobs_cv);
+  pthread_mutex_unlock(&pool->mutex);
+  for (int16_t t = 0; t < pool->nthreads; t++) {
+    int rc = pthread_join(pool->threads[t], NULL);
+    if (rc) {
+      BLOSC_TRACE_ERROR("Return code from pthread_join() is %d\n"
+                        "\tError detail: %s.", rc, strerror(rc));
+    }
+    destroy_thread_context(pool->thread_contexts + t);
+  }
+  pthread_mutex_destroy(&pool->mutex);
+  pthread_cond_destroy(&pool->jobs_cv);
+  pthread_cond_destroy(&pool->done_cv);
+  my_free(pool->thread_contexts);
+  my_free(pool->threads);
+  my_free(pool);
+  g_shared_pool = NULL;
+}
+
+static int init_shared_pool(int16_t nthreads) {
+  shared_pool* pool = (shared_pool*)my_malloc(sizeof(shared_pool));
+  BLOSC_ERROR_NULL(pool, BLOSC2_ERROR_MEMORY_ALLOC);
+  memset(pool, 0, sizeof(shared_pool));
+  pthread_mutex_init(&pool->mutex, NULL);
+  pthread_cond_init(&pool->jobs_cv, NULL);
+  pthread_cond_init(&pool->done_cv, NULL);
+  pool->threads = (pthread_t*)my_malloc(nthreads * sizeof(pthread_t));
+  BLOSC_ERROR_NULL(pool->threads, BLOSC2_ERROR_MEMORY_ALLOC);
+  /* The temporaries are made (or resized) by the first tasks that each thread gets */
+  pool->thread_contexts = (struct thread_context*)my_malloc(nthreads * sizeof(struct thread_context));
+  BLOSC_ERROR_NULL(pool->thread_contexts, BLOSC2_ERROR_MEMORY_ALLOC);
+  memset(pool->thread_contexts, 0, nthreads * sizeof(struct thread_context));
+  g_shared_pool = pool;
+
+  for (int16_t tid = 0; tid < nthreads; tid++) {
+    int rc = pthread_create(&pool->threads[tid], NULL, t_shared_pool,
+                            (void*)(pool->thread_contexts + tid));
+    if (rc) {
+      BLOSC_TRACE_ERROR("Return code from pthread_create() is %d.\n"
+                        "\tError detail: %s\n", rc, strerror(rc));
+      release_shared_pool();
+      return BLOSC2_ERROR_THREAD_CREATE;
+    }
+    pool->nthreads++;
+  }
+
+  return 0;
+}
+
+int32_t blosc2_set_parallel_min_nbytes(int32_t nbytes) {
+  int32_t ret = g_parallel_min_nbytes;
+  g_parallel_min_nbytes = nbytes != 0 ? nbytes : BLOSC2_PARALLEL_MIN_NBYTES;
+  return ret;
+}
+
+int16_t blosc2_get_shared_nthreads(void) {
+  return g_shared_nthreads;
+}
+
+int16_t blosc2_set_shared_nthreads(int16_t nthreads) {
+  int16_t ret = g_shared_nthreads;
+
+  if (nthreads < 0) {
+    BLOSC_TRACE_ERROR("nthreads must be a positive integer (or 0).");
+    return BLOSC2_ERROR_INVALID_PARAM;
+  }
+  /* Check whether the library should be initialized */
+  if (!g_initlib) blosc_init();
+
+  if (nthreads != ret || (nthreads > 0) != (g_shared_pool != NULL)) {
+    release_shared_pool();
+    g_shared_nthreads = 0;
+    if (nthreads > 0) {
+      int rc = init_shared_pool(nthreads);
+      if (rc < 0) {
+        return rc;
+      }
+    }
+    g_shared_nthreads = nthreads;
+  }
+
+  return ret;
+}
+
 int16_t blosc_get_nthreads(void)
 {
-  return g_nthreads;
+  /* BLOSC_NTHREADS prevails (see get_global_settings) */
+  return g_env.nthreads > 0 ? g_env.nthreads : g_nthreads;
 }
 
 int16_t blosc_set_nthreads(int16_t nthreads_new) {
@@ -3135,11 +4186,8 @@ int16_t blosc_set_nthreads(int16_t nthreads_new) {
   /* Check whether the library should be initialized */
   if (!g_initlib) blosc_init();
 
- if (nthreads_new != ret) {
-   g_nthreads = nthreads_new;
-   g_global_context->new_nthreads = nthreads_new;
-   check_nthreads(g_global_context);
- }
+  /* The contexts of the non-contextual API catch up when they are used */
+  g_nthreads = nthreads_new;
 
   return ret;
 }
@@ -3148,7 +4196,8 @@ int16_t blosc_set_nthreads(int16_t nthreads_new) {
 const char* blosc_get_compressor(void)
 {
   const char* compname;
-  blosc_compcode_to_compname(g_compressor, &compname);
+  /* BLOSC_COMPRESSOR prevails (see get_global_settings) */
+  blosc_compcode_to_compname(g_env.compcode >= 0 ? g_env.compcode : g_compressor, &compname);
 
   return compname;
 }
@@ -3351,7 +4400,8 @@ const char* blosc_cbuffer_complib(const void* cbuffer) {
    that an automatic blocksize is computed internally. */
 int blosc_get_blocksize(void)
 {
-  return (int)g_force_blocksize;
+  /* BLOSC_BLOCKSIZE prevails (see get_global_settings) */
+  return (int)(g_env.blocksize > 0 ? g_env.blocksize : g_force_blocksize);
 }
 
 
@@ -3366,11 +4416,85 @@ void blosc_set_blocksize(size_t size) {
    reachable (the default). */
 void blosc_set_schunk(blosc2_schunk* schunk) {
   g_schunk = schunk;
-  g_global_context->schunk = schunk;
 }
 
 blosc2_io *blosc2_io_global = NULL;
 
+/* Read the environment variables for the non-contextual API */
+static void read_env(void) {
+  char* envvar;
+  long value;
+
+  g_env.clevel = -1;
+  g_env.doshuffle = -1;
+  g_env.delta = -1;
+  g_env.typesize = 0;
+  g_env.compcode = -1;
+  g_env.blocksize = 0;
+  g_env.nthreads = 0;
+
+  envvar = getenv("BLOSC_CLEVEL");
+  if (envvar != NULL) {
+    value = strtol(envvar, NULL, 10);
+    if ((value != EINVAL) && (value >= 0)) {
+      g_env.clevel = (int)value;
+    }
+  }
+
+  envvar = getenv("BLOSC_SHUFFLE");
+  if (envvar != NULL) {
+    if (strcmp(envvar, "NOSHUFFLE") == 0) {
+      g_env.doshuffle = BLOSC_NOSHUFFLE;
+    }
+    if (strcmp(envvar, "SHUFFLE") == 0) {
+      g_env.doshuffle = BLOSC_SHUFFLE;
+    }
+    if (strcmp(envvar, "BITSHUFFLE") == 0) {
+      g_env.doshuffle = BLOSC_BITSHUFFLE;
+    }
+  }
+
+  envvar = getenv("BLOSC_DELTA");
+  if (envvar != NULL) {
+    g_env.delta = strcmp(envvar, "1") == 0 ? 1 : 0;
+  }
+
+  envvar = getenv("BLOSC_TYPESIZE");
+  if (envvar != NULL) {
+    value = strtol(envvar, NULL, 10);
+    if ((value != EINVAL) && (value > 0)) {
+      g_env.typesize = (int32_t)value;
+    }
+  }
+
+  envvar = getenv("BLOSC_COMPRESSOR");
+  if (envvar != NULL) {
+    int code = blosc_compname_to_compcode(envvar);
+    g_env.compcode = (code >= 0 && code < BLOSC_LAST_CODEC) ? code : -2;
+  }
+
+  envvar = getenv("BLOSC_BLOCKSIZE");
+  if (envvar != NULL) {
+    value = strtol(envvar, NULL, 10);
+    if ((value != EINVAL) && (value > 0)) {
+      g_env.blocksize = (int32_t)value;
+    }
+  }
+
+  envvar = getenv("BLOSC_NTHREADS");
+  if (envvar != NULL) {
+    value = strtol(envvar, NULL, 10);
+    if ((value != EINVAL) && (value > 0)) {
+      g_env.nthreads = (int16_t)value;
+    }
+  }
+
+  g_env.blosc1_compat = getenv("BLOSC_BLOSC1_COMPAT") != NULL;
+
+  envvar = getenv("BLOSC_WARN");
+  g_env.warnlvl = envvar != NULL ? strtol(envvar, NULL, 10) : 0;
+}
+
 void blosc_init(void) {
   /* Return if Blosc is already initialized */
   if (g_initlib) return;
@@ -3385,11 +4509,12 @@ void blosc_init(void) {
   register_filters();
 #endif
   pthread_mutex_init(&global_comp_mutex, NULL);
-  /* Create a global context */
-  g_global_context = (blosc2_context*)my_malloc(sizeof(blosc2_context));
-  memset(g_global_context, 0, sizeof(blosc2_context));
-  g_global_context->nthreads = g_nthreads;
-  g_global_context->new_nthreads = g_nthreads;
+  /* The contexts for the non-contextual API are created on demand */
+  g_global_contexts = NULL;
+  g_global_nidle = 0;
+  g_global_nidle_threads = 0;
+  read_env();
+  apply_env_settings();
   g_initlib = 1;
 }
 
@@ -3399,7 +4524,15 @@ void blosc_destroy(void) {
   if (!g_initlib) return;
 
   g_initlib = 0;
-  blosc2_free_ctx(g_global_context);
+  while (g_global_contexts != NULL) {
+    blosc2_context* context = g_global_contexts;
+    g_global_contexts = context->next_global;
+    blosc2_free_ctx(context);
+  }
+  g_global_nidle = 0;
+  g_global_nidle_threads = 0;
+  release_shared_pool();
+  g_shared_nthreads = 0;
 
   pthread_mutex_destroy(&global_comp_mutex);
 
@@ -3412,7 +4545,10 @@ int release_threadpool(blosc2_context *context) {
   int rc;
 
   if (context->threads_started > 0) {
-    if (threads_callback) {
+    if (context->threads_shared) {
+      /* The shared pool keeps its threads */
+    }
+    else if (threads_callback) {
       /* free context data for user-managed threads */
       for (t=0; t<context->threads_started; t++)
         destroy_thread_context(context->thread_contexts + t);
@@ -3421,10 +4557,12 @@ int release_threadpool(blosc2_context *context) {
     else {
       /* Tell all existing threads to finish */
       context->end_threads = 1;
-      WAIT_INIT(-1, context);
+      for (t = 1; t < context->threads_started; t++) {
+        handoff_job(context, &context->handoffs[t]);
+      }
 
       /* Join exiting threads */
-      for (t = 0; t < context->threads_started; t++) {
+      for (t = 1; t < context->threads_started; t++) {
         rc = pthread_join(context->threads[t], &status);
         if (rc) {
           BLOSC_TRACE_ERROR("Return code from pthread_join() is %d\n"
@@ -3438,6 +4576,10 @@ int release_threadpool(blosc2_context *context) {
       #endif
 
       /* Release thread handlers */
+      for (t = 0; t < context->threads_started; t++) {
+        pthread_cond_destroy(&context->handoffs[t].cv);
+      }
+      my_free(context->handoffs);
       my_free(context->threads);
     }
 
@@ -3445,20 +4587,17 @@ int release_threadpool(blosc2_context *context) {
     pthread_mutex_destroy(&context->count_mutex);
     pthread_mutex_destroy(&context->delta_mutex);
     pthread_cond_destroy(&context->delta_cv);
+    pthread_mutex_destroy(&context->lazy_mutex);
+    pthread_cond_destroy(&context->lazy_cv);
 
-    /* Barriers */
-  #ifdef BLOSC_POSIX_BARRIERS
-    pthread_barrier_destroy(&context->barr_init);
-    pthread_barrier_destroy(&context->barr_finish);
-  #else
-    pthread_mutex_destroy(&context->count_threads_mutex);
-    pthread_cond_destroy(&context->count_threads_cv);
-    context->count_threads = 0;      /* Reset threads counter */
-  #endif
+    /* Handoff */
+    pthread_mutex_destroy(&context->handoff_mutex);
+    pthread_cond_destroy(&context->done_cv);
 
     /* Reset flags and counters */
     context->end_threads = 0;
     context->threads_started = 0;
+    context->threads_shared = 0;
   }
 
 
@@ -3469,7 +4608,14 @@ int blosc_free_resources(void) {
   /* Return if Blosc is not initialized */
   if (!g_initlib) return BLOSC2_ERROR_FAILURE;
 
-  return release_threadpool(g_global_context);
+  /* Contexts in use by other threads keep their threads */
+  pthread_mutex_lock(&global_comp_mutex);
+  for (blosc2_context* context = g_global_contexts; context != NULL; context = context->next_global) {
+    release_threadpool(context);
+  }
+  pthread_mutex_unlock(&global_comp_mutex);
+
+  return 0;
 }
 
 
@@ -3509,9 +4655,11 @@ blosc2_context* blosc2_create_cctx(blosc2_cparams cparams) {
   context->nthreads = cparams.nthreads;
   context->new_nthreads = context->nthreads;
   context->blocksize = cparams.blocksize;
+  context->user_blocksize = cparams.blocksize;
   context->splitmode = cparams.splitmode;
   context->threads_started = 0;
   context->schunk = cparams.schunk;
+  context->parallel_min_nbytes = cparams.parallel_min_nbytes;
 
   if (cparams.prefilter != NULL) {
     context->prefilter = cparams.prefilter;
@@ -3543,6 +4691,7 @@ blosc2_context* blosc2_create_dctx(blosc2_dparams dparams) {
   context->block_maskout = NULL;
   context->block_maskout_nitems = 0;
   context->schunk = dparams.schunk;
+  context->parallel_min_nbytes = dparams.parallel_min_nbytes;
 
   if (dparams.postfilter != NULL) {
     context->postfilter = dparams.postfilter;
@@ -3556,6 +4705,7 @@ blosc2_context* blosc2_create_dctx(blosc2_dparams dparams) {
 
 
 void blosc2_free_ctx(blosc2_context* context) {
+  release_async_thread(context);
   release_threadpool(context);
   if (context->serial_context != NULL) {
     free_thread_context(context->serial_context);
@@ -3583,6 +4733,19 @@ void blosc2_free_ctx(blosc2_context* context) {
   if (context->block_maskout != NULL) {
     free(context->block_maskout);
   }
+  free(context->lazy_segments);
+  free(context->lazy_rbytes);
+  free(context->lazy_block_segment);
+  free(context->lazy_buffer);
+  for (int i = 0; i < context->nstagings; i++) {
+    free(context->stagings[i].buffer);
+  }
+  free(context->stagings);
+  free(context->staged_blocks);
+  for (int i = 0; i < context->nbatch_contexts; i++) {
+    blosc2_free_ctx(context->batch_contexts[i]);
+  }
+  free(context->batch_contexts);
   my_free(context);
 }
 
@@ -3604,6 +4767,7 @@ int blosc2_ctx_get_cparams(blosc2_context *ctx, blosc2_cparams *cparams) {
   cparams->prefilter = ctx->prefilter;
   cparams->preparams = ctx->preparams;
   cparams->udbtune = ctx->udbtune;
+  cparams->parallel_min_nbytes = ctx->parallel_min_nbytes;
 
   return BLOSC2_ERROR_SUCCESS;
 }
@@ -3614,6 +4778,7 @@ int blosc2_ctx_get_dparams(blosc2_context *ctx, blosc2_dparams *dparams) {
   dparams->schunk = ctx->schunk;
   dparams->postfilter = ctx->postfilter;
   dparams->postparams = ctx->postparams;
+  dparams->parallel_min_nbytes = ctx->parallel_min_nbytes;
 
   return BLOSC2_ERROR_SUCCESS;
 }
@@ -3939,5 +5104,26 @@ blosc2_io_cb *blosc2_get_io_cb(uint8_t id) {
     }
     return blosc2_get_io_cb(id);
   }
+  if (id == BLOSC2_IO_FILESYSTEM_MMAP) {
+    if (_blosc2_register_io_cb(&BLOSC2_IO_CB_MMAP) < 0) {
+      BLOSC_TRACE_ERROR("Error registering the mmap IO API");
+      return NULL;
+    }
+    return blosc2_get_io_cb(id);
+  }
+  if (id == BLOSC2_IO_FILESYSTEM_URING) {
+    if (_blosc2_register_io_cb(&BLOSC2_IO_CB_URING) < 0) {
+      BLOSC_TRACE_ERROR("Error registering the io_uring IO API");
+      return NULL;
+    }
+    return blosc2_get_io_cb(id);
+  }
+  if (id == BLOSC2_IO_FILESYSTEM_DIRECT) {
+    if (_blosc2_register_io_cb(&BLOSC2_IO_CB_DIRECT) < 0) {
+      BLOSC_TRACE_ERROR("Error registering the direct IO API");
+      return NULL;
+    }
+    return blosc2_get_io_cb(id);
+  }
   return NULL;
 }
@@ -17,12 +17,6 @@
   #include <pthread.h>
 #endif
 
-/* Have problems using posix barriers when symbol value is 200112L */
-/* Requires more investigation, but this will work for the moment */
-#if defined(_POSIX_BARRIERS) && ( (_POSIX_BARRIERS - 20012L) >= 0 && _POSIX_BARRIERS != 200112L)
-#define BLOSC_POSIX_BARRIERS
-#endif
-
 #include "blosc2.h"
 
 #if defined(HAVE_ZSTD)
@@ -33,6 +27,51 @@
   #include <ipps.h>
 #endif /* HAVE_IPP */
 
+/* The handoff of jobs to a thread of a context */
+typedef struct {
+  int32_t job_id;
+  /* Bumped for every job that the thread takes part in */
+  bool parked;
+  /* Whether the thread is waiting on cv (rather than spinning) */
+  pthread_cond_t cv;
+} blosc_handoff;
+
+/* The blocks compressed by a task of a parallel compression */
+typedef struct {
+  uint8_t* buffer;
+  int64_t size;
+  /* The allocated bytes */
+  int64_t used;
+  /* The bytes taken by blocks */
+} blosc_staging;
+
+/* An asynchronous (de)compression, queued on its context */
+struct blosc2_async_s {
+  blosc2_context* context;
+  bool compress;
+  const void* src;
+  int32_t srcsize;
+  void* dest;
+  int32_t destsize;
+  blosc2_async_cb callback;
+  void* user_data;
+  int result;
+  bool done;
+  /* Whether result is ready (guarded by the async_mutex of the context) */
+  struct blosc2_async_s* next;
+  /* The next one in the queue of the context */
+};
+
+/* Where a compressed block is, before being copied into the chunk */
+typedef struct {
+  int32_t tid;
+  /* The task that compressed it */
+  int32_t offset;
+  /* Its offset in the staging area of the task */
+  int32_t cbytes;
+  /* Its compressed size */
+} blosc_staged_block;
+
 struct blosc2_context_s {
   const uint8_t* src;
   /* The source buffer */
@@ -52,6 +91,8 @@ struct blosc2_context_s {
   /* Extra bytes at end of buffer */
   int32_t blocksize;
   /* Length of the block in bytes */
+  int32_t user_blocksize;
+  /* The blocksize in the cparams (0 for an automatic one) */
   int32_t splitmode;
   /* Whether the blocks should be split or not */
   int32_t output_bytes;
@@ -106,6 +147,34 @@ struct blosc2_context_s {
    * the number of blocks in chunk) */
   blosc2_schunk* schunk;
   /* Associated super-chunk (if available) */
+  bool lazy_active;
+  /* Whether the blocks of the lazy chunk being decompressed are read in segments (see lazy_prepare_blocks) */
+  void* lazy_batch;
+  /* The reads of the segments in flight, if submitted up front (io_uring) */
+  void* lazy_fp;
+  /* The (pinned) file handle for the reads of the segments */
+  blosc2_io_segment* lazy_segments;
+  /* The reads covering the blocks of the lazy chunk (one or several neighbouring blocks each) */
+  int64_t* lazy_rbytes;
+  /* The bytes read for each segment (or whether it is being read) */
+  int32_t* lazy_block_segment;
+  /* The segment holding each block (followed by scratch space for sorting the blocks) */
+  int32_t lazy_nsegments;
+  /* The number of segments of the current chunk */
+  int32_t lazy_maxsegments;
+  /* The number of segments that fit in lazy_segments */
+  uint8_t* lazy_buffer;
+  /* The buffer for all the segments of the lazy chunk */
+  int64_t lazy_buffer_size;
+  /* The size of lazy_buffer */
+  blosc_staging* stagings;
+  /* The staging area of every task of a parallel compression */
+  int16_t nstagings;
+  /* The number of tasks with a staging area */
+  blosc_staged_block* staged_blocks;
+  /* Where every block has been staged, so that they are put in block order */
+  int32_t max_staged_blocks;
+  /* The number of blocks that fit in staged_blocks */
   struct thread_context* serial_context;
   /* Cache for temporaries for serial operation */
   int do_compress;
@@ -121,15 +190,16 @@ struct blosc2_context_s {
   int16_t end_threads;
   pthread_t *threads;
   struct thread_context *thread_contexts; /* only for user-managed threads */
+  int16_t threads_shared;  /* whether the threads are the ones of the shared pool */
   pthread_mutex_t count_mutex;
-#ifdef BLOSC_POSIX_BARRIERS
-  pthread_barrier_t barr_init;
-  pthread_barrier_t barr_finish;
-#else
-  int count_threads;
-  pthread_mutex_t count_threads_mutex;
-  pthread_cond_t count_threads_cv;
-#endif
+  blosc_handoff* handoffs;  /* one per thread, for handing jobs off to it */
+  int32_t spin_nsecs;      /* the time to spin waiting for a handoff before parking */
+  int16_t ntasks;          /* the tasks of the current job (see parallel_ntasks) */
+  int32_t parallel_min_nbytes;  /* the minimum of bytes for each task (0 for the global one) */
+  int32_t ntasks_left;     /* the tasks of the threads still running */
+  bool caller_parked;      /* whether the caller is waiting on done_cv */
+  pthread_mutex_t handoff_mutex;
+  pthread_cond_t done_cv;
 #if !defined(_WIN32)
   pthread_attr_t ct_attr;      /* creation time attrs for threads */
 #endif
@@ -139,6 +209,34 @@ struct blosc2_context_s {
   int dref_not_init;       /* data ref in delta not initialized */
   pthread_mutex_t delta_mutex;
   pthread_cond_t delta_cv;
+  pthread_mutex_t lazy_mutex;  /* for reading the segments of lazy chunks */
+  pthread_cond_t lazy_cv;
+  struct blosc2_context_s* next_global;  /* the next idle context of the non-contextual API */
+  /* Batches of buffers (see blosc2_compress_batch) */
+  struct blosc2_context_s** batch_contexts;  /* one for every task, with a single thread */
+  int16_t nbatch_contexts;
+  int (*batch_func)(struct blosc2_context_s* context, void* batch_data, int32_t nitem);
+                           /* runs an item of the current batch (NULL if none) */
+  void* batch_data;
+  int32_t* batch_results;
+  int32_t batch_nitems;
+  int32_t batch_next;      /* the next item to claim */
+  /* Getitem (see _blosc_getitem) */
+  uint8_t* getitem_dest;   /* where the items go (NULL if no getitem is running) */
+  int32_t getitem_start;   /* the offset of the first item in the chunk */
+  int32_t getitem_stop;    /* the offset after the last item in the chunk */
+  int32_t getitem_last_block;
+  bool getitem_delta;      /* whether the chunk has the DELTA filter */
+  /* Asynchronous (de)compressions (see blosc2_compress_ctx_async) */
+  bool async_started;      /* whether the queue (and async_thread, if any) is set up */
+  bool async_own_thread;   /* whether async_thread runs the queue (no threads callback) */
+  bool async_running;      /* whether a caller is running the head of the queue, without async_thread */
+  bool async_end;          /* tells async_thread to finish once the queue is empty */
+  pthread_t async_thread;
+  pthread_mutex_t async_mutex;
+  pthread_cond_t async_cv;       /* signals new (de)compressions to async_thread */
+  pthread_cond_t async_done_cv;  /* signals finished (de)compressions to waiters */
+  blosc2_async* async_queue;     /* the (de)compressions not done yet, in order */
 };
 
 struct thread_context {
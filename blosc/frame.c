@@ -23,6 +23,7 @@
 #if defined(_WIN32)
 #include <windows.h>
   #include <malloc.h>
+  #include <io.h>
 
 /* stdint.h only available in VS2010 (VC++ 16.0) and newer */
   #if defined(_MSC_VER) && _MSC_VER < 1600
@@ -31,6 +32,9 @@
     #include <stdint.h>
   #endif
 
+#else
+  #include <fcntl.h>
+  #include <unistd.h>
 #endif  /* _WIN32 */
 
 /* If C11 is supported, use it's built-in aligned allocation. */
@@ -42,6 +46,9 @@
 /* Create a new (empty) frame */
 blosc2_frame_s* frame_new(const char* urlpath) {
   blosc2_frame_s* new_frame = calloc(1, sizeof(blosc2_frame_s));
+  new_frame->sframe_nextid = -1;
+  pthread_mutex_init(&new_frame->fp_mutex, NULL);
+  pthread_mutex_init(&new_frame->offsets_mutex, NULL);
   if (urlpath != NULL) {
     char* new_urlpath = malloc(strlen(urlpath) + 1);  // + 1 for the trailing NULL
     new_frame->urlpath = strcpy(new_urlpath, urlpath);
@@ -60,6 +67,18 @@ int frame_free(blosc2_frame_s* frame) {
   if (frame->coffsets != NULL) {
     free(frame->coffsets);
   }
+  free(frame->offsets);
+  free(frame->holes);
+  free(frame->wbuffer);
+
+  for (int i = 0; i < FRAME_FP_CACHE_SIZE; i++) {
+    frame_fp_entry* entry = &frame->fp_cache[i];
+    if (entry->fp != NULL) {
+      entry->io_cb->close(entry->fp);
+    }
+  }
+  pthread_mutex_destroy(&frame->fp_mutex);
+  pthread_mutex_destroy(&frame->offsets_mutex);
 
   if (frame->urlpath != NULL) {
     free(frame->urlpath);
@@ -71,6 +90,222 @@ int frame_free(blosc2_frame_s* frame) {
 }
 
 
+/* Make room for (at least) len bytes in the buffer of an in-memory frame.
+ *
+ * The room grows geometrically (or straight to the reserve hint of the storage),
+ * so that appending chunks does not copy the whole frame every time.
+ */
+static uint8_t* frame_reserve(blosc2_frame_s* frame, int64_t len) {
+  if (frame->cframe != NULL && len <= frame->cframe_size) {
+    return frame->cframe;
+  }
+  int64_t size = frame->cframe_size * 2;
+  if (size < len) {
+    size = len;
+  }
+  if (frame->schunk != NULL && frame->schunk->storage != NULL &&
+      frame->schunk->storage->cframe_reserve > size) {
+    size = frame->schunk->storage->cframe_reserve;
+  }
+  uint8_t* cframe = realloc(frame->cframe, (size_t)size);
+  if (cframe == NULL) {
+    return NULL;
+  }
+  frame->cframe = cframe;
+  frame->cframe_size = size;
+  return cframe;
+}
+
+
+/* Release the room of an in-memory frame beyond its length. */
+int frame_trim(blosc2_frame_s* frame) {
+  if (frame->cframe == NULL || frame->cframe_size == frame->len) {
+    return 0;
+  }
+  uint8_t* cframe = realloc(frame->cframe, (size_t)frame->len);
+  if (cframe == NULL) {
+    BLOSC_TRACE_ERROR("Cannot realloc space for the frame.");
+    return BLOSC2_ERROR_MEMORY_ALLOC;
+  }
+  frame->cframe = cframe;
+  frame->cframe_size = frame->len;
+  return 0;
+}
+
+
+/* Look up (or open) a handle in the cache of file handles; the cache must be locked */
+static frame_fp_entry* get_fp_entry(blosc2_frame_s* frame, int64_t nchunk, const blosc2_io* io) {
+  frame_fp_entry* entry = NULL;
+  frame_fp_entry* victim = NULL;
+  for (int i = 0; i < FRAME_FP_CACHE_SIZE; i++) {
+    frame_fp_entry* entry_ = &frame->fp_cache[i];
+    if (entry_->fp != NULL && !entry_->stale && entry_->nchunk == nchunk) {
+      entry = entry_;
+      break;
+    }
+    // Prefer free slots, then the least recently used one (but never a pinned one)
+    if (entry_->refs > 0) {
+      continue;
+    }
+    if (victim == NULL ||
+        (victim->fp != NULL && (entry_->fp == NULL || entry_->last_use < victim->last_use))) {
+      victim = entry_;
+    }
+  }
+
+  if (entry == NULL) {
+    if (victim == NULL) {
+      BLOSC_TRACE_ERROR("All the cached file handles of the frame are in use.");
+      return NULL;
+    }
+    blosc2_io_cb *io_cb = blosc2_get_io_cb(io->id);
+    if (io_cb == NULL) {
+      BLOSC_TRACE_ERROR("Error getting the input/output API");
+      return NULL;
+    }
+    void* fp;
+    if (nchunk >= 0) {
+      fp = sframe_open_chunk(frame->urlpath, nchunk, "rb", io);
+    }
+    else if (frame->sframe) {
+      fp = sframe_open_index(frame->urlpath, "rb", io);
+    }
+    else {
+      fp = io_cb->open(frame->urlpath, "rb", io->params);
+    }
+    if (fp == NULL) {
+      return NULL;
+    }
+    if (victim->fp != NULL) {
+      victim->io_cb->close(victim->fp);
+    }
+    entry = victim;
+    entry->fp = fp;
+    entry->nchunk = nchunk;
+    entry->io_cb = io_cb;
+  }
+  entry->last_use = ++frame->fp_clock;
+
+  return entry;
+}
+
+
+/* Get a cached file handle for reading the frame (or the chunk files of a sframe) */
+void* frame_acquire_fp(blosc2_frame_s* frame, int64_t nchunk, const blosc2_io* io) {
+  if (nchunk < 0) {
+    nchunk = -1;
+  }
+  pthread_mutex_lock(&frame->fp_mutex);
+  frame_fp_entry* entry = get_fp_entry(frame, nchunk, io);
+  if (entry == NULL) {
+    pthread_mutex_unlock(&frame->fp_mutex);
+    return NULL;
+  }
+
+  return entry->fp;
+}
+
+
+/* Release a file handle acquired with frame_acquire_fp() */
+void frame_release_fp(blosc2_frame_s* frame) {
+  pthread_mutex_unlock(&frame->fp_mutex);
+}
+
+
+/* Get a cached file handle for positional reads, without keeping the cache locked */
+void* frame_pin_fp(blosc2_frame_s* frame, int64_t nchunk, const blosc2_io* io) {
+  if (nchunk < 0) {
+    nchunk = -1;
+  }
+  pthread_mutex_lock(&frame->fp_mutex);
+  frame_fp_entry* entry = get_fp_entry(frame, nchunk, io);
+  void* fp = NULL;
+  if (entry != NULL) {
+    entry->refs++;
+    fp = entry->fp;
+  }
+  pthread_mutex_unlock(&frame->fp_mutex);
+
+  return fp;
+}
+
+
+/* Unpin a file handle pinned with frame_pin_fp() */
+void frame_unpin_fp(blosc2_frame_s* frame, void* fp) {
+  pthread_mutex_lock(&frame->fp_mutex);
+  for (int i = 0; i < FRAME_FP_CACHE_SIZE; i++) {
+    frame_fp_entry* entry = &frame->fp_cache[i];
+    if (entry->fp == fp && entry->refs > 0) {
+      entry->refs--;
+      if (entry->refs == 0 && entry->stale) {
+        // It was invalidated while in use
+        entry->io_cb->close(entry->fp);
+        entry->fp = NULL;
+        entry->stale = false;
+      }
+      break;
+    }
+  }
+  pthread_mutex_unlock(&frame->fp_mutex);
+}
+
+
+/* Close a cached file handle (typically, before writing into the file) */
+void frame_invalidate_fp(blosc2_frame_s* frame, int64_t nchunk) {
+  if (nchunk < 0) {
+    nchunk = -1;
+  }
+  pthread_mutex_lock(&frame->fp_mutex);
+  for (int i = 0; i < FRAME_FP_CACHE_SIZE; i++) {
+    frame_fp_entry* entry = &frame->fp_cache[i];
+    if (entry->fp != NULL && !entry->stale && entry->nchunk == nchunk) {
+      if (entry->refs > 0) {
+        // Still being read; the last user will close it
+        entry->stale = true;
+      }
+      else {
+        entry->io_cb->close(entry->fp);
+        entry->fp = NULL;
+      }
+      break;
+    }
+  }
+  pthread_mutex_unlock(&frame->fp_mutex);
+}
+
+
+/* Positional read, falling back to seek + read */
+int64_t frame_read_at(blosc2_io_cb* io_cb, void* fp, int64_t offset, int64_t size, void* ptr) {
+  if (io_cb->read_at != NULL) {
+    return io_cb->read_at(fp, offset, size, ptr);
+  }
+  if (io_cb->seek(fp, offset, SEEK_SET) != 0) {
+    return -1;
+  }
+  return io_cb->read(ptr, 1, size, fp);
+}
+
+
+/* Vectored read, falling back to a positional read per segment */
+int64_t frame_readv_at(blosc2_io_cb* io_cb, void* fp, const blosc2_io_segment* segments, int64_t nsegments) {
+  if (io_cb->readv_at != NULL) {
+    return io_cb->readv_at(fp, segments, nsegments);
+  }
+  int64_t total = 0;
+  for (int64_t i = 0; i < nsegments; i++) {
+    int64_t rbytes = frame_read_at(io_cb, fp, segments[i].offset, segments[i].size, segments[i].ptr);
+    if (rbytes < 0) {
+      return rbytes;
+    }
+    total += rbytes;
+    if (rbytes < segments[i].size) {
+      break;
+    }
+  }
+  return total;
+}
+
+
 void *new_header_frame(blosc2_schunk *schunk, blosc2_frame_s *frame) {
   if (frame == NULL) {
     return NULL;
@@ -359,41 +594,53 @@ void *new_header_frame(blosc2_schunk *schunk, blosc2_frame_s *frame) {
 }
 
 
-int get_header_info(blosc2_frame_s *frame, int32_t *header_len, int64_t *frame_len, int64_t *nbytes, int64_t *cbytes,
-                    int32_t *blocksize, int32_t *chunksize, int32_t *nchunks, int32_t *typesize, uint8_t *compcode,
-                    uint8_t *compcode_meta, uint8_t *clevel, uint8_t *filters, uint8_t *filters_meta, const blosc2_io *io) {
-  uint8_t* framep = frame->cframe;
-  uint8_t header[FRAME_HEADER_MINLEN];
+/* Get the fixed part of the header of an on-disk frame.  It is read only once
+ * from the file; writers keep the in-memory copy in sync afterwards.  As
+ * several threads may read the frame at once, the copy is checked and filled
+ * under the mutex of the file handles. */
+static uint8_t* get_cached_header(blosc2_frame_s *frame, const blosc2_io *io) {
+  pthread_mutex_lock(&frame->fp_mutex);
+  bool header_cached = frame->header_cached;
+  pthread_mutex_unlock(&frame->fp_mutex);
+  if (header_cached) {
+    return frame->header;
+  }
 
   blosc2_io_cb *io_cb = blosc2_get_io_cb(io->id);
   if (io_cb == NULL) {
     BLOSC_TRACE_ERROR("Error getting the input/output API");
-    return BLOSC2_ERROR_PLUGIN_IO;
+    return NULL;
+  }
+  void* fp = frame_acquire_fp(frame, -1, io);
+  if (fp == NULL) {
+    return NULL;
+  }
+  if (!frame->header_cached) {
+    // Another thread may have read it meanwhile
+    int64_t rbytes = frame_read_at(io_cb, fp, 0, FRAME_HEADER_MINLEN, frame->header);
+    frame->header_cached = (rbytes == FRAME_HEADER_MINLEN);
   }
+  header_cached = frame->header_cached;
+  frame_release_fp(frame);
+
+  return header_cached ? frame->header : NULL;
+}
+
+
+int get_header_info(blosc2_frame_s *frame, int32_t *header_len, int64_t *frame_len, int64_t *nbytes, int64_t *cbytes,
+                    int32_t *blocksize, int32_t *chunksize, int32_t *nchunks, int32_t *typesize, uint8_t *compcode,
+                    uint8_t *compcode_meta, uint8_t *clevel, uint8_t *filters, uint8_t *filters_meta, const blosc2_io *io) {
+  uint8_t* framep = frame->cframe;
 
   if (frame->len <= 0) {
     return BLOSC2_ERROR_READ_BUFFER;
   }
 
   if (frame->cframe == NULL) {
-    int64_t rbytes = 0;
-    void* fp = NULL;
-    if (frame->sframe) {
-      fp = sframe_open_index(frame->urlpath, "rb",
-                             io);
-    }
-    else {
-      fp = io_cb->open(frame->urlpath, "rb", io->params);
-    }
-    if (fp != NULL) {
-      rbytes = io_cb->read(header, 1, FRAME_HEADER_MINLEN, fp);
-      io_cb->close(fp);
-    }
-    (void) rbytes;
-    if (rbytes != FRAME_HEADER_MINLEN) {
+    framep = get_cached_header(frame, io);
+    if (framep == NULL) {
       return BLOSC2_ERROR_FILE_READ;
     }
-    framep = header;
   }
 
   // Consistency check for frame type
@@ -512,6 +759,7 @@ int update_frame_len(blosc2_frame_s* frame, int64_t len) {
   }
   else {
     void* fp = NULL;
+    frame_invalidate_fp(frame, -1);
     if (frame->sframe) {
       fp = sframe_open_index(frame->urlpath, "rb+",
                              frame->schunk->storage->io);
@@ -524,7 +772,9 @@ int update_frame_len(blosc2_frame_s* frame, int64_t len) {
     to_big(&swap_len, &len, sizeof(int64_t));
     int64_t wbytes = io_cb->write(&swap_len, 1, sizeof(int64_t), fp);
     io_cb->close(fp);
+    memcpy(frame->header + FRAME_LEN, &swap_len, sizeof(int64_t));
     if (wbytes != sizeof(int64_t)) {
+      frame->header_cached = false;
       BLOSC_TRACE_ERROR("Cannot write the frame length in header.");
       return BLOSC2_ERROR_FILE_WRITE;
     }
@@ -534,6 +784,11 @@ int update_frame_len(blosc2_frame_s* frame, int64_t len) {
 
 
 int frame_update_trailer(blosc2_frame_s* frame, blosc2_schunk* schunk) {
+  // Pending appends go first (see frame_flush)
+  int flush_rc = frame_flush(frame);
+  if (flush_rc < 0) {
+    return flush_rc;
+  }
   if (frame != NULL && frame->len == 0) {
     BLOSC_TRACE_ERROR("The trailer cannot be updated on empty frames.");
   }
@@ -707,8 +962,7 @@ int frame_update_trailer(blosc2_frame_s* frame, blosc2_schunk* schunk) {
   // and it is always at the end of the frame, we can just write (or overwrite) it
   // at the end of the frame.
   if (frame->cframe != NULL) {
-    frame->cframe = realloc(frame->cframe, (size_t)(trailer_offset + trailer_len));
-    if (frame->cframe == NULL) {
+    if (frame_reserve(frame, trailer_offset + trailer_len) == NULL) {
       BLOSC_TRACE_ERROR("Cannot realloc space for the frame.");
       return BLOSC2_ERROR_MEMORY_ALLOC;
     }
@@ -716,6 +970,7 @@ int frame_update_trailer(blosc2_frame_s* frame, blosc2_schunk* schunk) {
   }
   else {
     void* fp = NULL;
+    frame_invalidate_fp(frame, -1);
     if (frame->sframe) {
       fp = sframe_open_index(frame->urlpath, "rb+",
                              frame->schunk->storage->io);
@@ -819,10 +1074,12 @@ blosc2_frame_s* frame_from_file(const char* urlpath, const blosc2_io *io) {
   int64_t frame_len;
   to_big(&frame_len, header + FRAME_LEN, sizeof(frame_len));
 
-  blosc2_frame_s* frame = calloc(1, sizeof(blosc2_frame_s));
+  blosc2_frame_s* frame = frame_new(NULL);
   frame->urlpath = urlpath_cpy;
   frame->len = frame_len;
   frame->sframe = sframe;
+  memcpy(frame->header, header, FRAME_HEADER_MINLEN);
+  frame->header_cached = true;
 
   // Now, the trailer length
   io_cb->seek(fp, frame_len - FRAME_TRAILER_MINLEN, SEEK_SET);
@@ -830,14 +1087,12 @@ blosc2_frame_s* frame_from_file(const char* urlpath, const blosc2_io *io) {
   io_cb->close(fp);
   if (rbytes != FRAME_TRAILER_MINLEN) {
     BLOSC_TRACE_ERROR("Cannot read from file '%s'.", urlpath);
-    free(urlpath_cpy);
-    free(frame);
+    frame_free(frame);
     return NULL;
   }
   int trailer_offset = FRAME_TRAILER_MINLEN - FRAME_TRAILER_LEN_OFFSET;
   if (trailer[trailer_offset - 1] != 0xce) {
-    free(urlpath_cpy);
-    free(frame);
+    frame_free(frame);
     return NULL;
   }
   uint32_t trailer_len;
@@ -862,14 +1117,14 @@ blosc2_frame_s* frame_from_cframe(uint8_t *cframe, int64_t len, bool copy) {
     return NULL;
   }
 
-  blosc2_frame_s* frame = calloc(1, sizeof(blosc2_frame_s));
+  blosc2_frame_s* frame = frame_new(NULL);
   frame->len = frame_len;
 
   // Now, the trailer length
   const uint8_t* trailer = cframe + frame_len - FRAME_TRAILER_MINLEN;
   int trailer_offset = FRAME_TRAILER_MINLEN - FRAME_TRAILER_LEN_OFFSET;
   if (trailer[trailer_offset - 1] != 0xce) {
-    free(frame);
+    frame_free(frame);
     return NULL;
   }
   uint32_t trailer_len;
@@ -884,6 +1139,7 @@ blosc2_frame_s* frame_from_cframe(uint8_t *cframe, int64_t len, bool copy) {
     frame->cframe = cframe;
     frame->avoid_cframe_free = true;
   }
+  frame->cframe_size = len;
 
   return frame;
 }
@@ -973,10 +1229,16 @@ int64_t frame_from_schunk(blosc2_schunk *schunk, blosc2_frame_s *frame) {
 
   // Create the frame and put the header at the beginning
   if (frame->urlpath == NULL) {
-    frame->cframe = malloc((size_t)frame->len);
+    if (frame_reserve(frame, frame->len) == NULL) {
+      BLOSC_TRACE_ERROR("Cannot allocate space for the frame.");
+      free(off_chunk);
+      free(h2);
+      return BLOSC2_ERROR_MEMORY_ALLOC;
+    }
     memcpy(frame->cframe, h2, h2len);
   }
   else {
+    frame_invalidate_fp(frame, -1);
     if (frame->sframe) {
       fp = sframe_open_index(frame->urlpath, "wb",
                              frame->schunk->storage->io);
@@ -984,7 +1246,9 @@ int64_t frame_from_schunk(blosc2_schunk *schunk, blosc2_frame_s *frame) {
     else {
       fp = io_cb->open(frame->urlpath, "wb", frame->schunk->storage->io->params);
     }
-    io_cb->write(h2, h2len, 1, fp);
+    int64_t wbytes = io_cb->write(h2, h2len, 1, fp);
+    memcpy(frame->header, h2, FRAME_HEADER_MINLEN);
+    frame->header_cached = (wbytes == 1);
   }
   free(h2);
 
@@ -1103,19 +1367,15 @@ uint8_t* get_coffsets(blosc2_frame_s *frame, int32_t header_len, int64_t cbytes,
     return NULL;
   }
 
-  void* fp = NULL;
-  uint8_t* coffsets = malloc((size_t)coffsets_cbytes);
-  if (frame->sframe) {
-    fp = sframe_open_index(frame->urlpath, "rb",
-                           frame->schunk->storage->io);
-    io_cb->seek(fp, header_len + 0, SEEK_SET);
-  }
-  else {
-    fp = io_cb->open(frame->urlpath, "rb", frame->schunk->storage->io->params);
-    io_cb->seek(fp, header_len + cbytes, SEEK_SET);
+  void* fp = frame_acquire_fp(frame, -1, frame->schunk->storage->io);
+  if (fp == NULL) {
+    BLOSC_TRACE_ERROR("Cannot open the frame for reading the offsets.");
+    return NULL;
   }
-  int64_t rbytes = io_cb->read(coffsets, 1, (size_t)coffsets_cbytes, fp);
-  io_cb->close(fp);
+  uint8_t* coffsets = malloc((size_t)coffsets_cbytes);
+  int64_t coffsets_offset = frame->sframe ? header_len + 0 : header_len + cbytes;
+  int64_t rbytes = frame_read_at(io_cb, fp, coffsets_offset, coffsets_cbytes, coffsets);
+  frame_release_fp(frame);
   if (rbytes != coffsets_cbytes) {
     BLOSC_TRACE_ERROR("Cannot read the offsets out of the frame.");
     free(coffsets);
@@ -1127,8 +1387,12 @@ uint8_t* get_coffsets(blosc2_frame_s *frame, int32_t header_len, int64_t cbytes,
 
 
 int frame_update_header(blosc2_frame_s* frame, blosc2_schunk* schunk, bool new) {
+  // Pending appends go first (see frame_flush)
+  int flush_rc = frame_flush(frame);
+  if (flush_rc < 0) {
+    return flush_rc;
+  }
   uint8_t* framep = frame->cframe;
-  uint8_t header[FRAME_HEADER_MINLEN];
 
   if (frame->len <= 0) {
     return BLOSC2_ERROR_INVALID_PARAM;
@@ -1147,24 +1411,10 @@ int frame_update_header(blosc2_frame_s* frame, blosc2_schunk* schunk, bool new)
   }
 
   if (frame->cframe == NULL) {
-    int64_t rbytes = 0;
-    void* fp = NULL;
-    if (frame->sframe) {
-      fp = sframe_open_index(frame->urlpath, "rb+",
-                             frame->schunk->storage->io);
-    }
-    else {
-      fp = io_cb->open(frame->urlpath, "rb", frame->schunk->storage->io->params);
-    }
-    if (fp != NULL) {
-      rbytes = io_cb->read(header, 1, FRAME_HEADER_MINLEN, fp);
-      io_cb->close(fp);
-    }
-    (void) rbytes;
-    if (rbytes != FRAME_HEADER_MINLEN) {
+    framep = get_cached_header(frame, frame->schunk->storage->io);
+    if (framep == NULL) {
       return BLOSC2_ERROR_FILE_WRITE;
     }
-    framep = header;
   }
   uint32_t prev_h2len;
   from_big(&prev_h2len, framep + FRAME_HEADER_LEN, sizeof(prev_h2len));
@@ -1189,6 +1439,7 @@ int frame_update_header(blosc2_frame_s* frame, blosc2_schunk* schunk, bool new)
   void* fp = NULL;
   if (frame->cframe == NULL) {
     // Write updated header down to file
+    frame_invalidate_fp(frame, -1);
     if (frame->sframe) {
       fp = sframe_open_index(frame->urlpath, "rb+",
                              frame->schunk->storage->io);
@@ -1196,14 +1447,19 @@ int frame_update_header(blosc2_frame_s* frame, blosc2_schunk* schunk, bool new)
     else {
       fp = io_cb->open(frame->urlpath, "rb+", frame->schunk->storage->io->params);
     }
+    frame->header_cached = false;
     if (fp != NULL) {
-      io_cb->write(h2, h2len, 1, fp);
+      int64_t wbytes = io_cb->write(h2, h2len, 1, fp);
       io_cb->close(fp);
+      memcpy(frame->header, h2, FRAME_HEADER_MINLEN);
+      frame->header_cached = (wbytes == 1);
     }
   }
   else {
-    if (new) {
-      frame->cframe = realloc(frame->cframe, h2len);
+    if (new && frame_reserve(frame, h2len) == NULL) {
+      BLOSC_TRACE_ERROR("Cannot realloc space for the frame.");
+      free(h2);
+      return BLOSC2_ERROR_MEMORY_ALLOC;
     }
     memcpy(frame->cframe, h2, h2len);
   }
@@ -1352,17 +1608,10 @@ int frame_get_metalayers(blosc2_frame_s* frame, blosc2_schunk* schunk) {
       return BLOSC2_ERROR_PLUGIN_IO;
     }
 
-    void* fp = NULL;
-    if (frame->sframe) {
-      fp = sframe_open_index(frame->urlpath, "rb",
-                             frame->schunk->storage->io);
-    }
-    else {
-      fp = io_cb->open(frame->urlpath, "rb", frame->schunk->storage->io->params);
-    }
+    void* fp = frame_acquire_fp(frame, -1, frame->schunk->storage->io);
     if (fp != NULL) {
-      rbytes = io_cb->read(header, 1, header_len, fp);
-      io_cb->close(fp);
+      rbytes = frame_read_at(io_cb, fp, 0, header_len, header);
+      frame_release_fp(frame);
     }
     if (rbytes != (size_t) header_len) {
       BLOSC_TRACE_ERROR("Cannot access the header out of the frame.");
@@ -1530,20 +1779,10 @@ int frame_get_vlmetalayers(blosc2_frame_s* frame, blosc2_schunk* schunk) {
       return BLOSC2_ERROR_PLUGIN_IO;
     }
 
-    void* fp = NULL;
-    if (frame->sframe) {
-      char* eframe_name = malloc(strlen(frame->urlpath) + strlen("/chunks.b2frame") + 1);
-      sprintf(eframe_name, "%s/chunks.b2frame", frame->urlpath);
-      fp = io_cb->open(eframe_name, "rb", frame->schunk->storage->io->params);
-      free(eframe_name);
-    }
-    else {
-      fp = io_cb->open(frame->urlpath, "rb", frame->schunk->storage->io->params);
-    }
+    void* fp = frame_acquire_fp(frame, -1, frame->schunk->storage->io);
     if (fp != NULL) {
-      io_cb->seek(fp, trailer_offset, SEEK_SET);
-      rbytes = io_cb->read(trailer, 1, trailer_len, fp);
-      io_cb->close(fp);
+      rbytes = frame_read_at(io_cb, fp, trailer_offset, trailer_len, trailer);
+      frame_release_fp(frame);
     }
     if (rbytes != (size_t) trailer_len) {
       BLOSC_TRACE_ERROR("Cannot access the trailer out of the fileframe.");
@@ -1820,8 +2059,90 @@ int sort_offset(const void* a, const void* b) {
 }
 
 
-int get_coffset(blosc2_frame_s* frame, int32_t header_len, int64_t cbytes,
-                int32_t nchunk, int32_t nchunks, int64_t *offset) {
+/* Drop the resident (decompressed) chunk offsets, e.g. because the frame has changed. */
+static void drop_offsets(blosc2_frame_s* frame) {
+  free(frame->offsets);
+  frame->offsets = NULL;
+  frame->noffsets = 0;
+  frame->maxoffsets = 0;
+  frame->offsets_lookups = 0;
+}
+
+
+/* Make the chunk offsets resident by decompressing the offsets chunk.  Returns NULL on failure. */
+static int64_t* load_offsets(blosc2_frame_s* frame, int32_t header_len, int64_t cbytes,
+                             int32_t nchunks) {
+  int32_t off_cbytes;
+  uint8_t *coffsets = get_coffsets(frame, header_len, cbytes, nchunks, &off_cbytes);
+  if (coffsets == NULL) {
+    return NULL;
+  }
+  int32_t off_nbytes = nchunks * (int32_t)sizeof(int64_t);
+  int64_t* offsets = malloc((size_t)off_nbytes);
+  blosc2_dparams off_dparams = BLOSC2_DPARAMS_DEFAULTS;
+  blosc2_context *dctx = blosc2_create_dctx(off_dparams);
+  int32_t nbytes = blosc2_decompress_ctx(dctx, coffsets, off_cbytes, offsets, off_nbytes);
+  blosc2_free_ctx(dctx);
+  if (nbytes != off_nbytes) {
+    // Not an error per se; just keep using the compressed offsets
+    free(offsets);
+    return NULL;
+  }
+  frame->offsets = offsets;
+  frame->noffsets = nchunks;
+  frame->maxoffsets = nchunks;
+
+  return frame->offsets;
+}
+
+
+/* Get the resident chunk offsets, decompressing them when it is worth it.
+ *
+ * Returns NULL when the offsets are not resident, so they have to be fetched from the
+ * compressed offsets chunk.
+ */
+static int64_t* get_offsets(blosc2_frame_s* frame, int32_t header_len, int64_t cbytes,
+                            int32_t nchunks) {
+  if (frame->offsets != NULL) {
+    if (frame->noffsets == nchunks) {
+      return frame->offsets;
+    }
+    drop_offsets(frame);
+  }
+  int offsets_mode = BLOSC2_OFFSETS_AUTO;
+  if (frame->schunk != NULL && frame->schunk->storage != NULL) {
+    offsets_mode = frame->schunk->storage->offsets_mode;
+  }
+  if (offsets_mode == BLOSC2_OFFSETS_COMPRESSED || nchunks <= 0) {
+    return NULL;
+  }
+  if (offsets_mode == BLOSC2_OFFSETS_AUTO) {
+    // Decompressing all the offsets costs about the same than looking up
+    // one offset per block, so wait for that many lookups before doing it
+    int32_t nblocks = nchunks / (16 * 1024 / (int32_t)sizeof(int64_t)) + 1;
+    frame->offsets_lookups++;
+    if (frame->offsets_lookups <= nblocks) {
+      return NULL;
+    }
+  }
+
+  return load_offsets(frame, header_len, cbytes, nchunks);
+}
+
+
+static int lookup_coffset(blosc2_frame_s* frame, int32_t header_len, int64_t cbytes,
+                          int32_t nchunk, int32_t nchunks, int64_t *offset) {
+  int64_t* offsets = get_offsets(frame, header_len, cbytes, nchunks);
+  if (offsets != NULL) {
+    if (nchunk < 0 || nchunk >= nchunks) {
+      BLOSC_TRACE_ERROR("nchunk ('%d') exceeds the number of chunks ('%d') in frame.",
+                        nchunk, nchunks);
+      return BLOSC2_ERROR_INVALID_PARAM;
+    }
+    *offset = offsets[nchunk];
+    return (int)sizeof(int64_t);
+  }
+
   int32_t off_cbytes;
   // Get the offset to nchunk
   uint8_t *coffsets = get_coffsets(frame, header_len, cbytes, nchunks, &off_cbytes);
@@ -1831,7 +2152,17 @@ int get_coffset(blosc2_frame_s* frame, int32_t header_len, int64_t cbytes,
   }
 
   // Get the 64-bit offset
-  int rc = blosc2_getitem(coffsets, off_cbytes, nchunk, 1, offset, (int32_t)sizeof(int64_t));
+  return blosc2_getitem(coffsets, off_cbytes, nchunk, 1, offset, (int32_t)sizeof(int64_t));
+}
+
+
+int get_coffset(blosc2_frame_s* frame, int32_t header_len, int64_t cbytes,
+                int32_t nchunk, int32_t nchunks, int64_t *offset) {
+  // Several threads may read chunks at once (see blosc2_schunk_decompress_range),
+  // and the offsets are cached on the first lookups
+  pthread_mutex_lock(&frame->offsets_mutex);
+  int rc = lookup_coffset(frame, header_len, cbytes, nchunk, nchunks, offset);
+  pthread_mutex_unlock(&frame->offsets_mutex);
   if (rc < 0) {
     BLOSC_TRACE_ERROR("Problems retrieving a chunk offset.");
   } else if (!frame->sframe && *offset > frame->len) {
@@ -1891,6 +2222,22 @@ int frame_special_chunk(int64_t special_value, int32_t nbytes, int32_t typesize,
 }
 
 
+/* Get the address of the chunk at `offset` when the frame file is mapped in memory.
+ *
+ * Returns NULL if the I/O backend does not map files (or the chunk cannot be mapped).
+ */
+static uint8_t* get_mapped_chunk(blosc2_io_cb* io_cb, void* fp, int64_t offset, int32_t* chunk_cbytes) {
+  if (io_cb->id != BLOSC2_IO_FILESYSTEM_MMAP) {
+    return NULL;
+  }
+  uint8_t* header = blosc2_stdio_mmap_addr(fp, offset, BLOSC_EXTENDED_HEADER_LENGTH);
+  if (header == NULL || blosc2_cbuffer_sizes(header, NULL, chunk_cbytes, NULL) < 0) {
+    return NULL;
+  }
+  return blosc2_stdio_mmap_addr(fp, offset, *chunk_cbytes);
+}
+
+
 /* Return a compressed chunk that is part of a frame in the `chunk` parameter.
  * If the frame is disk-based, a buffer is allocated for the (compressed) chunk,
  * and hence a free is needed.  You can check if the chunk requires a free with the `needs_free`
@@ -1959,6 +2306,24 @@ int frame_get_chunk(blosc2_frame_s *frame, int nchunk, uint8_t **chunk, bool *ne
     return sframe_get_chunk(frame, nchunk, chunk, needs_free);
   }
 
+  if (frame->wbuffer_len > 0 && offset >= frame->wbuffer_offset) {
+    // The chunk is not written yet (see frame_flush); copy it, as the buffer is
+    // reallocated by appends and emptied by flushes
+    uint8_t* buffered_chunk = frame->wbuffer + (offset - frame->wbuffer_offset);
+    rc = blosc2_cbuffer_sizes(buffered_chunk, NULL, &chunk_cbytes, NULL);
+    if (rc < 0) {
+      return rc;
+    }
+    *chunk = malloc(chunk_cbytes);
+    if (*chunk == NULL) {
+      BLOSC_TRACE_ERROR("Cannot allocate memory for the chunk.");
+      return BLOSC2_ERROR_MEMORY_ALLOC;
+    }
+    memcpy(*chunk, buffered_chunk, chunk_cbytes);
+    *needs_free = true;
+    goto end;
+  }
+
   blosc2_io_cb *io_cb = blosc2_get_io_cb(frame->schunk->storage->io->id);
   if (io_cb == NULL) {
     BLOSC_TRACE_ERROR("Error getting the input/output API");
@@ -1967,26 +2332,43 @@ int frame_get_chunk(blosc2_frame_s *frame, int nchunk, uint8_t **chunk, bool *ne
 
   if (frame->cframe == NULL) {
     uint8_t header[BLOSC_EXTENDED_HEADER_LENGTH];
-    void* fp = io_cb->open(frame->urlpath, "rb", frame->schunk->storage->io->params);
-    io_cb->seek(fp, header_len + offset, SEEK_SET);
-    int64_t rbytes = io_cb->read(header, 1, sizeof(header), fp);
+    void* fp = frame_acquire_fp(frame, -1, frame->schunk->storage->io);
+    if (fp == NULL) {
+      BLOSC_TRACE_ERROR("Cannot open the frame for reading.");
+      return BLOSC2_ERROR_FILE_OPEN;
+    }
+    // Mapped frames are copied straight from the mapping, which goes away when the frame changes
+    uint8_t* mapped_chunk = get_mapped_chunk(io_cb, fp, header_len + offset, &chunk_cbytes);
+    if (mapped_chunk != NULL) {
+      *chunk = malloc(chunk_cbytes);
+      if (*chunk == NULL) {
+        frame_release_fp(frame);
+        BLOSC_TRACE_ERROR("Cannot allocate memory for the chunk.");
+        return BLOSC2_ERROR_MEMORY_ALLOC;
+      }
+      memcpy(*chunk, mapped_chunk, chunk_cbytes);
+      frame_release_fp(frame);
+      *needs_free = true;
+      goto end;
+    }
+    int64_t rbytes = frame_read_at(io_cb, fp, header_len + offset, sizeof(header), header);
     if (rbytes != sizeof(header)) {
       BLOSC_TRACE_ERROR("Cannot read the cbytes for chunk in the frame.");
-      io_cb->close(fp);
+      frame_release_fp(frame);
       return BLOSC2_ERROR_FILE_READ;
     }
     rc = blosc2_cbuffer_sizes(header, NULL, &chunk_cbytes, NULL);
     if (rc < 0) {
       BLOSC_TRACE_ERROR("Cannot read the cbytes for chunk in the frame.");
-      io_cb->close(fp);
+      frame_release_fp(frame);
       return rc;
     }
     *chunk = malloc(chunk_cbytes);
-    io_cb->seek(fp, header_len + offset, SEEK_SET);
-    rbytes = io_cb->read(*chunk, 1, chunk_cbytes, fp);
-    io_cb->close(fp);
+    rbytes = frame_read_at(io_cb, fp, header_len + offset, chunk_cbytes, *chunk);
+    frame_release_fp(frame);
     if (rbytes != chunk_cbytes) {
       BLOSC_TRACE_ERROR("Cannot read the chunk out of the frame.");
+      free(*chunk);
       return BLOSC2_ERROR_FILE_READ;
     }
     *needs_free = true;
@@ -2004,17 +2386,11 @@ int frame_get_chunk(blosc2_frame_s *frame, int nchunk, uint8_t **chunk, bool *ne
 }
 
 
-/* Return a compressed chunk that is part of a frame in the `chunk` parameter.
- * If the frame is disk-based, a buffer is allocated for the (lazy) chunk,
- * and hence a free is needed.  You can check if the chunk requires a free with the `needs_free`
- * parameter.
- * If the chunk does not need a free, it means that the frame is in memory and that just a
- * pointer to the location of the chunk in memory is returned.
- *
- * The size of the (compressed, potentially lazy) chunk is returned.  If some problem is detected,
- * a negative code is returned instead.
-*/
-int frame_get_lazychunk(blosc2_frame_s *frame, int nchunk, uint8_t **chunk, bool *needs_free) {
+/* Get a (lazy) chunk of a frame.  When `borrow` is true, chunks of mapped frames are
+ * returned as pointers into the mapping instead of lazy chunks, and chunks not flushed
+ * yet as pointers into the write buffer instead of copies. */
+static int get_lazychunk(blosc2_frame_s *frame, int nchunk, uint8_t **chunk, bool *needs_free,
+                         bool borrow) {
   int32_t header_len;
   int64_t frame_len;
   int64_t nbytes;
@@ -2064,6 +2440,29 @@ int frame_get_lazychunk(blosc2_frame_s *frame, int nchunk, uint8_t **chunk, bool
     goto end;
   }
 
+  if (frame->wbuffer_len > 0 && offset >= frame->wbuffer_offset) {
+    // The chunk is not written yet (see frame_flush) and just one pointer away, but
+    // only borrowers can keep that pointer, as appends and flushes invalidate it
+    uint8_t* buffered_chunk = frame->wbuffer + (offset - frame->wbuffer_offset);
+    rc = blosc2_cbuffer_sizes(buffered_chunk, NULL, &lazychunk_cbytes, NULL);
+    if (rc < 0) {
+      goto end;
+    }
+    if (borrow) {
+      *chunk = buffered_chunk;
+      goto end;
+    }
+    *chunk = malloc(lazychunk_cbytes);
+    if (*chunk == NULL) {
+      BLOSC_TRACE_ERROR("Cannot allocate memory for the chunk.");
+      rc = BLOSC2_ERROR_MEMORY_ALLOC;
+      goto end;
+    }
+    memcpy(*chunk, buffered_chunk, lazychunk_cbytes);
+    *needs_free = true;
+    goto end;
+  }
+
   blosc2_io_cb *io_cb = blosc2_get_io_cb(frame->schunk->storage->io->id);
   if (io_cb == NULL) {
     BLOSC_TRACE_ERROR("Error getting the input/output API");
@@ -2080,15 +2479,27 @@ int frame_get_lazychunk(blosc2_frame_s *frame, int nchunk, uint8_t **chunk, bool
     uint8_t header[BLOSC_EXTENDED_HEADER_LENGTH];
     if (frame->sframe) {
       // The chunk is not in the frame
-      fp = sframe_open_chunk(frame->urlpath, offset, "rb",
-                             frame->schunk->storage->io);
+      fp = frame_acquire_fp(frame, offset, frame->schunk->storage->io);
     }
     else {
-      fp = io_cb->open(frame->urlpath, "rb", frame->schunk->storage->io->params);
-      io_cb->seek(fp, header_len + offset, SEEK_SET);
+      fp = frame_acquire_fp(frame, -1, frame->schunk->storage->io);
     }
-    int64_t rbytes = io_cb->read(header, 1, BLOSC_EXTENDED_HEADER_LENGTH, fp);
-    if (rbytes != BLOSC_EXTENDED_HEADER_LENGTH) {
+    if (fp == NULL) {
+      BLOSC_TRACE_ERROR("Cannot open the frame for reading.");
+      rc = BLOSC2_ERROR_FILE_OPEN;
+      goto end;
+    }
+    if (borrow && !frame->sframe) {
+      // Mapped frames do not need lazy chunks; the whole chunk is just one pointer away
+      *chunk = get_mapped_chunk(io_cb, fp, header_len + offset, &lazychunk_cbytes);
+      if (*chunk != NULL) {
+        goto end;
+      }
+    }
+    // The chunk starts at the beginning of the chunk file in sframes
+    int64_t chunk_offset = frame->sframe ? 0 : header_len + offset;
+    int64_t rbytes = frame_read_at(io_cb, fp, chunk_offset, BLOSC_EXTENDED_HEADER_LENGTH, header);
+    if (rbytes != BLOSC_EXTENDED_HEADER_LENGTH) {
       BLOSC_TRACE_ERROR("Cannot read the header for chunk in the frame.");
       rc = BLOSC2_ERROR_FILE_READ;
       goto end;
@@ -2132,14 +2543,7 @@ int frame_get_lazychunk(blosc2_frame_s *frame, int nchunk, uint8_t **chunk, bool
     *needs_free = true;
 
     // Read just the full header and bstarts section too (lazy partial length)
-    if (frame->sframe) {
-      io_cb->seek(fp, 0, SEEK_SET);
-    }
-    else {
-      io_cb->seek(fp, header_len + offset, SEEK_SET);
-    }
-
-    rbytes = io_cb->read(*chunk, 1, streams_offset, fp);
+    rbytes = frame_read_at(io_cb, fp, chunk_offset, streams_offset, *chunk);
     if (rbytes != streams_offset) {
       BLOSC_TRACE_ERROR("Cannot read the (lazy) chunk out of the frame.");
       rc = BLOSC2_ERROR_FILE_READ;
@@ -2167,10 +2571,13 @@ int frame_get_lazychunk(blosc2_frame_s *frame, int nchunk, uint8_t **chunk, bool
     int32_t* block_csizes = malloc(nblocks * sizeof(int32_t));
 
     if (memcpyed) {
-      // When memcpyed the blocksizes are trivial to compute
+      // When memcpyed the blocksizes are trivial to compute (but the leftover block is shorter)
       for (int i = 0; i < (int)nblocks; i++) {
         block_csizes[i] = (int)chunk_blocksize;
       }
+      if (leftover_block) {
+        block_csizes[nblocks - 1] = (int)leftover_block;
+      }
     }
     else {
       // In regular, compressed chunks, we need to sort the bstarts (they can be out
@@ -2218,7 +2625,7 @@ int frame_get_lazychunk(blosc2_frame_s *frame, int nchunk, uint8_t **chunk, bool
 
   end:
   if (fp != NULL) {
-    io_cb->close(fp);
+    frame_release_fp(frame);
   }
   if (rc < 0) {
     if (*needs_free) {
@@ -2233,6 +2640,29 @@ int frame_get_lazychunk(blosc2_frame_s *frame, int nchunk, uint8_t **chunk, bool
 }
 
 
+/* Return a compressed chunk that is part of a frame in the `chunk` parameter.
+ * If the frame is disk-based, a buffer is allocated for the (lazy) chunk,
+ * and hence a free is needed.  You can check if the chunk requires a free with the `needs_free`
+ * parameter.
+ * If the chunk does not need a free, it means that the frame is in memory and that just a
+ * pointer to the location of the chunk in memory is returned.
+ *
+ * The size of the (compressed, potentially lazy) chunk is returned.  If some problem is detected,
+ * a negative code is returned instead.
+*/
+int frame_get_lazychunk(blosc2_frame_s *frame, int nchunk, uint8_t **chunk, bool *needs_free) {
+  return get_lazychunk(frame, nchunk, chunk, needs_free, false);
+}
+
+
+/* Same as frame_get_lazychunk(), but the chunk can be a pointer into the mapping of the
+ * frame or into its write buffer, which is only valid until the frame changes.  Meant for chunks that are
+ * decompressed right away.
+*/
+int frame_borrow_lazychunk(blosc2_frame_s *frame, int nchunk, uint8_t **chunk, bool *needs_free) {
+  return get_lazychunk(frame, nchunk, chunk, needs_free, true);
+}
+
 /* Fill an empty frame with special values (fast path). */
 int frame_fill_special(blosc2_frame_s* frame, int64_t nitems, int special_value,
                        int32_t chunksize, blosc2_schunk* schunk) {
@@ -2334,9 +2764,8 @@ int frame_fill_special(blosc2_frame_s* frame, int64_t nitems, int special_value,
   int64_t new_frame_len = header_len + new_off_cbytes + frame->trailer_len;
   void* fp = NULL;
   if (frame->cframe != NULL) {
-    uint8_t* framep = frame->cframe;
     /* Make space for the new chunk and copy it */
-    frame->cframe = framep = realloc(framep, (size_t)new_frame_len);
+    uint8_t* framep = frame_reserve(frame, new_frame_len);
     if (framep == NULL) {
       BLOSC_TRACE_ERROR("Cannot realloc space for the frame.");
       return BLOSC2_ERROR_FRAME_SPECIAL;
@@ -2346,6 +2775,7 @@ int frame_fill_special(blosc2_frame_s* frame, int64_t nitems, int special_value,
   }
   else {
     size_t wbytes;
+    frame_invalidate_fp(frame, -1);
     if (frame->sframe) {
       // Update the offsets chunk in the chunks frame
       fp = sframe_open_index(frame->urlpath, "rb+", frame->schunk->storage->io);
@@ -2369,6 +2799,8 @@ int frame_fill_special(blosc2_frame_s* frame, int64_t nitems, int special_value,
     free(frame->coffsets);
     frame->coffsets = NULL;
   }
+  frame->sframe_nextid = -1;
+  drop_offsets(frame);
   free(off_chunk);
 
   frame->len = new_frame_len;
@@ -2386,6 +2818,245 @@ int frame_fill_special(blosc2_frame_s* frame, int64_t nitems, int special_value,
 }
 
 
+/* Get the length of the (unsplit) stream of a block out of its compressed size */
+static int32_t get_stream_len(const uint8_t* stream) {
+  int32_t csize = sw32_(stream);
+  if (csize > 0) {
+    return (int32_t)sizeof(int32_t) + csize;
+  }
+  // Runs take either no extra bytes (zeros) or a token byte
+  return (int32_t)sizeof(int32_t) + (csize < 0 ? 1 : 0);
+}
+
+
+/* Compute the id for the next (regular) chunk to be stored in a sframe. */
+static int64_t get_sframe_nextid(uint8_t* coffsets, int32_t coffsets_cbytes, int32_t nchunks) {
+  int64_t nextid = 0;
+  if (nchunks == 0) {
+    return nextid;
+  }
+  int32_t off_nbytes = nchunks * (int32_t)sizeof(int64_t);
+  int64_t* offsets = malloc((size_t)off_nbytes);
+  blosc2_dparams off_dparams = BLOSC2_DPARAMS_DEFAULTS;
+  blosc2_context *dctx = blosc2_create_dctx(off_dparams);
+  int32_t prev_nbytes = blosc2_decompress_ctx(dctx, coffsets, coffsets_cbytes, offsets, off_nbytes);
+  blosc2_free_ctx(dctx);
+  if (prev_nbytes < 0) {
+    free(offsets);
+    BLOSC_TRACE_ERROR("Cannot decompress the offsets chunk.");
+    return prev_nbytes;
+  }
+  for (int i = 0; i < nchunks; ++i) {
+    if (offsets[i] >= nextid) {
+      nextid = offsets[i] + 1;
+    }
+  }
+  free(offsets);
+  return nextid;
+}
+
+
+/* Compress the chunk offsets of a frame.
+ *
+ * Returns the size of the offsets chunk (in `*off_chunk`) or a negative value on error.
+ */
+static int32_t offsets_compress(const int64_t* offsets, int32_t noffsets, uint8_t** off_chunk) {
+  int32_t off_nbytes = noffsets * (int32_t)sizeof(int64_t);
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.splitmode = BLOSC_NEVER_SPLIT;
+  cparams.typesize = sizeof(int64_t);
+  cparams.blocksize = 16 * 1024;  // based on experiments with create_frame.c bench
+  cparams.nthreads = 4;  // 4 threads seems a decent default for nowadays CPUs
+  cparams.compcode = BLOSC_BLOSCLZ;
+  blosc2_context* cctx = blosc2_create_cctx(cparams);
+  *off_chunk = malloc((size_t)off_nbytes + BLOSC_MAX_OVERHEAD);
+  int32_t off_cbytes = blosc2_compress_ctx(cctx, offsets, off_nbytes,
+                                           *off_chunk, off_nbytes + BLOSC_MAX_OVERHEAD);
+  blosc2_free_ctx(cctx);
+  if (off_cbytes < 0) {
+    free(*off_chunk);
+    *off_chunk = NULL;
+  }
+  return off_cbytes;
+}
+
+
+/* Append a new offset to an offsets chunk, re-compressing it as a whole.
+ *
+ * Returns the size of the new offsets chunk (in `*off_chunk`) or a negative value on error.
+ */
+static int32_t offsets_rebuild(uint8_t* coffsets, int32_t coffsets_cbytes, int32_t nchunks,
+                               int64_t offset, uint8_t** off_chunk) {
+  int32_t off_nbytes = (nchunks + 1) * (int32_t)sizeof(int64_t);
+  int64_t* offsets = (int64_t *) malloc((size_t)off_nbytes);
+  if (nchunks > 0) {
+    blosc2_dparams off_dparams = BLOSC2_DPARAMS_DEFAULTS;
+    blosc2_context *dctx = blosc2_create_dctx(off_dparams);
+    int32_t prev_nbytes = blosc2_decompress_ctx(dctx, coffsets, coffsets_cbytes, offsets,
+                                                nchunks * sizeof(int64_t));
+    blosc2_free_ctx(dctx);
+    if (prev_nbytes < 0) {
+      free(offsets);
+      BLOSC_TRACE_ERROR("Cannot decompress the offsets chunk.");
+      return prev_nbytes;
+    }
+  }
+  offsets[nchunks] = offset;
+
+  int32_t new_off_cbytes = offsets_compress(offsets, nchunks + 1, off_chunk);
+  free(offsets);
+  return new_off_cbytes;
+}
+
+
+/* Append a new offset to an offsets chunk.
+ *
+ * The offsets chunk is seen as a sequence of segments, one per block.  Full blocks are
+ * sealed: their compressed streams are copied verbatim into the new chunk, and only the
+ * tail block (plus the previous one when the tail alone would be too small to be
+ * compressed) is decompressed and compressed again.  This makes the cost of an append
+ * independent of the number of chunks, while the result is still a regular Blosc2 chunk,
+ * so the frame format does not change.  When the offsets chunk does not have the
+ * expected layout (e.g. it is a special or memcpyed chunk), it is rebuilt as a whole.
+ *
+ * `[*keep_start, *keep_end)` returns a range of the new chunk with the same contents and
+ * position than in `coffsets`, so that writers can skip it (it is empty if there is none).
+ * Only sparse frames can do so, because the offsets chunk of contiguous frames moves past
+ * every new chunk.
+ *
+ * Returns the size of the new offsets chunk (in `*off_chunk`) or a negative value on error.
+ */
+static int32_t offsets_append(uint8_t* coffsets, int32_t coffsets_cbytes, int32_t nchunks,
+                              int64_t offset, uint8_t** off_chunk,
+                              int32_t* keep_start, int32_t* keep_end) {
+  const int32_t header_len = BLOSC_EXTENDED_HEADER_LENGTH;
+  const int32_t off_blocksize = 16 * 1024;  // keep in sync with offsets_rebuild()
+  const int32_t nitems_block = off_blocksize / (int32_t)sizeof(int64_t);
+  int32_t nbytes, cbytes, blocksize;
+
+  *keep_start = 0;
+  *keep_end = 0;
+  if (nchunks == 0 || coffsets_cbytes < header_len ||
+      blosc2_cbuffer_sizes(coffsets, &nbytes, &cbytes, &blocksize) < 0) {
+    return offsets_rebuild(coffsets, coffsets_cbytes, nchunks, offset, off_chunk);
+  }
+  uint8_t flags = coffsets[BLOSC2_CHUNK_FLAGS];
+  uint8_t blosc2_flags = coffsets[BLOSC2_CHUNK_BLOSC2_FLAGS];
+  bool regular = ((flags & (BLOSC_DOSHUFFLE | BLOSC_DOBITSHUFFLE)) == (BLOSC_DOSHUFFLE | BLOSC_DOBITSHUFFLE)) &&
+                 !(flags & BLOSC_MEMCPYED) && (flags & 0x10) &&  // extended header, compressed, not split
+                 ((blosc2_flags >> 4) & BLOSC2_SPECIAL_MASK) == 0 && !(blosc2_flags & BLOSC2_USEDICT);
+  // The block that will be re-compressed, making sure that the tail is large enough
+  int32_t nblock = nchunks / nitems_block;
+  if ((nchunks + 1 - nblock * nitems_block) * (int32_t)sizeof(int64_t) < BLOSC_MIN_BUFFERSIZE) {
+    nblock--;
+  }
+  if (!regular || nbytes != nchunks * (int32_t)sizeof(int64_t) || blocksize != off_blocksize ||
+      cbytes > coffsets_cbytes || nblock <= 0) {
+    return offsets_rebuild(coffsets, coffsets_cbytes, nchunks, offset, off_chunk);
+  }
+  int32_t nblocks = nbytes / blocksize + (nbytes % blocksize ? 1 : 0);
+
+  // Decompress the tail only and add the new offset
+  int32_t tail_start = nblock * nitems_block;
+  int32_t tail_nitems = nchunks + 1 - tail_start;
+  int32_t tail_nbytes = tail_nitems * (int32_t)sizeof(int64_t);
+  int64_t* tail = malloc((size_t)tail_nbytes);
+  int rc = blosc2_getitem(coffsets, coffsets_cbytes, tail_start, tail_nitems - 1, tail, tail_nbytes);
+  if (rc < 0) {
+    free(tail);
+    BLOSC_TRACE_ERROR("Cannot get the tail of the offsets chunk.");
+    return rc;
+  }
+  tail[tail_nitems - 1] = offset;
+
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.splitmode = BLOSC_NEVER_SPLIT;
+  cparams.typesize = sizeof(int64_t);
+  cparams.blocksize = off_blocksize;
+  cparams.nthreads = 1;  // just a couple of blocks at most
+  cparams.compcode = BLOSC_BLOSCLZ;
+  blosc2_context* cctx = blosc2_create_cctx(cparams);
+  // Leave room for storing the blocks uncompressed instead of memcpy'ing the whole chunk
+  int32_t tail_maxsize = tail_nbytes + BLOSC_MAX_OVERHEAD + 4 * (int32_t)sizeof(int32_t);
+  uint8_t* tail_chunk = malloc((size_t)tail_maxsize);
+  int32_t tail_cbytes = blosc2_compress_ctx(cctx, tail, tail_nbytes, tail_chunk, tail_maxsize);
+  blosc2_free_ctx(cctx);
+  free(tail);
+  if (tail_cbytes < 0) {
+    free(tail_chunk);
+    return tail_cbytes;
+  }
+  // The compressed tail must be encoded exactly like the sealed blocks
+  int32_t tail_blocksize = sw32_(tail_chunk + BLOSC2_CHUNK_BLOCKSIZE);
+  if (tail_cbytes < header_len ||
+      memcmp(tail_chunk, coffsets, BLOSC2_CHUNK_NBYTES) != 0 ||
+      memcmp(tail_chunk + BLOSC2_CHUNK_FILTER_CODES, coffsets + BLOSC2_CHUNK_FILTER_CODES,
+             header_len - BLOSC2_CHUNK_FILTER_CODES) != 0 ||
+      (tail_blocksize != off_blocksize && tail_nbytes > tail_blocksize)) {
+    free(tail_chunk);
+    return offsets_rebuild(coffsets, coffsets_cbytes, nchunks, offset, off_chunk);
+  }
+  int32_t tail_nblocks = tail_nbytes / tail_blocksize + (tail_nbytes % tail_blocksize ? 1 : 0);
+
+  // Compute the size of the new chunk
+  int32_t new_nblocks = nblock + tail_nblocks;
+  int32_t new_nbytes = nbytes + (int32_t)sizeof(int64_t);
+  int32_t streams_start = header_len + new_nblocks * (int32_t)sizeof(int32_t);
+  int64_t new_cbytes = streams_start;
+  for (int i = 0; i < nblock; i++) {
+    int32_t bstart = sw32_(coffsets + header_len + i * sizeof(int32_t));
+    if (bstart < header_len + nblocks * (int32_t)sizeof(int32_t) ||
+        bstart > cbytes - (int32_t)sizeof(int32_t) ||
+        bstart + get_stream_len(coffsets + bstart) > cbytes) {
+      free(tail_chunk);
+      BLOSC_TRACE_ERROR("The offsets chunk is corrupted.");
+      return BLOSC2_ERROR_DATA;
+    }
+    new_cbytes += get_stream_len(coffsets + bstart);
+  }
+  for (int i = 0; i < tail_nblocks; i++) {
+    int32_t bstart = sw32_(tail_chunk + header_len + i * sizeof(int32_t));
+    new_cbytes += get_stream_len(tail_chunk + bstart);
+  }
+  if (new_cbytes > new_nbytes + BLOSC_MAX_OVERHEAD) {
+    free(tail_chunk);
+    return offsets_rebuild(coffsets, coffsets_cbytes, nchunks, offset, off_chunk);
+  }
+
+  // Assemble the sealed blocks and the new tail
+  uint8_t* new_chunk = malloc((size_t)new_cbytes);
+  memcpy(new_chunk, tail_chunk, header_len);
+  _sw32(new_chunk + BLOSC2_CHUNK_NBYTES, new_nbytes);
+  _sw32(new_chunk + BLOSC2_CHUNK_BLOCKSIZE, off_blocksize);
+  _sw32(new_chunk + BLOSC2_CHUNK_CBYTES, (int32_t)new_cbytes);
+  bool same_layout = (new_nblocks == nblocks);
+  int32_t pos = streams_start;
+  for (int i = 0; i < nblock; i++) {
+    int32_t bstart = sw32_(coffsets + header_len + i * sizeof(int32_t));
+    int32_t stream_len = get_stream_len(coffsets + bstart);
+    same_layout = same_layout && (bstart == pos);
+    _sw32(new_chunk + header_len + i * sizeof(int32_t), pos);
+    memcpy(new_chunk + pos, coffsets + bstart, (size_t)stream_len);
+    pos += stream_len;
+  }
+  if (same_layout) {
+    *keep_start = streams_start;
+    *keep_end = pos;
+  }
+  for (int i = 0; i < tail_nblocks; i++) {
+    int32_t bstart = sw32_(tail_chunk + header_len + i * sizeof(int32_t));
+    int32_t stream_len = get_stream_len(tail_chunk + bstart);
+    _sw32(new_chunk + header_len + (nblock + i) * sizeof(int32_t), pos);
+    memcpy(new_chunk + pos, tail_chunk + bstart, (size_t)stream_len);
+    pos += stream_len;
+  }
+  free(tail_chunk);
+
+  *off_chunk = new_chunk;
+  return (int32_t)new_cbytes;
+}
+
+
 /* Append an existing chunk into a frame. */
 void* frame_append_chunk(blosc2_frame_s* frame, void* chunk, blosc2_schunk* schunk) {
   int8_t* chunk_ = chunk;
@@ -2423,7 +3094,7 @@ void* frame_append_chunk(blosc2_frame_s* frame, void* chunk, blosc2_schunk* schu
   if (chunksize == 0 && (nchunks > 0) && (chunk_nbytes < (size_t)chunksize)) {
     uint8_t* last_chunk;
     bool needs_free;
-    rc = frame_get_lazychunk(frame, nchunks - 1, &last_chunk, &needs_free);
+    rc = frame_borrow_lazychunk(frame, nchunks - 1, &last_chunk, &needs_free);
     if (rc < 0) {
       BLOSC_TRACE_ERROR("Cannot get the last chunk (in position %d).", nchunks - 1);
     } else {
@@ -2443,35 +3114,41 @@ void* frame_append_chunk(blosc2_frame_s* frame, void* chunk, blosc2_schunk* schu
     }
   }
 
-  // Get the current offsets and add one more
-  int32_t off_nbytes = (nchunks + 1) * sizeof(int64_t);
-  int64_t* offsets = (int64_t *) malloc((size_t)off_nbytes);
-  if (nchunks > 0) {
-    int32_t coffsets_cbytes;
-    uint8_t *coffsets = get_coffsets(frame, header_len, cbytes, nchunks, &coffsets_cbytes);
+  // Appends to on-disk frames can be kept in memory until the next flush.  In that case,
+  // the resident offsets are the index, and it is only compressed when flushing.
+  bool buffered = frame->cframe == NULL && schunk->storage->write_buffer_size > 0;
+  if (buffered && (frame->offsets == NULL || frame->noffsets != nchunks)) {
+    if (frame->dirty) {
+      BLOSC_TRACE_ERROR("The offsets of the pending appends are lost.");
+      return NULL;
+    }
+    drop_offsets(frame);
+    if (nchunks == 0) {
+      frame->maxoffsets = 16;
+      frame->offsets = malloc((size_t)frame->maxoffsets * sizeof(int64_t));
+    }
+    else if (load_offsets(frame, header_len, cbytes, nchunks) == NULL) {
+      // Just write the append right away
+      buffered = false;
+    }
+  }
+
+  // Get the current offsets
+  int32_t coffsets_cbytes = 0;
+  uint8_t *coffsets = NULL;
+  if (nchunks > 0 && !buffered) {
+    coffsets = get_coffsets(frame, header_len, cbytes, nchunks, &coffsets_cbytes);
     if (coffsets == NULL) {
       BLOSC_TRACE_ERROR("Cannot get the offsets for the frame.");
-      free(offsets);
       return NULL;
     }
     if (coffsets_cbytes == 0) {
       coffsets_cbytes = (int32_t)cbytes;
     }
-
-    // Decompress offsets
-    blosc2_dparams off_dparams = BLOSC2_DPARAMS_DEFAULTS;
-    blosc2_context *dctx = blosc2_create_dctx(off_dparams);
-    int32_t prev_nbytes = blosc2_decompress_ctx(dctx, coffsets, coffsets_cbytes, offsets,
-                                                nchunks * sizeof(int64_t));
-    blosc2_free_ctx(dctx);
-    if (prev_nbytes < 0) {
-      free(offsets);
-      BLOSC_TRACE_ERROR("Cannot decompress the offsets chunk.");
-      return NULL;
-    }
   }
 
-  // Add the new offset
+  // Compute the new offset
+  int64_t offset;
   int64_t sframe_chunk_id = -1;
   int special_value = (chunk_[BLOSC2_CHUNK_BLOSC2_FLAGS] >> 4) & BLOSC2_SPECIAL_MASK;
   uint64_t offset_value = ((uint64_t)1 << 63);
@@ -2479,54 +3156,67 @@ void* frame_append_chunk(blosc2_frame_s* frame, void* chunk, blosc2_schunk* schu
     case BLOSC2_SPECIAL_ZERO:
       // Zero chunk.  Code it in a special way.
       offset_value += (uint64_t) BLOSC2_SPECIAL_ZERO << (8 * 7);  // chunk of zeros
-      to_little(offsets + nchunks, &offset_value, sizeof(uint64_t));
+      to_little(&offset, &offset_value, sizeof(uint64_t));
       chunk_cbytes = 0;   // we don't need to store the chunk
       break;
     case BLOSC2_SPECIAL_UNINIT:
       // Non initizalized values chunk.  Code it in a special way.
       offset_value += (uint64_t) BLOSC2_SPECIAL_UNINIT << (8 * 7);  // chunk of uninit values
-      to_little(offsets + nchunks, &offset_value, sizeof(uint64_t));
+      to_little(&offset, &offset_value, sizeof(uint64_t));
       chunk_cbytes = 0;   // we don't need to store the chunk
       break;
     case BLOSC2_SPECIAL_NAN:
       // NaN chunk.  Code it in a special way.
       offset_value += (uint64_t)BLOSC2_SPECIAL_NAN << (8 * 7);  // chunk of NANs
-      to_little(offsets + nchunks, &offset_value, sizeof(uint64_t));
+      to_little(&offset, &offset_value, sizeof(uint64_t));
       chunk_cbytes = 0;   // we don't need to store the chunk
       break;
     default:
       if (frame->sframe) {
-        // Compute the sframe_chunk_id value
-        for (int i = 0; i < nchunks; ++i) {
-          if (offsets[i] > sframe_chunk_id) {
-            sframe_chunk_id = offsets[i];
+        if (frame->sframe_nextid < 0) {
+          // Not cached yet; compute it from the current offsets
+          if (buffered) {
+            frame->sframe_nextid = 0;
+            for (int32_t i = 0; i < nchunks; i++) {
+              if (frame->offsets[i] >= frame->sframe_nextid) {
+                frame->sframe_nextid = frame->offsets[i] + 1;
+              }
+            }
+          }
+          else {
+            frame->sframe_nextid = get_sframe_nextid(coffsets, coffsets_cbytes, nchunks);
+          }
+          if (frame->sframe_nextid < 0) {
+            BLOSC_TRACE_ERROR("Cannot compute the id for the new chunk.");
+            return NULL;
           }
         }
-        offsets[nchunks] = ++sframe_chunk_id;
+        sframe_chunk_id = frame->sframe_nextid;
+        offset = sframe_chunk_id;
       }
       else {
-        offsets[nchunks] = cbytes;
+        offset = cbytes;
       }
   }
 
-  // Re-compress the offsets again
-  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
-  cparams.splitmode = BLOSC_NEVER_SPLIT;
-  cparams.typesize = sizeof(int64_t);
-  cparams.blocksize = 16 * 1024;  // based on experiments with create_frame.c bench
-  cparams.nthreads = 4;  // 4 threads seems a decent default for nowadays CPUs
-  cparams.compcode = BLOSC_BLOSCLZ;
-  blosc2_context* cctx = blosc2_create_cctx(cparams);
-  void* off_chunk = malloc((size_t)off_nbytes + BLOSC_MAX_OVERHEAD);
-  int32_t new_off_cbytes = blosc2_compress_ctx(cctx, offsets, off_nbytes,
-                                               off_chunk, off_nbytes + BLOSC_MAX_OVERHEAD);
-  blosc2_free_ctx(cctx);
-  free(offsets);
+  // Add the new offset to the index.  Only the tail of the offsets chunk is re-compressed,
+  // but contiguous frames on disk still write all of it, as it goes after the new chunk.
+  uint8_t* off_chunk = NULL;
+  int32_t off_keep_start;
+  int32_t off_keep_end;
+  int32_t new_off_cbytes;
+  if (buffered) {
+    // An upper bound for the offsets chunk until it is compressed (see frame_flush)
+    new_off_cbytes = (nchunks + 1) * (int32_t)sizeof(int64_t) + BLOSC_EXTENDED_HEADER_LENGTH;
+  }
+  else {
+    new_off_cbytes = offsets_append(coffsets, coffsets_cbytes, nchunks, offset, &off_chunk,
+                                    &off_keep_start, &off_keep_end);
+  }
   if (new_off_cbytes < 0) {
-    free(off_chunk);
+    BLOSC_TRACE_ERROR("Cannot add the new offset to the offsets chunk.");
     return NULL;
   }
-  // printf("%f\n", (double) off_nbytes / new_off_cbytes);
 
   int64_t new_cbytes = cbytes + chunk_cbytes;
   int64_t new_frame_len;
@@ -2539,9 +3229,8 @@ void* frame_append_chunk(blosc2_frame_s* frame, void* chunk, blosc2_schunk* schu
 
   void* fp = NULL;
   if (frame->cframe != NULL) {
-    uint8_t* framep = frame->cframe;
     /* Make space for the new chunk and copy it */
-    frame->cframe = framep = realloc(framep, (size_t)new_frame_len);
+    uint8_t* framep = frame_reserve(frame, new_frame_len);
     if (framep == NULL) {
       BLOSC_TRACE_ERROR("Cannot realloc space for the frame.");
       return NULL;
@@ -2551,14 +3240,46 @@ void* frame_append_chunk(blosc2_frame_s* frame, void* chunk, blosc2_schunk* schu
     /* Copy the offsets */
     memcpy(framep + header_len + new_cbytes, off_chunk, (size_t)new_off_cbytes);
   }
+  else if (buffered) {
+    // Keep the chunk (if in a cframe) and the index in memory until the next flush
+    if (frame->sframe) {
+      if (chunk_cbytes != 0 && sframe_create_chunk(frame, chunk, sframe_chunk_id, chunk_cbytes) == NULL) {
+        BLOSC_TRACE_ERROR("Cannot write the full chunk.");
+        return NULL;
+      }
+    }
+    else if (chunk_cbytes != 0) {
+      if (frame->wbuffer_len == 0) {
+        frame->wbuffer_offset = cbytes;
+      }
+      if (frame->wbuffer_len + chunk_cbytes > frame->wbuffer_size) {
+        int64_t wbuffer_size = frame->wbuffer_size * 2;
+        if (wbuffer_size < frame->wbuffer_len + chunk_cbytes) {
+          wbuffer_size = frame->wbuffer_len + chunk_cbytes;
+        }
+        uint8_t* wbuffer = realloc(frame->wbuffer, (size_t)wbuffer_size);
+        if (wbuffer == NULL) {
+          BLOSC_TRACE_ERROR("Cannot realloc space for the pending chunks.");
+          return NULL;
+        }
+        frame->wbuffer = wbuffer;
+        frame->wbuffer_size = wbuffer_size;
+      }
+      memcpy(frame->wbuffer + frame->wbuffer_len, chunk, (size_t)chunk_cbytes);
+      frame->wbuffer_len += chunk_cbytes;
+    }
+    frame->dirty = true;
+  }
   else {
     int64_t wbytes;
+    int32_t off_wstart = 0;
     blosc2_io_cb *io_cb = blosc2_get_io_cb(frame->schunk->storage->io->id);
     if (io_cb == NULL) {
       BLOSC_TRACE_ERROR("Error getting the input/output API");
       return NULL;
     }
 
+    frame_invalidate_fp(frame, -1);
     if (frame->sframe) {
       // Update the offsets chunk in the chunks frame
       if (chunk_cbytes != 0) {
@@ -2574,6 +3295,17 @@ void* frame_append_chunk(blosc2_frame_s* frame, void* chunk, blosc2_schunk* schu
       fp = sframe_open_index(frame->urlpath, "rb+",
                              frame->schunk->storage->io);
       io_cb->seek(fp, header_len, SEEK_SET);
+      if (off_keep_end > off_keep_start) {
+        // The sealed part of the offsets is already on disk; skip it
+        wbytes = io_cb->write(off_chunk, 1, off_keep_start, fp);
+        if (wbytes != (size_t)off_keep_start) {
+          BLOSC_TRACE_ERROR("Cannot write the offsets to frame.");
+          io_cb->close(fp);
+          return NULL;
+        }
+        io_cb->seek(fp, header_len + off_keep_end, SEEK_SET);
+        off_wstart = off_keep_end;
+      }
     }
     else {
       // Regular frame
@@ -2586,22 +3318,57 @@ void* frame_append_chunk(blosc2_frame_s* frame, void* chunk, blosc2_schunk* schu
         return NULL;
       }
     }
-    wbytes = io_cb->write(off_chunk, 1, new_off_cbytes, fp);  // the new offsets
+    // The new offsets
+    wbytes = io_cb->write(off_chunk + off_wstart, 1, new_off_cbytes - off_wstart, fp);
     io_cb->close(fp);
-    if (wbytes != (size_t)new_off_cbytes) {
+    if (wbytes != (size_t)(new_off_cbytes - off_wstart)) {
       BLOSC_TRACE_ERROR("Cannot write the offsets to frame.");
       return NULL;
     }
   }
-  // Invalidate the cache for chunk offsets
+
   if (frame->coffsets != NULL) {
     free(frame->coffsets);
     frame->coffsets = NULL;
   }
+  if (frame->cframe == NULL) {
+    // The new offsets are the same than on disk, so keep them cached for the next access
+    // (when buffered, there is none until the next flush)
+    frame->coffsets = off_chunk;
+  }
+  else {
+    free(off_chunk);
+  }
+  if (sframe_chunk_id >= 0) {
+    frame->sframe_nextid = sframe_chunk_id + 1;
+  }
+  // Keep the resident offsets (if any) in sync
+  if (frame->offsets != NULL && frame->noffsets == nchunks) {
+    if (frame->noffsets == frame->maxoffsets) {
+      frame->maxoffsets = frame->maxoffsets * 2 + 1;
+      frame->offsets = realloc(frame->offsets, (size_t)frame->maxoffsets * sizeof(int64_t));
+    }
+    frame->offsets[frame->noffsets++] = offset;
+  }
+  else {
+    drop_offsets(frame);
+  }
   free(chunk);  // chunk has always to be a copy when reaching here...
-  free(off_chunk);
 
   frame->len = new_frame_len;
+  if (frame->dirty) {
+    // Just keep the copy of the header up to date
+    uint8_t* h2 = new_header_frame(schunk, frame);
+    memcpy(frame->header, h2, FRAME_HEADER_MINLEN);
+    free(h2);
+    frame->header_cached = true;
+    // Special chunks take no space, but their offsets do
+    frame->wpending += chunk_cbytes + (int64_t)sizeof(int64_t);
+    if (frame->wpending >= schunk->storage->write_buffer_size && frame_flush(frame) < 0) {
+      return NULL;
+    }
+    return frame;
+  }
   rc = frame_update_header(frame, schunk, false);
   if (rc < 0) {
     return NULL;
@@ -2616,6 +3383,93 @@ void* frame_append_chunk(blosc2_frame_s* frame, void* chunk, blosc2_schunk* schu
 }
 
 
+/* Write the appends to an on-disk frame that are still pending (see
+ * blosc2_storage.write_buffer_size) with a few large writes. */
+int frame_flush(blosc2_frame_s* frame) {
+  if (!frame->dirty) {
+    return 0;
+  }
+  blosc2_schunk* schunk = frame->schunk;
+  int32_t header_len;
+  int64_t frame_len;
+  int64_t nbytes;
+  int64_t cbytes;
+  int32_t blocksize;
+  int32_t chunksize;
+  int32_t nchunks;
+  int rc = get_header_info(frame, &header_len, &frame_len, &nbytes, &cbytes, &blocksize, &chunksize,
+                           &nchunks, NULL, NULL, NULL, NULL, NULL, NULL,
+                           schunk->storage->io);
+  if (rc < 0) {
+    BLOSC_TRACE_ERROR("Unable to get meta info from frame.");
+    return rc;
+  }
+  // The offsets are resident while there are pending appends
+  if (frame->offsets == NULL || frame->noffsets != nchunks) {
+    BLOSC_TRACE_ERROR("Cannot get the offsets for the frame.");
+    return BLOSC2_ERROR_DATA;
+  }
+  uint8_t* off_chunk;
+  int32_t off_cbytes = offsets_compress(frame->offsets, nchunks, &off_chunk);
+  if (off_cbytes < 0) {
+    BLOSC_TRACE_ERROR("Cannot compress the offsets of the frame.");
+    return off_cbytes;
+  }
+  free(frame->coffsets);
+  frame->coffsets = off_chunk;
+
+  blosc2_io_cb *io_cb = blosc2_get_io_cb(schunk->storage->io->id);
+  if (io_cb == NULL) {
+    BLOSC_TRACE_ERROR("Error getting the input/output API");
+    return BLOSC2_ERROR_PLUGIN_IO;
+  }
+  frame_invalidate_fp(frame, -1);
+  void* fp;
+  if (frame->sframe) {
+    fp = sframe_open_index(frame->urlpath, "rb+", schunk->storage->io);
+  }
+  else {
+    fp = io_cb->open(frame->urlpath, "rb+", schunk->storage->io->params);
+  }
+  if (fp == NULL) {
+    BLOSC_TRACE_ERROR("Cannot open the frame for reading and writing.");
+    return BLOSC2_ERROR_FILE_OPEN;
+  }
+  if (frame->wbuffer_len > 0) {
+    // The pending chunks are just before the offsets
+    io_cb->seek(fp, header_len + frame->wbuffer_offset, SEEK_SET);
+    int64_t wbytes = io_cb->write(frame->wbuffer, 1, frame->wbuffer_len, fp);
+    if (wbytes != frame->wbuffer_len) {
+      BLOSC_TRACE_ERROR("Cannot write the pending chunks to frame.");
+      io_cb->close(fp);
+      return BLOSC2_ERROR_FILE_WRITE;
+    }
+  }
+  io_cb->seek(fp, header_len + (frame->sframe ? 0 : cbytes), SEEK_SET);
+  int64_t wbytes = io_cb->write(frame->coffsets, 1, off_cbytes, fp);
+  io_cb->close(fp);
+  if (wbytes != off_cbytes) {
+    BLOSC_TRACE_ERROR("Cannot write the offsets to frame.");
+    return BLOSC2_ERROR_FILE_WRITE;
+  }
+  frame->wbuffer_len = 0;
+  frame->wpending = 0;
+  frame->dirty = false;
+  frame->len = header_len + (frame->sframe ? 0 : cbytes) + off_cbytes + frame->trailer_len;
+
+  rc = frame_update_header(frame, schunk, false);
+  if (rc < 0) {
+    return rc;
+  }
+  rc = frame_update_trailer(frame, schunk);
+  if (rc < 0) {
+    return rc;
+  }
+
+  return 0;
+}
+
+
 void* frame_insert_chunk(blosc2_frame_s* frame, int nchunk, void* chunk, blosc2_schunk* schunk) {
   uint8_t* chunk_ = chunk;
   int32_t header_len;
@@ -2705,8 +3559,9 @@ void* frame_insert_chunk(blosc2_frame_s* frame, int nchunk, void* chunk, blosc2_
         offsets[i] = offsets[i - 1];
       }
       if (frame->sframe) {
-        for (int i = 0; i < nchunks; ++i) {
-          if (offsets[i] > sframe_chunk_id) {
+        // The offsets have been shifted already, so skip the slot of the new one
+        for (int i = 0; i <= nchunks; ++i) {
+          if (i != nchunk && offsets[i] > sframe_chunk_id) {
             sframe_chunk_id = offsets[i];
           }
         }
@@ -2749,9 +3604,8 @@ void* frame_insert_chunk(blosc2_frame_s* frame, int nchunk, void* chunk, blosc2_
   // Add the chunk and update meta
   void* fp = NULL;
   if (frame->cframe != NULL) {
-    uint8_t* framep = frame->cframe;
     /* Make space for the new chunk and copy it */
-    frame->cframe = framep = realloc(framep, (size_t)new_frame_len);
+    uint8_t* framep = frame_reserve(frame, new_frame_len);
     if (framep == NULL) {
       BLOSC_TRACE_ERROR("Cannot realloc space for the frame.");
       return NULL;
@@ -2769,6 +3623,7 @@ void* frame_insert_chunk(blosc2_frame_s* frame, int nchunk, void* chunk, blosc2_
       return NULL;
     }
 
+    frame_invalidate_fp(frame, -1);
     if (frame->sframe) {
       if (chunk_cbytes != 0) {
         if (sframe_chunk_id < 0) {
@@ -2807,7 +3662,9 @@ void* frame_insert_chunk(blosc2_frame_s* frame, int nchunk, void* chunk, blosc2_
       free(frame->coffsets);
       frame->coffsets = NULL;
     }
+    frame->sframe_nextid = -1;
   }
+  drop_offsets(frame);
   free(chunk);  // chunk has always to be a copy when reaching here...
   free(off_chunk);
 
@@ -2826,32 +3683,193 @@ void* frame_insert_chunk(blosc2_frame_s* frame, int nchunk, void* chunk, blosc2_
 }
 
 
-void* frame_update_chunk(blosc2_frame_s* frame, int nchunk, void* chunk, blosc2_schunk* schunk) {
-  uint8_t *chunk_ = (uint8_t *) chunk;
-  int32_t header_len;
-  int64_t frame_len;
-  int64_t nbytes;
-  int64_t cbytes;
-  int32_t blocksize;
-  int32_t chunksize;
-  int32_t nchunks;
-  int rc = get_header_info(frame, &header_len, &frame_len, &nbytes, &cbytes,
-                           &blocksize, &chunksize, &nchunks,
-                           NULL, NULL, NULL, NULL, NULL, NULL,
-                           frame->schunk->storage->io);
-  if (rc < 0) {
-    BLOSC_TRACE_ERROR("Unable to get meta info from frame.");
-    return NULL;
-  }
-  if (nchunk >= nchunks) {
-    BLOSC_TRACE_ERROR("The chunk must already exist.");
-    return NULL;
+/* Get the compressed size of the chunk at offset (from the start of the chunks section) of a cframe */
+static int32_t get_chunk_cbytes(blosc2_frame_s* frame, int32_t header_len, int64_t offset) {
+  uint8_t header[BLOSC_MIN_HEADER_LENGTH];
+  if (frame->cframe != NULL) {
+    if (header_len + offset + BLOSC_MIN_HEADER_LENGTH > frame->len) {
+      BLOSC_TRACE_ERROR("Cannot read chunk outside of frame boundary.");
+      return BLOSC2_ERROR_READ_BUFFER;
+    }
+    memcpy(header, frame->cframe + header_len + offset, BLOSC_MIN_HEADER_LENGTH);
   }
-
-  int32_t chunk_cbytes;
-  rc = blosc2_cbuffer_sizes(chunk, NULL, &chunk_cbytes, NULL);
-  if (rc < 0) {
-    return NULL;
+  else {
+    blosc2_io_cb *io_cb = blosc2_get_io_cb(frame->schunk->storage->io->id);
+    if (io_cb == NULL) {
+      BLOSC_TRACE_ERROR("Error getting the input/output API");
+      return BLOSC2_ERROR_PLUGIN_IO;
+    }
+    void* fp = frame_acquire_fp(frame, -1, frame->schunk->storage->io);
+    if (fp == NULL) {
+      BLOSC_TRACE_ERROR("Cannot open the frame file.");
+      return BLOSC2_ERROR_FILE_OPEN;
+    }
+    int64_t rbytes = frame_read_at(io_cb, fp, header_len + offset, BLOSC_MIN_HEADER_LENGTH, header);
+    frame_release_fp(frame);
+    if (rbytes != BLOSC_MIN_HEADER_LENGTH) {
+      BLOSC_TRACE_ERROR("Cannot read the header of a chunk in the frame.");
+      return BLOSC2_ERROR_FILE_READ;
+    }
+  }
+  return sw32_(header + BLOSC2_CHUNK_CBYTES);
+}
+
+
+/* Forget the unused ranges of a cframe, e.g. because chunks have been deleted. */
+static void drop_holes(blosc2_frame_s* frame) {
+  free(frame->holes);
+  frame->holes = NULL;
+  frame->nholes = 0;
+  frame->maxholes = 0;
+}
+
+
+/* Add an unused range to the (sorted) list of holes of a cframe, merging it with its neighbours */
+static void add_hole(blosc2_frame_s* frame, int64_t offset, int64_t size) {
+  if (frame->holes == NULL || size <= 0) {
+    return;
+  }
+  frame_hole* holes = frame->holes;
+  int32_t i = 0;
+  while (i < frame->nholes && holes[i].offset < offset) {
+    i++;
+  }
+  bool merge_prev = i > 0 && holes[i - 1].offset + holes[i - 1].size == offset;
+  bool merge_next = i < frame->nholes && offset + size == holes[i].offset;
+  if (merge_prev && merge_next) {
+    holes[i - 1].size += size + holes[i].size;
+    memmove(holes + i, holes + i + 1, (frame->nholes - i - 1) * sizeof(frame_hole));
+    frame->nholes--;
+    return;
+  }
+  if (merge_prev) {
+    holes[i - 1].size += size;
+    return;
+  }
+  if (merge_next) {
+    holes[i].offset = offset;
+    holes[i].size += size;
+    return;
+  }
+  if (frame->nholes == frame->maxholes) {
+    int32_t maxholes = frame->maxholes * 2;
+    holes = realloc(holes, maxholes * sizeof(frame_hole));
+    if (holes == NULL) {
+      // The holes will be looked up again when needed
+      drop_holes(frame);
+      return;
+    }
+    frame->holes = holes;
+    frame->maxholes = maxholes;
+  }
+  memmove(holes + i + 1, holes + i, (frame->nholes - i) * sizeof(frame_hole));
+  holes[i].offset = offset;
+  holes[i].size = size;
+  frame->nholes++;
+}
+
+
+/* Take room for size bytes out of the holes of a cframe (first fit); returns -1 if there is none */
+static int64_t take_hole(blosc2_frame_s* frame, int64_t size) {
+  for (int32_t i = 0; i < frame->nholes; i++) {
+    frame_hole* hole = &frame->holes[i];
+    if (hole->size < size) {
+      continue;
+    }
+    int64_t offset = hole->offset;
+    hole->offset += size;
+    hole->size -= size;
+    if (hole->size == 0) {
+      memmove(hole, hole + 1, (frame->nholes - i - 1) * sizeof(frame_hole));
+      frame->nholes--;
+    }
+    return offset;
+  }
+  return -1;
+}
+
+
+static int sort_hole(const void* a, const void* b) {
+  int64_t a_ = ((frame_hole*)a)->offset;
+  int64_t b_ = ((frame_hole*)b)->offset;
+  return (a_ > b_) - (a_ < b_);
+}
+
+
+/* Find the unused ranges in the chunks section (of cbytes bytes) of a cframe out of the offsets */
+static int build_holes(blosc2_frame_s* frame, int32_t header_len, int64_t cbytes,
+                       const int64_t* offsets, int32_t nchunks) {
+  drop_holes(frame);
+  frame_hole* extents = malloc(nchunks * sizeof(frame_hole));
+  if (extents == NULL) {
+    return BLOSC2_ERROR_MEMORY_ALLOC;
+  }
+  int32_t nextents = 0;
+  for (int32_t i = 0; i < nchunks; i++) {
+    if (offsets[i] < 0) {
+      // Special chunks take no space
+      continue;
+    }
+    int32_t chunk_cbytes = get_chunk_cbytes(frame, header_len, offsets[i]);
+    if (chunk_cbytes < 0) {
+      free(extents);
+      return chunk_cbytes;
+    }
+    extents[nextents].offset = offsets[i];
+    extents[nextents].size = chunk_cbytes;
+    nextents++;
+  }
+  qsort(extents, nextents, sizeof(frame_hole), sort_hole);
+
+  frame->maxholes = 16;
+  frame->holes = malloc(frame->maxholes * sizeof(frame_hole));
+  if (frame->holes == NULL) {
+    free(extents);
+    frame->maxholes = 0;
+    return BLOSC2_ERROR_MEMORY_ALLOC;
+  }
+  int64_t end = 0;
+  for (int32_t i = 0; i < nextents; i++) {
+    if (extents[i].offset > end) {
+      add_hole(frame, end, extents[i].offset - end);
+    }
+    if (extents[i].offset + extents[i].size > end) {
+      end = extents[i].offset + extents[i].size;
+    }
+  }
+  add_hole(frame, end, cbytes - end);
+  free(extents);
+
+  return 0;
+}
+
+
+void* frame_update_chunk(blosc2_frame_s* frame, int nchunk, void* chunk, blosc2_schunk* schunk) {
+  uint8_t *chunk_ = (uint8_t *) chunk;
+  int32_t header_len;
+  int64_t frame_len;
+  int64_t nbytes;
+  int64_t cbytes;
+  int32_t blocksize;
+  int32_t chunksize;
+  int32_t nchunks;
+  int rc = get_header_info(frame, &header_len, &frame_len, &nbytes, &cbytes,
+                           &blocksize, &chunksize, &nchunks,
+                           NULL, NULL, NULL, NULL, NULL, NULL,
+                           frame->schunk->storage->io);
+  if (rc < 0) {
+    BLOSC_TRACE_ERROR("Unable to get meta info from frame.");
+    return NULL;
+  }
+  if (nchunk >= nchunks) {
+    BLOSC_TRACE_ERROR("The chunk must already exist.");
+    return NULL;
+  }
+
+  int32_t chunk_cbytes;
+  rc = blosc2_cbuffer_sizes(chunk, NULL, &chunk_cbytes, NULL);
+  if (rc < 0) {
+    return NULL;
   }
 
   // Get the current offsets
@@ -2879,35 +3897,33 @@ void* frame_update_chunk(blosc2_frame_s* frame, int nchunk, void* chunk, blosc2_
       return NULL;
     }
   }
-  int32_t cbytes_old;
-  int32_t old_offset;
+  int32_t cbytes_old = 0;
+  int64_t old_offset = -1;
+  int special_value = (chunk_[BLOSC2_CHUNK_BLOSC2_FLAGS] >> 4) & BLOSC2_SPECIAL_MASK;
   if (!frame->sframe) {
-    // See how big would be the space
+    // See how big would be the space (special chunks take none)
     old_offset = offsets[nchunk];
-    bool needs_free;
-    uint8_t *chunk_old;
-    int err = blosc2_schunk_get_chunk(schunk, nchunk, &chunk_old, &needs_free);
-    if (err < 0) {
-      BLOSC_TRACE_ERROR("%d chunk can not be obtained from schunk.", nchunk);
-      return NULL;
-    }
-
-    if (chunk_old == NULL) {
-      cbytes_old = 0;
-    }
-    else {
-      cbytes_old = sw32_(chunk_old + BLOSC2_CHUNK_CBYTES);
-      if (cbytes_old == BLOSC_MAX_OVERHEAD) {
-        cbytes_old = 0;
+    if (old_offset >= 0) {
+      cbytes_old = get_chunk_cbytes(frame, header_len, old_offset);
+      if (cbytes_old < 0) {
+        free(offsets);
+        BLOSC_TRACE_ERROR("%d chunk can not be obtained from frame.", nchunk);
+        return NULL;
       }
     }
-    if (needs_free) {
-      free(chunk_old);
+    bool is_special = special_value == BLOSC2_SPECIAL_ZERO || special_value == BLOSC2_SPECIAL_NAN ||
+                      special_value == BLOSC2_SPECIAL_UNINIT;
+    if (!is_special && chunk_cbytes > cbytes_old && frame->holes == NULL) {
+      // Look for the holes left by other updates (before the offsets change)
+      if (build_holes(frame, header_len, cbytes, offsets, nchunks) < 0) {
+        // Not an error per se; the chunk just goes at the end
+        drop_holes(frame);
+      }
     }
   }
 
   // Add the new offset
-  int special_value = (chunk_[BLOSC2_CHUNK_BLOSC2_FLAGS] >> 4) & BLOSC2_SPECIAL_MASK;
+  int64_t sframe_chunk_id = -1;
   uint64_t offset_value = ((uint64_t)1 << 63);
   switch (special_value) {
     case BLOSC2_SPECIAL_ZERO:
@@ -2930,8 +3946,18 @@ void* frame_update_chunk(blosc2_frame_s* frame, int nchunk, void* chunk, blosc2_
       break;
     default:
       if (frame->sframe) {
-        // In case there was a reorder
-        offsets[nchunk] = nchunk;
+        // Reuse the file of the replaced chunk; special chunks have none, so take a new one
+        sframe_chunk_id = offsets[nchunk];
+        if (sframe_chunk_id < 0) {
+          sframe_chunk_id = -1;
+          for (int i = 0; i < nchunks; ++i) {
+            if (offsets[i] > sframe_chunk_id) {
+              sframe_chunk_id = offsets[i];
+            }
+          }
+          sframe_chunk_id++;
+        }
+        offsets[nchunk] = sframe_chunk_id;
       }
       else {
         // Add the new offset
@@ -2939,9 +3965,29 @@ void* frame_update_chunk(blosc2_frame_s* frame, int nchunk, void* chunk, blosc2_
       }
   }
 
-  if (!frame->sframe && chunk_cbytes != 0 && cbytes_old >= chunk_cbytes) {
-    offsets[nchunk] = old_offset;
-    cbytes = old_offset;
+  if (!frame->sframe) {
+    // Reuse the space of the old chunk if possible, or else a hole (but never the space
+    // after the chunks section, which holds the offsets); see frame_compact() too
+    int64_t chunk_offset = cbytes;
+    if (chunk_cbytes != 0 && cbytes_old >= chunk_cbytes) {
+      chunk_offset = old_offset;
+      add_hole(frame, old_offset + chunk_cbytes, cbytes_old - chunk_cbytes);
+    }
+    else {
+      add_hole(frame, old_offset, cbytes_old);
+      if (chunk_cbytes != 0) {
+        int64_t hole_offset = take_hole(frame, chunk_cbytes);
+        if (hole_offset >= 0) {
+          chunk_offset = hole_offset;
+        }
+      }
+    }
+    if (chunk_cbytes != 0) {
+      offsets[nchunk] = chunk_offset;
+    }
+    // The chunks section only grows when the chunk goes at its end
+    schunk->cbytes = chunk_offset == cbytes ? cbytes + chunk_cbytes : cbytes;
+    cbytes = chunk_offset;
   }
   // Re-compress the offsets again
   blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
@@ -2974,9 +4020,8 @@ void* frame_update_chunk(blosc2_frame_s* frame, int nchunk, void* chunk, blosc2_
 
   void* fp = NULL;
   if (frame->cframe != NULL) {
-    uint8_t* framep = frame->cframe;
     /* Make space for the new chunk and copy it */
-    frame->cframe = framep = realloc(framep, (size_t)new_frame_len);
+    uint8_t* framep = frame_reserve(frame, new_frame_len);
     if (framep == NULL) {
       BLOSC_TRACE_ERROR("Cannot realloc space for the frame.");
       return NULL;
@@ -2994,9 +4039,10 @@ void* frame_update_chunk(blosc2_frame_s* frame, int nchunk, void* chunk, blosc2_
       return NULL;
     }
 
+    frame_invalidate_fp(frame, -1);
     if (frame->sframe) {
       if (chunk_cbytes) {
-        if (sframe_create_chunk(frame, chunk, nchunk, chunk_cbytes) == NULL) {
+        if (sframe_create_chunk(frame, chunk, sframe_chunk_id, chunk_cbytes) == NULL) {
           BLOSC_TRACE_ERROR("Cannot write the full chunk.");
           return NULL;
         }
@@ -3029,7 +4075,9 @@ void* frame_update_chunk(blosc2_frame_s* frame, int nchunk, void* chunk, blosc2_
       free(frame->coffsets);
       frame->coffsets = NULL;
     }
+    frame->sframe_nextid = -1;
   }
+  drop_offsets(frame);
   free(chunk);  // chunk has always to be a copy when reaching here...
   free(off_chunk);
 
@@ -3128,9 +4176,8 @@ void* frame_delete_chunk(blosc2_frame_s* frame, int nchunk, blosc2_schunk* schun
   // Add the chunk and update meta
   FILE* fp = NULL;
   if (frame->cframe != NULL) {
-    uint8_t* framep = frame->cframe;
     /* Make space for the new chunk and copy it */
-    frame->cframe = framep = realloc(framep, (size_t)new_frame_len);
+    uint8_t* framep = frame_reserve(frame, new_frame_len);
     if (framep == NULL) {
       BLOSC_TRACE_ERROR("Cannot realloc space for the frame.");
       return NULL;
@@ -3152,8 +4199,10 @@ void* frame_delete_chunk(blosc2_frame_s* frame, int nchunk, blosc2_schunk* schun
         BLOSC_TRACE_ERROR("Unable to get offset to chunk %d.", nchunk);
         return NULL;
       }
+      frame_invalidate_fp(frame, -1);
       if (offset >= 0){
         // Remove the chunk file only if it is not a special value chunk
+        frame_invalidate_fp(frame, offset);
         int err = sframe_delete_chunk(frame->urlpath, offset);
         if (err != 0) {
           BLOSC_TRACE_ERROR("Unable to delete chunk!");
@@ -3166,7 +4215,8 @@ void* frame_delete_chunk(blosc2_frame_s* frame, int nchunk, blosc2_schunk* schun
     }
     else {
       // Regular frame
-      fp = io_cb->open(frame->urlpath, "rb+", frame->schunk->storage->io);
+      frame_invalidate_fp(frame, -1);
+      fp = io_cb->open(frame->urlpath, "rb+", frame->schunk->storage->io->params);
       io_cb->seek(fp, header_len + cbytes, SEEK_SET);
     }
     wbytes = io_cb->write(off_chunk, 1, (size_t)new_off_cbytes, fp);  // the new offsets
@@ -3180,7 +4230,11 @@ void* frame_delete_chunk(blosc2_frame_s* frame, int nchunk, blosc2_schunk* schun
       free(frame->coffsets);
       frame->coffsets = NULL;
     }
+    frame->sframe_nextid = -1;
   }
+  drop_offsets(frame);
+  // The space of the chunk is free now
+  drop_holes(frame);
   free(off_chunk);
 
   frame->len = new_frame_len;
@@ -3199,6 +4253,11 @@ void* frame_delete_chunk(blosc2_frame_s* frame, int nchunk, blosc2_schunk* schun
 
 
 int frame_reorder_offsets(blosc2_frame_s* frame, const int* offsets_order, blosc2_schunk* schunk) {
+  // Pending appends go first (see frame_flush)
+  int flush_rc = frame_flush(frame);
+  if (flush_rc < 0) {
+    return flush_rc;
+  }
   // Get header info
   int32_t header_len;
   int64_t frame_len;
@@ -3278,9 +4337,8 @@ int frame_reorder_offsets(blosc2_frame_s* frame, const int* offsets_order, blosc
   }
 
   if (frame->cframe != NULL) {
-    uint8_t* framep = frame->cframe;
     /* Make space for the new chunk and copy it */
-    frame->cframe = framep = realloc(framep, (size_t)new_frame_len);
+    uint8_t* framep = frame_reserve(frame, new_frame_len);
     if (framep == NULL) {
       BLOSC_TRACE_ERROR("Cannot realloc space for the frame.");
       return BLOSC2_ERROR_MEMORY_ALLOC;
@@ -3297,6 +4355,7 @@ int frame_reorder_offsets(blosc2_frame_s* frame, const int* offsets_order, blosc
       return BLOSC2_ERROR_PLUGIN_IO;
     }
 
+    frame_invalidate_fp(frame, -1);
     if (frame->sframe) {
       // Update the offsets chunk in the chunks frame
       fp = sframe_open_index(frame->urlpath, "rb+",
@@ -3321,6 +4380,8 @@ int frame_reorder_offsets(blosc2_frame_s* frame, const int* offsets_order, blosc
     free(frame->coffsets);
     frame->coffsets = NULL;
   }
+  frame->sframe_nextid = -1;
+  drop_offsets(frame);
   free(off_chunk);
 
   frame->len = new_frame_len;
@@ -3338,6 +4399,470 @@ int frame_reorder_offsets(blosc2_frame_s* frame, const int* offsets_order, blosc
 }
 
 
+/* Sort the chunks of a frame by their position */
+typedef struct {
+  int64_t offset;
+  int32_t nchunk;
+} chunk_extent;
+
+static int sort_extent(const void* a, const void* b) {
+  int64_t a_ = ((chunk_extent*)a)->offset;
+  int64_t b_ = ((chunk_extent*)b)->offset;
+  return (a_ > b_) - (a_ < b_);
+}
+
+
+/* Read or write size bytes at offset of the (opened) file of a cframe */
+static int move_chunk_data(blosc2_io_cb* io_cb, void* fp, int64_t offset, int64_t size, void* ptr, bool write) {
+  io_cb->seek(fp, offset, SEEK_SET);
+  int64_t nbytes = write ? io_cb->write(ptr, 1, size, fp) : io_cb->read(ptr, 1, size, fp);
+  if (nbytes != size) {
+    BLOSC_TRACE_ERROR("Cannot %s a chunk while compacting the frame.", write ? "write" : "read");
+    return write ? BLOSC2_ERROR_FILE_WRITE : BLOSC2_ERROR_FILE_READ;
+  }
+  return 0;
+}
+
+
+/* Move the chunks of an on-disk cframe to their compacted positions.
+ *
+ * Chunks are placed in logical order.  The chunks that are in the way of the
+ * one being placed are moved to the end of the file (past every target) first,
+ * so no chunk is ever overwritten before being read. */
+static int compact_file(blosc2_frame_s* frame, int32_t header_len, int64_t cbytes, int64_t* offsets,
+                        const int32_t* sizes, const int64_t* targets, int32_t nchunks) {
+  blosc2_io_cb *io_cb = blosc2_get_io_cb(frame->schunk->storage->io->id);
+  if (io_cb == NULL) {
+    BLOSC_TRACE_ERROR("Error getting the input/output API");
+    return BLOSC2_ERROR_PLUGIN_IO;
+  }
+
+  chunk_extent* extents = malloc(nchunks * sizeof(chunk_extent));
+  bool* placed = calloc(nchunks, sizeof(bool));
+  int32_t nextents = 0;
+  int32_t max_size = 0;
+  for (int32_t i = 0; i < nchunks; i++) {
+    if (offsets[i] < 0) {
+      continue;
+    }
+    extents[nextents].offset = offsets[i];
+    extents[nextents].nchunk = i;
+    nextents++;
+    if (sizes[i] > max_size) {
+      max_size = sizes[i];
+    }
+  }
+  qsort(extents, nextents, sizeof(chunk_extent), sort_extent);
+  uint8_t* chunk = malloc(max_size);
+  uint8_t* other = malloc(max_size);
+
+  frame_invalidate_fp(frame, -1);
+  void* fp = io_cb->open(frame->urlpath, "rb+", frame->schunk->storage->io->params);
+  if (fp == NULL) {
+    BLOSC_TRACE_ERROR("Cannot open the frame for reading and writing.");
+    free(extents);
+    free(placed);
+    free(chunk);
+    free(other);
+    return BLOSC2_ERROR_FILE_OPEN;
+  }
+
+  int rc = 0;
+  int64_t end = header_len + cbytes;
+  int32_t next = 0;
+  for (int32_t i = 0; rc == 0 && i < nchunks; i++) {
+    if (offsets[i] < 0) {
+      continue;
+    }
+    int64_t target = targets[i];
+    if (offsets[i] != target) {
+      rc = move_chunk_data(io_cb, fp, header_len + offsets[i], sizes[i], chunk, false);
+    }
+    // Get the chunks still in [target, target + size) out of the way
+    for (; rc == 0 && next < nextents && extents[next].offset < target + sizes[i]; next++) {
+      int32_t j = extents[next].nchunk;
+      if (j == i || placed[j]) {
+        continue;
+      }
+      rc = move_chunk_data(io_cb, fp, header_len + offsets[j], sizes[j], other, false);
+      if (rc == 0) {
+        rc = move_chunk_data(io_cb, fp, end, sizes[j], other, true);
+      }
+      offsets[j] = end - header_len;
+      end += sizes[j];
+    }
+    if (rc == 0 && offsets[i] != target) {
+      rc = move_chunk_data(io_cb, fp, header_len + target, sizes[i], chunk, true);
+      offsets[i] = target;
+    }
+    placed[i] = true;
+  }
+  io_cb->close(fp);
+
+  free(extents);
+  free(placed);
+  free(chunk);
+  free(other);
+  return rc;
+}
+
+
+/* Write a compacted copy of an on-disk cframe into a new file, which then replaces the frame.
+ *
+ * The header, the chunks in logical order, the new offsets and the trailer (which has no
+ * positions in it) are written to `<urlpath>.compact` first, so the frame is left untouched
+ * if this fails or is interrupted before the final rename. */
+/* Give the compacted copy of a frame (open with the stdio backend) the permissions (and the
+ * owner, if allowed) of the frame, and make sure that it is on disk before it replaces it. */
+static int finish_compact_copy(void* copy_fp, const char* copy_urlpath, const char* urlpath) {
+  FILE* file = ((blosc2_stdio_file*)copy_fp)->file;
+  struct stat st;
+  if (fflush(file) != 0 || stat(urlpath, &st) != 0) {
+    return BLOSC2_ERROR_FILE_WRITE;
+  }
+#if defined(_WIN32)
+  if (_chmod(copy_urlpath, st.st_mode & (_S_IREAD | _S_IWRITE)) != 0 || _commit(_fileno(file)) != 0) {
+    return BLOSC2_ERROR_FILE_WRITE;
+  }
+#else
+  (void) copy_urlpath;
+  int fd = fileno(file);
+  if (fchmod(fd, st.st_mode & 07777) != 0) {
+    return BLOSC2_ERROR_FILE_WRITE;
+  }
+  // Only privileged processes can give files away; otherwise keep at least the group
+  if (fchown(fd, st.st_uid, st.st_gid) != 0 && fchown(fd, (uid_t)-1, st.st_gid) != 0) {
+    BLOSC_TRACE_WARNING("Cannot give the compacted frame the owner of the original one.");
+  }
+  if (fsync(fd) != 0) {
+    return BLOSC2_ERROR_FILE_WRITE;
+  }
+#endif
+  return 0;
+}
+
+
+/* Make the rename of a file durable by syncing its directory (a no-op on Windows) */
+static void sync_parent_dir(const char* urlpath) {
+#if !defined(_WIN32)
+  const char* slash = strrchr(urlpath, '/');
+  char* dirpath = slash == NULL ? strdup(".") : strndup(urlpath, slash == urlpath ? 1 : slash - urlpath);
+  if (dirpath == NULL) {
+    return;
+  }
+  int fd = open(dirpath, O_RDONLY);
+  if (fd >= 0) {
+    fsync(fd);
+    close(fd);
+  }
+  free(dirpath);
+#else
+  (void) urlpath;
+#endif
+}
+
+
+static int compact_into_copy(blosc2_frame_s* frame, blosc2_schunk* schunk, int32_t header_len,
+                             const int64_t* offsets, const int32_t* sizes, int32_t nchunks,
+                             const void* off_chunk, int32_t off_cbytes, int64_t new_cbytes,
+                             int64_t new_frame_len) {
+  blosc2_io_cb *io_cb = blosc2_get_io_cb(frame->schunk->storage->io->id);
+  blosc2_io_cb *copy_io_cb = blosc2_get_io_cb(BLOSC2_IO_FILESYSTEM);
+  if (io_cb == NULL || copy_io_cb == NULL) {
+    BLOSC_TRACE_ERROR("Error getting the input/output API");
+    return BLOSC2_ERROR_PLUGIN_IO;
+  }
+
+  // The header of the compacted frame
+  int64_t old_len = frame->len;
+  int64_t old_cbytes = schunk->cbytes;
+  int64_t trailer_offset = get_trailer_offset(frame, header_len, true);
+  frame->len = new_frame_len;
+  schunk->cbytes = new_cbytes;
+  uint8_t* h2 = new_header_frame(schunk, frame);
+  frame->len = old_len;
+  schunk->cbytes = old_cbytes;
+  if (h2 == NULL) {
+    return BLOSC2_ERROR_DATA;
+  }
+  uint32_t h2len;
+  from_big(&h2len, h2 + FRAME_HEADER_LEN, sizeof(h2len));
+  if ((int32_t)h2len != header_len) {
+    BLOSC_TRACE_ERROR("The header of the compacted frame does not have the same size.");
+    free(h2);
+    return BLOSC2_ERROR_DATA;
+  }
+
+  int32_t max_size = frame->trailer_len;
+  for (int32_t i = 0; i < nchunks; i++) {
+    if (offsets[i] >= 0 && sizes[i] > max_size) {
+      max_size = sizes[i];
+    }
+  }
+  uint8_t* buffer = malloc((size_t)max_size);
+  char* copy_urlpath = malloc(strlen(frame->urlpath) + strlen(".compact") + 1);
+  sprintf(copy_urlpath, "%s.compact", frame->urlpath);
+
+  int rc = 0;
+  frame_invalidate_fp(frame, -1);
+  void* fp = io_cb->open(frame->urlpath, "rb", frame->schunk->storage->io->params);
+  void* copy_fp = copy_io_cb->open(copy_urlpath, "wb", NULL);
+  if (fp == NULL || copy_fp == NULL) {
+    BLOSC_TRACE_ERROR("Cannot open the frame or its compacted copy.");
+    rc = BLOSC2_ERROR_FILE_OPEN;
+    goto out;
+  }
+  if (copy_io_cb->write(h2, 1, header_len, copy_fp) != header_len) {
+    rc = BLOSC2_ERROR_FILE_WRITE;
+    goto out;
+  }
+  for (int32_t i = 0; i < nchunks; i++) {
+    if (offsets[i] < 0) {
+      continue;
+    }
+    if (frame_read_at(io_cb, fp, header_len + offsets[i], sizes[i], buffer) != sizes[i]) {
+      BLOSC_TRACE_ERROR("Cannot read a chunk while compacting the frame.");
+      rc = BLOSC2_ERROR_FILE_READ;
+      goto out;
+    }
+    if (copy_io_cb->write(buffer, 1, sizes[i], copy_fp) != sizes[i]) {
+      rc = BLOSC2_ERROR_FILE_WRITE;
+      goto out;
+    }
+  }
+  if (copy_io_cb->write(off_chunk, 1, off_cbytes, copy_fp) != off_cbytes) {
+    rc = BLOSC2_ERROR_FILE_WRITE;
+    goto out;
+  }
+  if (frame_read_at(io_cb, fp, trailer_offset, frame->trailer_len, buffer) != frame->trailer_len) {
+    BLOSC_TRACE_ERROR("Cannot read the trailer while compacting the frame.");
+    rc = BLOSC2_ERROR_FILE_READ;
+    goto out;
+  }
+  if (copy_io_cb->write(buffer, 1, frame->trailer_len, copy_fp) != frame->trailer_len) {
+    rc = BLOSC2_ERROR_FILE_WRITE;
+    goto out;
+  }
+  rc = finish_compact_copy(copy_fp, copy_urlpath, frame->urlpath);
+
+  out:
+  if (fp != NULL) {
+    io_cb->close(fp);
+  }
+  if (copy_fp != NULL && copy_io_cb->close(copy_fp) != 0 && rc == 0) {
+    rc = BLOSC2_ERROR_FILE_WRITE;
+  }
+  if (rc == BLOSC2_ERROR_FILE_WRITE) {
+    BLOSC_TRACE_ERROR("Cannot write the compacted copy of the frame.");
+  }
+  if (rc == 0) {
+#if defined(_WIN32)
+    bool renamed = MoveFileExA(copy_urlpath, frame->urlpath, MOVEFILE_REPLACE_EXISTING);
+#else
+    bool renamed = rename(copy_urlpath, frame->urlpath) == 0;
+#endif
+    if (!renamed) {
+      BLOSC_TRACE_ERROR("Cannot replace the frame with its compacted copy.");
+      rc = BLOSC2_ERROR_FILE_WRITE;
+    }
+    else {
+      sync_parent_dir(frame->urlpath);
+    }
+  }
+  if (rc < 0 && copy_fp != NULL) {
+    remove(copy_urlpath);
+  }
+  free(copy_urlpath);
+  free(buffer);
+  free(h2);
+  return rc;
+}
+
+
+int frame_compact(blosc2_frame_s* frame, blosc2_schunk* schunk) {
+  // Pending appends go first (see frame_flush)
+  int flush_rc = frame_flush(frame);
+  if (flush_rc < 0) {
+    return flush_rc;
+  }
+  if (frame->sframe) {
+    // Every chunk has a file of its own, so there is nothing to compact
+    return 0;
+  }
+
+  // Get header info
+  int32_t header_len;
+  int64_t frame_len;
+  int64_t nbytes;
+  int64_t cbytes;
+  int32_t blocksize;
+  int32_t chunksize;
+  int32_t nchunks;
+  int rc = get_header_info(frame, &header_len, &frame_len, &nbytes, &cbytes,
+                           &blocksize, &chunksize, &nchunks,
+                           NULL, NULL, NULL, NULL, NULL, NULL,
+                           frame->schunk->storage->io);
+  if (rc < 0) {
+    BLOSC_TRACE_ERROR("Cannot get the header info for the frame.");
+    return rc;
+  }
+  if (nchunks == 0) {
+    return 0;
+  }
+
+  // Get the current offsets
+  int32_t off_nbytes = nchunks * sizeof(int64_t);
+  int64_t* offsets = (int64_t *) malloc((size_t)off_nbytes);
+  int32_t coffsets_cbytes = 0;
+  uint8_t *coffsets = get_coffsets(frame, header_len, cbytes, nchunks, &coffsets_cbytes);
+  if (coffsets == NULL) {
+    BLOSC_TRACE_ERROR("Cannot get the offsets for the frame.");
+    free(offsets);
+    return BLOSC2_ERROR_DATA;
+  }
+  blosc2_dparams off_dparams = BLOSC2_DPARAMS_DEFAULTS;
+  blosc2_context *dctx = blosc2_create_dctx(off_dparams);
+  int32_t prev_nbytes = blosc2_decompress_ctx(dctx, coffsets, coffsets_cbytes, offsets, off_nbytes);
+  blosc2_free_ctx(dctx);
+  if (prev_nbytes < 0) {
+    free(offsets);
+    BLOSC_TRACE_ERROR("Cannot decompress the offsets chunk.");
+    return prev_nbytes;
+  }
+
+  // The chunks go one after the other, in logical order
+  int32_t* sizes = malloc(nchunks * sizeof(int32_t));
+  int64_t* targets = malloc(nchunks * sizeof(int64_t));
+  void* off_chunk = NULL;
+  int64_t new_cbytes = 0;
+  bool compacted = true;
+  for (int32_t i = 0; i < nchunks; i++) {
+    sizes[i] = 0;
+    targets[i] = offsets[i];
+    if (offsets[i] < 0) {
+      // Special chunks take no space
+      continue;
+    }
+    sizes[i] = get_chunk_cbytes(frame, header_len, offsets[i]);
+    if (sizes[i] < 0) {
+      rc = sizes[i];
+      goto out;
+    }
+    targets[i] = new_cbytes;
+    if (offsets[i] != targets[i]) {
+      compacted = false;
+    }
+    new_cbytes += sizes[i];
+  }
+  if (compacted && new_cbytes == cbytes) {
+    goto out;
+  }
+
+  // Compress the new offsets upfront, so that the frame is only touched when all is ready
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.splitmode = BLOSC_NEVER_SPLIT;
+  cparams.typesize = sizeof(int64_t);
+  cparams.blocksize = 16 * 1024;  // based on experiments with create_frame.c bench
+  cparams.nthreads = 4;  // 4 threads seems a decent default for nowadays CPUs
+  cparams.compcode = BLOSC_BLOSCLZ;
+  blosc2_context* cctx = blosc2_create_cctx(cparams);
+  off_chunk = malloc((size_t)off_nbytes + BLOSC_MAX_OVERHEAD);
+  int32_t new_off_cbytes = blosc2_compress_ctx(cctx, targets, off_nbytes,
+                                               off_chunk, off_nbytes + BLOSC_MAX_OVERHEAD);
+  blosc2_free_ctx(cctx);
+  if (new_off_cbytes < 0) {
+    rc = new_off_cbytes;
+    goto out;
+  }
+  int64_t new_frame_len = header_len + new_cbytes + new_off_cbytes + frame->trailer_len;
+
+  if (frame->cframe != NULL) {
+    uint8_t* chunks = malloc((size_t)new_cbytes);
+    if (chunks == NULL) {
+      BLOSC_TRACE_ERROR("Cannot allocate space for compacting the frame.");
+      rc = BLOSC2_ERROR_MEMORY_ALLOC;
+      goto out;
+    }
+    if (frame_reserve(frame, new_frame_len) == NULL) {
+      BLOSC_TRACE_ERROR("Cannot realloc space for the frame.");
+      free(chunks);
+      rc = BLOSC2_ERROR_MEMORY_ALLOC;
+      goto out;
+    }
+    for (int32_t i = 0; i < nchunks; i++) {
+      if (offsets[i] >= 0) {
+        memcpy(chunks + targets[i], frame->cframe + header_len + offsets[i], sizes[i]);
+      }
+    }
+    memcpy(frame->cframe + header_len, chunks, (size_t)new_cbytes);
+    memcpy(frame->cframe + header_len + new_cbytes, off_chunk, (size_t)new_off_cbytes);
+    free(chunks);
+  }
+  else if (frame->schunk->storage->io->id < BLOSC_IO_LAST_BLOSC_DEFINED) {
+    // Frames in (regular) files are replaced as a whole, so they are never half-compacted
+    rc = compact_into_copy(frame, schunk, header_len, offsets, sizes, nchunks,
+                           off_chunk, new_off_cbytes, new_cbytes, new_frame_len);
+    if (rc < 0) {
+      goto out;
+    }
+  }
+  else {
+    // Other backends may not store files, so the chunks are moved in place
+    rc = compact_file(frame, header_len, cbytes, offsets, sizes, targets, nchunks);
+    if (rc < 0) {
+      BLOSC_TRACE_ERROR("Cannot move the chunks of the frame.");
+      goto out;
+    }
+    blosc2_io_cb *io_cb = blosc2_get_io_cb(frame->schunk->storage->io->id);
+    void* fp = io_cb->open(frame->urlpath, "rb+", frame->schunk->storage->io->params);
+    if (fp == NULL) {
+      BLOSC_TRACE_ERROR("Cannot open the frame for reading and writing.");
+      rc = BLOSC2_ERROR_FILE_OPEN;
+      goto out;
+    }
+    rc = move_chunk_data(io_cb, fp, header_len + new_cbytes, new_off_cbytes, off_chunk, true);
+    io_cb->close(fp);
+    if (rc < 0) {
+      BLOSC_TRACE_ERROR("Cannot write the offsets to frame.");
+      goto out;
+    }
+  }
+
+  // Invalidate the cache for chunk offsets and the holes (there are none left)
+  if (frame->coffsets != NULL) {
+    free(frame->coffsets);
+    frame->coffsets = NULL;
+  }
+  drop_offsets(frame);
+  drop_holes(frame);
+
+  frame->len = new_frame_len;
+  schunk->cbytes = new_cbytes;
+  rc = frame_update_header(frame, schunk, false);
+  if (rc < 0) {
+    goto out;
+  }
+  rc = frame_update_trailer(frame, schunk);
+  if (rc < 0) {
+    goto out;
+  }
+  if (frame->cframe != NULL) {
+    rc = frame_trim(frame);
+    if (rc < 0) {
+      goto out;
+    }
+  }
+  rc = 0;
+
+  out:
+  free(off_chunk);
+  free(offsets);
+  free(sizes);
+  free(targets);
+  return rc;
+}
+
+
 /* Decompress and return a chunk that is part of a frame. */
 int frame_decompress_chunk(blosc2_context *dctx, blosc2_frame_s* frame, int nchunk, void *dest, int32_t nbytes) {
   uint8_t* src;
@@ -3347,7 +4872,7 @@ int frame_decompress_chunk(blosc2_context *dctx, blosc2_frame_s* frame, int nchu
   int rc;
 
   // Use a lazychunk here in order to do a potential parallel read.
-  rc = frame_get_lazychunk(frame, nchunk, &src, &needs_free);
+  rc = frame_borrow_lazychunk(frame, nchunk, &src, &needs_free);
   if (rc < 0) {
     BLOSC_TRACE_ERROR("Cannot get the chunk in position %d.", nchunk);
     goto end;
@@ -14,6 +14,14 @@
 #include <stdio.h>
 #include <stdint.h>
 
+#if defined(_WIN32) && !defined(__GNUC__)
+  #include "win32/pthread.h"
+#else
+  #include <pthread.h>
+#endif
+
+#include "blosc2.h"
+
 // Different types of frames
 #define FRAME_CONTIGUOUS_TYPE 0
 #define FRAME_DIRECTORY_TYPE 1
@@ -50,16 +58,55 @@
 #define FRAME_TRAILER_LEN_OFFSET (22)  // offset to trailer length (counting from the end)
 #define FRAME_TRAILER_VLMETALAYERS (2)
 
+#define FRAME_FP_CACHE_SIZE (16)  // the maximum number of file handles cached in a frame
+
+
+typedef struct {
+  void* fp;                 //!< The cached file handle; if NULL, the slot is free
+  int64_t nchunk;           //!< The id of the chunk file in sframes; if < 0, the frame (or index) file
+  blosc2_io_cb *io_cb;      //!< The input/output callbacks used for opening the handle
+  uint64_t last_use;        //!< The last time (in frame->fp_clock units) that the handle was used
+  int32_t refs;             //!< The number of users that pinned the handle (see frame_pin_fp)
+  bool stale;               //!< Whether the handle has to be closed as soon as it is unpinned
+} frame_fp_entry;
+
+
+typedef struct {
+  int64_t offset;           //!< The offset of the unused range in the chunks section of the frame
+  int64_t size;             //!< The size of the unused range
+} frame_hole;
+
 
 typedef struct {
   char* urlpath;            //!< The name of the file or directory if it's an sframe; if NULL, this is in-memory
   uint8_t* cframe;          //!< The in-memory, contiguous frame buffer
+  int64_t cframe_size;      //!< The size of the buffer above, which may be larger than the frame
   bool avoid_cframe_free;   //!< Whether the cframe can be freed (false) or not (true).
   uint8_t* coffsets;        //!< Pointers to the (compressed, on-disk) chunk offsets
+  int64_t* offsets;         //!< The decompressed chunk offsets; if NULL, they are not resident
+  int32_t noffsets;         //!< The number of resident chunk offsets
+  int32_t maxoffsets;       //!< The number of chunk offsets that fit in the offsets buffer
+  int32_t offsets_lookups;  //!< The number of offset lookups since the resident offsets were dropped
+  frame_hole* holes;        //!< The unused ranges between the chunks of a cframe, by offset; if NULL, not computed yet
+  int32_t nholes;           //!< The number of unused ranges
+  int32_t maxholes;         //!< The number of unused ranges that fit in the holes buffer
+  uint8_t* wbuffer;         //!< The chunks appended to an on-disk cframe that are not written yet
+  int64_t wbuffer_len;      //!< The length of the pending chunks in the buffer above
+  int64_t wbuffer_size;     //!< The size of the buffer for pending chunks
+  int64_t wbuffer_offset;   //!< The offset of the first pending chunk in the chunks section
+  int64_t wpending;         //!< The bytes appended since the last flush
+  bool dirty;               //!< Whether the offsets, header and trailer on disk are outdated (see frame_flush)
   int64_t len;              //!< The current length of the frame in (compressed) bytes
   int64_t maxlen;           //!< The maximum length of the frame; if 0, there is no maximum
   uint32_t trailer_len;     //!< The current length of the trailer in (compressed) bytes
+  uint8_t header[FRAME_HEADER_MINLEN];  //!< Copy of the fixed part of the header for on-disk frames
+  bool header_cached;       //!< Whether the copy of the header above is in sync with the file
   bool sframe;              //!< Whether the frame is sparse (true) or not
+  int64_t sframe_nextid;    //!< The id for the next chunk file in a sparse frame; if < 0, not computed yet
+  frame_fp_entry fp_cache[FRAME_FP_CACHE_SIZE];  //!< LRU cache of file handles for reading the frame
+  uint64_t fp_clock;        //!< The clock for the LRU cache of file handles
+  pthread_mutex_t fp_mutex; //!< Lock for the cache of file handles (and the handles themselves)
+  pthread_mutex_t offsets_mutex;  //!< Lock for the lookups of chunk offsets (and the resident offsets)
   blosc2_schunk *schunk;    //!< The schunk associated
 } blosc2_frame_s;
 
@@ -79,6 +126,82 @@ typedef struct {
  */
 blosc2_frame_s* frame_new(const char* urlpath);
 
+/**
+ * @brief Get a cached file handle for reading a frame.
+ *
+ * @param frame The frame to read from.
+ * @param nchunk The id of the chunk file for sparse frames.  If negative, the handle is for
+ * the frame file (or the index file for sparse frames).
+ * @param io The input/output API for opening the file (if not cached yet).
+ *
+ * @note The cache is locked until the handle is released with @ref frame_release_fp, so no
+ * other frame function should be called in-between.  Handles should not be closed by callers.
+ *
+ * @return The file handle.  If an error occurs it returns NULL (and the cache is not locked).
+ */
+void* frame_acquire_fp(blosc2_frame_s* frame, int64_t nchunk, const blosc2_io* io);
+
+/**
+ * @brief Release a file handle acquired with @ref frame_acquire_fp.
+ *
+ * @param frame The frame the handle belongs to.
+ */
+void frame_release_fp(blosc2_frame_s* frame);
+
+/**
+ * @brief Pin a cached file handle for positional reads.
+ *
+ * Unlike @ref frame_acquire_fp, the cache is not kept locked, so several threads can read
+ * from the same handle at once.  This is only safe with the `read_at` and `readv_at`
+ * callbacks, which do not move the position of the stream.
+ *
+ * @param frame The frame to read from.
+ * @param nchunk The id of the chunk file for sparse frames.  If negative, the handle is for
+ * the frame file (or the index file for sparse frames).
+ * @param io The input/output API for opening the file (if not cached yet).
+ *
+ * @return The file handle, which stays open until unpinned with @ref frame_unpin_fp.
+ * If an error occurs it returns NULL.
+ */
+void* frame_pin_fp(blosc2_frame_s* frame, int64_t nchunk, const blosc2_io* io);
+
+/**
+ * @brief Unpin a file handle pinned with @ref frame_pin_fp.
+ *
+ * @param frame The frame the handle belongs to.
+ * @param fp The file handle.
+ */
+void frame_unpin_fp(blosc2_frame_s* frame, void* fp);
+
+/**
+ * @brief Read @p size bytes at @p offset of a file, without moving its position if possible.
+ *
+ * This uses the `read_at` callback of @p io_cb and falls back to seek + read for the
+ * backends that do not implement it (so then the handle must be acquired).
+ *
+ * @return The number of bytes read.  If an error occurs it returns a negative value.
+ */
+int64_t frame_read_at(blosc2_io_cb* io_cb, void* fp, int64_t offset, int64_t size, void* ptr);
+
+/**
+ * @brief Read many ranges of a file, without moving its position if possible.
+ *
+ * This uses the `readv_at` callback of @p io_cb and falls back to one @ref frame_read_at
+ * per range for the backends that do not implement it.
+ *
+ * @return The total number of bytes read.  If an error occurs it returns a negative value.
+ */
+int64_t frame_readv_at(blosc2_io_cb* io_cb, void* fp, const blosc2_io_segment* segments, int64_t nsegments);
+
+/**
+ * @brief Close a cached file handle, so that the next reads see changes made to the file.
+ *
+ * @param frame The frame the handle belongs to.
+ * @param nchunk The id of the chunk file for sparse frames.  If negative, the handle of the
+ * frame file (or the index file for sparse frames).
+ */
+void frame_invalidate_fp(blosc2_frame_s* frame, int64_t nchunk);
+
 /**
  * @brief Create a frame from a super-chunk.
  *
@@ -101,6 +224,15 @@ int64_t frame_from_schunk(blosc2_schunk* schunk, blosc2_frame_s* frame);
  */
 int frame_free(blosc2_frame_s *frame);
 
+/**
+ * @brief Release the memory of an in-memory frame beyond its length.
+ *
+ * @param frame The frame to be trimmed.
+ *
+ * @return 0 if succeeds.  Else, a negative value.
+ */
+int frame_trim(blosc2_frame_s *frame);
+
 /**
  * @brief Initialize a frame out of a file.
  *
@@ -142,9 +274,12 @@ void* frame_insert_chunk(blosc2_frame_s* frame, int nchunk, void* chunk, blosc2_
 void* frame_update_chunk(blosc2_frame_s* frame, int nchunk, void* chunk, blosc2_schunk* schunk);
 void* frame_delete_chunk(blosc2_frame_s* frame, int nchunk, blosc2_schunk* schunk);
 int frame_reorder_offsets(blosc2_frame_s *frame, const int *offsets_order, blosc2_schunk* schunk);
+int frame_compact(blosc2_frame_s *frame, blosc2_schunk* schunk);
+int frame_flush(blosc2_frame_s *frame);
 
 int frame_get_chunk(blosc2_frame_s* frame, int nchunk, uint8_t **chunk, bool *needs_free);
 int frame_get_lazychunk(blosc2_frame_s* frame, int nchunk, uint8_t **chunk, bool *needs_free);
+int frame_borrow_lazychunk(blosc2_frame_s* frame, int nchunk, uint8_t **chunk, bool *needs_free);
 int frame_decompress_chunk(blosc2_context* dctx, blosc2_frame_s* frame, int nchunk,
                            void *dest, int32_t nbytes);
 
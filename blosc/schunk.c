@@ -17,6 +17,7 @@
 #include "blosc-private.h"
 #include "frame.h"
 #include "stune.h"
+#include "blockcache.h"
 
 #if defined(_WIN32)
   #include <windows.h>
@@ -331,6 +332,11 @@ int64_t blosc2_schunk_to_buffer(blosc2_schunk* schunk, uint8_t** dest, bool* nee
   int64_t cframe_len;
   if ((schunk->storage->contiguous == true) && (schunk->storage->urlpath == NULL)) {
     frame =  (blosc2_frame_s*)(schunk->frame);
+    // The buffer may have room for more chunks
+    int rc = frame_trim(frame);
+    if (rc < 0) {
+      return rc;
+    }
     *dest = frame->cframe;
     cframe_len = frame->len;
     *needs_free = false;
@@ -344,6 +350,11 @@ int64_t blosc2_schunk_to_buffer(blosc2_schunk* schunk, uint8_t** dest, bool* nee
       return BLOSC2_ERROR_SCHUNK_COPY;
     }
     frame = (blosc2_frame_s*)(schunk_copy->frame);
+    int rc = frame_trim(frame);
+    if (rc < 0) {
+      blosc2_schunk_free(schunk_copy);
+      return rc;
+    }
     *dest = frame->cframe;
     cframe_len = frame->len;
     *needs_free = true;
@@ -363,7 +374,7 @@ int64_t frame_to_file(blosc2_frame_s* frame, const char* urlpath) {
     BLOSC_TRACE_ERROR("Error getting the input/output API");
     return BLOSC2_ERROR_PLUGIN_IO;
   }
-  void* fp = io_cb->open(urlpath, "wb", frame->schunk->storage->io);
+  void* fp = io_cb->open(urlpath, "wb", frame->schunk->storage->io->params);
   int64_t nitems = io_cb->write(frame->cframe, frame->len, 1, fp);
   io_cb->close(fp);
   return nitems * (size_t)frame->len;
@@ -403,6 +414,15 @@ int64_t blosc2_schunk_to_file(blosc2_schunk* schunk, const char* urlpath) {
 
 /* Free all memory from a super-chunk. */
 int blosc2_schunk_free(blosc2_schunk *schunk) {
+  int rc = 0;
+  if (schunk->frame != NULL) {
+    // Do not lose the pending appends
+    rc = frame_flush((blosc2_frame_s *) schunk->frame);
+    if (rc < 0) {
+      BLOSC_TRACE_ERROR("Cannot write the pending appends to the frame.");
+    }
+  }
+
   if (schunk->data != NULL) {
     for (int i = 0; i < schunk->nchunks; i++) {
       free(schunk->data[i]);
@@ -441,6 +461,10 @@ int blosc2_schunk_free(blosc2_schunk *schunk) {
     frame_free((blosc2_frame_s *) schunk->frame);
   }
 
+  if (schunk->block_cache != NULL) {
+    block_cache_free(schunk->block_cache);
+  }
+
   if (schunk->nvlmetalayers > 0) {
     for (int i = 0; i < schunk->nvlmetalayers; ++i) {
       if (schunk->vlmetalayers[i] != NULL) {
@@ -458,7 +482,7 @@ int blosc2_schunk_free(blosc2_schunk *schunk) {
   }
   free(schunk);
 
-  return 0;
+  return rc;
 }
 
 
@@ -657,6 +681,15 @@ int blosc2_schunk_append_chunk(blosc2_schunk *schunk, uint8_t *chunk, bool copy)
 }
 
 
+/* Drop the blocks of a chunk that has changed (and of the following ones, if they have moved)
+   out of the block cache.  Call it once the chunks have changed, even if only partly. */
+static void invalidate_block_cache(blosc2_schunk *schunk, int nchunk, bool following) {
+  if (schunk->block_cache != NULL) {
+    block_cache_invalidate(schunk->block_cache, nchunk, following);
+  }
+}
+
+
 /* Insert an existing @p chunk in a specified position on a super-chunk */
 int blosc2_schunk_insert_chunk(blosc2_schunk *schunk, int nchunk, uint8_t *chunk, bool copy) {
   int32_t chunk_nbytes;
@@ -668,6 +701,12 @@ int blosc2_schunk_insert_chunk(blosc2_schunk *schunk, int nchunk, uint8_t *chunk
     return rc;
   }
 
+  // Pending appends go first (see blosc2_schunk_flush)
+  rc = blosc2_schunk_flush(schunk);
+  if (rc < 0) {
+    return rc;
+  }
+
   if (schunk->chunksize == -1) {
     schunk->chunksize = chunk_nbytes;  // The super-chunk is initialized now
   }
@@ -743,11 +782,16 @@ int blosc2_schunk_insert_chunk(blosc2_schunk *schunk, int nchunk, uint8_t *chunk
   }
 
   else {
-    if (frame_insert_chunk(frame, nchunk, chunk, schunk) == NULL) {
+    void* rframe = frame_insert_chunk(frame, nchunk, chunk, schunk);
+    // The following chunks are moved one position
+    invalidate_block_cache(schunk, nchunk, true);
+    if (rframe == NULL) {
       BLOSC_TRACE_ERROR("Problems inserting a chunk in a frame.");
       return BLOSC2_ERROR_CHUNK_INSERT;
     }
+    return schunk->nchunks;
   }
+  invalidate_block_cache(schunk, nchunk, true);
   return schunk->nchunks;
 }
 
@@ -761,11 +805,19 @@ int blosc2_schunk_update_chunk(blosc2_schunk *schunk, int nchunk, uint8_t *chunk
     return rc;
   }
 
+  // Pending appends go first (see blosc2_schunk_flush)
+  rc = blosc2_schunk_flush(schunk);
+  if (rc < 0) {
+    return rc;
+  }
+
   if (schunk->chunksize == -1) {
     schunk->chunksize = chunk_nbytes;  // The super-chunk is initialized now
   }
 
-  if ((schunk->chunksize != 0) && (chunk_nbytes != schunk->chunksize)) {
+  // The last chunk may be smaller
+  if ((schunk->chunksize != 0) && (chunk_nbytes != schunk->chunksize) &&
+      !(nchunk == schunk->nchunks - 1 && chunk_nbytes < schunk->chunksize)) {
     BLOSC_TRACE_ERROR("Inserting chunks that have different lengths in the same schunk "
                       "is not supported yet: %d > %d.", chunk_nbytes, schunk->chunksize);
     return BLOSC2_ERROR_CHUNK_INSERT;
@@ -825,15 +877,12 @@ int blosc2_schunk_update_chunk(blosc2_schunk *schunk, int nchunk, uint8_t *chunk
         /* Update counters */
         schunk->nbytes += chunk_nbytes;
         schunk->nbytes -= chunk_nbytes_old;
-        schunk->cbytes += chunk_cbytes;
+        // For cframes, this is the size of the chunks section (holes included), which
+        // depends on where the chunk goes (see frame_update_chunk)
         if (frame->sframe) {
+          schunk->cbytes += chunk_cbytes;
           schunk->cbytes -= chunk_cbytes_old;
         }
-        else {
-          if (chunk_cbytes_old >= chunk_cbytes) {
-            schunk->cbytes -= chunk_cbytes;
-          }
-        }
     }
   }
 
@@ -851,11 +900,15 @@ int blosc2_schunk_update_chunk(blosc2_schunk *schunk, int nchunk, uint8_t *chunk
     schunk->data[nchunk] = chunk;
   }
   else {
-    if (frame_update_chunk(frame, nchunk, chunk, schunk) == NULL) {
+    void* rframe = frame_update_chunk(frame, nchunk, chunk, schunk);
+    invalidate_block_cache(schunk, nchunk, false);
+    if (rframe == NULL) {
         BLOSC_TRACE_ERROR("Problems updating a chunk in a frame.");
         return BLOSC2_ERROR_CHUNK_UPDATE;
     }
+    return schunk->nchunks;
   }
+  invalidate_block_cache(schunk, nchunk, false);
 
   return schunk->nchunks;
 }
@@ -866,6 +919,12 @@ int blosc2_schunk_delete_chunk(blosc2_schunk *schunk, int nchunk) {
     BLOSC_TRACE_ERROR("The schunk has not enough chunks (%d)!", schunk->nchunks);
   }
 
+  // Pending appends go first (see blosc2_schunk_flush)
+  rc = blosc2_schunk_flush(schunk);
+  if (rc < 0) {
+    return rc;
+  }
+
   bool needs_free;
   uint8_t *chunk_old;
   int err = blosc2_schunk_get_chunk(schunk, nchunk, &chunk_old, &needs_free);
@@ -917,11 +976,16 @@ int blosc2_schunk_delete_chunk(blosc2_schunk *schunk, int nchunk) {
 
   }
   else {
-    if (frame_delete_chunk(frame, nchunk, schunk) == NULL) {
+    void* rframe = frame_delete_chunk(frame, nchunk, schunk);
+    // The following chunks are moved one position
+    invalidate_block_cache(schunk, nchunk, true);
+    if (rframe == NULL) {
       BLOSC_TRACE_ERROR("Problems deleting a chunk in a frame.");
       return BLOSC2_ERROR_CHUNK_UPDATE;
     }
+    return schunk->nchunks;
   }
+  invalidate_block_cache(schunk, nchunk, true);
   return schunk->nchunks;
 }
 
@@ -946,8 +1010,8 @@ int blosc2_schunk_append_buffer(blosc2_schunk *schunk, void *src, int32_t nbytes
   return nchunks;
 }
 
-/* Decompress and return a chunk that is part of a super-chunk. */
-int blosc2_schunk_decompress_chunk(blosc2_schunk *schunk, int nchunk,
+/* Decompress a chunk that is part of a super-chunk with the `dctx` context. */
+static int decompress_stored_chunk(blosc2_schunk *schunk, blosc2_context *dctx, int nchunk,
                                    void *dest, int32_t nbytes) {
   int32_t chunk_nbytes;
   int32_t chunk_cbytes;
@@ -977,7 +1041,7 @@ int blosc2_schunk_decompress_chunk(blosc2_schunk *schunk, int nchunk,
       return BLOSC2_ERROR_INVALID_PARAM;
     }
 
-    chunksize = blosc2_decompress_ctx(schunk->dctx, src, chunk_cbytes, dest, nbytes);
+    chunksize = blosc2_decompress_ctx(dctx, src, chunk_cbytes, dest, nbytes);
     if (chunksize < 0 || chunksize != chunk_nbytes) {
       BLOSC_TRACE_ERROR("Error in decompressing chunk.");
       if (chunksize < 0)
@@ -985,7 +1049,7 @@ int blosc2_schunk_decompress_chunk(blosc2_schunk *schunk, int nchunk,
       return BLOSC2_ERROR_FAILURE;
     }
   } else {
-    chunksize = frame_decompress_chunk(schunk->dctx, frame, nchunk, dest, nbytes);
+    chunksize = frame_decompress_chunk(dctx, frame, nchunk, dest, nbytes);
     if (chunksize < 0) {
       return chunksize;
     }
@@ -993,6 +1057,845 @@ int blosc2_schunk_decompress_chunk(blosc2_schunk *schunk, int nchunk,
   return chunksize;
 }
 
+/* Decompress a chunk that is part of a super-chunk, going through its block cache (if any). */
+static int decompress_chunk(blosc2_schunk *schunk, blosc2_context *dctx, int nchunk,
+                            void *dest, int32_t nbytes) {
+  blosc2_block_cache* cache = schunk->block_cache;
+  // Masked out blocks are not decompressed, so they cannot go to the cache
+  if (cache == NULL || dctx->block_maskout != NULL) {
+    return decompress_stored_chunk(schunk, dctx, nchunk, dest, nbytes);
+  }
+
+  int64_t generation = block_cache_generation(cache);
+  int32_t chunk_nbytes;
+  int32_t blocksize;
+  int32_t nblocks;
+  if (block_cache_get_layout(cache, nchunk, &chunk_nbytes, &blocksize) && chunk_nbytes <= nbytes) {
+    nblocks = (chunk_nbytes + blocksize - 1) / blocksize;
+    int32_t nblock = 0;
+    for (; nblock < nblocks; nblock++) {
+      int32_t offset = nblock * blocksize;
+      int32_t bsize = chunk_nbytes - offset < blocksize ? chunk_nbytes - offset : blocksize;
+      if (!block_cache_get(cache, nchunk, nblock, 0, bsize, (uint8_t*)dest + offset, false)) {
+        break;
+      }
+    }
+    if (nblock == nblocks) {
+      block_cache_count(cache, nblocks, 0);
+      return chunk_nbytes;
+    }
+  }
+
+  chunk_nbytes = decompress_stored_chunk(schunk, dctx, nchunk, dest, nbytes);
+  if (chunk_nbytes <= 0) {
+    return chunk_nbytes;
+  }
+  // The context has the blocksize of the chunk that has just been decompressed
+  blocksize = dctx->blocksize > 0 && dctx->blocksize < chunk_nbytes ? dctx->blocksize : chunk_nbytes;
+  // All the blocks have been decompressed, including the ones found in the cache
+  nblocks = (chunk_nbytes + blocksize - 1) / blocksize;
+  block_cache_count(cache, 0, nblocks);
+  int rc = block_cache_set_layout(cache, nchunk, chunk_nbytes, blocksize, generation);
+  for (int32_t offset = 0; rc >= 0 && offset < chunk_nbytes; offset += blocksize) {
+    int32_t bsize = chunk_nbytes - offset < blocksize ? chunk_nbytes - offset : blocksize;
+    rc = block_cache_put(cache, nchunk, offset / blocksize, (uint8_t*)dest + offset, bsize, generation);
+  }
+  return rc < 0 ? rc : chunk_nbytes;
+}
+
+/* Decompress and return a chunk that is part of a super-chunk. */
+int blosc2_schunk_decompress_chunk(blosc2_schunk *schunk, int nchunk,
+                                   void *dest, int32_t nbytes) {
+  return decompress_chunk(schunk, schunk->dctx, nchunk, dest, nbytes);
+}
+
+
+/* The frame of a super-chunk caches its header and chunk offsets the first
+   time they are needed; do that before its chunks are read by several
+   threads at once. */
+static int warm_frame_caches(blosc2_schunk *schunk, int nchunk) {
+  blosc2_frame_s* frame = (blosc2_frame_s*)schunk->frame;
+  if (frame == NULL) {
+    return 0;
+  }
+  uint8_t* chunk;
+  bool needs_free;
+  int rc = frame_borrow_lazychunk(frame, nchunk, &chunk, &needs_free);
+  if (needs_free) {
+    free(chunk);
+  }
+  return rc < 0 ? rc : 0;
+}
+
+
+/* Get a lazy chunk that is decompressed right away, so that chunks of mapped
+   frames can be read in place (see frame_borrow_lazychunk). */
+static int borrow_lazychunk(blosc2_schunk *schunk, int nchunk, uint8_t **chunk, bool *needs_free) {
+  blosc2_frame_s* frame = (blosc2_frame_s*)schunk->frame;
+  if (frame != NULL) {
+    return frame_borrow_lazychunk(frame, nchunk, chunk, needs_free);
+  }
+  return blosc2_schunk_get_lazychunk(schunk, nchunk, chunk, needs_free);
+}
+
+
+typedef struct {
+  blosc2_schunk* schunk;
+  int start;
+  uint8_t* dest;
+  int64_t nbytes;
+} decompress_range_data;
+
+/* Decompress a chunk of a range into its place in the destination */
+static int decompress_range_chunk(blosc2_context *dctx, void *batch_data, int32_t nitem) {
+  decompress_range_data* range = (decompress_range_data*)batch_data;
+  int64_t offset = (int64_t)nitem * range->schunk->chunksize;
+  int64_t nbytes = range->nbytes - offset;
+  if (nbytes > range->schunk->chunksize) {
+    nbytes = range->schunk->chunksize;
+  }
+  return decompress_chunk(range->schunk, dctx, range->start + nitem, range->dest + offset, (int32_t)nbytes);
+}
+
+/* Decompress the chunks from `start` to `stop` (not included) of a super-chunk, one after another. */
+int64_t blosc2_schunk_decompress_range(blosc2_schunk *schunk, int start, int stop,
+                                       void *dest, int64_t nbytes) {
+  if (start < 0 || stop > schunk->nchunks || start > stop) {
+    BLOSC_TRACE_ERROR("The range of chunks [%d, %d) is out of the super-chunk "
+                      "('%d' chunks).", start, stop, schunk->nchunks);
+    return BLOSC2_ERROR_INVALID_PARAM;
+  }
+  int32_t nchunks = stop - start;
+  if (nchunks == 0) {
+    return 0;
+  }
+  if (nbytes < (int64_t)(nchunks - 1) * schunk->chunksize) {
+    BLOSC_TRACE_ERROR("Buffer size is too small for the decompressed chunks "
+                      "('%d' bytes per chunk are needed).", schunk->chunksize);
+    return BLOSC2_ERROR_INVALID_PARAM;
+  }
+
+  if (nchunks > 1) {
+    int rc = warm_frame_caches(schunk, start);
+    if (rc < 0) {
+      return rc;
+    }
+  }
+
+  int32_t* results = malloc(nchunks * sizeof(int32_t));
+  BLOSC_ERROR_NULL(results, BLOSC2_ERROR_MEMORY_ALLOC);
+  decompress_range_data range = {schunk, start, dest, nbytes};
+  // Every thread of the context reads and decompresses chunks of its own, so
+  // that reading a chunk overlaps with the decompression of the others
+  int64_t rc = run_batch(schunk->dctx, decompress_range_chunk, &range, nchunks, results);
+  if (rc == 0) {
+    for (int32_t i = 0; i < nchunks; i++) {
+      if (i < nchunks - 1 && results[i] != schunk->chunksize) {
+        BLOSC_TRACE_ERROR("Chunk %d is not full, so the range cannot be contiguous.", start + i);
+        rc = BLOSC2_ERROR_FAILURE;
+        break;
+      }
+      rc += results[i];
+    }
+  }
+  free(results);
+
+  return rc;
+}
+
+
+/* Check that the items from `start` to `stop` (not included) are in a super-chunk */
+static int check_slice(blosc2_schunk *schunk, int64_t start, int64_t stop) {
+  int64_t nitems = schunk->nbytes / schunk->typesize;
+  if (start < 0 || stop > nitems || start > stop) {
+    BLOSC_TRACE_ERROR("The slice [%lld, %lld) is out of the super-chunk ('%lld' items).",
+                      (long long)start, (long long)stop, (long long)nitems);
+    return BLOSC2_ERROR_INVALID_PARAM;
+  }
+  if (start < stop && schunk->chunksize <= 0) {
+    BLOSC_TRACE_ERROR("Slices need super-chunks with a fixed chunksize.");
+    return BLOSC2_ERROR_INVALID_PARAM;
+  }
+  return 0;
+}
+
+typedef struct {
+  blosc2_schunk* schunk;
+  int64_t start;   // in bytes
+  int64_t stop;    // in bytes
+  int first_chunk;
+  uint8_t* buffer;
+} slice_data;
+
+/* Get `nbytes` from `start` of a chunk, going through the block cache of the super-chunk */
+static int get_cached_items(blosc2_schunk *schunk, blosc2_context *dctx, int nchunk,
+                            int32_t start, int32_t nbytes, uint8_t *dest) {
+  blosc2_block_cache* cache = schunk->block_cache;
+  uint8_t* chunk = NULL;
+  bool needs_free = false;
+  int cbytes = 0;
+  uint8_t* block = NULL;
+  int32_t chunk_nbytes;
+  int32_t blocksize;
+  int rc = 0;
+
+  int64_t generation = block_cache_generation(cache);
+  if (!block_cache_get_layout(cache, nchunk, &chunk_nbytes, &blocksize)) {
+    cbytes = rc = borrow_lazychunk(schunk, nchunk, &chunk, &needs_free);
+    if (rc <= 0) {
+      BLOSC_TRACE_ERROR("Cannot get the chunk in position %d.", nchunk);
+      return rc < 0 ? rc : BLOSC2_ERROR_NOT_FOUND;
+    }
+    rc = blosc2_cbuffer_sizes(chunk, &chunk_nbytes, NULL, &blocksize);
+    if (rc >= 0) {
+      blocksize = blocksize > 0 && blocksize < chunk_nbytes ? blocksize : chunk_nbytes;
+      rc = block_cache_set_layout(cache, nchunk, chunk_nbytes, blocksize, generation);
+    }
+  }
+
+  int32_t stop = start + nbytes;
+  for (int32_t nblock = start / blocksize; rc >= 0 && nblock <= (stop - 1) / blocksize; nblock++) {
+    int32_t block_start = nblock * blocksize;
+    int32_t bsize = chunk_nbytes - block_start < blocksize ? chunk_nbytes - block_start : blocksize;
+    int32_t offset = start > block_start ? start - block_start : 0;
+    int32_t part = (stop < block_start + bsize ? stop - block_start : bsize) - offset;
+    uint8_t* part_dest = dest + (block_start + offset - start);
+    if (block_cache_get(cache, nchunk, nblock, offset, part, part_dest, true)) {
+      continue;
+    }
+    // Decompress the whole block, so that it can go to the cache
+    if (chunk == NULL) {
+      cbytes = rc = borrow_lazychunk(schunk, nchunk, &chunk, &needs_free);
+      if (rc < 0) {
+        break;
+      }
+    }
+    if (block == NULL) {
+      block = malloc(blocksize);
+      if (block == NULL) {
+        BLOSC_TRACE_ERROR("Error allocating memory for a block.");
+        rc = BLOSC2_ERROR_MEMORY_ALLOC;
+        break;
+      }
+    }
+    rc = blosc2_getitem_ctx(dctx, chunk, cbytes, block_start / schunk->typesize,
+                            bsize / schunk->typesize, block, bsize);
+    if (rc >= 0) {
+      memcpy(part_dest, block + offset, part);
+      rc = block_cache_put(cache, nchunk, nblock, block, bsize, generation);
+    }
+  }
+  free(block);
+  if (needs_free) {
+    free(chunk);
+  }
+  return rc < 0 ? rc : nbytes;
+}
+
+/* Get the part of a slice in a chunk, decompressing only the blocks with items */
+static int get_slice_chunk(blosc2_context *dctx, void *batch_data, int32_t nitem) {
+  slice_data* slice = (slice_data*)batch_data;
+  blosc2_schunk* schunk = slice->schunk;
+  int nchunk = slice->first_chunk + nitem;
+  int64_t chunk_start = (int64_t)nchunk * schunk->chunksize;
+  int64_t chunk_stop = chunk_start + schunk->chunksize;
+  if (chunk_stop > schunk->nbytes) {
+    chunk_stop = schunk->nbytes;
+  }
+  int64_t start = slice->start > chunk_start ? slice->start : chunk_start;
+  int64_t stop = slice->stop < chunk_stop ? slice->stop : chunk_stop;
+  uint8_t* dest = slice->buffer + (start - slice->start);
+  int32_t nbytes = (int32_t)(stop - start);
+
+  if (start == chunk_start && stop == chunk_stop) {
+    return decompress_chunk(schunk, dctx, nchunk, dest, nbytes);
+  }
+  if (schunk->block_cache != NULL && dctx->block_maskout == NULL) {
+    return get_cached_items(schunk, dctx, nchunk, (int32_t)(start - chunk_start), nbytes, dest);
+  }
+  // Lazy chunks of frames only read the blocks with items
+  uint8_t* chunk;
+  bool needs_free;
+  int cbytes = borrow_lazychunk(schunk, nchunk, &chunk, &needs_free);
+  if (cbytes < 0) {
+    return cbytes;
+  }
+  int rc = blosc2_getitem_ctx(dctx, chunk, cbytes, (int)((start - chunk_start) / schunk->typesize),
+                              nbytes / schunk->typesize, dest, nbytes);
+  if (needs_free) {
+    free(chunk);
+  }
+  return rc;
+}
+
+/* Get the items from `start` to `stop` (not included) of a super-chunk. */
+int blosc2_schunk_get_slice_buffer(blosc2_schunk *schunk, int64_t start, int64_t stop, void *buffer) {
+  int rc = check_slice(schunk, start, stop);
+  if (rc < 0 || start == stop) {
+    return rc;
+  }
+  slice_data slice = {schunk, start * schunk->typesize, stop * schunk->typesize, 0, buffer};
+  slice.first_chunk = (int)(slice.start / schunk->chunksize);
+  int32_t nchunks = (int32_t)((slice.stop - 1) / schunk->chunksize) + 1 - slice.first_chunk;
+  if (nchunks > 1) {
+    rc = warm_frame_caches(schunk, slice.first_chunk);
+    if (rc < 0) {
+      return rc;
+    }
+  }
+
+  int32_t* results = malloc(nchunks * sizeof(int32_t));
+  BLOSC_ERROR_NULL(results, BLOSC2_ERROR_MEMORY_ALLOC);
+  // The chunks are spread among the threads of the decompression context
+  rc = run_batch(schunk->dctx, get_slice_chunk, &slice, nchunks, results);
+  free(results);
+
+  return rc < 0 ? rc : BLOSC2_ERROR_SUCCESS;
+}
+
+/* Set the items from `start` to `stop` (not included) of a super-chunk. */
+int blosc2_schunk_set_slice_buffer(blosc2_schunk *schunk, int64_t start, int64_t stop, void *buffer) {
+  int rc = check_slice(schunk, start, stop);
+  if (rc < 0 || start == stop) {
+    return rc;
+  }
+  int64_t byte_start = start * schunk->typesize;
+  int64_t byte_stop = stop * schunk->typesize;
+  int first_chunk = (int)(byte_start / schunk->chunksize);
+  int last_chunk = (int)((byte_stop - 1) / schunk->chunksize);
+
+  uint8_t* data = NULL;  // for the chunks that are partly overwritten
+  for (int nchunk = first_chunk; nchunk <= last_chunk && rc >= 0; nchunk++) {
+    int64_t chunk_start = (int64_t)nchunk * schunk->chunksize;
+    int32_t chunk_nbytes = schunk->chunksize;
+    if (chunk_start + chunk_nbytes > schunk->nbytes) {
+      chunk_nbytes = (int32_t)(schunk->nbytes - chunk_start);
+    }
+    int64_t nstart = byte_start > chunk_start ? byte_start : chunk_start;
+    int64_t nstop = byte_stop < chunk_start + chunk_nbytes ? byte_stop : chunk_start + chunk_nbytes;
+    const uint8_t* src = (uint8_t*)buffer + (chunk_start - byte_start);
+    if (nstart != chunk_start || nstop != chunk_start + chunk_nbytes) {
+      // Merge the new items with the old ones
+      if (data == NULL) {
+        data = malloc(schunk->chunksize);
+        BLOSC_ERROR_NULL(data, BLOSC2_ERROR_MEMORY_ALLOC);
+      }
+      rc = blosc2_schunk_decompress_chunk(schunk, nchunk, data, chunk_nbytes);
+      if (rc < 0) {
+        break;
+      }
+      memcpy(data + (nstart - chunk_start), (uint8_t*)buffer + (nstart - byte_start), nstop - nstart);
+      src = data;
+    }
+
+    uint8_t* chunk = malloc(chunk_nbytes + BLOSC_MAX_OVERHEAD);
+    if (chunk == NULL) {
+      BLOSC_TRACE_ERROR("Error allocating memory for a chunk.");
+      rc = BLOSC2_ERROR_MEMORY_ALLOC;
+      break;
+    }
+    rc = blosc2_compress_ctx(schunk->cctx, src, chunk_nbytes, chunk, chunk_nbytes + BLOSC_MAX_OVERHEAD);
+    if (rc < 0) {
+      free(chunk);
+      break;
+    }
+    // We don't need a copy of the chunk, as it will be shrinked if necessary
+    rc = blosc2_schunk_update_chunk(schunk, nchunk, chunk, false);
+  }
+  free(data);
+
+  return rc < 0 ? rc : BLOSC2_ERROR_SUCCESS;
+}
+
+typedef struct {
+  blosc2_schunk* schunk;
+  int8_t ndim;
+  int64_t shape[BLOSC2_MAX_DIM];
+  int32_t chunkshape[BLOSC2_MAX_DIM];
+  int32_t blockshape[BLOSC2_MAX_DIM];
+  const int64_t* start;
+  const int64_t* stop;
+  int64_t grid_nchunks[BLOSC2_MAX_DIM];   // chunks of the array along each dimension
+  int64_t first_chunk[BLOSC2_MAX_DIM];    // first chunk with items along each dimension
+  int64_t slice_nchunks[BLOSC2_MAX_DIM];  // chunks with items along each dimension
+  int64_t buffer_strides[BLOSC2_MAX_DIM];  // in items
+  uint8_t* buffer;
+} slice_nd_data;
+
+/* Read the shape, chunkshape and blockshape of the `caterva` metalayer */
+static int get_caterva_meta(blosc2_schunk *schunk, slice_nd_data *slice) {
+  uint8_t* smeta;
+  uint32_t smeta_len;
+  if (blosc2_meta_get(schunk, "caterva", &smeta, &smeta_len) < 0) {
+    BLOSC_TRACE_ERROR("n-d slices need a 'caterva' metalayer.");
+    return BLOSC2_ERROR_NOT_FOUND;
+  }
+  // An array with 5 entries (version, ndim, shape, chunkshape, blockshape)
+  int8_t ndim = smeta_len > 3 ? (int8_t)smeta[2] : 0;
+  if (ndim < 1 || ndim > BLOSC2_MAX_DIM ||
+      smeta_len < 3 + 3 + (uint32_t)ndim * (9 + 5 + 5) || smeta[0] != 0x95) {
+    BLOSC_TRACE_ERROR("The 'caterva' metalayer is not valid.");
+    free(smeta);
+    return BLOSC2_ERROR_DATA;
+  }
+  slice->ndim = ndim;
+  uint8_t* pmeta = smeta + 4;
+  for (int i = 0; i < ndim; i++) {
+    from_big(&slice->shape[i], pmeta + 1, sizeof(int64_t));
+    pmeta += 1 + sizeof(int64_t);
+  }
+  pmeta += 1;
+  for (int i = 0; i < ndim; i++) {
+    from_big(&slice->chunkshape[i], pmeta + 1, sizeof(int32_t));
+    pmeta += 1 + sizeof(int32_t);
+  }
+  pmeta += 1;
+  for (int i = 0; i < ndim; i++) {
+    from_big(&slice->blockshape[i], pmeta + 1, sizeof(int32_t));
+    pmeta += 1 + sizeof(int32_t);
+  }
+  free(smeta);
+
+  // Chunks and blocks are padded up to a whole number of blocks
+  int64_t chunk_nbytes = schunk->typesize;
+  for (int i = 0; i < ndim; i++) {
+    if (slice->shape[i] < 0 || slice->chunkshape[i] <= 0 || slice->blockshape[i] <= 0) {
+      BLOSC_TRACE_ERROR("The 'caterva' metalayer is not valid.");
+      return BLOSC2_ERROR_DATA;
+    }
+    int32_t nblocks = (slice->chunkshape[i] - 1) / slice->blockshape[i] + 1;
+    chunk_nbytes *= (int64_t)nblocks * slice->blockshape[i];
+    slice->grid_nchunks[i] = (slice->shape[i] + slice->chunkshape[i] - 1) / slice->chunkshape[i];
+  }
+  if (chunk_nbytes != schunk->chunksize) {
+    BLOSC_TRACE_ERROR("The chunks of the super-chunk do not match the 'caterva' metalayer.");
+    return BLOSC2_ERROR_DATA;
+  }
+  return 0;
+}
+
+/* Compute the C-order indices of the `index`-th element of `shape` */
+static void unravel_index(int64_t index, int8_t ndim, const int64_t *shape, int64_t *indices) {
+  for (int i = ndim - 1; i >= 0; i--) {
+    indices[i] = index % shape[i];
+    index /= shape[i];
+  }
+}
+
+/* Get the part of an n-d slice in a chunk, decompressing only the blocks with items */
+static int get_slice_nd_chunk(blosc2_context *dctx, void *batch_data, int32_t nitem) {
+  slice_nd_data* slice = (slice_nd_data*)batch_data;
+  int8_t ndim = slice->ndim;
+  int32_t typesize = slice->schunk->typesize;
+
+  // The part of the slice in the chunk, and the blocks with items, in chunk coordinates
+  int64_t chunk_index[BLOSC2_MAX_DIM];
+  int64_t origin[BLOSC2_MAX_DIM];
+  int64_t lstart[BLOSC2_MAX_DIM];
+  int64_t lstop[BLOSC2_MAX_DIM];
+  int64_t grid_nblocks[BLOSC2_MAX_DIM];
+  int64_t first_block[BLOSC2_MAX_DIM];
+  int64_t slice_nblocks[BLOSC2_MAX_DIM];
+  int64_t block_strides[BLOSC2_MAX_DIM];
+  unravel_index(nitem, ndim, slice->slice_nchunks, chunk_index);
+  int64_t nchunk = 0;
+  int32_t nblocks = 1;
+  int64_t nblocks_slice = 1;
+  for (int i = 0; i < ndim; i++) {
+    chunk_index[i] += slice->first_chunk[i];
+    nchunk = nchunk * slice->grid_nchunks[i] + chunk_index[i];
+    origin[i] = chunk_index[i] * slice->chunkshape[i];
+    lstart[i] = slice->start[i] > origin[i] ? slice->start[i] - origin[i] : 0;
+    lstop[i] = slice->stop[i] - origin[i];
+    if (lstop[i] > slice->chunkshape[i]) {
+      lstop[i] = slice->chunkshape[i];
+    }
+    grid_nblocks[i] = (slice->chunkshape[i] - 1) / slice->blockshape[i] + 1;
+    first_block[i] = lstart[i] / slice->blockshape[i];
+    slice_nblocks[i] = (lstop[i] - 1) / slice->blockshape[i] + 1 - first_block[i];
+    nblocks *= (int32_t)grid_nblocks[i];
+    nblocks_slice *= slice_nblocks[i];
+  }
+  int32_t block_nitems = 1;
+  for (int i = ndim - 1; i >= 0; i--) {
+    block_strides[i] = block_nitems;
+    block_nitems *= slice->blockshape[i];
+  }
+
+  bool* maskout = malloc(nblocks);
+  uint8_t* data = malloc(slice->schunk->chunksize);
+  int64_t* nblock = malloc(nblocks_slice * sizeof(int64_t));
+  if (maskout == NULL || data == NULL || nblock == NULL) {
+    BLOSC_TRACE_ERROR("Error allocating memory for a chunk.");
+    free(maskout);
+    free(data);
+    free(nblock);
+    return BLOSC2_ERROR_MEMORY_ALLOC;
+  }
+  memset(maskout, true, nblocks);
+  for (int64_t k = 0; k < nblocks_slice; k++) {
+    int64_t block_index[BLOSC2_MAX_DIM];
+    unravel_index(k, ndim, slice_nblocks, block_index);
+    nblock[k] = 0;
+    for (int i = 0; i < ndim; i++) {
+      nblock[k] = nblock[k] * grid_nblocks[i] + first_block[i] + block_index[i];
+    }
+    maskout[nblock[k]] = false;
+  }
+
+  // Lazy chunks of frames only read the blocks that are not masked out
+  uint8_t* chunk;
+  bool needs_free = false;
+  int32_t chunk_nbytes = 0;
+  int32_t chunk_cbytes = 0;
+  int rc = borrow_lazychunk(slice->schunk, (int)nchunk, &chunk, &needs_free);
+  if (rc == 0) {
+    BLOSC_TRACE_ERROR("The chunk %lld of the slice does not exist.", (long long)nchunk);
+    rc = BLOSC2_ERROR_NOT_FOUND;
+  }
+  if (rc > 0) {
+    rc = blosc2_cbuffer_sizes(chunk, &chunk_nbytes, &chunk_cbytes, NULL);
+  }
+  if (rc >= 0 && chunk_nbytes != slice->schunk->chunksize) {
+    BLOSC_TRACE_ERROR("The chunk %lld does not match the 'caterva' metalayer.", (long long)nchunk);
+    rc = BLOSC2_ERROR_DATA;
+  }
+  if (rc >= 0) {
+    rc = blosc2_set_maskout(dctx, maskout, nblocks);
+  }
+  if (rc >= 0) {
+    rc = blosc2_decompress_ctx(dctx, chunk, chunk_cbytes, data, chunk_nbytes);
+  }
+  if (needs_free) {
+    free(chunk);
+  }
+  free(maskout);
+
+  // Scatter the rows of items of every block into the buffer
+  for (int64_t k = 0; rc >= 0 && k < nblocks_slice; k++) {
+    int64_t block_index[BLOSC2_MAX_DIM];
+    int64_t lo[BLOSC2_MAX_DIM];
+    int64_t count[BLOSC2_MAX_DIM];
+    int64_t buffer_offset = 0;
+    unravel_index(k, ndim, slice_nblocks, block_index);
+    int64_t nrows = 1;
+    for (int i = 0; i < ndim; i++) {
+      int64_t block_start = (first_block[i] + block_index[i]) * slice->blockshape[i];
+      int64_t block_stop = block_start + slice->blockshape[i];
+      lo[i] = lstart[i] > block_start ? lstart[i] - block_start : 0;
+      count[i] = (lstop[i] < block_stop ? lstop[i] : block_stop) - block_start - lo[i];
+      buffer_offset += (origin[i] + block_start + lo[i] - slice->start[i]) * slice->buffer_strides[i];
+      if (i < ndim - 1) {
+        nrows *= count[i];
+      }
+    }
+    const uint8_t* block = data + nblock[k] * block_nitems * typesize;
+    int32_t row_nbytes = (int32_t)count[ndim - 1] * typesize;
+    for (int64_t row = 0; row < nrows; row++) {
+      int64_t row_index[BLOSC2_MAX_DIM];
+      unravel_index(row, ndim - 1, count, row_index);
+      int64_t src_offset = lo[ndim - 1];
+      int64_t dest_offset = buffer_offset;
+      for (int i = 0; i < ndim - 1; i++) {
+        src_offset += (lo[i] + row_index[i]) * block_strides[i];
+        dest_offset += row_index[i] * slice->buffer_strides[i];
+      }
+      memcpy(slice->buffer + dest_offset * typesize, block + src_offset * typesize, row_nbytes);
+    }
+  }
+  free(data);
+  free(nblock);
+
+  return rc;
+}
+
+/* Get an n-d slice of a super-chunk with a `caterva` metalayer. */
+int blosc2_schunk_get_slice_nd(blosc2_schunk *schunk, const int64_t *start, const int64_t *stop,
+                               void *buffer, const int64_t *buffershape, int64_t buffersize) {
+  slice_nd_data slice = {.schunk=schunk, .start=start, .stop=stop, .buffer=buffer};
+  int rc = get_caterva_meta(schunk, &slice);
+  if (rc < 0) {
+    return rc;
+  }
+
+  int64_t buffer_nitems = 1;
+  int64_t nchunks = 1;
+  for (int i = slice.ndim - 1; i >= 0; i--) {
+    if (start[i] < 0 || stop[i] > slice.shape[i] || start[i] > stop[i]) {
+      BLOSC_TRACE_ERROR("The slice [%lld, %lld) is out of the dimension %d ('%lld' items).",
+                        (long long)start[i], (long long)stop[i], i, (long long)slice.shape[i]);
+      return BLOSC2_ERROR_INVALID_PARAM;
+    }
+    if (buffershape[i] < stop[i] - start[i]) {
+      BLOSC_TRACE_ERROR("The buffer shape is too small for the slice in the dimension %d.", i);
+      return BLOSC2_ERROR_INVALID_PARAM;
+    }
+    slice.buffer_strides[i] = buffer_nitems;
+    buffer_nitems *= buffershape[i];
+    if (start[i] < stop[i]) {
+      slice.first_chunk[i] = start[i] / slice.chunkshape[i];
+      slice.slice_nchunks[i] = (stop[i] - 1) / slice.chunkshape[i] + 1 - slice.first_chunk[i];
+    }
+    nchunks *= slice.slice_nchunks[i];
+  }
+  if (buffersize < buffer_nitems * schunk->typesize) {
+    BLOSC_TRACE_ERROR("The buffer size is too small for the buffer shape.");
+    return BLOSC2_ERROR_INVALID_PARAM;
+  }
+  if (nchunks == 0) {
+    return BLOSC2_ERROR_SUCCESS;
+  }
+  if (nchunks > 1) {
+    int64_t first_nchunk = 0;
+    for (int i = 0; i < slice.ndim; i++) {
+      first_nchunk = first_nchunk * slice.grid_nchunks[i] + slice.first_chunk[i];
+    }
+    rc = warm_frame_caches(schunk, (int)first_nchunk);
+    if (rc < 0) {
+      return rc;
+    }
+  }
+
+  int32_t* results = malloc(nchunks * sizeof(int32_t));
+  BLOSC_ERROR_NULL(results, BLOSC2_ERROR_MEMORY_ALLOC);
+  // The chunks are spread among the threads of the decompression context
+  rc = run_batch(schunk->dctx, get_slice_nd_chunk, &slice, (int32_t)nchunks, results);
+  free(results);
+
+  return rc < 0 ? rc : BLOSC2_ERROR_SUCCESS;
+}
+
+
+/* Set a cache of up to `nbytes` of decompressed blocks for a super-chunk (0 disables it). */
+int blosc2_schunk_set_block_cache(blosc2_schunk *schunk, int64_t nbytes) {
+  if (nbytes < 0) {
+    BLOSC_TRACE_ERROR("The size of the block cache cannot be negative.");
+    return BLOSC2_ERROR_INVALID_PARAM;
+  }
+  if (schunk->block_cache != NULL) {
+    block_cache_free(schunk->block_cache);
+    schunk->block_cache = NULL;
+  }
+  if (nbytes > 0) {
+    schunk->block_cache = block_cache_new(nbytes);
+    BLOSC_ERROR_NULL(schunk->block_cache, BLOSC2_ERROR_MEMORY_ALLOC);
+  }
+  return BLOSC2_ERROR_SUCCESS;
+}
+
+/* Get the hits and misses of the block cache of a super-chunk. */
+int blosc2_schunk_get_block_cache_stats(blosc2_schunk *schunk, int64_t *hits, int64_t *misses) {
+  if (schunk->block_cache == NULL) {
+    BLOSC_TRACE_ERROR("The super-chunk has no block cache.");
+    return BLOSC2_ERROR_NOT_FOUND;
+  }
+  block_cache_stats(schunk->block_cache, hits, misses);
+  return BLOSC2_ERROR_SUCCESS;
+}
+
+/* A chunk iterator that reads ahead (see blosc2_schunk_iter_new) */
+struct blosc2_schunk_iter_s {
+  blosc2_schunk* schunk;
+  blosc2_context* dctx;    //!< For the chunks decompressed by the thread of the iterator
+  bool decompress;
+  int start;
+  int stop;
+  int nslots;              //!< The chunk of the caller plus the ones read ahead
+  uint8_t** slots;
+  int32_t slot_size;
+  int* results;            //!< The size of the chunk in every slot, or an error code
+  int nfetched;            //!< Chunks put in the slots by the thread
+  int nreturned;           //!< Chunks returned to the caller
+  int nreleased;           //!< Chunks whose slots can be reused
+  int error;
+  bool end;                //!< Tells the thread to finish
+  pthread_t thread;
+  pthread_mutex_t mutex;   //!< Guards the counters and `end`
+  pthread_cond_t fetched_cv;
+  pthread_cond_t released_cv;
+};
+
+/* Get a chunk of an iterator into a slot */
+static int fetch_chunk(blosc2_schunk_iter *iter, int nchunk, uint8_t *slot) {
+  if (iter->decompress) {
+    return decompress_chunk(iter->schunk, iter->dctx, nchunk, slot, iter->slot_size);
+  }
+  uint8_t* chunk;
+  bool needs_free;
+  int cbytes = blosc2_schunk_get_chunk(iter->schunk, nchunk, &chunk, &needs_free);
+  if (cbytes > iter->slot_size) {
+    BLOSC_TRACE_ERROR("The chunk %d is larger than expected.", nchunk);
+    cbytes = BLOSC2_ERROR_READ_BUFFER;
+  }
+  if (cbytes > 0) {
+    memcpy(slot, chunk, cbytes);
+  }
+  if (needs_free) {
+    free(chunk);
+  }
+  return cbytes;
+}
+
+/* Read the chunks of an iterator ahead of the caller, as long as there are free slots */
+static void* t_iter(void* arg) {
+  blosc2_schunk_iter* iter = (blosc2_schunk_iter*)arg;
+
+  for (int i = 0; i < iter->stop - iter->start; i++) {
+    pthread_mutex_lock(&iter->mutex);
+    while (!iter->end && i - iter->nreleased >= iter->nslots) {
+      pthread_cond_wait(&iter->released_cv, &iter->mutex);
+    }
+    bool end = iter->end;
+    pthread_mutex_unlock(&iter->mutex);
+    if (end) {
+      break;
+    }
+
+    int slot = i % iter->nslots;
+    int rc = fetch_chunk(iter, iter->start + i, iter->slots[slot]);
+
+    pthread_mutex_lock(&iter->mutex);
+    iter->results[slot] = rc;
+    iter->nfetched = i + 1;
+    pthread_cond_signal(&iter->fetched_cv);
+    pthread_mutex_unlock(&iter->mutex);
+    if (rc < 0) {
+      break;
+    }
+  }
+
+  return NULL;
+}
+
+/* Create an iterator over the chunks from `start` to `stop` (not included) that reads `depth` chunks ahead. */
+blosc2_schunk_iter* blosc2_schunk_iter_new(blosc2_schunk *schunk, int start, int stop, int depth,
+                                           bool decompress) {
+  if (start < 0 || stop > schunk->nchunks || start > stop) {
+    BLOSC_TRACE_ERROR("The chunks [%d, %d) are out of the super-chunk ('%d' chunks).",
+                      start, stop, schunk->nchunks);
+    return NULL;
+  }
+  if (depth < 1) {
+    BLOSC_TRACE_ERROR("The iterator needs to read at least one chunk ahead.");
+    return NULL;
+  }
+  if (schunk->chunksize <= 0 && start < stop) {
+    BLOSC_TRACE_ERROR("Iterators need super-chunks with a fixed chunksize.");
+    return NULL;
+  }
+  if (start < stop && warm_frame_caches(schunk, start) < 0) {
+    return NULL;
+  }
+
+  blosc2_schunk_iter* iter = calloc(1, sizeof(blosc2_schunk_iter));
+  BLOSC_ERROR_NULL(iter, NULL);
+  iter->schunk = schunk;
+  iter->decompress = decompress;
+  iter->start = start;
+  iter->stop = stop;
+  iter->nslots = depth + 1;
+  iter->slot_size = decompress ? schunk->chunksize : schunk->chunksize + BLOSC_MAX_OVERHEAD;
+  blosc2_dparams dparams;
+  blosc2_ctx_get_dparams(schunk->dctx, &dparams);
+  iter->dctx = blosc2_create_dctx(dparams);
+  iter->slots = calloc(iter->nslots, sizeof(uint8_t*));
+  iter->results = calloc(iter->nslots, sizeof(int));
+  bool failed = iter->dctx == NULL || iter->slots == NULL || iter->results == NULL;
+  for (int i = 0; !failed && i < iter->nslots; i++) {
+    iter->slots[i] = malloc(iter->slot_size);
+    failed = iter->slots[i] == NULL;
+  }
+  if (failed) {
+    BLOSC_TRACE_ERROR("Error allocating memory for the iterator.");
+    goto failed;
+  }
+
+  pthread_mutex_init(&iter->mutex, NULL);
+  pthread_cond_init(&iter->fetched_cv, NULL);
+  pthread_cond_init(&iter->released_cv, NULL);
+  int rc = pthread_create(&iter->thread, NULL, t_iter, (void*)iter);
+  if (rc) {
+    BLOSC_TRACE_ERROR("Return code from pthread_create() is %d.\n"
+                      "\tError detail: %s\n", rc, strerror(rc));
+    pthread_mutex_destroy(&iter->mutex);
+    pthread_cond_destroy(&iter->fetched_cv);
+    pthread_cond_destroy(&iter->released_cv);
+    goto failed;
+  }
+  return iter;
+
+  failed:
+  if (iter->slots != NULL) {
+    for (int i = 0; i < iter->nslots; i++) {
+      free(iter->slots[i]);
+    }
+    free(iter->slots);
+  }
+  free(iter->results);
+  if (iter->dctx != NULL) {
+    blosc2_free_ctx(iter->dctx);
+  }
+  free(iter);
+  return NULL;
+}
+
+/* Get the next chunk of an iterator. */
+int blosc2_schunk_iter_next(blosc2_schunk_iter *iter, uint8_t **dest) {
+  if (iter->error < 0) {
+    return iter->error;
+  }
+
+  pthread_mutex_lock(&iter->mutex);
+  // The slot of the chunk returned the last time can be reused now
+  if (iter->nreturned > iter->nreleased) {
+    iter->nreleased++;
+    pthread_cond_signal(&iter->released_cv);
+  }
+  if (iter->nreturned == iter->stop - iter->start) {
+    pthread_mutex_unlock(&iter->mutex);
+    return 0;
+  }
+  while (iter->nfetched <= iter->nreturned) {
+    pthread_cond_wait(&iter->fetched_cv, &iter->mutex);
+  }
+  int slot = iter->nreturned % iter->nslots;
+  int rc = iter->results[slot];
+  iter->nreturned++;
+  pthread_mutex_unlock(&iter->mutex);
+
+  if (rc < 0) {
+    iter->error = rc;
+    return rc;
+  }
+  *dest = iter->slots[slot];
+  return rc;
+}
+
+/* Free an iterator, stopping its reads ahead. */
+int blosc2_schunk_iter_free(blosc2_schunk_iter *iter) {
+  pthread_mutex_lock(&iter->mutex);
+  iter->end = true;
+  pthread_cond_signal(&iter->released_cv);
+  pthread_mutex_unlock(&iter->mutex);
+  int rc = pthread_join(iter->thread, NULL);
+  if (rc) {
+    BLOSC_TRACE_ERROR("Return code from pthread_join() is %d\n"
+                      "\tError detail: %s.", rc, strerror(rc));
+  }
+  pthread_mutex_destroy(&iter->mutex);
+  pthread_cond_destroy(&iter->fetched_cv);
+  pthread_cond_destroy(&iter->released_cv);
+
+  for (int i = 0; i < iter->nslots; i++) {
+    free(iter->slots[i]);
+  }
+  free(iter->slots);
+  free(iter->results);
+  blosc2_free_ctx(iter->dctx);
+  free(iter);
+  return rc ? BLOSC2_ERROR_FAILURE : BLOSC2_ERROR_SUCCESS;
+}
+
 /* Return a compressed chunk that is part of a super-chunk in the `chunk` parameter.
  * If the super-chunk is backed by a frame that is disk-based, a buffer is allocated for the
  * (compressed) chunk, and hence a free is needed.  You can check if the chunk requires a free
@@ -1115,7 +2018,9 @@ int blosc2_schunk_reorder_offsets(blosc2_schunk *schunk, int *offsets_order) {
 
   blosc2_frame_s* frame = (blosc2_frame_s*)schunk->frame;
   if (frame != NULL) {
-    return frame_reorder_offsets(frame, offsets_order, schunk);
+    int rc = frame_reorder_offsets(frame, offsets_order, schunk);
+    invalidate_block_cache(schunk, 0, true);
+    return rc;
   }
   uint8_t **offsets = schunk->data;
 
@@ -1127,11 +2032,33 @@ int blosc2_schunk_reorder_offsets(blosc2_schunk *schunk, int *offsets_order) {
     offsets[i] = offsets_copy[offsets_order[i]];
   }
   free(offsets_copy);
+  invalidate_block_cache(schunk, 0, true);
 
   return 0;
 }
 
 
+/* Write out the appends to the on-disk frame of a super-chunk that are still pending. */
+int blosc2_schunk_flush(blosc2_schunk *schunk) {
+  blosc2_frame_s* frame = (blosc2_frame_s*)schunk->frame;
+  if (frame == NULL) {
+    return 0;
+  }
+  return frame_flush(frame);
+}
+
+
+/* Reclaim the space left unused in the contiguous frame of a super-chunk. */
+int blosc2_schunk_compact(blosc2_schunk *schunk) {
+  blosc2_frame_s* frame = (blosc2_frame_s*)schunk->frame;
+  if (frame == NULL) {
+    // The chunks are kept apart in memory
+    return 0;
+  }
+  return frame_compact(frame, schunk);
+}
+
+
 // Get the length (in bytes) of the internal frame of the super-chunk
 int64_t blosc2_schunk_frame_len(blosc2_schunk* schunk) {
   int64_t len;
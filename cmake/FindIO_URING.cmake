@@ -0,0 +1,22 @@
+# Find the io_uring interface of the Linux kernel
+#
+# IO_URING_FOUND - The kernel headers declare io_uring (Linux 5.1 or newer)
+#
+# Blosc talks to the kernel directly through the io_uring_setup() and
+# io_uring_enter() system calls, so no liburing is needed.
+
+include(CheckCSourceCompiles)
+
+check_c_source_compiles("
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+int main(void) {
+  struct io_uring_params p;
+  (void) p;
+  return __NR_io_uring_setup + __NR_io_uring_enter + IORING_OP_READV + IORING_OFF_SQES;
+}" IO_URING_COMPILES)
+
+if(IO_URING_COMPILES)
+    set(IO_URING_FOUND TRUE)
+    message(STATUS "Found io_uring kernel interface")
+endif()
@@ -347,6 +347,10 @@ enum {
  * Blosc to be used simultaneously in a multi-threaded environment, in
  * which case you can use the #blosc2_compress_ctx #blosc2_decompress_ctx pair.
  *
+ * This is also when the environment variables honored by #blosc_compress and
+ * #blosc_decompress are read, so changes to them after this call are ignored
+ * until the next #blosc_destroy and #blosc_init pair.
+ *
  * @sa #blosc_destroy
  */
 BLOSC_EXPORT void blosc_init(void);
@@ -405,7 +409,8 @@ BLOSC_EXPORT void blosc_destroy(void);
  * @parblock
  *
  * This function honors different environment variables to control
- * internal parameters without the need of doing that programatically.
+ * internal parameters without the need of doing that programatically
+ * (they are read by #blosc_init).
  * Here are the ones supported:
  *
  * * **BLOSC_CLEVEL=(INTEGER)**: This will overwrite the @p clevel parameter
@@ -434,12 +439,9 @@ BLOSC_EXPORT void blosc_destroy(void);
  * starts.  *NOTE:* The *blocksize* is a critical parameter with
  * important restrictions in the allowed values, so use this with care.
  *
- * * **BLOSC_NOLOCK=(ANY VALUE)**: This will call *blosc2_compress_ctx()* under
- * the hood, with the *compressor*, *blocksize* and
- * *numinternalthreads* parameters set to the same as the last calls to
- * #blosc_set_compressor, #blosc_set_blocksize and
- * #blosc_set_nthreads. *BLOSC_CLEVEL*, *BLOSC_SHUFFLE*, *BLOSC_DELTA* and
- * *BLOSC_TYPESIZE* environment vars will also be honored.
+ * * **BLOSC_NOLOCK=(ANY VALUE)**: Not needed anymore.  Every call uses a
+ * context of its own, so calls from different threads never wait for each
+ * other.
  *
  * @endparblock
  *
@@ -476,16 +478,17 @@ BLOSC_EXPORT int blosc_compress(int clevel, int doshuffle, size_t typesize,
  * @par Environment variables
  * @parblock
  * This function honors different environment variables to control
- * internal parameters without the need of doing that programatically.
+ * internal parameters without the need of doing that programatically
+ * (they are read by #blosc_init).
  * Here are the ones supported:
  *
  * * **BLOSC_NTHREADS=(INTEGER)**: This will call
  * #blosc_set_nthreads(BLOSC_NTHREADS) before the proper decompression
  * process starts.
  *
- * * **BLOSC_NOLOCK=(ANY VALUE)**: This will call #blosc2_decompress_ctx
- * under the hood, with the *numinternalthreads* parameter set to the
- * same value as the last call to #blosc_set_nthreads.
+ * * **BLOSC_NOLOCK=(ANY VALUE)**: Not needed anymore.  Every call uses a
+ * context of its own, so calls from different threads never wait for each
+ * other.
  *
  * @endparblock
  *
@@ -545,6 +548,52 @@ typedef void (*blosc_threads_callback)(void *callback_data, void (*dojob)(void *
  */
 BLOSC_EXPORT void blosc_set_threads_callback(blosc_threads_callback callback, void *callback_data);
 
+/**
+ * @brief Get the number of threads of the pool shared by every context.
+ *
+ * @return The number of threads of the shared pool, or 0 if there is none.
+ */
+BLOSC_EXPORT int16_t blosc2_get_shared_nthreads(void);
+
+/**
+ * @brief Set the number of threads of a pool shared by every context.
+ *
+ * By default, every context with more than one thread starts threads of its own, which
+ * adds up to many (mostly idle) threads when there are many contexts around (e.g. the
+ * ones of many super-chunks).  With a shared pool, the contexts hand their blocks to the
+ * threads of the pool instead, and the thread calling the (de)compression function works
+ * on them too.  The number of threads of each context still sets in how many tasks its
+ * blocks are split.  Each thread of the pool keeps its temporaries and codec state for
+ * any context.
+ *
+ * This function is *not* thread-safe: no (de)compression should be going on while the
+ * pool is changed.  A custom threading backend (see #blosc_set_threads_callback) has
+ * precedence over the shared pool, and #blosc_destroy stops it.
+ *
+ * @param nthreads The number of threads of the pool.  If 0, the pool is stopped and
+ * every context starts threads of its own again (the default).
+ *
+ * @return The previous number of threads of the pool, or a negative value on error.
+ */
+BLOSC_EXPORT int16_t blosc2_set_shared_nthreads(int16_t nthreads);
+
+/**
+ * @brief Set the minimum of bytes for a thread to take part in a (de)compression.
+ *
+ * This applies to the contexts without a `parallel_min_nbytes` of their own (see
+ * #blosc2_cparams and #blosc2_dparams), including the global one.  Buffers get one
+ * thread for every @p nbytes at most (and never more threads than blocks), so the
+ * ones smaller than twice @p nbytes are (de)compressed serially.  The best value
+ * depends on the machine and the codec; `bench/parallel_threshold_bench` can help
+ * choosing it.
+ *
+ * @param nbytes The minimum of bytes.  If 0, @ref BLOSC2_PARALLEL_MIN_NBYTES is
+ * used; if negative, every thread gets used as long as it has a block.
+ *
+ * @return The previous minimum of bytes.
+ */
+BLOSC_EXPORT int32_t blosc2_set_parallel_min_nbytes(int32_t nbytes);
+
 
 /**
  * @brief Returns the current number of threads that are used for
@@ -784,7 +833,10 @@ BLOSC_EXPORT const char* blosc_cbuffer_complib(const void* cbuffer);
 
 enum {
   BLOSC2_IO_FILESYSTEM = 0,
-  BLOSC_IO_LAST_BLOSC_DEFINED = 1,  // sentinel
+  BLOSC2_IO_FILESYSTEM_MMAP = 1,
+  BLOSC2_IO_FILESYSTEM_URING = 2,
+  BLOSC2_IO_FILESYSTEM_DIRECT = 3,
+  BLOSC_IO_LAST_BLOSC_DEFINED = 4,  // sentinel
   BLOSC_IO_LAST_REGISTERED = 32,  // sentinel
 };
 
@@ -801,6 +853,8 @@ typedef int     (*blosc2_seek_cb)(void *stream, int64_t offset, int whence);
 typedef int64_t (*blosc2_write_cb)(const void *ptr, int64_t size, int64_t nitems, void *stream);
 typedef int64_t (*blosc2_read_cb)(void *ptr, int64_t size, int64_t nitems, void *stream);
 typedef int     (*blosc2_truncate_cb)(void *stream, int64_t size);
+typedef int64_t (*blosc2_read_at_cb)(void *stream, int64_t offset, int64_t size, void *ptr);
+typedef int64_t (*blosc2_readv_at_cb)(void *stream, const blosc2_io_segment *segments, int64_t nsegments);
 
 
 /*
@@ -823,6 +877,15 @@ typedef struct {
   //!< The IO read callback.
   blosc2_truncate_cb truncate;
   //!< The IO truncate callback.
+  blosc2_read_at_cb read_at;
+  //!< The IO positional read callback (optional).  It reads up to `size` bytes at `offset`
+  //!< without moving the position of the stream, so that several threads can read from the
+  //!< same stream at once.  It returns the number of bytes read, or a negative value on errors.
+  //!< If NULL, Blosc falls back to seek + read (serializing the readers of the stream).
+  blosc2_readv_at_cb readv_at;
+  //!< The IO vectored read callback (optional).  It reads many (offset, size) ranges at once
+  //!< and returns the total number of bytes read, or a negative value on errors.  If NULL,
+  //!< Blosc falls back to one `read_at` (or seek + read) per range.
 } blosc2_io_cb;
 
 
@@ -845,6 +908,71 @@ static const blosc2_io_cb BLOSC2_IO_CB_DEFAULTS = {
   .write = (blosc2_write_cb) blosc2_stdio_write,
   .read = (blosc2_read_cb) blosc2_stdio_read,
   .truncate = (blosc2_truncate_cb) blosc2_stdio_truncate,
+  .read_at = (blosc2_read_at_cb) blosc2_stdio_read_at,
+  .readv_at = (blosc2_readv_at_cb) blosc2_stdio_readv_at,
+};
+
+/**
+ * @brief Input/output callbacks for memory-mapped files.
+ *
+ * Chunks of contiguous frames on disk are read straight out of the mapping.
+ * The access pattern can be hinted by passing #blosc2_stdio_mmap_params in `blosc2_io.params`.
+ * On platforms without mmap support, these are the same than @ref BLOSC2_IO_CB_DEFAULTS.
+ */
+static const blosc2_io_cb BLOSC2_IO_CB_MMAP = {
+  .id = BLOSC2_IO_FILESYSTEM_MMAP,
+  .open = (blosc2_open_cb) blosc2_stdio_mmap_open,
+  .close = (blosc2_close_cb) blosc2_stdio_mmap_close,
+  .tell = (blosc2_tell_cb) blosc2_stdio_mmap_tell,
+  .seek = (blosc2_seek_cb) blosc2_stdio_mmap_seek,
+  .write = (blosc2_write_cb) blosc2_stdio_mmap_write,
+  .read = (blosc2_read_cb) blosc2_stdio_mmap_read,
+  .truncate = (blosc2_truncate_cb) blosc2_stdio_mmap_truncate,
+  .read_at = (blosc2_read_at_cb) blosc2_stdio_mmap_read_at,
+  .readv_at = (blosc2_readv_at_cb) blosc2_stdio_mmap_readv_at,
+};
+
+/**
+ * @brief Input/output callbacks for reading with io_uring (Linux only).
+ *
+ * When decompressing a lazy chunk, the reads of all its blocks are submitted at once
+ * (see @ref blosc2_stdio_uring_submit), and each block is decompressed as soon as its read
+ * completes.  Where io_uring is not available, blocks are read with positional reads.
+ */
+static const blosc2_io_cb BLOSC2_IO_CB_URING = {
+  .id = BLOSC2_IO_FILESYSTEM_URING,
+  .open = (blosc2_open_cb) blosc2_stdio_uring_open,
+  .close = (blosc2_close_cb) blosc2_stdio_uring_close,
+  .tell = (blosc2_tell_cb) blosc2_stdio_uring_tell,
+  .seek = (blosc2_seek_cb) blosc2_stdio_uring_seek,
+  .write = (blosc2_write_cb) blosc2_stdio_uring_write,
+  .read = (blosc2_read_cb) blosc2_stdio_uring_read,
+  .truncate = (blosc2_truncate_cb) blosc2_stdio_uring_truncate,
+  .read_at = (blosc2_read_at_cb) blosc2_stdio_uring_read_at,
+  .readv_at = (blosc2_readv_at_cb) blosc2_stdio_uring_readv_at,
+};
+
+/**
+ * @brief Input/output callbacks for reading without going through the page cache.
+ *
+ * Frames are read with `O_DIRECT` (`F_NOCACHE` on macOS), so that scanning large frames
+ * once does not evict the data that other processes are using.  Ranges not aligned as
+ * direct reads require (e.g. chunks, whose offsets are arbitrary) are read into aligned,
+ * pooled buffers first; see #blosc2_stdio_direct_params.  Writes still go through the
+ * page cache.  If the filesystem does not support direct reads, regular reads are done
+ * and their pages are dropped from the cache afterwards (where posix_fadvise() is available).
+ */
+static const blosc2_io_cb BLOSC2_IO_CB_DIRECT = {
+  .id = BLOSC2_IO_FILESYSTEM_DIRECT,
+  .open = (blosc2_open_cb) blosc2_stdio_direct_open,
+  .close = (blosc2_close_cb) blosc2_stdio_direct_close,
+  .tell = (blosc2_tell_cb) blosc2_stdio_direct_tell,
+  .seek = (blosc2_seek_cb) blosc2_stdio_direct_seek,
+  .write = (blosc2_write_cb) blosc2_stdio_direct_write,
+  .read = (blosc2_read_cb) blosc2_stdio_direct_read,
+  .truncate = (blosc2_truncate_cb) blosc2_stdio_direct_truncate,
+  .read_at = (blosc2_read_at_cb) blosc2_stdio_direct_read_at,
+  .readv_at = (blosc2_readv_at_cb) blosc2_stdio_direct_readv_at,
 };
 
 static const blosc2_io BLOSC2_IO_DEFAULTS = {
@@ -934,6 +1062,18 @@ typedef int (*blosc2_prefilter_fn)(blosc2_prefilter_params* params);
  */
 typedef int (*blosc2_postfilter_fn)(blosc2_postfilter_params* params);
 
+/**
+ * @brief The default minimum of bytes for a thread to take part in a (de)compression.
+ *
+ * Handing blocks off to threads and waiting for them has a cost that small buffers
+ * do not make up for, so buffers get a thread for each #BLOSC2_PARALLEL_MIN_NBYTES
+ * bytes at most, and the ones smaller than twice it are (de)compressed serially.
+ * See the `parallel_min_nbytes` field of #blosc2_cparams and #blosc2_dparams.
+ */
+enum {
+  BLOSC2_PARALLEL_MIN_NBYTES = 64 * 1024,
+};
+
 /**
  * @brief The parameters for creating a context for compression purposes.
  *
@@ -969,6 +1109,10 @@ typedef struct {
   //!< The prefilter parameters.
   blosc2_btune *udbtune;
   //!< The user-defined BTune parameters.
+  int32_t parallel_min_nbytes;
+  //!< The minimum of bytes for each thread to work on.  If 0, the value set with
+  //!< #blosc2_set_parallel_min_nbytes (@ref BLOSC2_PARALLEL_MIN_NBYTES by default) is used;
+  //!< if negative, every thread gets used as long as it has a block.
 } blosc2_cparams;
 
 /**
@@ -977,7 +1121,7 @@ typedef struct {
 static const blosc2_cparams BLOSC2_CPARAMS_DEFAULTS = {
         BLOSC_BLOSCLZ, 0, 5, 0, 8, 1, 0, BLOSC_FORWARD_COMPAT_SPLIT,
         NULL, {0, 0, 0, 0, 0, BLOSC_SHUFFLE}, {0, 0, 0, 0, 0, 0},
-        NULL, NULL, NULL};
+        NULL, NULL, NULL, 0};
 
 
 /**
@@ -995,12 +1139,16 @@ typedef struct {
   //!< The postfilter function.
   blosc2_postfilter_params *postparams;
   //!< The postfilter parameters.
+  int32_t parallel_min_nbytes;
+  //!< The minimum of bytes for each thread to work on.  If 0, the value set with
+  //!< #blosc2_set_parallel_min_nbytes (@ref BLOSC2_PARALLEL_MIN_NBYTES by default) is used;
+  //!< if negative, every thread gets used as long as it has a block.
 } blosc2_dparams;
 
 /**
  * @brief Default struct for decompression params meant for user initialization.
  */
-static const blosc2_dparams BLOSC2_DPARAMS_DEFAULTS = {1, NULL, NULL, NULL};
+static const blosc2_dparams BLOSC2_DPARAMS_DEFAULTS = {1, NULL, NULL, NULL, 0};
 
 /**
  * @brief Create a context for @a *_ctx() compression functions.
@@ -1113,7 +1261,8 @@ BLOSC_EXPORT int blosc2_set_maskout(blosc2_context *ctx, bool *maskout, int nblo
  * _____________________
  *
  * *blosc_compress()* honors different environment variables to control
- * internal parameters without the need of doing that programatically.
+ * internal parameters without the need of doing that programatically
+ * (they are read by *blosc_init()*).
  * Here are the ones supported:
  *
  * **BLOSC_CLEVEL=(INTEGER)**: This will overwrite the @p clevel parameter
@@ -1142,12 +1291,9 @@ BLOSC_EXPORT int blosc2_set_maskout(blosc2_context *ctx, bool *maskout, int nblo
  * starts.  *NOTE:* The blocksize is a critical parameter with
  * important restrictions in the allowed values, so use this with care.
  *
- * **BLOSC_NOLOCK=(ANY VALUE)**: This will call *blosc2_compress_ctx()* under
- * the hood, with the *compressor*, *blocksize* and
- * *numinternalthreads* parameters set to the same as the last calls to
- * *blosc_set_compressor*, *blosc_set_blocksize* and
- * *blosc_set_nthreads*. *BLOSC_CLEVEL*, *BLOSC_SHUFFLE*, *BLOSC_DELTA* and
- * *BLOSC_TYPESIZE* environment vars will also be honored.
+ * **BLOSC_NOLOCK=(ANY VALUE)**: Not needed anymore.  Every call uses a
+ * context of its own, so calls from different threads never wait for each
+ * other.
  *
  */
 BLOSC_EXPORT int blosc2_compress(int clevel, int doshuffle, int32_t typesize,
@@ -1184,16 +1330,17 @@ BLOSC_EXPORT int blosc2_compress(int clevel, int doshuffle, int32_t typesize,
  * _____________________
  *
  * *blosc_decompress* honors different environment variables to control
- * internal parameters without the need of doing that programatically.
+ * internal parameters without the need of doing that programatically
+ * (they are read by *blosc_init()*).
  * Here are the ones supported:
  *
  * **BLOSC_NTHREADS=(INTEGER)**: This will call
  * *blosc_set_nthreads(BLOSC_NTHREADS)* before the proper decompression
  * process starts.
  *
- * **BLOSC_NOLOCK=(ANY VALUE)**: This will call *blosc2_decompress_ctx*
- * under the hood, with the *numinternalthreads* parameter set to the
- * same value as the last call to *blosc_set_nthreads*.
+ * **BLOSC_NOLOCK=(ANY VALUE)**: Not needed anymore.  Every call uses a
+ * context of its own, so calls from different threads never wait for each
+ * other.
  *
  */
 BLOSC_EXPORT int blosc2_decompress(const void* src, int32_t srcsize,
@@ -1259,6 +1406,177 @@ BLOSC_EXPORT int blosc2_compress_ctx(
 BLOSC_EXPORT int blosc2_decompress_ctx(blosc2_context* context, const void* src,
                                        int32_t srcsize, void* dest, int32_t destsize);
 
+/**
+ * @brief A buffer of a batch (see #blosc2_compress_batch and
+ * #blosc2_decompress_batch).
+ */
+typedef struct {
+  const void* src;
+  //!< The buffer to be (de)compressed.
+  int32_t srcsize;
+  //!< The size (in bytes) of the @p src buffer.
+  void* dest;
+  //!< The buffer where the (de)compressed data will be put.
+  int32_t destsize;
+  //!< The size (in bytes) of the @p dest buffer.
+} blosc2_batch_item;
+
+/**
+ * @brief Compress a batch of independent buffers with a context.
+ *
+ * Every buffer is compressed by a single thread of the context, so that
+ * many small buffers (with just a few blocks each) are compressed in
+ * parallel.  The threads keep their temporaries and codec state from one
+ * buffer (and batch) to the next.
+ *
+ * @param context A blosc2_context meant for compression.
+ * @param items The buffers to be compressed.
+ * @param nitems The number of buffers in @p items.
+ * @param results The sizes of the compressed buffers (as returned by
+ * #blosc2_compress_ctx), or the negative error codes of the failed ones.
+ * It must have room for @p nitems values.
+ *
+ * @return 0 if every buffer has been compressed (some may not fit in their
+ * @p dest buffer, with a 0 in @p results), or else the error code of the
+ * first buffer that failed.
+ */
+BLOSC_EXPORT int blosc2_compress_batch(blosc2_context* context, const blosc2_batch_item* items,
+                                       int32_t nitems, int32_t* results);
+
+/**
+ * @brief Decompress a batch of independent buffers with a context.
+ *
+ * Every buffer is decompressed by a single thread of the context (see
+ * #blosc2_compress_batch).
+ *
+ * @param context A blosc2_context meant for decompression.
+ * @param items The buffers to be decompressed.
+ * @param nitems The number of buffers in @p items.
+ * @param results The sizes of the decompressed buffers (as returned by
+ * #blosc2_decompress_ctx), or the negative error codes of the failed ones.
+ * It must have room for @p nitems values.
+ *
+ * @return 0 if every buffer has been decompressed, or else the error code of
+ * the first buffer that failed.
+ */
+BLOSC_EXPORT int blosc2_decompress_batch(blosc2_context* context, const blosc2_batch_item* items,
+                                         int32_t nitems, int32_t* results);
+
+typedef struct blosc2_async_s blosc2_async;   /* opaque type */
+
+/**
+ * @brief The function called when an asynchronous (de)compression is done.
+ *
+ * @param user_data The pointer passed to #blosc2_compress_ctx_async or
+ * #blosc2_decompress_ctx_async.
+ * @param result What the synchronous function would have returned.
+ */
+typedef void (*blosc2_async_cb)(void* user_data, int result);
+
+/**
+ * @brief Compress a buffer with a context without waiting for it.
+ *
+ * The compression is queued on the context and done in order with the other
+ * asynchronous ones, as by #blosc2_compress_ctx.  A thread of the context
+ * (started on the first call) drives them, and the blocks are (de)compressed
+ * by the threads of the context as usual, or by the ones of the shared pool.
+ *
+ * If a threads callback is set (see #blosc_set_threads_callback) when the
+ * first one is queued, Blosc starts no thread for the context: the queued
+ * (de)compressions are done by #blosc2_async_run or #blosc2_async_wait, from
+ * the thread calling them (e.g. a task of your own threading backend), with
+ * the blocks dispatched through the callback as usual.
+ *
+ * @remark The @p src and @p dest buffers must be left alone, and the context
+ * must not be used for anything else, until the compression is done.
+ *
+ * @param context A blosc2_context meant for compression.
+ * @param src The buffer containing the data to be compressed.
+ * @param srcsize The number of bytes to be compressed from the @p src buffer.
+ * @param dest The buffer where the compressed data will be put.
+ * @param destsize The size in bytes of the @p dest buffer.
+ * @param callback A function to call (from the thread of the context) when
+ * the compression is done, or NULL.  It must not wait for the compression.
+ * It is called from the thread of the context, or from the one running the
+ * queue with a threads callback.
+ * @param user_data The pointer passed to @p callback.
+ *
+ * @return A handle to poll (see #blosc2_async_poll) and wait for (see
+ * #blosc2_async_wait) the compression, or NULL if it could not be queued.
+ * Every handle must be passed to #blosc2_async_wait (before freeing the
+ * context), which releases it.
+ */
+BLOSC_EXPORT blosc2_async* blosc2_compress_ctx_async(
+        blosc2_context* context, const void* src, int32_t srcsize, void* dest,
+        int32_t destsize, blosc2_async_cb callback, void* user_data);
+
+/**
+ * @brief Decompress a buffer with a context without waiting for it.
+ *
+ * The decompression is queued on the context, as with
+ * #blosc2_compress_ctx_async, and done as by #blosc2_decompress_ctx.
+ *
+ * @param context A blosc2_context meant for decompression.
+ * @param src The buffer of compressed data.
+ * @param srcsize The length of buffer of compressed data.
+ * @param dest The buffer where the decompressed data will be put.
+ * @param destsize The size in bytes of the @p dest buffer.
+ * @param callback A function to call (from the thread of the context) when
+ * the decompression is done, or NULL.  It must not wait for the decompression.
+ * It is called as for #blosc2_compress_ctx_async.
+ * @param user_data The pointer passed to @p callback.
+ *
+ * @return A handle to poll (see #blosc2_async_poll) and wait for (see
+ * #blosc2_async_wait) the decompression, or NULL if it could not be queued.
+ * Every handle must be passed to #blosc2_async_wait (before freeing the
+ * context), which releases it.
+ */
+BLOSC_EXPORT blosc2_async* blosc2_decompress_ctx_async(
+        blosc2_context* context, const void* src, int32_t srcsize, void* dest,
+        int32_t destsize, blosc2_async_cb callback, void* user_data);
+
+/**
+ * @brief Check whether an asynchronous (de)compression is done.
+ *
+ * This does not do the (de)compression, so with a threads callback it is only
+ * done after a call to #blosc2_async_run or #blosc2_async_wait.
+ *
+ * @param handle The handle of the (de)compression.
+ * @param result Where to put what the synchronous function would have
+ * returned (when done).  It can be NULL.
+ *
+ * @return 1 if the (de)compression is done (and its callback has returned),
+ * or 0 otherwise.
+ */
+BLOSC_EXPORT int blosc2_async_poll(blosc2_async* handle, int* result);
+
+/**
+ * @brief Wait for an asynchronous (de)compression and release its handle.
+ *
+ * With a threads callback, the queued (de)compressions of the context up to
+ * this one are done by the calling thread, if no other one is doing them.
+ *
+ * @param handle The handle of the (de)compression.
+ *
+ * @return What the synchronous function would have returned.
+ */
+BLOSC_EXPORT int blosc2_async_wait(blosc2_async* handle);
+
+/**
+ * @brief Do the queued asynchronous (de)compressions of a context.
+ *
+ * With a threads callback (see #blosc2_compress_ctx_async), the queued
+ * (de)compressions are done in order by the calling thread (or by the one
+ * doing them already), until the queue is empty.  Otherwise, this just waits
+ * for the thread of the context to empty the queue.  The handles must still
+ * be passed to #blosc2_async_wait.
+ *
+ * @param context The context of the (de)compressions.
+ *
+ * @return 0 if succeeds.
+ */
+BLOSC_EXPORT int blosc2_async_run(blosc2_context* context);
+
 /**
  * @brief Create a chunk made of zeros.
  *
@@ -1331,7 +1649,9 @@ BLOSC_EXPORT int blosc2_chunk_uninit(blosc2_cparams cparams, size_t nbytes,
  * @brief Context interface counterpart for #blosc_getitem.
  *
  * It uses many of the same parameters as blosc_getitem() function with
- * a few additions.
+ * a few additions.  Only the blocks with items are decompressed, and they
+ * are spread among the threads of @p context when the items are large
+ * enough (see #blosc2_set_parallel_min_nbytes).
  *
  * @param context Context pointer.
  * @param srcsize Compressed buffer length.
@@ -1358,6 +1678,31 @@ BLOSC_EXPORT int blosc2_getitem_ctx(blosc2_context* context, const void* src,
 #define BLOSC2_MAX_VLMETALAYERS (8 * 1024)
 #define BLOSC2_VLMETALAYERS_NAME_MAXLEN BLOSC2_METALAYER_NAME_MAXLEN
 
+// Maximum number of dimensions of the arrays described by a `caterva` metalayer
+#define BLOSC2_MAX_DIM 8
+
+/**
+ * @brief How the chunk offsets of a frame are kept in memory.
+ */
+enum {
+  BLOSC2_OFFSETS_AUTO = 0,
+  //!< Keep them decompressed once they have been looked up often enough (the default).
+  BLOSC2_OFFSETS_RESIDENT = 1,
+  //!< Keep them decompressed since the first lookup.
+  BLOSC2_OFFSETS_COMPRESSED = 2,
+  //!< Never keep them decompressed; every lookup decompresses the block holding the offset.
+};
+
+/**
+ * @brief The default maximum size of a read covering several blocks of a lazy chunk.
+ *
+ * Blocks of a chunk are stored one after the other, so reading them in large pieces saves
+ * requests (which is what matters on network filesystems).
+ */
+enum {
+  BLOSC2_LAZY_MAX_READ = 1024 * 1024,
+};
+
 /**
  * @brief This struct is meant for holding storage parameters for a
  * for a blosc2 container, allowing to specify, for example, how to interpret
@@ -1376,14 +1721,32 @@ typedef struct {
     //!< If NULL, sensible defaults are used depending on the context.
     blosc2_io *io;
     //!< Input/output backend.
+    int offsets_mode;
+    //!< How the chunk offsets are kept in memory. See @ref BLOSC2_OFFSETS_AUTO and friends.
+    int32_t lazy_max_gap;
+    //!< The maximum number of unneeded bytes between two blocks of a lazy chunk that are still
+    //!< read at once (e.g. blocks masked out in-between).  If 0, only adjacent blocks are.
+    int32_t lazy_max_read;
+    //!< The maximum size of a read covering several blocks of a lazy chunk.  If 0,
+    //!< @ref BLOSC2_LAZY_MAX_READ is used; if negative, blocks are read one by one.
+    int32_t write_buffer_size;
+    //!< The number of bytes that can be appended to an on-disk frame before being written out.
+    //!< Until then, the chunks (for contiguous frames) and the offsets, header and trailer are
+    //!< kept in memory (see #blosc2_schunk_flush).  If 0, every append is written right away.
+    int64_t cframe_reserve;
+    //!< The expected length (in bytes) of an in-memory contiguous frame, so that room for it
+    //!< is made at once.  If 0, the room grows geometrically as chunks are added.
 } blosc2_storage;
 
 /**
  * @brief Default struct for #blosc2_storage meant for user initialization.
  */
-static const blosc2_storage BLOSC2_STORAGE_DEFAULTS = {false, NULL, NULL, NULL, NULL};
+static const blosc2_storage BLOSC2_STORAGE_DEFAULTS = {false, NULL, NULL, NULL, NULL, BLOSC2_OFFSETS_AUTO,
+                                                       0, BLOSC2_LAZY_MAX_READ, 0, 0};
 
 typedef struct blosc2_frame_s blosc2_frame;   /* opaque type */
+typedef struct blosc2_block_cache_s blosc2_block_cache;   /* opaque type */
+typedef struct blosc2_schunk_iter_s blosc2_schunk_iter;   /* opaque type */
 
 /**
  * @brief This struct is meant to store metadata information inside
@@ -1450,6 +1813,8 @@ typedef struct blosc2_schunk {
   int16_t nvlmetalayers;
   //!< The number of variable-length metalayers.
   blosc2_btune *udbtune;
+  blosc2_block_cache* block_cache;
+  //!< The cache of decompressed blocks (NULL if disabled).
 } blosc2_schunk;
 
 
@@ -1553,9 +1918,10 @@ BLOSC_EXPORT int64_t blosc2_schunk_to_file(blosc2_schunk* schunk, const char* ur
  *
  * @remark All the memory resources attached to the super-frame are freed.
  * If the super-chunk is on-disk, the data continues there for a later
- * re-opening.
+ * re-opening (pending appends are written out first, see #blosc2_schunk_flush).
  *
- * @return 0 if success.
+ * @return 0 if success.  Else a negative code is returned (the resources are
+ * freed anyway).
  */
 BLOSC_EXPORT int blosc2_schunk_free(blosc2_schunk *schunk);
 
@@ -1642,6 +2008,169 @@ BLOSC_EXPORT int blosc2_schunk_append_buffer(blosc2_schunk *schunk, void *src, i
  */
 BLOSC_EXPORT int blosc2_schunk_decompress_chunk(blosc2_schunk *schunk, int nchunk, void *dest, int32_t nbytes);
 
+/**
+ * @brief Decompress the chunks from @p start to @p stop (not included) of a
+ * super-chunk, one after another in @p dest.
+ *
+ * The chunks are decompressed at once by the threads of the decompression
+ * context of the super-chunk, each of them with whole chunks of its own, so
+ * that reading chunks out of a frame overlaps with the decompression of the
+ * others.  Special chunks (zeros, NaNs, uninitialized...) are just filled in,
+ * without going through the codecs.
+ *
+ * @param schunk The super-chunk from where the chunks will be decompressed.
+ * @param start The first chunk to be decompressed (0 indexed).
+ * @param stop The chunk after the last one to be decompressed.
+ * @param dest The buffer where the decompressed data will be put.  Chunk
+ * @p start + i goes at offset i * @p schunk->chunksize.
+ * @param nbytes The size of the area pointed by @p *dest.
+ *
+ * @note Every chunk but the last one of the range must be full (only the last
+ * chunk of a super-chunk may be smaller).
+ *
+ * @return The size of the decompressed data. If some problem is detected, a
+ * negative code is returned instead.
+ */
+BLOSC_EXPORT int64_t blosc2_schunk_decompress_range(blosc2_schunk *schunk, int start, int stop,
+                                                    void *dest, int64_t nbytes);
+
+/**
+ * @brief Get the items from @p start to @p stop (not included) of a super-chunk.
+ *
+ * Only the chunks with items are read, and only their blocks with items are
+ * decompressed (lazy chunks of frames just read those blocks).  The chunks
+ * are spread among the threads of the decompression context of the
+ * super-chunk.
+ *
+ * @param schunk The super-chunk from where the items will be read.
+ * @param start The first item (0 indexed).
+ * @param stop The item after the last one.
+ * @param buffer The buffer where the items will be put; it must have room
+ * for (@p stop - @p start) * @p schunk->typesize bytes.
+ *
+ * @return An error code.
+ */
+BLOSC_EXPORT int blosc2_schunk_get_slice_buffer(blosc2_schunk *schunk, int64_t start, int64_t stop,
+                                                void *buffer);
+
+/**
+ * @brief Set the items from @p start to @p stop (not included) of a super-chunk.
+ *
+ * Only the chunks with items are compressed again and updated; the ones that
+ * are partly overwritten are decompressed first.
+ *
+ * @param schunk The super-chunk where the items will be written.
+ * @param start The first item (0 indexed).
+ * @param stop The item after the last one.
+ * @param buffer The new items, (@p stop - @p start) * @p schunk->typesize bytes.
+ *
+ * @return An error code.
+ */
+BLOSC_EXPORT int blosc2_schunk_set_slice_buffer(blosc2_schunk *schunk, int64_t start, int64_t stop,
+                                                void *buffer);
+
+/**
+ * @brief Get an n-d slice out of a super-chunk with a `caterva` metalayer.
+ *
+ * The metalayer (shape, chunkshape and blockshape of an array) describes the
+ * grid of chunks of the array and the grid of blocks inside every chunk.
+ * Only the chunks that intersect the slice are read, and only their blocks
+ * that intersect it are decompressed (lazy chunks of frames just read those
+ * blocks).  The chunks are spread among the threads of the decompression
+ * context of the super-chunk.
+ *
+ * @param schunk The super-chunk from where the items will be read.
+ * @param start The first item of the slice in every dimension (0 indexed).
+ * @param stop The item after the last one of the slice in every dimension.
+ * @param buffer The buffer where the slice will be put, in C order.
+ * @param buffershape The shape of @p buffer; the slice is put at its origin,
+ * so it must be at least (@p stop - @p start) in every dimension.
+ * @param buffersize The size (in bytes) of @p buffer.
+ *
+ * @return An error code.
+ */
+BLOSC_EXPORT int blosc2_schunk_get_slice_nd(blosc2_schunk *schunk, const int64_t *start,
+                                            const int64_t *stop, void *buffer,
+                                            const int64_t *buffershape, int64_t buffersize);
+
+/**
+ * @brief Set a cache of decompressed blocks for a super-chunk.
+ *
+ * The blocks read by blosc2_schunk_decompress_chunk(), blosc2_schunk_decompress_range()
+ * and blosc2_schunk_get_slice_buffer() are kept in the cache, keyed by their
+ * chunk and block numbers, so that later reads of the same blocks are just
+ * copies out of memory.  When the cache is full, the least recently used
+ * blocks are dropped.  The blocks of the chunks that are updated, inserted
+ * or deleted are dropped too.  The cache can be used by several threads at
+ * once.
+ *
+ * @param schunk The super-chunk.
+ * @param nbytes The maximum size (in bytes) of the blocks in the cache.  A
+ * previous cache is discarded, and 0 disables the cache.
+ *
+ * @return An error code.
+ */
+BLOSC_EXPORT int blosc2_schunk_set_block_cache(blosc2_schunk *schunk, int64_t nbytes);
+
+/**
+ * @brief Get the number of block lookups that hit and missed the cache of
+ * decompressed blocks of a super-chunk.
+ *
+ * @param schunk The super-chunk.
+ * @param hits The number of blocks that were read out of the cache.
+ * @param misses The number of blocks that had to be decompressed.
+ *
+ * @return An error code.  It fails if the super-chunk has no cache.
+ */
+BLOSC_EXPORT int blosc2_schunk_get_block_cache_stats(blosc2_schunk *schunk, int64_t *hits,
+                                                     int64_t *misses);
+
+/**
+ * @brief Create an iterator over the chunks from @p start to @p stop (not
+ * included) of a super-chunk that reads ahead.
+ *
+ * A thread of the iterator fetches the next @p depth chunks (and decompresses
+ * them, if asked to) into a ring of buffers while the caller is working with
+ * the current one.  So the reads of a frame on disk overlap with the work of
+ * the caller, and with the decompression of the other chunks.  The chunks are
+ * decompressed with a context of their own, with the threads of the
+ * decompression context of the super-chunk.  The super-chunk must not be
+ * changed while the iterator exists.
+ *
+ * @param schunk The super-chunk.
+ * @param start The first chunk (0 indexed).
+ * @param stop The chunk after the last one.
+ * @param depth The number of chunks read ahead (at least 1).
+ * @param decompress Whether the chunks are given decompressed or compressed.
+ *
+ * @return The new iterator, or NULL if it could not be created.  Free it with
+ * #blosc2_schunk_iter_free.
+ */
+BLOSC_EXPORT blosc2_schunk_iter* blosc2_schunk_iter_new(blosc2_schunk *schunk, int start, int stop,
+                                                        int depth, bool decompress);
+
+/**
+ * @brief Get the next chunk of an iterator.
+ *
+ * @param iter The iterator.
+ * @param dest The pointer to the chunk (decompressed or not, see
+ * #blosc2_schunk_iter_new).  The chunk belongs to the iterator, and it stays
+ * there until the next call to this function or to #blosc2_schunk_iter_free.
+ *
+ * @return The size (in bytes) of the chunk, 0 when there are no more chunks,
+ * or a negative error code.  After an error, no more chunks are returned.
+ */
+BLOSC_EXPORT int blosc2_schunk_iter_next(blosc2_schunk_iter *iter, uint8_t **dest);
+
+/**
+ * @brief Free an iterator, stopping its reads ahead.
+ *
+ * @param iter The iterator.
+ *
+ * @return An error code.
+ */
+BLOSC_EXPORT int blosc2_schunk_iter_free(blosc2_schunk_iter *iter);
+
 /**
  * @brief Return a compressed chunk that is part of a super-chunk in the @p chunk parameter.
  *
@@ -1724,6 +2253,44 @@ BLOSC_EXPORT int blosc2_schunk_get_dparams(blosc2_schunk *schunk, blosc2_dparams
  */
 BLOSC_EXPORT int blosc2_schunk_reorder_offsets(blosc2_schunk *schunk, int *offsets_order);
 
+/**
+ * @brief Reclaim the space left unused in the contiguous frame of a super-chunk.
+ *
+ * Updates and deletions of chunks leave holes behind in contiguous frames (the
+ * holes are reused by later updates where the new chunks fit).  This rewrites
+ * the chunks one after the other in their logical order (so the physical order
+ * follows a previous #blosc2_schunk_reorder_offsets too) and shrinks the frame.
+ *
+ * @param schunk The super-chunk to be compacted.
+ *
+ * Frames on disk are compacted into a new file (`<urlpath>.compact`, so there
+ * must be room for a copy of the frame) that replaces the frame once complete
+ * and synced to disk, so an interrupted compaction (even by a power loss)
+ * leaves the frame as it was.  The new file gets the permissions of the frame
+ * (and its owner, when the process is allowed to), but other hard links to the
+ * frame keep the old contents.  Super-chunks without a contiguous frame are
+ * left untouched.
+ *
+ * @warning With user-defined I/O backends (see #blosc2_register_io_cb) the
+ * chunks are moved in place instead, so the frame is not usable if this is
+ * interrupted.
+ *
+ * @return 0 if succeeds. Else a negative code is returned.
+ */
+BLOSC_EXPORT int blosc2_schunk_compact(blosc2_schunk *schunk);
+
+/**
+ * @brief Write out the appends to the on-disk frame of a super-chunk that are still pending.
+ *
+ * See #blosc2_storage.write_buffer_size.  This is done when the super-chunk is freed, and
+ * before any other change of the frame (updates, insertions, metalayers...) too.
+ *
+ * @param schunk The super-chunk to be flushed.
+ *
+ * @return 0 if succeeds. Else a negative code is returned.
+ */
+BLOSC_EXPORT int blosc2_schunk_flush(blosc2_schunk *schunk);
+
 /**
  * @brief Get the length (in bytes) of the internal frame of the super-chunk.
  *
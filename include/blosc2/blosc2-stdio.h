@@ -41,6 +41,18 @@ typedef struct {
   FILE *file;
 } blosc2_stdio_file;
 
+/**
+ * @brief A range of a file to be read with a vectored read (see #blosc2_readv_at_cb).
+ */
+typedef struct {
+  int64_t offset;
+  //!< The offset of the range in the file.
+  int64_t size;
+  //!< The number of bytes to read.
+  void *ptr;
+  //!< Where to put the bytes read.
+} blosc2_io_segment;
+
 BLOSC_EXPORT void *blosc2_stdio_open(const char *urlpath, const char *mode, void* params);
 BLOSC_EXPORT int blosc2_stdio_close(void *stream);
 BLOSC_EXPORT int64_t blosc2_stdio_tell(void *stream);
@@ -48,5 +60,154 @@ BLOSC_EXPORT int blosc2_stdio_seek(void *stream, int64_t offset, int whence);
 BLOSC_EXPORT int64_t blosc2_stdio_write(const void *ptr, int64_t size, int64_t nitems, void *stream);
 BLOSC_EXPORT int64_t blosc2_stdio_read(void *ptr, int64_t size, int64_t nitems, void *stream);
 BLOSC_EXPORT int blosc2_stdio_truncate(void *stream, int64_t size);
+BLOSC_EXPORT int64_t blosc2_stdio_read_at(void *stream, int64_t offset, int64_t size, void *ptr);
+BLOSC_EXPORT int64_t blosc2_stdio_readv_at(void *stream, const blosc2_io_segment *segments, int64_t nsegments);
+
+
+/**
+ * @brief Hints about how a file is going to be accessed via the mmap backend.
+ */
+enum {
+  BLOSC2_MMAP_ACCESS_NORMAL = 0,      //!< No special treatment (the OS default).
+  BLOSC2_MMAP_ACCESS_SEQUENTIAL = 1,  //!< Read ahead aggressively (e.g. for scanning a frame).
+  BLOSC2_MMAP_ACCESS_RANDOM = 2,      //!< Do not read ahead (e.g. for reading chunks at random).
+};
+
+/**
+ * @brief Parameters for the mmap backend (to be passed in `blosc2_io.params`).
+ *
+ * If no parameters are passed, @ref BLOSC2_MMAP_ACCESS_NORMAL is used.
+ */
+typedef struct {
+  int access;
+  //!< The expected access pattern (see @ref BLOSC2_MMAP_ACCESS_NORMAL and friends).
+} blosc2_stdio_mmap_params;
+
+typedef struct {
+  int fd;
+  //!< The file descriptor.
+  uint8_t* addr;
+  //!< The start of the mapping; NULL if nothing is mapped (yet).
+  int64_t mapped_size;
+  //!< The number of bytes mapped.
+  int64_t file_size;
+  //!< The (known) size of the file; the mapping is extended on demand up to it.
+  int64_t pos;
+  //!< The current position in the file.
+  int access;
+  //!< The expected access pattern.
+  void* file;
+  //!< The stdio file used on platforms without mmap support.
+} blosc2_stdio_mmap;
+
+BLOSC_EXPORT void *blosc2_stdio_mmap_open(const char *urlpath, const char *mode, void* params);
+BLOSC_EXPORT int blosc2_stdio_mmap_close(void *stream);
+BLOSC_EXPORT int64_t blosc2_stdio_mmap_tell(void *stream);
+BLOSC_EXPORT int blosc2_stdio_mmap_seek(void *stream, int64_t offset, int whence);
+BLOSC_EXPORT int64_t blosc2_stdio_mmap_write(const void *ptr, int64_t size, int64_t nitems, void *stream);
+BLOSC_EXPORT int64_t blosc2_stdio_mmap_read(void *ptr, int64_t size, int64_t nitems, void *stream);
+BLOSC_EXPORT int blosc2_stdio_mmap_truncate(void *stream, int64_t size);
+BLOSC_EXPORT int64_t blosc2_stdio_mmap_read_at(void *stream, int64_t offset, int64_t size, void *ptr);
+BLOSC_EXPORT int64_t blosc2_stdio_mmap_readv_at(void *stream, const blosc2_io_segment *segments, int64_t nsegments);
+
+/**
+ * @brief Get the address where a range of a file opened with @ref blosc2_stdio_mmap_open
+ * is mapped in memory.
+ *
+ * The address is valid until the file is written, truncated or closed.
+ *
+ * @return The address for @p offset, or NULL if the range is outside of the file or
+ * the file cannot be mapped.
+ */
+BLOSC_EXPORT void *blosc2_stdio_mmap_addr(void *stream, int64_t offset, int64_t size);
+
+
+typedef struct {
+  int fd;
+  //!< The file descriptor.
+  int64_t pos;
+  //!< The current position in the file.
+  void* rings;
+  //!< The io_uring instances for submitting reads (private).
+  void* file;
+  //!< The stdio file used on platforms without positional reads.
+} blosc2_stdio_uring;
+
+BLOSC_EXPORT void *blosc2_stdio_uring_open(const char *urlpath, const char *mode, void* params);
+BLOSC_EXPORT int blosc2_stdio_uring_close(void *stream);
+BLOSC_EXPORT int64_t blosc2_stdio_uring_tell(void *stream);
+BLOSC_EXPORT int blosc2_stdio_uring_seek(void *stream, int64_t offset, int whence);
+BLOSC_EXPORT int64_t blosc2_stdio_uring_write(const void *ptr, int64_t size, int64_t nitems, void *stream);
+BLOSC_EXPORT int64_t blosc2_stdio_uring_read(void *ptr, int64_t size, int64_t nitems, void *stream);
+BLOSC_EXPORT int blosc2_stdio_uring_truncate(void *stream, int64_t size);
+BLOSC_EXPORT int64_t blosc2_stdio_uring_read_at(void *stream, int64_t offset, int64_t size, void *ptr);
+BLOSC_EXPORT int64_t blosc2_stdio_uring_readv_at(void *stream, const blosc2_io_segment *segments, int64_t nsegments);
+
+/**
+ * @brief Submit the reads of many ranges of a file opened with @ref blosc2_stdio_uring_open,
+ * without waiting for them.
+ *
+ * The ranges are read in the background (up to a queue depth of 16); use
+ * @ref blosc2_stdio_uring_wait for getting each one.  Segments with a size of 0 are skipped.
+ *
+ * @return A handle for the batch of reads, which has to be released with
+ * @ref blosc2_stdio_uring_release.  If io_uring is not available, it returns NULL.
+ */
+BLOSC_EXPORT void *blosc2_stdio_uring_submit(void *stream, const blosc2_io_segment *segments, int64_t nsegments);
+
+/**
+ * @brief Wait for the read of a segment submitted with @ref blosc2_stdio_uring_submit.
+ *
+ * Several threads can wait for (different segments of) the same batch at once.
+ *
+ * @return The number of bytes read, or a negative value on errors.
+ */
+BLOSC_EXPORT int64_t blosc2_stdio_uring_wait(void *batch, int64_t nsegment);
+
+/**
+ * @brief Wait for all the reads of a batch still in flight and free it.
+ */
+BLOSC_EXPORT void blosc2_stdio_uring_release(void *batch);
+
+/**
+ * @brief Parameters for the direct I/O backend (to be passed in `blosc2_io.params`).
+ *
+ * If no parameters are passed (or they are 0), the defaults are used.
+ */
+typedef struct {
+  int32_t alignment;
+  //!< The alignment of the offsets, sizes and buffers of direct reads (4096 by default).
+  int32_t buffer_size;
+  //!< The size of the buffers where unaligned ranges are read (1 MB by default).
+} blosc2_stdio_direct_params;
+
+typedef struct {
+  int fd;
+  //!< The file descriptor for reading (bypassing the page cache if possible).
+  int wfd;
+  //!< The file descriptor for writing (through the page cache); -1 for read-only files.
+  int direct;
+  //!< Whether reads bypass the page cache (not every filesystem supports it).
+  int32_t alignment;
+  //!< The alignment of the offsets, sizes and buffers of direct reads.
+  int32_t buffer_size;
+  //!< The size of the buffers where unaligned ranges are read.
+  int64_t pos;
+  //!< The current position in the file.
+  void* buffers;
+  //!< The pool of aligned buffers (private).
+  void* file;
+  //!< The stdio file used on platforms without direct I/O.
+} blosc2_stdio_direct;
+
+BLOSC_EXPORT void *blosc2_stdio_direct_open(const char *urlpath, const char *mode, void* params);
+BLOSC_EXPORT int blosc2_stdio_direct_close(void *stream);
+BLOSC_EXPORT int64_t blosc2_stdio_direct_tell(void *stream);
+BLOSC_EXPORT int blosc2_stdio_direct_seek(void *stream, int64_t offset, int whence);
+BLOSC_EXPORT int64_t blosc2_stdio_direct_write(const void *ptr, int64_t size, int64_t nitems, void *stream);
+BLOSC_EXPORT int64_t blosc2_stdio_direct_read(void *ptr, int64_t size, int64_t nitems, void *stream);
+BLOSC_EXPORT int blosc2_stdio_direct_truncate(void *stream, int64_t size);
+BLOSC_EXPORT int64_t blosc2_stdio_direct_read_at(void *stream, int64_t offset, int64_t size, void *ptr);
+BLOSC_EXPORT int64_t blosc2_stdio_direct_readv_at(void *stream, const blosc2_io_segment *segments, int64_t nsegments);
 
 #endif //BLOSC_BLOSC2_STDIO_H
@@ -0,0 +1,167 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Test the asynchronous compression and decompression with contexts.
+*/
+
+#include "test_common.h"
+#include "cutest.h"
+
+#define CHUNKSIZE (50 * 1000)
+#define NBUFFERS 8
+
+
+typedef struct {
+  int16_t nthreads;
+  int16_t pool_nthreads;
+  bool threads_callback;
+} test_async_backend;
+
+CUTEST_TEST_DATA(async) {
+  int32_t *data;
+};
+
+CUTEST_TEST_SETUP(async) {
+  blosc_init();
+  data->data = malloc(NBUFFERS * CHUNKSIZE * sizeof(int32_t));
+  for (int i = 0; i < NBUFFERS * CHUNKSIZE; i++) {
+    data->data[i] = i / 3 + (i % 1013) * 7 % 11;
+  }
+
+  CUTEST_PARAMETRIZE(backend, test_async_backend, CUTEST_DATA(
+      {1, 0, false},
+      {4, 0, false},
+      {4, 2, false},  // with the shared pool
+      {4, 0, true},  // with a threads callback
+  ));
+}
+
+
+typedef struct {
+  int ncalls;
+  int result;
+} test_callback_data;
+
+static void count_callback(void *user_data, int result) {
+  test_callback_data *cb_data = (test_callback_data *) user_data;
+  cb_data->ncalls++;
+  cb_data->result = result;
+}
+
+
+/* A serial threading backend, counting its calls */
+static void serial_threads_callback(void *callback_data, void (*dojob)(void *), int numjobs,
+                                    size_t jobdata_elsize, void *jobdata) {
+  (*(int *) callback_data)++;
+  for (int i = 0; i < numjobs; i++) {
+    dojob((char *) jobdata + i * jobdata_elsize);
+  }
+}
+
+
+CUTEST_TEST_TEST(async) {
+  CUTEST_GET_PARAMETER(backend, test_async_backend);
+
+  CUTEST_ASSERT("Error setting the shared pool", blosc2_set_shared_nthreads(backend.pool_nthreads) >= 0);
+  int ncallbacks = 0;
+  if (backend.threads_callback) {
+    blosc_set_threads_callback(serial_threads_callback, &ncallbacks);
+  }
+
+  int32_t nbytes = CHUNKSIZE * sizeof(int32_t);
+  int32_t chunksize = nbytes + BLOSC_MAX_OVERHEAD;
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = sizeof(int32_t);
+  cparams.blocksize = 16 * 1024;
+  cparams.nthreads = backend.nthreads;
+  blosc2_context *cctx = blosc2_create_cctx(cparams);
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  dparams.nthreads = backend.nthreads;
+  blosc2_context *dctx = blosc2_create_dctx(dparams);
+
+  uint8_t *chunks = malloc(NBUFFERS * chunksize);
+  int32_t *dest = malloc(NBUFFERS * nbytes);
+  blosc2_async *handles[NBUFFERS];
+  test_callback_data cb_data[NBUFFERS] = {0};
+  int csizes[NBUFFERS];
+
+  // Several compressions queued on the same context
+  for (int i = 0; i < NBUFFERS; i++) {
+    handles[i] = blosc2_compress_ctx_async(cctx, data->data + i * CHUNKSIZE, nbytes,
+                                           chunks + i * chunksize, chunksize,
+                                           count_callback, &cb_data[i]);
+    CUTEST_ASSERT("Error queuing a compression", handles[i] != NULL);
+  }
+  int result;
+  if (backend.threads_callback) {
+    // Nothing is done until the queue is run
+    for (int i = 0; i < NBUFFERS; i++) {
+      CUTEST_ASSERT("Compression done without running the queue", blosc2_async_poll(handles[i], NULL) == 0);
+    }
+    CUTEST_ASSERT("Error running the queue", blosc2_async_run(cctx) == 0);
+    CUTEST_ASSERT("Threads callback not used", ncallbacks > 0);
+  }
+  // Wait for the last one by polling (the previous ones are done before)
+  while (blosc2_async_poll(handles[NBUFFERS - 1], &result) == 0) {
+  }
+  for (int i = 0; i < NBUFFERS; i++) {
+    CUTEST_ASSERT("Compression not done in order", blosc2_async_poll(handles[i], NULL) == 1);
+    csizes[i] = blosc2_async_wait(handles[i]);
+    CUTEST_ASSERT("Error compressing", csizes[i] > 0 && csizes[i] < nbytes);
+    CUTEST_ASSERT("Callback not called once", cb_data[i].ncalls == 1 && cb_data[i].result == csizes[i]);
+  }
+  CUTEST_ASSERT("Bad result when polling", result == csizes[NBUFFERS - 1]);
+
+  // The same chunks as the synchronous compression
+  uint8_t *chunk = malloc(chunksize);
+  for (int i = 0; i < NBUFFERS; i++) {
+    int csize = blosc2_compress_ctx(cctx, data->data + i * CHUNKSIZE, nbytes, chunk, chunksize);
+    CUTEST_ASSERT("Compressed sizes are not equal", csize == csizes[i]);
+    CUTEST_ASSERT("Chunks are not equal", memcmp(chunk, chunks + i * chunksize, csize) == 0);
+  }
+  free(chunk);
+
+  // Decompressions, without callbacks (waiting for the last one first runs the queue)
+  for (int i = 0; i < NBUFFERS; i++) {
+    handles[i] = blosc2_decompress_ctx_async(dctx, chunks + i * chunksize, csizes[i],
+                                             dest + i * CHUNKSIZE, nbytes, NULL, NULL);
+    CUTEST_ASSERT("Error queuing a decompression", handles[i] != NULL);
+  }
+  CUTEST_ASSERT("Error decompressing", blosc2_async_wait(handles[NBUFFERS - 1]) == nbytes);
+  for (int i = 0; i < NBUFFERS - 1; i++) {
+    CUTEST_ASSERT("Decompression not done in order", blosc2_async_poll(handles[i], NULL) == 1);
+    CUTEST_ASSERT("Error decompressing", blosc2_async_wait(handles[i]) == nbytes);
+  }
+  CUTEST_ASSERT("Data are not equal", memcmp(data->data, dest, NBUFFERS * nbytes) == 0);
+
+  // Errors are returned as by the synchronous functions
+  blosc2_async *handle = blosc2_decompress_ctx_async(dctx, chunks, csizes[0], dest, 16, NULL, NULL);
+  CUTEST_ASSERT("Error queuing a decompression", handle != NULL);
+  CUTEST_ASSERT("Error not detected", blosc2_async_wait(handle) < 0);
+  handle = blosc2_compress_ctx_async(dctx, data->data, nbytes, chunks, chunksize, NULL, NULL);
+  CUTEST_ASSERT("Wrong context not detected", handle != NULL && blosc2_async_wait(handle) < 0);
+  handle = blosc2_decompress_ctx_async(cctx, chunks, csizes[0], dest, nbytes, NULL, NULL);
+  CUTEST_ASSERT("Wrong context not detected", handle != NULL && blosc2_async_wait(handle) < 0);
+
+  // Freeing the contexts finishes their threads
+  blosc2_free_ctx(cctx);
+  blosc2_free_ctx(dctx);
+  free(chunks);
+  free(dest);
+  CUTEST_ASSERT("Error releasing the shared pool", blosc2_set_shared_nthreads(0) == backend.pool_nthreads);
+  blosc_set_threads_callback(NULL, NULL);
+
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(async) {
+  free(data->data);
+  blosc_destroy();
+}
+
+
+int main() {
+  CUTEST_TEST_RUN(async)
+}
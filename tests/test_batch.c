@@ -0,0 +1,134 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Test the compression and decompression of batches of buffers.
+*/
+
+#include "test_common.h"
+#include "cutest.h"
+
+#define NITEMS 50
+#define MAX_ITEMSIZE (64 * 1024)
+
+
+typedef struct {
+  int16_t nthreads;
+  int16_t pool_nthreads;
+  uint8_t compcode;
+} test_batch_backend;
+
+CUTEST_TEST_DATA(batch) {
+  uint8_t *data;
+  int32_t itemsizes[NITEMS];
+};
+
+CUTEST_TEST_SETUP(batch) {
+  blosc_init();
+  data->data = malloc(NITEMS * MAX_ITEMSIZE);
+  int32_t *idata = (int32_t *) data->data;
+  for (int i = 0; i < NITEMS * MAX_ITEMSIZE / (int) sizeof(int32_t); i++) {
+    idata[i] = i / 3 + (i % 1013) * 7 % 11;
+  }
+  for (int i = 0; i < NITEMS; i++) {
+    // From 4 KB to 64 KB
+    data->itemsizes[i] = 4 * 1024 + (i * 7 * 1024) % (MAX_ITEMSIZE - 4 * 1024 + 4);
+  }
+
+  CUTEST_PARAMETRIZE(backend, test_batch_backend, CUTEST_DATA(
+      {1, 0, BLOSC_BLOSCLZ},
+      {2, 0, BLOSC_LZ4},
+      {4, 0, BLOSC_ZSTD},
+      {8, 0, BLOSC_BLOSCLZ},
+      {4, 3, BLOSC_LZ4},  // with the shared pool
+  ));
+}
+
+
+CUTEST_TEST_TEST(batch) {
+  CUTEST_GET_PARAMETER(backend, test_batch_backend);
+
+  CUTEST_ASSERT("Error setting the shared pool", blosc2_set_shared_nthreads(backend.pool_nthreads) >= 0);
+
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = sizeof(int32_t);
+  cparams.compcode = backend.compcode;
+  cparams.nthreads = backend.nthreads;
+  blosc2_context *cctx = blosc2_create_cctx(cparams);
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  dparams.nthreads = backend.nthreads;
+  blosc2_context *dctx = blosc2_create_dctx(dparams);
+  cparams.nthreads = 1;
+
+  uint8_t *chunks = malloc(NITEMS * (MAX_ITEMSIZE + BLOSC_MAX_OVERHEAD));
+  uint8_t *chunk = malloc(MAX_ITEMSIZE + BLOSC_MAX_OVERHEAD);
+  uint8_t *dest = malloc(NITEMS * MAX_ITEMSIZE);
+  blosc2_batch_item items[NITEMS];
+  int32_t results[NITEMS];
+
+  // A few batches, so that the contexts of the tasks are reused
+  for (int round = 0; round < 3; round++) {
+    for (int i = 0; i < NITEMS; i++) {
+      items[i].src = data->data + i * MAX_ITEMSIZE;
+      items[i].srcsize = data->itemsizes[i];
+      items[i].dest = chunks + i * (MAX_ITEMSIZE + BLOSC_MAX_OVERHEAD);
+      items[i].destsize = MAX_ITEMSIZE + BLOSC_MAX_OVERHEAD;
+    }
+    CUTEST_ASSERT("Error compressing a batch", blosc2_compress_batch(cctx, items, NITEMS, results) == 0);
+    for (int i = 0; i < NITEMS; i++) {
+      // Every buffer is compressed as if it were on its own
+      blosc2_context *cctx_serial = blosc2_create_cctx(cparams);
+      int csize = blosc2_compress_ctx(cctx_serial, items[i].src, items[i].srcsize, chunk,
+                                      MAX_ITEMSIZE + BLOSC_MAX_OVERHEAD);
+      blosc2_free_ctx(cctx_serial);
+      CUTEST_ASSERT("Compressed sizes are not equal", csize > 0 && results[i] == csize);
+      CUTEST_ASSERT("Chunks are not equal", memcmp(items[i].dest, chunk, csize) == 0);
+    }
+
+    for (int i = 0; i < NITEMS; i++) {
+      items[i].src = chunks + i * (MAX_ITEMSIZE + BLOSC_MAX_OVERHEAD);
+      items[i].srcsize = results[i];
+      items[i].dest = dest + i * MAX_ITEMSIZE;
+      items[i].destsize = MAX_ITEMSIZE;
+    }
+    CUTEST_ASSERT("Error decompressing a batch", blosc2_decompress_batch(dctx, items, NITEMS, results) == 0);
+    for (int i = 0; i < NITEMS; i++) {
+      CUTEST_ASSERT("Decompressed sizes are not equal", results[i] == data->itemsizes[i]);
+      CUTEST_ASSERT("Data are not equal",
+                    memcmp(data->data + i * MAX_ITEMSIZE, dest + i * MAX_ITEMSIZE, results[i]) == 0);
+    }
+  }
+
+  // A failed buffer does not stop the others
+  items[NITEMS / 2].destsize = 16;
+  int rc = blosc2_decompress_batch(dctx, items, NITEMS, results);
+  CUTEST_ASSERT("Error not detected", rc < 0 && results[NITEMS / 2] == rc);
+  for (int i = 0; i < NITEMS; i++) {
+    CUTEST_ASSERT("Decompressed sizes are not equal", i == NITEMS / 2 || results[i] == data->itemsizes[i]);
+  }
+
+  // Contexts for the other direction are refused
+  CUTEST_ASSERT("Wrong context not detected", blosc2_compress_batch(dctx, items, NITEMS, results) < 0);
+  CUTEST_ASSERT("Wrong context not detected", blosc2_decompress_batch(cctx, items, NITEMS, results) < 0);
+  CUTEST_ASSERT("Empty batch not accepted", blosc2_compress_batch(cctx, NULL, 0, NULL) == 0);
+
+  free(chunks);
+  free(chunk);
+  free(dest);
+  blosc2_free_ctx(cctx);
+  blosc2_free_ctx(dctx);
+  CUTEST_ASSERT("Error releasing the shared pool", blosc2_set_shared_nthreads(0) == backend.pool_nthreads);
+
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(batch) {
+  free(data->data);
+  blosc_destroy();
+}
+
+
+int main() {
+  CUTEST_TEST_RUN(batch)
+}
@@ -0,0 +1,240 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Test the reuse of the holes of contiguous frames and their compaction.
+*/
+
+#include "test_common.h"
+#include "cutest.h"
+
+#define CHUNKSIZE (20 * 1000)
+#define NCHUNKS 10
+#define NUPDATES 20
+
+
+typedef struct {
+  char *urlpath;
+  bool reorder;
+} test_compact_backend;
+
+CUTEST_TEST_DATA(compact) {
+  blosc2_cparams cparams;
+  blosc2_dparams dparams;
+};
+
+CUTEST_TEST_SETUP(compact) {
+  blosc_init();
+
+  data->cparams = BLOSC2_CPARAMS_DEFAULTS;
+  data->cparams.typesize = sizeof(int32_t);
+  data->cparams.compcode = BLOSC_BLOSCLZ;
+  data->cparams.clevel = 5;
+  data->cparams.nthreads = 2;
+  data->dparams = BLOSC2_DPARAMS_DEFAULTS;
+  data->dparams.nthreads = 2;
+
+  CUTEST_PARAMETRIZE(backend, test_compact_backend, CUTEST_DATA(
+      {NULL, false}, // memory - cframe
+      {NULL, true}, // memory - cframe
+      {"test_compact.b2frame", false}, // disk - cframe
+      {"test_compact.b2frame", true}, // disk - cframe
+  ));
+}
+
+
+/* Fill a chunk, where bigger values of ncolors make it less compressible */
+static void fill_chunk(int32_t *buffer, int value, int ncolors) {
+  for (int j = 0; j < CHUNKSIZE; ++j) {
+    buffer[j] = value + (j * 7919) % ncolors;
+  }
+}
+
+
+static int check_chunks(blosc2_schunk *schunk, const int *values, const int *ncolors) {
+  int32_t nbytes = CHUNKSIZE * sizeof(int32_t);
+  int32_t *rec_buffer = malloc(nbytes);
+  int32_t *expected = malloc(nbytes);
+  int rc = 0;
+  for (int i = 0; rc == 0 && i < schunk->nchunks; ++i) {
+    int32_t dbytes = blosc2_schunk_decompress_chunk(schunk, i, rec_buffer, nbytes);
+    if (dbytes != nbytes) {
+      rc = -1;
+      break;
+    }
+    if (values[i] < 0) {
+      // A chunk of zeros
+      memset(expected, 0, nbytes);
+    }
+    else {
+      fill_chunk(expected, values[i], ncolors[i]);
+    }
+    if (memcmp(rec_buffer, expected, nbytes) != 0) {
+      rc = -1;
+    }
+  }
+  free(rec_buffer);
+  free(expected);
+  return rc;
+}
+
+
+static int update_buffer(blosc2_schunk *schunk, int nchunk, int32_t *buffer) {
+  int32_t nbytes = CHUNKSIZE * sizeof(int32_t);
+  void *chunk = malloc(nbytes + BLOSC_MAX_OVERHEAD);
+  int csize = blosc2_compress_ctx(schunk->cctx, buffer, nbytes, chunk, nbytes + BLOSC_MAX_OVERHEAD);
+  if (csize < 0) {
+    free(chunk);
+    return csize;
+  }
+  return blosc2_schunk_update_chunk(schunk, nchunk, chunk, false);
+}
+
+
+CUTEST_TEST_TEST(compact) {
+  CUTEST_GET_PARAMETER(backend, test_compact_backend);
+
+  blosc2_remove_urlpath(backend.urlpath);
+
+  int32_t nbytes = CHUNKSIZE * sizeof(int32_t);
+  int32_t *data_buffer = malloc(nbytes);
+  int values[NCHUNKS];
+  int ncolors[NCHUNKS];
+
+  blosc2_storage storage = {.cparams=&data->cparams, .dparams=&data->dparams,
+                            .contiguous=true, .urlpath=backend.urlpath};
+  blosc2_schunk *schunk = blosc2_schunk_new(&storage);
+  CUTEST_ASSERT("Error creating the super-chunk", schunk != NULL);
+
+  for (int i = 0; i < NCHUNKS; ++i) {
+    values[i] = i * 1000;
+    ncolors[i] = 10 + i * 100;
+    fill_chunk(data_buffer, values[i], ncolors[i]);
+    int nchunks = blosc2_schunk_append_buffer(schunk, data_buffer, nbytes);
+    CUTEST_ASSERT("Error during compression", nchunks == i + 1);
+  }
+
+  // Chunks that do not fit in their old place go to the holes left by other ones
+  int64_t grown_len = 0;
+  for (int n = 0; n < NUPDATES; ++n) {
+    int i = (n * 3) % NCHUNKS;
+    bool bigger = n % 2 == 0;
+    values[i] = n;
+    ncolors[i] = bigger ? 1000 : 10;
+    fill_chunk(data_buffer, values[i], ncolors[i]);
+    int nchunks = update_buffer(schunk, i, data_buffer);
+    CUTEST_ASSERT("Error updating the chunk", nchunks == NCHUNKS);
+    if (n == NUPDATES / 2) {
+      grown_len = blosc2_schunk_frame_len(schunk);
+    }
+  }
+  CUTEST_ASSERT("Data are not equal", check_chunks(schunk, values, ncolors) == 0);
+  // After a while, holes are big enough for the bigger chunks
+  CUTEST_ASSERT("Holes are not reused", blosc2_schunk_frame_len(schunk) <= grown_len);
+
+  // Make a hole in the middle and a special chunk
+  int nchunks = blosc2_schunk_delete_chunk(schunk, 2);
+  CUTEST_ASSERT("Error deleting the chunk", nchunks == NCHUNKS - 1);
+  memmove(values + 2, values + 3, (NCHUNKS - 3) * sizeof(int));
+  memmove(ncolors + 2, ncolors + 3, (NCHUNKS - 3) * sizeof(int));
+  uint8_t zeros[BLOSC_EXTENDED_HEADER_LENGTH];
+  int csize = blosc2_chunk_zeros(data->cparams, nbytes, zeros, BLOSC_EXTENDED_HEADER_LENGTH);
+  CUTEST_ASSERT("Error creating a chunk of zeros", csize > 0);
+  nchunks = blosc2_schunk_update_chunk(schunk, 4, zeros, true);
+  CUTEST_ASSERT("Error updating the chunk", nchunks == NCHUNKS - 1);
+  values[4] = -1;
+
+  if (backend.reorder) {
+    int offsets_order[NCHUNKS - 1];
+    int values_[NCHUNKS - 1];
+    int ncolors_[NCHUNKS - 1];
+    for (int i = 0; i < NCHUNKS - 1; ++i) {
+      offsets_order[i] = (i + 4) % (NCHUNKS - 1);
+      values_[i] = values[offsets_order[i]];
+      ncolors_[i] = ncolors[offsets_order[i]];
+    }
+    CUTEST_ASSERT("Error reordering the offsets",
+                  blosc2_schunk_reorder_offsets(schunk, offsets_order) == 0);
+    memcpy(values, values_, sizeof(values_));
+    memcpy(ncolors, ncolors_, sizeof(ncolors_));
+  }
+
+  int64_t frame_len = blosc2_schunk_frame_len(schunk);
+#if !defined(_WIN32)
+  if (backend.urlpath != NULL) {
+    CUTEST_ASSERT("Error changing the permissions", chmod(backend.urlpath, 0640) == 0);
+  }
+#endif
+  CUTEST_ASSERT("Error compacting the frame", blosc2_schunk_compact(schunk) == 0);
+  CUTEST_ASSERT("Frame has not shrunk", blosc2_schunk_frame_len(schunk) < frame_len);
+  CUTEST_ASSERT("Data are not equal", check_chunks(schunk, values, ncolors) == 0);
+  if (backend.urlpath != NULL) {
+    // The compacted copy has replaced the frame
+    char copy_urlpath[64];
+    sprintf(copy_urlpath, "%s.compact", backend.urlpath);
+    FILE *fp = fopen(copy_urlpath, "rb");
+    CUTEST_ASSERT("The compacted copy is left behind", fp == NULL);
+    fp = fopen(backend.urlpath, "rb");
+    CUTEST_ASSERT("The frame is missing", fp != NULL);
+    fseek(fp, 0, SEEK_END);
+    CUTEST_ASSERT("Bad size of the frame file", ftell(fp) == blosc2_schunk_frame_len(schunk));
+    fclose(fp);
+#if !defined(_WIN32)
+    struct stat st;
+    CUTEST_ASSERT("Error getting the permissions", stat(backend.urlpath, &st) == 0);
+    CUTEST_ASSERT("The permissions of the frame are lost", (st.st_mode & 0777) == 0640);
+#endif
+  }
+
+  // The chunks are one after the other, in logical order
+  int64_t cbytes = 0;
+  for (int i = 0; i < schunk->nchunks; ++i) {
+    uint8_t *chunk;
+    bool needs_free;
+    csize = blosc2_schunk_get_chunk(schunk, i, &chunk, &needs_free);
+    CUTEST_ASSERT("Error getting the chunk", csize > 0);
+    if (values[i] >= 0) {
+      cbytes += csize;
+    }
+    if (needs_free) {
+      free(chunk);
+    }
+  }
+  CUTEST_ASSERT("Bad compressed size", schunk->cbytes == cbytes);
+  frame_len = blosc2_schunk_frame_len(schunk);
+  CUTEST_ASSERT("Error compacting the frame again", blosc2_schunk_compact(schunk) == 0);
+  CUTEST_ASSERT("Frame should not change", blosc2_schunk_frame_len(schunk) == frame_len);
+
+  // Updates keep working after compaction
+  values[1] = 77;
+  ncolors[1] = 5000;
+  fill_chunk(data_buffer, values[1], ncolors[1]);
+  nchunks = update_buffer(schunk, 1, data_buffer);
+  CUTEST_ASSERT("Error updating the chunk", nchunks == NCHUNKS - 1);
+  CUTEST_ASSERT("Data are not equal", check_chunks(schunk, values, ncolors) == 0);
+
+  // Reopen it
+  if (backend.urlpath != NULL) {
+    blosc2_schunk_free(schunk);
+    schunk = blosc2_schunk_open(backend.urlpath);
+    CUTEST_ASSERT("Error opening the super-chunk", schunk != NULL);
+    CUTEST_ASSERT("Bad number of chunks", schunk->nchunks == NCHUNKS - 1);
+    CUTEST_ASSERT("Data are not equal", check_chunks(schunk, values, ncolors) == 0);
+  }
+
+  blosc2_schunk_free(schunk);
+  blosc2_remove_urlpath(backend.urlpath);
+  free(data_buffer);
+
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(compact) {
+  blosc_destroy();
+}
+
+
+int main() {
+  CUTEST_TEST_RUN(compact)
+}
@@ -23,6 +23,19 @@ size_t typesize = 8;
 size_t size = 8 * 1000 * 1000;  /* must be divisible by typesize */
 
 
+/* Set (or unset if value is NULL) an environment variable, which is read by blosc_init() */
+static void set_blosc_env(const char *name, const char *value) {
+  if (value != NULL) {
+    setenv(name, value, 0);
+  }
+  else {
+    unsetenv(name);
+  }
+  blosc_destroy();
+  blosc_init();
+}
+
+
 /* Check compressor */
 static char *test_compressor(void) {
   const char* compressor;
@@ -33,7 +46,7 @@ static char *test_compressor(void) {
 	    strcmp(compressor, "blosclz") == 0);
 
   /* Activate the BLOSC_COMPRESSOR variable */
-  setenv("BLOSC_COMPRESSOR", "lz4", 0);
+  set_blosc_env("BLOSC_COMPRESSOR", "lz4");
 
   /* Get a compressed buffer */
   cbytes = blosc_compress(clevel, doshuffle, typesize, size, src,
@@ -45,7 +58,7 @@ static char *test_compressor(void) {
 	    strcmp(compressor, "lz4") == 0);
 
   /* Reset envvar */
-  unsetenv("BLOSC_COMPRESSOR");
+  set_blosc_env("BLOSC_COMPRESSOR", NULL);
   return 0;
 }
 
@@ -55,7 +68,7 @@ static char *test_compress_decompress(void) {
   const char* compressor;
 
   /* Activate the BLOSC_COMPRESSOR variable */
-  setenv("BLOSC_COMPRESSOR", "lz4", 0);
+  set_blosc_env("BLOSC_COMPRESSOR", "lz4");
 
   compressor = blosc_get_compressor();
   mu_assert("ERROR: get_compressor incorrect",
@@ -79,7 +92,7 @@ static char *test_compress_decompress(void) {
 	    strcmp(compressor, "lz4") == 0);
 
   /* Reset envvar */
-  unsetenv("BLOSC_COMPRESSOR");
+  set_blosc_env("BLOSC_COMPRESSOR", NULL);
   return 0;
 }
 
@@ -94,13 +107,13 @@ static char *test_clevel(void) {
   mu_assert("ERROR: cbytes is not correct", cbytes < (int)size);
 
   /* Activate the BLOSC_CLEVEL variable */
-  setenv("BLOSC_CLEVEL", "9", 0);
+  set_blosc_env("BLOSC_CLEVEL", "9");
   cbytes2 = blosc_compress(clevel, doshuffle, typesize, size, src,
                            dest, size + BLOSC_MAX_OVERHEAD);
   mu_assert("ERROR: BLOSC_CLEVEL does not work correctly", cbytes2 < cbytes);
 
   /* Reset envvar */
-  unsetenv("BLOSC_CLEVEL");
+  set_blosc_env("BLOSC_CLEVEL", NULL);
   return 0;
 }
 
@@ -114,14 +127,14 @@ static char *test_noshuffle(void) {
   mu_assert("ERROR: cbytes is not correct", cbytes < (int)size);
 
   /* Activate the BLOSC_SHUFFLE variable */
-  setenv("BLOSC_SHUFFLE", "NOSHUFFLE", 0);
+  set_blosc_env("BLOSC_SHUFFLE", "NOSHUFFLE");
   cbytes2 = blosc_compress(clevel, doshuffle, typesize, size, src,
                            dest, size + BLOSC_MAX_OVERHEAD);
   mu_assert("ERROR: BLOSC_SHUFFLE=NOSHUFFLE does not work correctly",
             cbytes2 > cbytes);
 
   /* Reset env var */
-  unsetenv("BLOSC_SHUFFLE");
+  set_blosc_env("BLOSC_SHUFFLE", NULL);
   return 0;
 }
 
@@ -136,14 +149,14 @@ static char *test_shuffle(void) {
   mu_assert("ERROR: cbytes is not 0", cbytes < (int)size);
 
   /* Activate the BLOSC_SHUFFLE variable */
-  setenv("BLOSC_SHUFFLE", "SHUFFLE", 0);
+  set_blosc_env("BLOSC_SHUFFLE", "SHUFFLE");
   cbytes2 = blosc_compress(clevel, doshuffle, typesize, size, src,
                            dest, size + BLOSC_MAX_OVERHEAD);
   mu_assert("ERROR: BLOSC_SHUFFLE=SHUFFLE does not work correctly",
             cbytes2 == cbytes);
 
   /* Reset env var */
-  unsetenv("BLOSC_SHUFFLE");
+  set_blosc_env("BLOSC_SHUFFLE", NULL);
   return 0;
 }
 
@@ -161,14 +174,14 @@ static char *test_bitshuffle(void) {
   mu_assert("ERROR: cbytes is not 0", cbytes < (int)size);
 
   /* Activate the BLOSC_BITSHUFFLE variable */
-  setenv("BLOSC_SHUFFLE", "BITSHUFFLE", 0);
+  set_blosc_env("BLOSC_SHUFFLE", "BITSHUFFLE");
   cbytes2 = blosc_compress(clevel, doshuffle, typesize, size, src,
                            dest, size + BLOSC_MAX_OVERHEAD);
   mu_assert("ERROR: BLOSC_SHUFFLE=BITSHUFFLE does not work correctly",
             cbytes2 < cbytes);
 
   /* Reset env var */
-  unsetenv("BLOSC_SHUFFLE");
+  set_blosc_env("BLOSC_SHUFFLE", NULL);
   return 0;
 }
 
@@ -185,14 +198,14 @@ static char *test_delta(void) {
   mu_assert("ERROR: cbytes is not 0", cbytes < (int)size);
 
   /* Activate the BLOSC_DELTA variable */
-  setenv("BLOSC_DELTA", "1", 0);
+  set_blosc_env("BLOSC_DELTA", "1");
   cbytes2 = blosc_compress(clevel, doshuffle, typesize, size, src,
                            dest, size + BLOSC_MAX_OVERHEAD);
   mu_assert("ERROR: BLOSC_DELTA=1 does not work correctly",
             cbytes2 < 3 * cbytes / 4);
 
   /* Reset env var */
-  unsetenv("BLOSC_DELTA");
+  set_blosc_env("BLOSC_DELTA", NULL);
   return 0;
 }
 
@@ -207,13 +220,13 @@ static char *test_typesize(void) {
   mu_assert("ERROR: cbytes is not correct", cbytes < (int)size);
 
   /* Activate the BLOSC_TYPESIZE variable */
-  setenv("BLOSC_TYPESIZE", "9", 0);
+  set_blosc_env("BLOSC_TYPESIZE", "9");
   cbytes2 = blosc_compress(clevel, doshuffle, typesize, size, src,
                            dest, size + BLOSC_MAX_OVERHEAD);
   mu_assert("ERROR: undetected chunksize not being a multiple of typesize", cbytes2 < 0);
 
   /* Reset envvar */
-  unsetenv("BLOSC_TYPESIZE");
+  set_blosc_env("BLOSC_TYPESIZE", NULL);
   return 0;
 }
 
@@ -0,0 +1,195 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+*/
+
+#include "test_common.h"
+#include "cutest.h"
+
+#define CHUNKSIZE (20 * 1000)
+#define NCHUNKS 10
+#define FILESIZE (100 * 1000)
+
+
+typedef struct {
+  bool contiguous;
+  char *urlpath;
+  int32_t alignment;
+  int32_t buffer_size;
+}test_direct_backend;
+
+CUTEST_TEST_DATA(direct_io) {
+  blosc2_cparams cparams;
+  blosc2_dparams dparams;
+};
+
+CUTEST_TEST_SETUP(direct_io) {
+  blosc_init();
+
+  data->cparams = BLOSC2_CPARAMS_DEFAULTS;
+  data->cparams.typesize = sizeof(int32_t);
+  data->cparams.compcode = BLOSC_BLOSCLZ;
+  data->cparams.clevel = 5;
+  data->cparams.nthreads = 2;
+  data->dparams = BLOSC2_DPARAMS_DEFAULTS;
+  data->dparams.nthreads = 2;
+
+  CUTEST_PARAMETRIZE(backend, test_direct_backend, CUTEST_DATA(
+      {true, "test_direct_io.b2frame", 0, 0}, // disk - cframe
+      {true, "test_direct_io.b2frame", 512, 1000}, // disk - cframe, small buffers
+      {false, "test_direct_io_s.b2frame", 0, 0}, // disk - sframe
+      {false, "test_direct_io_s.b2frame", 4096, 4096}, // disk - sframe, small buffers
+  ));
+}
+
+
+/* Unaligned ranges, larger than the buffers and reaching the end of the file */
+static int check_ranges(blosc2_stdio_direct_params *params) {
+  char *urlpath = "test_direct_io.bin";
+  uint8_t *buf = malloc(FILESIZE);
+  // Like fread, reads may fill the whole destination, even past the end of the file
+  uint8_t *dest = malloc(FILESIZE + 3000);
+  for (int i = 0; i < FILESIZE; ++i) {
+    buf[i] = (uint8_t) (i * 7 + i / 256);
+  }
+  void *fp = blosc2_stdio_direct_open(urlpath, "wb", params);
+  if (fp == NULL) {
+    return -1;
+  }
+  int rc = 0;
+  if (blosc2_stdio_direct_write(buf, 1, FILESIZE, fp) != FILESIZE) {
+    rc = -1;
+  }
+  // Written data are seen by direct reads of the same handle
+  if (blosc2_stdio_direct_read_at(fp, 1, 100, dest) != 100 || memcmp(dest, buf + 1, 100) != 0) {
+    rc = -1;
+  }
+  blosc2_stdio_direct_close(fp);
+
+  fp = blosc2_stdio_direct_open(urlpath, "rb", params);
+  if (fp == NULL) {
+    return -1;
+  }
+  int64_t ranges[][2] = {{0, FILESIZE - 1}, {4096, 8192}, {3, 10}, {4095, 2}, {1000, 70000},
+                         {FILESIZE - 5000, 5000}, {FILESIZE - 10, 100}, {FILESIZE, 10}};
+  for (int i = 0; i < (int) (sizeof(ranges) / sizeof(ranges[0])); ++i) {
+    int64_t offset = ranges[i][0];
+    int64_t size = ranges[i][1];
+    int64_t expected = offset + size > FILESIZE ? FILESIZE - offset : size;
+    // Unaligned destinations too
+    uint8_t *ptr = dest + (i % 2);
+    if (blosc2_stdio_direct_read_at(fp, offset, size, ptr) != expected ||
+        memcmp(ptr, buf + offset, (size_t) expected) != 0) {
+      rc = -1;
+    }
+  }
+  // Sequential reads
+  uint8_t *ptr = dest;
+  while (blosc2_stdio_direct_read(ptr, 3000, 1, fp) > 0) {
+    ptr += 3000;
+  }
+  if (ptr - dest != FILESIZE / 3000 * 3000 || memcmp(dest, buf, ptr - dest) != 0) {
+    rc = -1;
+  }
+  // Read-only files cannot be written
+  if (blosc2_stdio_direct_write(buf, 1, 10, fp) != 0 || blosc2_stdio_direct_truncate(fp, 10) == 0) {
+    rc = -1;
+  }
+  blosc2_stdio_direct_close(fp);
+  blosc2_remove_urlpath(urlpath);
+  free(buf);
+  free(dest);
+  return rc;
+}
+
+
+static int check_chunk(blosc2_schunk *schunk, int nchunk, int value) {
+  int32_t nbytes = CHUNKSIZE * sizeof(int32_t);
+  int32_t *rec_buffer = malloc(nbytes);
+  int rc = 0;
+
+  int32_t dbytes = blosc2_schunk_decompress_chunk(schunk, nchunk, rec_buffer, nbytes);
+  if (dbytes != nbytes) {
+    rc = -1;
+  }
+  for (int j = 0; rc == 0 && j < CHUNKSIZE; ++j) {
+    if (rec_buffer[j] != j + value) {
+      rc = -1;
+    }
+  }
+  free(rec_buffer);
+  return rc;
+}
+
+
+CUTEST_TEST_TEST(direct_io) {
+  CUTEST_GET_PARAMETER(backend, test_direct_backend);
+
+  blosc2_stdio_direct_params io_params = {.alignment = backend.alignment, .buffer_size = backend.buffer_size};
+  CUTEST_ASSERT("Bad direct reads", check_ranges(&io_params) == 0);
+
+  /* Free resources */
+  blosc2_remove_urlpath(backend.urlpath);
+
+  int32_t nbytes = CHUNKSIZE * sizeof(int32_t);
+  int32_t *data_buffer = malloc(nbytes);
+
+  /* Create a super-chunk container */
+  blosc2_io io = {.id = BLOSC2_IO_FILESYSTEM_DIRECT, .params = &io_params};
+  blosc2_storage storage = {.cparams=&data->cparams, .dparams=&data->dparams,
+                            .contiguous=backend.contiguous, .urlpath = backend.urlpath, .io=&io};
+
+  blosc2_schunk *schunk = blosc2_schunk_new(&storage);
+  CUTEST_ASSERT("Error creating the super-chunk", schunk != NULL);
+
+  for (int i = 0; i < NCHUNKS; ++i) {
+    for (int j = 0; j < CHUNKSIZE; ++j) {
+      data_buffer[j] = j + i;
+    }
+    int nchunks = blosc2_schunk_append_buffer(schunk, data_buffer, nbytes);
+    CUTEST_ASSERT("Error during compression", nchunks == i + 1);
+  }
+
+  // The chunks (and their blocks) are at arbitrary offsets in the frame
+  for (int i = 0; i < NCHUNKS; ++i) {
+    CUTEST_ASSERT("Data are not equal", check_chunk(schunk, i, i) == 0);
+  }
+
+  // Updating and deleting chunks rewrite (and truncate) the files
+  for (int j = 0; j < CHUNKSIZE; ++j) {
+    data_buffer[j] = j + 100;
+  }
+  uint8_t *new_chunk = malloc(nbytes + BLOSC_MAX_OVERHEAD);
+  int cbytes = blosc2_compress_ctx(schunk->cctx, data_buffer, nbytes, new_chunk, nbytes + BLOSC_MAX_OVERHEAD);
+  CUTEST_ASSERT("Error compressing a chunk", cbytes > 0);
+  int nchunks = blosc2_schunk_update_chunk(schunk, 2, new_chunk, true);
+  CUTEST_ASSERT("Error updating a chunk", nchunks == NCHUNKS);
+  free(new_chunk);
+  nchunks = blosc2_schunk_delete_chunk(schunk, 0);
+  CUTEST_ASSERT("Error deleting a chunk", nchunks == NCHUNKS - 1);
+  blosc2_schunk_free(schunk);
+  free(data_buffer);
+
+  // Reopen it
+  schunk = blosc2_schunk_open_udio(backend.urlpath, &io);
+  CUTEST_ASSERT("Error opening the super-chunk", schunk != NULL);
+  CUTEST_ASSERT("Bad number of chunks", schunk->nchunks == NCHUNKS - 1);
+  for (int i = 0; i < NCHUNKS - 1; ++i) {
+    CUTEST_ASSERT("Data are not equal", check_chunk(schunk, i, i == 1 ? 100 : i + 1) == 0);
+  }
+
+  blosc2_schunk_free(schunk);
+  blosc2_remove_urlpath(backend.urlpath);
+
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(direct_io) {
+  blosc_destroy();
+}
+
+
+int main() {
+  CUTEST_TEST_RUN(direct_io)
+}
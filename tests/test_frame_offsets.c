@@ -0,0 +1,161 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+
+  Test appending many chunks, so that the offsets index spans several blocks.
+*/
+
+#include <stdio.h>
+#include "test_common.h"
+
+#define CHUNKSIZE (100)
+#define NTHREADS (2)
+
+/* Global vars */
+int tests_run = 0;
+
+
+typedef struct {
+  int nchunks;
+  char* urlpath;
+  bool contiguous;
+} test_data;
+
+test_data tdata;
+
+int tnchunks[] = {1, 2047, 2048, 2049, 2063, 4111, 5000};
+
+typedef struct {
+  bool contiguous;
+  char *urlpath;
+}test_storage;
+
+test_storage tstorage[] = {
+    {true, NULL},  // memory - cframe
+    {true, "test_frame_offsets.b2frame"}, // disk - cframe
+    {false, "test_frame_offsets_s.b2frame"}, // disk - sframe
+};
+
+
+static int fill_chunk(int32_t* data, int nchunk) {
+  for (int i = 0; i < CHUNKSIZE; i++) {
+    // Make some of the chunks special ones
+    data[i] = (nchunk % 7 == 3) ? 0 : i + nchunk;
+  }
+  return nchunk;
+}
+
+
+static char* check_chunks(blosc2_schunk* schunk, int nchunks) {
+  int32_t data[CHUNKSIZE];
+  int32_t data_dest[CHUNKSIZE];
+  int32_t isize = CHUNKSIZE * sizeof(int32_t);
+
+  mu_assert("ERROR: bad number of chunks", schunk->nchunks == nchunks);
+  for (int nchunk = 0; nchunk < nchunks; nchunk++) {
+    fill_chunk(data, nchunk);
+    int dsize = blosc2_schunk_decompress_chunk(schunk, nchunk, data_dest, isize);
+    mu_assert("ERROR: chunk cannot be decompressed correctly", dsize == isize);
+    for (int i = 0; i < CHUNKSIZE; i++) {
+      mu_assert("ERROR: bad roundtrip", data_dest[i] == data[i]);
+    }
+  }
+  return EXIT_SUCCESS;
+}
+
+
+static char* test_frame_offsets(void) {
+  int32_t data[CHUNKSIZE];
+  int32_t isize = CHUNKSIZE * sizeof(int32_t);
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  blosc2_schunk* schunk;
+  char* msg;
+
+  blosc2_remove_urlpath(tdata.urlpath);
+
+  /* Create a super-chunk container */
+  cparams.typesize = sizeof(int32_t);
+  cparams.nthreads = NTHREADS;
+  dparams.nthreads = NTHREADS;
+  blosc2_storage storage = {.cparams=&cparams, .dparams=&dparams,
+                            .urlpath=tdata.urlpath, .contiguous=tdata.contiguous};
+  schunk = blosc2_schunk_new(&storage);
+  mu_assert("ERROR: cannot create the super-chunk", schunk != NULL);
+
+  // Feed it with data
+  for (int nchunk = 0; nchunk < tdata.nchunks; nchunk++) {
+    fill_chunk(data, nchunk);
+    int nchunks_ = blosc2_schunk_append_buffer(schunk, data, isize);
+    mu_assert("ERROR: bad append", nchunks_ == nchunk + 1);
+  }
+  msg = check_chunks(schunk, tdata.nchunks);
+  if (msg != EXIT_SUCCESS) {
+    return msg;
+  }
+
+  if (tdata.urlpath != NULL) {
+    // Reopen the frame and keep appending to it
+    blosc2_schunk_free(schunk);
+    schunk = blosc2_schunk_open(tdata.urlpath);
+    mu_assert("ERROR: cannot open the super-chunk", schunk != NULL);
+    msg = check_chunks(schunk, tdata.nchunks);
+    if (msg != EXIT_SUCCESS) {
+      return msg;
+    }
+  }
+  for (int nchunk = tdata.nchunks; nchunk < tdata.nchunks + 3; nchunk++) {
+    fill_chunk(data, nchunk);
+    int nchunks_ = blosc2_schunk_append_buffer(schunk, data, isize);
+    mu_assert("ERROR: bad append", nchunks_ == nchunk + 1);
+  }
+  msg = check_chunks(schunk, tdata.nchunks + 3);
+  if (msg != EXIT_SUCCESS) {
+    return msg;
+  }
+
+  /* Free resources */
+  blosc2_schunk_free(schunk);
+  blosc2_remove_urlpath(tdata.urlpath);
+
+  return EXIT_SUCCESS;
+}
+
+static char *all_tests(void) {
+
+  for (int i = 0; i < sizeof(tstorage) / sizeof(test_storage); ++i) {
+    for (int j = 0; j < sizeof(tnchunks) / sizeof(int); ++j) {
+      tdata.contiguous = tstorage[i].contiguous;
+      tdata.urlpath = tstorage[i].urlpath;
+      tdata.nchunks = tnchunks[j];
+      mu_run_test(test_frame_offsets);
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+
+int main(void) {
+  char *result;
+
+  install_blosc_callback_test(); /* optionally install callback test */
+  blosc_init();
+
+  /* Run all the suite */
+  result = all_tests();
+  if (result != EXIT_SUCCESS) {
+    printf(" (%s)\n", result);
+  }
+  else {
+    printf(" ALL TESTS PASSED");
+  }
+  printf("\tTests run: %d\n", tests_run);
+
+  blosc_destroy();
+
+  return result != EXIT_SUCCESS;
+}
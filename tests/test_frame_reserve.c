@@ -0,0 +1,124 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Test the room made for in-memory contiguous frames as chunks are added.
+*/
+
+#include "test_common.h"
+#include "cutest.h"
+
+#define CHUNKSIZE (5 * 1000)
+#define NCHUNKS 200
+
+
+typedef struct {
+  int64_t cframe_reserve;
+} test_reserve_backend;
+
+CUTEST_TEST_DATA(frame_reserve) {
+  blosc2_cparams cparams;
+  blosc2_dparams dparams;
+};
+
+CUTEST_TEST_SETUP(frame_reserve) {
+  blosc_init();
+
+  data->cparams = BLOSC2_CPARAMS_DEFAULTS;
+  data->cparams.typesize = sizeof(int32_t);
+  data->cparams.compcode = BLOSC_BLOSCLZ;
+  data->cparams.clevel = 5;
+  data->cparams.nthreads = 2;
+  data->dparams = BLOSC2_DPARAMS_DEFAULTS;
+  data->dparams.nthreads = 2;
+
+  CUTEST_PARAMETRIZE(backend, test_reserve_backend, CUTEST_DATA(
+      {0}, // geometric growth
+      {1000}, // a reserve too small
+      {10 * 1000 * 1000}, // a reserve for everything
+  ));
+}
+
+
+static int check_chunks(blosc2_schunk *schunk, int nchunks) {
+  int32_t nbytes = CHUNKSIZE * sizeof(int32_t);
+  int32_t *rec_buffer = malloc(nbytes);
+  int rc = schunk->nchunks == nchunks ? 0 : -1;
+  for (int i = 0; rc == 0 && i < nchunks; ++i) {
+    int32_t dbytes = blosc2_schunk_decompress_chunk(schunk, i, rec_buffer, nbytes);
+    if (dbytes != nbytes) {
+      rc = -1;
+    }
+    for (int j = 0; rc == 0 && j < CHUNKSIZE; ++j) {
+      if (rec_buffer[j] != j * (i + 1)) {
+        rc = -1;
+      }
+    }
+  }
+  free(rec_buffer);
+  return rc;
+}
+
+
+CUTEST_TEST_TEST(frame_reserve) {
+  CUTEST_GET_PARAMETER(backend, test_reserve_backend);
+
+  int32_t nbytes = CHUNKSIZE * sizeof(int32_t);
+  int32_t *data_buffer = malloc(nbytes);
+
+  blosc2_storage storage = BLOSC2_STORAGE_DEFAULTS;
+  storage.cparams = &data->cparams;
+  storage.dparams = &data->dparams;
+  storage.contiguous = true;
+  storage.cframe_reserve = backend.cframe_reserve;
+  blosc2_schunk *schunk = blosc2_schunk_new(&storage);
+  CUTEST_ASSERT("Error creating the super-chunk", schunk != NULL);
+
+  for (int i = 0; i < NCHUNKS; ++i) {
+    for (int j = 0; j < CHUNKSIZE; ++j) {
+      data_buffer[j] = j * (i + 1);
+    }
+    int nchunks = blosc2_schunk_append_buffer(schunk, data_buffer, nbytes);
+    CUTEST_ASSERT("Error during compression", nchunks == i + 1);
+  }
+  free(data_buffer);
+  CUTEST_ASSERT("Data are not equal", check_chunks(schunk, NCHUNKS) == 0);
+
+  // The serialized frame has just the length of the frame
+  uint8_t *cframe;
+  bool cframe_needs_free;
+  int64_t cframe_len = blosc2_schunk_to_buffer(schunk, &cframe, &cframe_needs_free);
+  CUTEST_ASSERT("Error serializing the super-chunk", cframe_len > 0);
+  CUTEST_ASSERT("Bad length of the frame", cframe_len == blosc2_schunk_frame_len(schunk));
+  blosc2_schunk *schunk2 = blosc2_schunk_from_buffer(cframe, cframe_len, true);
+  CUTEST_ASSERT("Error deserializing the super-chunk", schunk2 != NULL);
+  CUTEST_ASSERT("Data are not equal", check_chunks(schunk2, NCHUNKS) == 0);
+
+  // The copy can be added chunks too
+  data_buffer = malloc(nbytes);
+  for (int j = 0; j < CHUNKSIZE; ++j) {
+    data_buffer[j] = j * (NCHUNKS + 1);
+  }
+  int nchunks = blosc2_schunk_append_buffer(schunk2, data_buffer, nbytes);
+  CUTEST_ASSERT("Error during compression", nchunks == NCHUNKS + 1);
+  CUTEST_ASSERT("Data are not equal", check_chunks(schunk2, NCHUNKS + 1) == 0);
+  free(data_buffer);
+
+  blosc2_schunk_free(schunk2);
+  if (cframe_needs_free) {
+    free(cframe);
+  }
+  blosc2_schunk_free(schunk);
+
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(frame_reserve) {
+  blosc_destroy();
+}
+
+
+int main() {
+  CUTEST_TEST_RUN(frame_reserve)
+}
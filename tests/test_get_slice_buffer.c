@@ -0,0 +1,155 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Test getting and setting slices of items of a super-chunk.
+*/
+
+#include "test_common.h"
+#include "cutest.h"
+
+#define CHUNKITEMS (50 * 1000)
+#define NCHUNKS 7
+#define NITEMS ((NCHUNKS - 1) * CHUNKITEMS + CHUNKITEMS / 3)
+#define NSLICES 7
+
+
+typedef struct {
+  bool contiguous;
+  char *urlpath;
+} test_slice_backend;
+
+CUTEST_TEST_DATA(get_slice_buffer) {
+  int32_t *data;
+};
+
+CUTEST_TEST_SETUP(get_slice_buffer) {
+  blosc_init();
+  data->data = malloc(NITEMS * sizeof(int32_t));
+
+  CUTEST_PARAMETRIZE(nthreads, int16_t, CUTEST_DATA(
+      1,
+      4,
+  ));
+  CUTEST_PARAMETRIZE(backend, test_slice_backend, CUTEST_DATA(
+      {false, NULL},  // memory - schunk
+      {true, NULL},  // memory - cframe
+      {true, "test_get_slice_buffer.b2frame"},  // disk - cframe
+      {false, "test_get_slice_buffer_s.b2frame"},  // disk - sframe
+  ));
+}
+
+
+CUTEST_TEST_TEST(get_slice_buffer) {
+  CUTEST_GET_PARAMETER(nthreads, int16_t);
+  CUTEST_GET_PARAMETER(backend, test_slice_backend);
+
+  int32_t *items = data->data;
+  for (int i = 0; i < NITEMS; i++) {
+    items[i] = i / 3 + (i % 1013) * 7 % 11;
+  }
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = sizeof(int32_t);
+  cparams.blocksize = 16 * 1024;
+  cparams.nthreads = nthreads;
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  dparams.nthreads = nthreads;
+  blosc2_storage storage = {.cparams=&cparams, .dparams=&dparams,
+                            .urlpath=backend.urlpath, .contiguous=backend.contiguous};
+  blosc2_remove_urlpath(backend.urlpath);
+  blosc2_schunk *schunk = blosc2_schunk_new(&storage);
+  for (int nchunk = 0; nchunk < NCHUNKS; nchunk++) {
+    int32_t nitems = nchunk < NCHUNKS - 1 ? CHUNKITEMS : NITEMS - nchunk * CHUNKITEMS;
+    int rc = blosc2_schunk_append_buffer(schunk, items + nchunk * CHUNKITEMS, nitems * sizeof(int32_t));
+    CUTEST_ASSERT("Error appending a chunk", rc == nchunk + 1);
+  }
+
+  // Whole super-chunk, within a chunk, across chunks, up to the (smaller) last chunk...
+  int64_t slices[NSLICES][2] = {
+      {0, NITEMS},
+      {10, 20},
+      {CHUNKITEMS, 2 * CHUNKITEMS},
+      {CHUNKITEMS - 7, 4 * CHUNKITEMS + 3},
+      {3 * CHUNKITEMS + 100, NITEMS},
+      {NITEMS - 1, NITEMS},
+      {5, 5},
+  };
+  int32_t *buffer = malloc(NITEMS * sizeof(int32_t));
+  for (int i = 0; i < NSLICES; i++) {
+    int64_t start = slices[i][0];
+    int64_t stop = slices[i][1];
+    memset(buffer, 0xff, NITEMS * sizeof(int32_t));
+    CUTEST_ASSERT("Error getting a slice", blosc2_schunk_get_slice_buffer(schunk, start, stop, buffer) == 0);
+    CUTEST_ASSERT("Data are not equal", memcmp(buffer, items + start, (stop - start) * sizeof(int32_t)) == 0);
+    CUTEST_ASSERT("Items written out of the slice", stop == NITEMS || buffer[stop - start] == (int32_t)0xffffffff);
+  }
+
+  // Setting slices changes just their items
+  for (int i = 0; i < NSLICES; i++) {
+    int64_t start = slices[NSLICES - 1 - i][0];
+    int64_t stop = slices[NSLICES - 1 - i][1];
+    for (int64_t j = start; j < stop; j++) {
+      items[j] = (int32_t)(j * 3 + i);
+    }
+    CUTEST_ASSERT("Error setting a slice", blosc2_schunk_set_slice_buffer(schunk, start, stop, items + start) == 0);
+  }
+  CUTEST_ASSERT("The super-chunk has changed its shape",
+                schunk->nchunks == NCHUNKS && schunk->nbytes == NITEMS * (int64_t)sizeof(int32_t));
+  for (int nchunk = 0; nchunk < NCHUNKS; nchunk++) {
+    int32_t nbytes = (nchunk < NCHUNKS - 1 ? CHUNKITEMS : NITEMS - nchunk * CHUNKITEMS) * sizeof(int32_t);
+    int dsize = blosc2_schunk_decompress_chunk(schunk, nchunk, buffer, CHUNKITEMS * sizeof(int32_t));
+    CUTEST_ASSERT("Error decompressing a chunk", dsize == nbytes);
+    CUTEST_ASSERT("Data are not equal", memcmp(buffer, items + nchunk * CHUNKITEMS, nbytes) == 0);
+  }
+
+  // Incompressible data replacing whole chunks (which are then stored memcpyed)
+  uint32_t state = 12345;
+  for (int64_t j = CHUNKITEMS; j < 3 * CHUNKITEMS; j++) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    items[j] = (int32_t)state;
+  }
+  CUTEST_ASSERT("Error setting a slice",
+                blosc2_schunk_set_slice_buffer(schunk, CHUNKITEMS, 3 * CHUNKITEMS, items + CHUNKITEMS) == 0);
+  memset(buffer, 0, NITEMS * sizeof(int32_t));
+  CUTEST_ASSERT("Error getting a slice", blosc2_schunk_get_slice_buffer(schunk, 0, NITEMS, buffer) == 0);
+  CUTEST_ASSERT("Data are not equal", memcmp(buffer, items, NITEMS * sizeof(int32_t)) == 0);
+  if (backend.urlpath != NULL) {
+    // The items set are read back from disk too
+    blosc2_schunk_free(schunk);
+    schunk = blosc2_schunk_open(backend.urlpath);
+    CUTEST_ASSERT("Error opening the super-chunk", schunk != NULL);
+    memset(buffer, 0, NITEMS * sizeof(int32_t));
+    CUTEST_ASSERT("Error getting a slice", blosc2_schunk_get_slice_buffer(schunk, 0, NITEMS, buffer) == 0);
+    CUTEST_ASSERT("Data are not equal", memcmp(buffer, items, NITEMS * sizeof(int32_t)) == 0);
+    int dsize = blosc2_schunk_decompress_chunk(schunk, 2, buffer, CHUNKITEMS * sizeof(int32_t));
+    CUTEST_ASSERT("Error decompressing a chunk", dsize == CHUNKITEMS * (int)sizeof(int32_t));
+    CUTEST_ASSERT("Data are not equal", memcmp(buffer, items + 2 * CHUNKITEMS, dsize) == 0);
+  }
+
+  // Errors
+  CUTEST_ASSERT("Slice out of bounds not detected",
+                blosc2_schunk_get_slice_buffer(schunk, 0, NITEMS + 1, buffer) < 0);
+  CUTEST_ASSERT("Reversed slice not detected",
+                blosc2_schunk_get_slice_buffer(schunk, 10, 5, buffer) < 0);
+  CUTEST_ASSERT("Slice out of bounds not detected",
+                blosc2_schunk_set_slice_buffer(schunk, -1, 10, buffer) < 0);
+
+  free(buffer);
+  blosc2_schunk_free(schunk);
+  blosc2_remove_urlpath(backend.urlpath);
+
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(get_slice_buffer) {
+  free(data->data);
+  blosc_destroy();
+}
+
+
+int main() {
+  CUTEST_TEST_RUN(get_slice_buffer)
+}
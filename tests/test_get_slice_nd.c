@@ -0,0 +1,233 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Test getting n-d slices out of super-chunks with a caterva metalayer.
+*/
+
+#include "test_common.h"
+#include "cutest.h"
+
+#define NSLICES 6
+
+
+typedef struct {
+  int8_t ndim;
+  int64_t shape[BLOSC2_MAX_DIM];
+  int32_t chunkshape[BLOSC2_MAX_DIM];
+  int32_t blockshape[BLOSC2_MAX_DIM];
+} test_slice_nd_geometry;
+
+typedef struct {
+  bool contiguous;
+  char *urlpath;
+} test_slice_nd_backend;
+
+CUTEST_TEST_DATA(get_slice_nd) {
+  void *unused;
+};
+
+CUTEST_TEST_SETUP(get_slice_nd) {
+  blosc_init();
+
+  CUTEST_PARAMETRIZE(nthreads, int16_t, CUTEST_DATA(
+      1,
+      4,
+  ));
+  CUTEST_PARAMETRIZE(geometry, test_slice_nd_geometry, CUTEST_DATA(
+      {1, {1000}, {300}, {64}},
+      {2, {100, 80}, {32, 25}, {8, 10}},
+      {3, {50, 37, 23}, {20, 15, 10}, {7, 6, 4}},
+  ));
+  CUTEST_PARAMETRIZE(backend, test_slice_nd_backend, CUTEST_DATA(
+      {false, NULL},  // memory - schunk
+      {true, NULL},  // memory - cframe
+      {true, "test_get_slice_nd.b2frame"},  // disk - cframe
+      {false, "test_get_slice_nd_s.b2frame"},  // disk - sframe
+  ));
+}
+
+
+/* Serialize the caterva metalayer (msgpack with big-endian integers) */
+static int32_t serialize_meta(test_slice_nd_geometry *geometry, uint8_t *smeta) {
+  int8_t ndim = geometry->ndim;
+  uint8_t *pmeta = smeta;
+  *pmeta++ = 0x90 + 5;  // array with version, ndim, shape, chunkshape, blockshape
+  *pmeta++ = 0;  // version
+  *pmeta++ = (uint8_t)ndim;
+  *pmeta++ = (uint8_t)(0x90 + ndim);
+  for (int i = 0; i < ndim; i++) {
+    *pmeta++ = 0xd3;  // int64
+    for (int j = 7; j >= 0; j--) {
+      *pmeta++ = (uint8_t)(geometry->shape[i] >> (8 * j));
+    }
+  }
+  int32_t *shapes[2] = {geometry->chunkshape, geometry->blockshape};
+  for (int k = 0; k < 2; k++) {
+    *pmeta++ = (uint8_t)(0x90 + ndim);
+    for (int i = 0; i < ndim; i++) {
+      *pmeta++ = 0xd2;  // int32
+      for (int j = 3; j >= 0; j--) {
+        *pmeta++ = (uint8_t)(shapes[k][i] >> (8 * j));
+      }
+    }
+  }
+  return (int32_t)(pmeta - smeta);
+}
+
+
+/* The item of the array at `index`, or 0 for the padding */
+static int32_t array_item(test_slice_nd_geometry *geometry, int64_t *index) {
+  int32_t item = 1;
+  for (int i = 0; i < geometry->ndim; i++) {
+    if (index[i] >= geometry->shape[i]) {
+      return 0;
+    }
+    item = item * (int32_t)geometry->shape[i] + (int32_t)index[i];
+  }
+  return item;
+}
+
+
+CUTEST_TEST_TEST(get_slice_nd) {
+  CUTEST_GET_PARAMETER(nthreads, int16_t);
+  CUTEST_GET_PARAMETER(geometry, test_slice_nd_geometry);
+  CUTEST_GET_PARAMETER(backend, test_slice_nd_backend);
+
+  int8_t ndim = geometry.ndim;
+  int32_t typesize = sizeof(int32_t);
+  int64_t extchunkshape[BLOSC2_MAX_DIM];
+  int64_t grid_nblocks[BLOSC2_MAX_DIM];
+  int64_t grid_nchunks[BLOSC2_MAX_DIM];
+  int32_t block_nitems = 1;
+  int32_t chunk_nitems = 1;
+  int nchunks = 1;
+  for (int i = 0; i < ndim; i++) {
+    grid_nblocks[i] = (geometry.chunkshape[i] - 1) / geometry.blockshape[i] + 1;
+    extchunkshape[i] = grid_nblocks[i] * geometry.blockshape[i];
+    grid_nchunks[i] = (geometry.shape[i] - 1) / geometry.chunkshape[i] + 1;
+    block_nitems *= geometry.blockshape[i];
+    chunk_nitems *= (int32_t)extchunkshape[i];
+    nchunks *= (int)grid_nchunks[i];
+  }
+
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = typesize;
+  cparams.blocksize = block_nitems * typesize;
+  cparams.nthreads = nthreads;
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  dparams.nthreads = nthreads;
+  blosc2_storage storage = {.cparams=&cparams, .dparams=&dparams,
+                            .urlpath=backend.urlpath, .contiguous=backend.contiguous};
+  blosc2_remove_urlpath(backend.urlpath);
+  blosc2_schunk *schunk = blosc2_schunk_new(&storage);
+  uint8_t smeta[128];
+  int32_t smeta_len = serialize_meta(&geometry, smeta);
+  CUTEST_ASSERT("Error adding the metalayer", blosc2_meta_add(schunk, "caterva", smeta, smeta_len) >= 0);
+
+  // Every chunk is a C-order grid of blocks, and every block is in C order
+  int32_t *chunk_data = malloc(chunk_nitems * typesize);
+  for (int nchunk = 0; nchunk < nchunks; nchunk++) {
+    int64_t chunk_index[BLOSC2_MAX_DIM];
+    int64_t rest = nchunk;
+    for (int i = ndim - 1; i >= 0; i--) {
+      chunk_index[i] = rest % grid_nchunks[i];
+      rest /= grid_nchunks[i];
+    }
+    for (int32_t j = 0; j < chunk_nitems; j++) {
+      int64_t nblock = j / block_nitems;
+      int64_t nitem = j % block_nitems;
+      int64_t index[BLOSC2_MAX_DIM];
+      bool padding = false;
+      for (int i = ndim - 1; i >= 0; i--) {
+        int64_t local = (nblock % grid_nblocks[i]) * geometry.blockshape[i] + nitem % geometry.blockshape[i];
+        nblock /= grid_nblocks[i];
+        nitem /= geometry.blockshape[i];
+        padding |= local >= geometry.chunkshape[i];
+        index[i] = chunk_index[i] * geometry.chunkshape[i] + local;
+      }
+      chunk_data[j] = padding ? 0 : array_item(&geometry, index);
+    }
+    int rc = blosc2_schunk_append_buffer(schunk, chunk_data, chunk_nitems * typesize);
+    CUTEST_ASSERT("Error appending a chunk", rc == nchunk + 1);
+  }
+  free(chunk_data);
+
+  // Fractions of the shape for the slices: whole array, a few items, across chunks...
+  double slices[NSLICES][2] = {
+      {0., 1.},
+      {0.1, 0.12},
+      {0.35, 0.95},
+      {0.5, 1.},
+      {0.99, 1.},
+      {0.3, 0.3},
+  };
+  for (int s = 0; s < NSLICES; s++) {
+    int64_t start[BLOSC2_MAX_DIM];
+    int64_t stop[BLOSC2_MAX_DIM];
+    int64_t buffershape[BLOSC2_MAX_DIM];
+    int64_t buffer_nitems = 1;
+    for (int i = 0; i < ndim; i++) {
+      start[i] = (int64_t)(slices[s][0] * geometry.shape[i]);
+      stop[i] = (int64_t)(slices[s][1] * geometry.shape[i]);
+      // A larger buffer than the slice, to check the strides
+      buffershape[i] = stop[i] - start[i] + 2;
+      buffer_nitems *= buffershape[i];
+    }
+    int32_t *buffer = malloc(buffer_nitems * typesize);
+    memset(buffer, 0xff, buffer_nitems * typesize);
+    int rc = blosc2_schunk_get_slice_nd(schunk, start, stop, buffer, buffershape, buffer_nitems * typesize);
+    CUTEST_ASSERT("Error getting an n-d slice", rc == 0);
+    for (int64_t j = 0; j < buffer_nitems; j++) {
+      int64_t index[BLOSC2_MAX_DIM];
+      int64_t rest = j;
+      bool in_slice = true;
+      for (int i = ndim - 1; i >= 0; i--) {
+        index[i] = start[i] + rest % buffershape[i];
+        rest /= buffershape[i];
+        in_slice &= index[i] < stop[i];
+      }
+      int32_t expected = in_slice ? array_item(&geometry, index) : (int32_t)0xffffffff;
+      CUTEST_ASSERT("Data are not equal", buffer[j] == expected);
+    }
+    free(buffer);
+  }
+
+  // Errors
+  int64_t start[BLOSC2_MAX_DIM] = {0};
+  int64_t buffershape[BLOSC2_MAX_DIM];
+  int64_t buffer_nitems = 1;
+  for (int i = 0; i < ndim; i++) {
+    buffershape[i] = geometry.shape[i];
+    buffer_nitems *= buffershape[i];
+  }
+  int32_t *buffer = malloc(buffer_nitems * typesize);
+  buffershape[0]++;
+  CUTEST_ASSERT("Slice out of bounds not detected",
+                blosc2_schunk_get_slice_nd(schunk, start, buffershape, buffer, buffershape,
+                                           buffer_nitems * 2 * typesize) < 0);
+  buffershape[0] -= 2;
+  CUTEST_ASSERT("Small buffer shape not detected",
+                blosc2_schunk_get_slice_nd(schunk, start, geometry.shape, buffer, buffershape,
+                                           buffer_nitems * typesize) < 0);
+  buffershape[0]++;
+  CUTEST_ASSERT("Small buffer not detected",
+                blosc2_schunk_get_slice_nd(schunk, start, geometry.shape, buffer, buffershape,
+                                           buffer_nitems * typesize - 1) < 0);
+  free(buffer);
+
+  blosc2_schunk_free(schunk);
+  blosc2_remove_urlpath(backend.urlpath);
+
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(get_slice_nd) {
+  blosc_destroy();
+}
+
+
+int main() {
+  CUTEST_TEST_RUN(get_slice_nd)
+}
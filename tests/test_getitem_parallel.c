@@ -0,0 +1,130 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Test getitem on contexts with several threads, for chunks in memory and
+  lazy chunks out of a frame on disk.
+*/
+
+#include "test_common.h"
+#include "cutest.h"
+
+#define CHUNKSIZE (1000 * 1000)
+#define BLOCKSIZE (32 * 1024)
+#define NRANGES 8
+
+
+typedef struct {
+  int16_t nthreads;
+  int16_t pool_nthreads;
+} test_getitem_backend;
+
+CUTEST_TEST_DATA(getitem_parallel) {
+  int32_t *data;
+};
+
+CUTEST_TEST_SETUP(getitem_parallel) {
+  blosc_init();
+  data->data = malloc(CHUNKSIZE * sizeof(int32_t));
+  for (int i = 0; i < CHUNKSIZE; i++) {
+    data->data[i] = i / 3 + (i % 1013) * 7 % 11;
+  }
+
+  CUTEST_PARAMETRIZE(backend, test_getitem_backend, CUTEST_DATA(
+      {1, 0},
+      {4, 0},
+      {8, 0},
+      {4, 3},  // with the shared pool
+  ));
+  CUTEST_PARAMETRIZE(filter, uint8_t, CUTEST_DATA(
+      BLOSC_SHUFFLE,
+      BLOSC_DELTA,
+  ));
+  CUTEST_PARAMETRIZE(lazy, bool, CUTEST_DATA(
+      false,
+      true,
+  ));
+}
+
+
+CUTEST_TEST_TEST(getitem_parallel) {
+  CUTEST_GET_PARAMETER(backend, test_getitem_backend);
+  CUTEST_GET_PARAMETER(filter, uint8_t);
+  CUTEST_GET_PARAMETER(lazy, bool);
+
+  CUTEST_ASSERT("Error setting the shared pool", blosc2_set_shared_nthreads(backend.pool_nthreads) >= 0);
+
+  int32_t nbytes = CHUNKSIZE * sizeof(int32_t);
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = sizeof(int32_t);
+  cparams.blocksize = BLOCKSIZE;
+  cparams.filters[BLOSC2_MAX_FILTERS - 1] = filter;
+  cparams.nthreads = backend.nthreads;
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  dparams.nthreads = backend.nthreads;
+  char *urlpath = lazy ? "test_getitem_parallel.b2frame" : NULL;
+  blosc2_storage storage = {.cparams=&cparams, .dparams=&dparams, .urlpath=urlpath, .contiguous=true};
+  blosc2_remove_urlpath(urlpath);
+  blosc2_schunk *schunk = blosc2_schunk_new(&storage);
+  CUTEST_ASSERT("Error appending a chunk", blosc2_schunk_append_buffer(schunk, data->data, nbytes) == 1);
+
+  uint8_t *chunk;
+  bool needs_free;
+  int cbytes = blosc2_schunk_get_lazychunk(schunk, 0, &chunk, &needs_free);
+  CUTEST_ASSERT("Error getting the chunk", cbytes > 0);
+  CUTEST_ASSERT("The chunk is not lazy", !lazy || cbytes < nbytes / 10);
+
+  // Aligned and unaligned ranges, within a block, up to the (leftover) last block...
+  int32_t items_per_block = BLOCKSIZE / sizeof(int32_t);
+  int ranges[NRANGES][2] = {
+      {0, CHUNKSIZE},
+      {10, items_per_block - 10},
+      {0, 10 * items_per_block},
+      {3 * items_per_block, 30 * items_per_block},
+      {100, 100 + 20 * items_per_block + 7},
+      {items_per_block + 5, items_per_block + 10},
+      {CHUNKSIZE - 3 * items_per_block - 11, CHUNKSIZE},
+      {CHUNKSIZE - 1, CHUNKSIZE},
+  };
+  int32_t *dest = malloc(nbytes);
+  for (int i = 0; i < NRANGES; i++) {
+    int start = ranges[i][0];
+    int nitems = ranges[i][1] - ranges[i][0];
+    memset(dest, 0xff, nbytes);
+    int dsize = blosc2_getitem_ctx(schunk->dctx, chunk, cbytes, start, nitems, dest, nbytes);
+    CUTEST_ASSERT("Error in getitem", dsize == nitems * (int)sizeof(int32_t));
+    if (filter == BLOSC_DELTA && start + nitems > items_per_block) {
+      // getitem only gets DELTA chunks right in the first block
+      continue;
+    }
+    CUTEST_ASSERT("Data are not equal", memcmp(dest, data->data + start, dsize) == 0);
+    CUTEST_ASSERT("Items written out of range", dest[nitems] == (int32_t)0xffffffff || nitems == CHUNKSIZE);
+  }
+
+  // Errors are returned as before
+  CUTEST_ASSERT("Small destination not detected",
+                blosc2_getitem_ctx(schunk->dctx, chunk, cbytes, 0, CHUNKSIZE, dest, nbytes - 4) < 0);
+  CUTEST_ASSERT("Out of bounds not detected",
+                blosc2_getitem_ctx(schunk->dctx, chunk, cbytes, 10, CHUNKSIZE, dest, nbytes) < 0);
+
+  if (needs_free) {
+    free(chunk);
+  }
+  free(dest);
+  blosc2_schunk_free(schunk);
+  blosc2_remove_urlpath(urlpath);
+  CUTEST_ASSERT("Error releasing the shared pool", blosc2_set_shared_nthreads(0) == backend.pool_nthreads);
+
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(getitem_parallel) {
+  free(data->data);
+  blosc_destroy();
+}
+
+
+int main() {
+  CUTEST_TEST_RUN(getitem_parallel)
+}
@@ -0,0 +1,124 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Test several threads calling the non-contextual API at once.
+*/
+
+#include "test_common.h"
+#include "cutest.h"
+#if !defined(_WIN32)
+#include <pthread.h>
+#endif
+
+#define CHUNKSIZE (100 * 1000)
+#define NCALLERS 4
+#define NROUNDS 20
+
+
+typedef struct {
+  int16_t nthreads;
+  int doshuffle;
+} test_callers_backend;
+
+CUTEST_TEST_DATA(global_callers) {
+  int32_t *data;
+};
+
+CUTEST_TEST_SETUP(global_callers) {
+  blosc_init();
+  data->data = malloc(CHUNKSIZE * sizeof(int32_t));
+  for (int i = 0; i < CHUNKSIZE; i++) {
+    data->data[i] = i / 3 + (i * 7919) % 11;
+  }
+
+  CUTEST_PARAMETRIZE(backend, test_callers_backend, CUTEST_DATA(
+      {1, BLOSC_SHUFFLE},
+      {2, BLOSC_SHUFFLE},
+      {4, BLOSC_BITSHUFFLE},
+  ));
+}
+
+
+/* Compress and decompress with blosc_compress() and blosc_decompress() */
+static int roundtrip(const test_callers_backend *backend, const int32_t *data, int nrounds) {
+  int32_t nbytes = CHUNKSIZE * sizeof(int32_t);
+  uint8_t *chunk = malloc(nbytes + BLOSC_MAX_OVERHEAD);
+  int32_t *dest = malloc(nbytes);
+  int rc = 0;
+  for (int n = 0; n < nrounds; n++) {
+    int csize = blosc_compress(5, backend->doshuffle, sizeof(int32_t), nbytes, data,
+                               chunk, nbytes + BLOSC_MAX_OVERHEAD);
+    if (csize <= 0 || csize >= nbytes) {
+      rc = -1;
+      break;
+    }
+    int dsize = blosc_decompress(chunk, dest, nbytes);
+    if (dsize != nbytes || memcmp(data, dest, nbytes) != 0) {
+      rc = -1;
+      break;
+    }
+  }
+  free(chunk);
+  free(dest);
+  return rc;
+}
+
+
+#if !defined(_WIN32)
+typedef struct {
+  const test_callers_backend *backend;
+  const int32_t *data;
+  int rc;
+} test_caller;
+
+static void *caller(void *arg) {
+  test_caller *my = (test_caller *) arg;
+  my->rc = roundtrip(my->backend, my->data, NROUNDS);
+  return NULL;
+}
+#endif
+
+
+CUTEST_TEST_TEST(global_callers) {
+  CUTEST_GET_PARAMETER(backend, test_callers_backend);
+
+  blosc_set_nthreads(backend.nthreads);
+  CUTEST_ASSERT("Data are not equal", roundtrip(&backend, data->data, NROUNDS) == 0);
+
+#if !defined(_WIN32)
+  // Several threads (de)compressing at once, each with a context of its own
+  pthread_t threads[NCALLERS];
+  test_caller callers[NCALLERS];
+  for (int i = 0; i < NCALLERS; i++) {
+    callers[i].backend = &backend;
+    callers[i].data = data->data;
+    callers[i].rc = -1;
+    CUTEST_ASSERT("Error creating a thread", pthread_create(&threads[i], NULL, caller, &callers[i]) == 0);
+  }
+  for (int i = 0; i < NCALLERS; i++) {
+    pthread_join(threads[i], NULL);
+    CUTEST_ASSERT("Data are not equal", callers[i].rc == 0);
+  }
+#endif
+
+  // The contexts left behind by the callers pick a new number of threads up
+  blosc_set_nthreads(3);
+  CUTEST_ASSERT("Data are not equal", roundtrip(&backend, data->data, 2) == 0);
+  CUTEST_ASSERT("Error releasing resources", blosc_free_resources() == 0);
+  CUTEST_ASSERT("Data are not equal", roundtrip(&backend, data->data, 2) == 0);
+
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(global_callers) {
+  free(data->data);
+  blosc_set_nthreads(1);
+  blosc_destroy();
+}
+
+
+int main() {
+  CUTEST_TEST_RUN(global_callers)
+}
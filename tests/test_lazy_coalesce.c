@@ -0,0 +1,232 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Test that neighbouring blocks of lazy chunks are read at once.
+*/
+
+#include "test_common.h"
+#include "cutest.h"
+
+#define CHUNKSIZE (50 * 1000)
+#define NCHUNKS 5
+#define BLOCKSIZE (8 * 1024)
+#define NBLOCKS ((CHUNKSIZE * (int)sizeof(int32_t) + BLOCKSIZE - 1) / BLOCKSIZE)
+
+
+/* A plugin wrapping stdio which counts the reads */
+typedef struct {
+  int32_t nreads;
+} test_coalesce_params;
+
+typedef struct {
+  blosc2_stdio_file *bfile;
+  test_coalesce_params *params;
+} test_file;
+
+void* test_open(const char *urlpath, const char *mode, void *params) {
+  void *bfile = blosc2_stdio_open(urlpath, mode, NULL);
+  if (bfile == NULL) {
+    return NULL;
+  }
+  test_file *my = malloc(sizeof(test_file));
+  my->params = params;
+  my->bfile = bfile;
+  return my;
+}
+
+int test_close(void *stream) {
+  test_file *my = (test_file *) stream;
+  int err = blosc2_stdio_close(my->bfile);
+  free(my);
+  return err;
+}
+
+int64_t test_tell(void *stream) {
+  return blosc2_stdio_tell(((test_file *) stream)->bfile);
+}
+
+int test_seek(void *stream, int64_t offset, int whence) {
+  return blosc2_stdio_seek(((test_file *) stream)->bfile, offset, whence);
+}
+
+int64_t test_write(const void *ptr, int64_t size, int64_t nitems, void *stream) {
+  return blosc2_stdio_write(ptr, size, nitems, ((test_file *) stream)->bfile);
+}
+
+int64_t test_read(void *ptr, int64_t size, int64_t nitems, void *stream) {
+  test_file *my = (test_file *) stream;
+  my->params->nreads++;
+  return blosc2_stdio_read(ptr, size, nitems, my->bfile);
+}
+
+int test_truncate(void *stream, int64_t size) {
+  return blosc2_stdio_truncate(((test_file *) stream)->bfile, size);
+}
+
+int64_t test_read_at(void *stream, int64_t offset, int64_t size, void *ptr) {
+  test_file *my = (test_file *) stream;
+  my->params->nreads++;
+  return blosc2_stdio_read_at(my->bfile, offset, size, ptr);
+}
+
+
+typedef struct {
+  bool contiguous;
+  char *urlpath;
+  bool read_at;
+  int nthreads;
+} test_coalesce_backend;
+
+CUTEST_TEST_DATA(lazy_coalesce) {
+  blosc2_cparams cparams;
+  blosc2_dparams dparams;
+};
+
+CUTEST_TEST_SETUP(lazy_coalesce) {
+  blosc_init();
+
+  data->cparams = BLOSC2_CPARAMS_DEFAULTS;
+  data->cparams.typesize = sizeof(int32_t);
+  data->cparams.compcode = BLOSC_BLOSCLZ;
+  data->cparams.clevel = 5;
+  data->cparams.blocksize = BLOCKSIZE;
+  data->cparams.nthreads = 2;
+  data->dparams = BLOSC2_DPARAMS_DEFAULTS;
+
+  CUTEST_PARAMETRIZE(backend, test_coalesce_backend, CUTEST_DATA(
+      {true, "test_lazy_coalesce.b2frame", true, 1}, // disk - cframe
+      {true, "test_lazy_coalesce.b2frame", false, 1}, // disk - cframe, seek + read
+      {true, "test_lazy_coalesce.b2frame", true, 4}, // disk - cframe
+      {false, "test_lazy_coalesce_s.b2frame", true, 1}, // disk - sframe
+      {false, "test_lazy_coalesce_s.b2frame", false, 4}, // disk - sframe, seek + read
+  ));
+}
+
+
+/* Decompress all the chunks and return the number of reads (or -1 if data are wrong) */
+static int count_reads(blosc2_schunk *schunk, test_coalesce_params *params, bool *maskout) {
+  int32_t nbytes = CHUNKSIZE * sizeof(int32_t);
+  int32_t *rec_buffer = malloc(nbytes);
+  int32_t block_nitems = BLOCKSIZE / sizeof(int32_t);
+  int rc = 0;
+
+  params->nreads = 0;
+  for (int i = 0; rc == 0 && i < NCHUNKS; ++i) {
+    if (maskout != NULL) {
+      blosc2_set_maskout(schunk->dctx, maskout, NBLOCKS);
+    }
+    int32_t dbytes = blosc2_schunk_decompress_chunk(schunk, i, rec_buffer, nbytes);
+    if (dbytes != nbytes) {
+      rc = -1;
+    }
+    for (int j = 0; rc == 0 && j < CHUNKSIZE; ++j) {
+      if (maskout != NULL && maskout[j / block_nitems]) {
+        continue;
+      }
+      if (rec_buffer[j] != j * (i + 1)) {
+        rc = -1;
+      }
+    }
+  }
+  free(rec_buffer);
+  return rc < 0 ? rc : params->nreads;
+}
+
+
+CUTEST_TEST_TEST(lazy_coalesce) {
+  CUTEST_GET_PARAMETER(backend, test_coalesce_backend);
+
+  blosc2_io_cb io_cb = {0};
+  io_cb.id = backend.read_at ? 172 : 173;
+  io_cb.open = (blosc2_open_cb) test_open;
+  io_cb.close = (blosc2_close_cb) test_close;
+  io_cb.tell = (blosc2_tell_cb) test_tell;
+  io_cb.seek = (blosc2_seek_cb) test_seek;
+  io_cb.write = (blosc2_write_cb) test_write;
+  io_cb.read = (blosc2_read_cb) test_read;
+  io_cb.truncate = (blosc2_truncate_cb) test_truncate;
+  if (backend.read_at) {
+    io_cb.read_at = (blosc2_read_at_cb) test_read_at;
+  }
+  blosc2_register_io_cb(&io_cb);
+
+  blosc2_remove_urlpath(backend.urlpath);
+
+  int32_t nbytes = CHUNKSIZE * sizeof(int32_t);
+  int32_t *data_buffer = malloc(nbytes);
+
+  test_coalesce_params params = {0};
+  blosc2_io io = {.id = io_cb.id, .params = &params};
+  data->dparams.nthreads = backend.nthreads;
+  blosc2_storage storage = BLOSC2_STORAGE_DEFAULTS;
+  storage.cparams = &data->cparams;
+  storage.dparams = &data->dparams;
+  storage.contiguous = backend.contiguous;
+  storage.urlpath = backend.urlpath;
+  storage.io = &io;
+  blosc2_schunk *schunk = blosc2_schunk_new(&storage);
+  CUTEST_ASSERT("Error creating the super-chunk", schunk != NULL);
+
+  for (int i = 0; i < NCHUNKS; ++i) {
+    for (int j = 0; j < CHUNKSIZE; ++j) {
+      data_buffer[j] = j * (i + 1);
+    }
+    int nchunks = blosc2_schunk_append_buffer(schunk, data_buffer, nbytes);
+    CUTEST_ASSERT("Error during compression", nchunks == i + 1);
+  }
+  free(data_buffer);
+
+  // Every other block is masked out
+  bool maskout[NBLOCKS];
+  for (int j = 0; j < NBLOCKS; ++j) {
+    maskout[j] = j % 2 == 1;
+  }
+  // Reads other than the ones of the blocks (e.g. of the chunks) are counted too,
+  // so just check for the differences (the counts are not reliable with several threads)
+  bool exact = backend.nthreads == 1;
+  schunk->storage->lazy_max_read = -1;
+  int one_by_one = count_reads(schunk, &params, NULL);
+  CUTEST_ASSERT("Data are not equal", one_by_one > 0);
+  int masked_one_by_one = count_reads(schunk, &params, maskout);
+  CUTEST_ASSERT("Data are not equal", masked_one_by_one > 0);
+  CUTEST_ASSERT("Masked out blocks should not be read", !exact ||
+                one_by_one - masked_one_by_one == NCHUNKS * (NBLOCKS / 2));
+
+  // The blocks of each chunk are read at once
+  schunk->storage->lazy_max_read = 0;
+  int coalesced = count_reads(schunk, &params, NULL);
+  CUTEST_ASSERT("Data are not equal", coalesced > 0);
+  CUTEST_ASSERT("Blocks are not read at once", !exact || one_by_one - coalesced == NCHUNKS * (NBLOCKS - 1));
+
+  // Masked out blocks make holes, unless the gap is allowed
+  int masked = count_reads(schunk, &params, maskout);
+  CUTEST_ASSERT("Data are not equal", masked > 0);
+  CUTEST_ASSERT("Holes should not be read", !exact || masked == masked_one_by_one);
+  schunk->storage->lazy_max_gap = BLOCKSIZE * 2;
+  masked = count_reads(schunk, &params, maskout);
+  CUTEST_ASSERT("Data are not equal", masked > 0);
+  CUTEST_ASSERT("Small holes should be read", !exact || masked == coalesced);
+
+  // Reads are limited in size
+  schunk->storage->lazy_max_gap = 0;
+  schunk->storage->lazy_max_read = BLOCKSIZE * 4;
+  int limited = count_reads(schunk, &params, NULL);
+  CUTEST_ASSERT("Data are not equal", limited > 0);
+  CUTEST_ASSERT("Reads are not limited in size", !exact || (limited > coalesced && limited < one_by_one));
+
+  blosc2_schunk_free(schunk);
+  blosc2_remove_urlpath(backend.urlpath);
+
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(lazy_coalesce) {
+  blosc_destroy();
+}
+
+
+int main() {
+  CUTEST_TEST_RUN(lazy_coalesce)
+}
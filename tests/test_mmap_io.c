@@ -0,0 +1,139 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+*/
+
+#include "test_common.h"
+#include "cutest.h"
+
+#define CHUNKSIZE (5 * 1000)
+#define NCHUNKS 10
+
+
+typedef struct {
+  bool contiguous;
+  char *urlpath;
+  int access;
+}test_mmap_backend;
+
+CUTEST_TEST_DATA(mmap_io) {
+  blosc2_cparams cparams;
+};
+
+CUTEST_TEST_SETUP(mmap_io) {
+  blosc_init();
+
+  data->cparams = BLOSC2_CPARAMS_DEFAULTS;
+  data->cparams.typesize = sizeof(int32_t);
+  data->cparams.compcode = BLOSC_BLOSCLZ;
+  data->cparams.clevel = 9;
+  data->cparams.nthreads = 2;
+
+  CUTEST_PARAMETRIZE(backend, test_mmap_backend, CUTEST_DATA(
+      {true, "test_mmap_io.b2frame", BLOSC2_MMAP_ACCESS_NORMAL}, // disk - cframe
+      {true, "test_mmap_io.b2frame", BLOSC2_MMAP_ACCESS_RANDOM}, // disk - cframe
+      {false, "test_mmap_io_s.b2frame", BLOSC2_MMAP_ACCESS_NORMAL}, // disk - sframe
+      {false, "test_mmap_io_s.b2frame", BLOSC2_MMAP_ACCESS_SEQUENTIAL}, // disk - sframe
+  ));
+}
+
+
+static int check_chunk(blosc2_schunk *schunk, int nchunk, int value) {
+  int32_t nbytes = CHUNKSIZE * sizeof(int32_t);
+  int32_t rec_buffer[CHUNKSIZE];
+
+  int32_t dbytes = blosc2_schunk_decompress_chunk(schunk, nchunk, rec_buffer, nbytes);
+  if (dbytes != nbytes) {
+    return -1;
+  }
+  for (int j = 0; j < CHUNKSIZE; ++j) {
+    if (rec_buffer[j] != j + value) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+
+CUTEST_TEST_TEST(mmap_io) {
+  CUTEST_GET_PARAMETER(backend, test_mmap_backend);
+
+  /* Free resources */
+  blosc2_remove_urlpath(backend.urlpath);
+
+  int32_t nbytes = CHUNKSIZE * sizeof(int32_t);
+  int32_t data_buffer[CHUNKSIZE];
+
+  /* Create a super-chunk container */
+  blosc2_stdio_mmap_params io_params = {.access = backend.access};
+  blosc2_io io = {.id = BLOSC2_IO_FILESYSTEM_MMAP, .params = &io_params};
+  blosc2_storage storage = {.cparams=&data->cparams, .contiguous=backend.contiguous,
+                            .urlpath = backend.urlpath, .io=&io};
+
+  blosc2_schunk *schunk = blosc2_schunk_new(&storage);
+  CUTEST_ASSERT("Error creating the super-chunk", schunk != NULL);
+
+  // The frame grows while appending, so the mappings have to follow it
+  for (int i = 0; i < NCHUNKS; ++i) {
+    for (int j = 0; j < CHUNKSIZE; ++j) {
+      data_buffer[j] = j + i;
+    }
+    int nchunks = blosc2_schunk_append_buffer(schunk, data_buffer, nbytes);
+    CUTEST_ASSERT("Error during compression", nchunks == i + 1);
+    for (int k = 0; k <= i; ++k) {
+      CUTEST_ASSERT("Data are not equal", check_chunk(schunk, k, k) == 0);
+    }
+  }
+
+  // Chunks are handed out as copies, as the mapping goes away when the frame changes
+  uint8_t *chunk;
+  bool needs_free;
+  int cbytes = blosc2_schunk_get_lazychunk(schunk, 1, &chunk, &needs_free);
+  CUTEST_ASSERT("Error getting a lazy chunk", cbytes > 0);
+  CUTEST_ASSERT("Lazy chunks of mapped frames should be copied", needs_free);
+  free(chunk);
+  cbytes = blosc2_schunk_get_chunk(schunk, 1, &chunk, &needs_free);
+  CUTEST_ASSERT("Error getting a chunk", cbytes > 0);
+  CUTEST_ASSERT("Chunks of mapped frames should be copied", needs_free);
+  int nchunks = blosc2_schunk_update_chunk(schunk, 3, chunk, true);
+  CUTEST_ASSERT("Error updating a chunk", nchunks == NCHUNKS);
+  free(chunk);
+  CUTEST_ASSERT("Data are not equal", check_chunk(schunk, 3, 1) == 0);
+
+  // Updating and deleting chunks rewrite (and truncate) the files
+  for (int j = 0; j < CHUNKSIZE; ++j) {
+    data_buffer[j] = j + 100;
+  }
+  uint8_t *new_chunk = malloc(nbytes + BLOSC_MAX_OVERHEAD);
+  cbytes = blosc2_compress_ctx(schunk->cctx, data_buffer, nbytes, new_chunk, nbytes + BLOSC_MAX_OVERHEAD);
+  CUTEST_ASSERT("Error compressing a chunk", cbytes > 0);
+  nchunks = blosc2_schunk_update_chunk(schunk, 2, new_chunk, true);
+  CUTEST_ASSERT("Error updating a chunk", nchunks == NCHUNKS);
+  free(new_chunk);
+  nchunks = blosc2_schunk_delete_chunk(schunk, 0);
+  CUTEST_ASSERT("Error deleting a chunk", nchunks == NCHUNKS - 1);
+  blosc2_schunk_free(schunk);
+
+  // Reopen it
+  schunk = blosc2_schunk_open_udio(backend.urlpath, &io);
+  CUTEST_ASSERT("Error opening the super-chunk", schunk != NULL);
+  CUTEST_ASSERT("Bad number of chunks", schunk->nchunks == NCHUNKS - 1);
+  for (int i = 0; i < NCHUNKS - 1; ++i) {
+    CUTEST_ASSERT("Data are not equal", check_chunk(schunk, i, i == 1 ? 100 : i == 2 ? 1 : i + 1) == 0);
+  }
+
+  blosc2_schunk_free(schunk);
+  blosc2_remove_urlpath(backend.urlpath);
+
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(mmap_io) {
+  blosc_destroy();
+}
+
+
+int main() {
+  CUTEST_TEST_RUN(mmap_io)
+}
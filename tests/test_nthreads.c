@@ -27,10 +27,10 @@ size_t size = 4 * 1000 * 1000;             /* must be divisible by 4 */
 static char *test_compress(void) {
   int16_t nthreads;
 
-  /* Before any blosc_compress() or blosc_decompress() the number of
-     threads must be 1 */
+  /* The BLOSC_NTHREADS variable prevails over blosc_set_nthreads() even before
+     any blosc_compress() or blosc_decompress() */
   nthreads = blosc_get_nthreads();
-  mu_assert("ERROR: get_nthreads (compress, before) incorrect", nthreads == 1);
+  mu_assert("ERROR: get_nthreads (compress, before) incorrect", nthreads == 3);
 
   /* Get a compressed buffer */
   cbytes = blosc_compress(clevel, doshuffle, typesize, size, src,
@@ -0,0 +1,237 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Test the positional (and vectored) read callbacks of the input/output API.
+*/
+
+#include "test_common.h"
+#include "cutest.h"
+
+#define CHUNKSIZE (50 * 1000)
+#define NCHUNKS 10
+#define FILESIZE 1000
+
+
+/* A plugin wrapping stdio which may or may not provide positional reads */
+typedef struct {
+  int32_t read;
+  int32_t read_at;
+} test_read_at_params;
+
+typedef struct {
+  blosc2_stdio_file *bfile;
+  test_read_at_params *params;
+} test_file;
+
+void* test_open(const char *urlpath, const char *mode, void *params) {
+  void *bfile = blosc2_stdio_open(urlpath, mode, NULL);
+  if (bfile == NULL) {
+    return NULL;
+  }
+  test_file *my = malloc(sizeof(test_file));
+  my->params = params;
+  my->bfile = bfile;
+  return my;
+}
+
+int test_close(void *stream) {
+  test_file *my = (test_file *) stream;
+  int err = blosc2_stdio_close(my->bfile);
+  free(my);
+  return err;
+}
+
+int64_t test_tell(void *stream) {
+  return blosc2_stdio_tell(((test_file *) stream)->bfile);
+}
+
+int test_seek(void *stream, int64_t offset, int whence) {
+  return blosc2_stdio_seek(((test_file *) stream)->bfile, offset, whence);
+}
+
+int64_t test_write(const void *ptr, int64_t size, int64_t nitems, void *stream) {
+  return blosc2_stdio_write(ptr, size, nitems, ((test_file *) stream)->bfile);
+}
+
+int64_t test_read(void *ptr, int64_t size, int64_t nitems, void *stream) {
+  test_file *my = (test_file *) stream;
+  my->params->read++;
+  return blosc2_stdio_read(ptr, size, nitems, my->bfile);
+}
+
+int test_truncate(void *stream, int64_t size) {
+  return blosc2_stdio_truncate(((test_file *) stream)->bfile, size);
+}
+
+int64_t test_read_at(void *stream, int64_t offset, int64_t size, void *ptr) {
+  test_file *my = (test_file *) stream;
+  // Several threads may be reading at once, but the count is just checked for being non-zero
+  my->params->read_at++;
+  return blosc2_stdio_read_at(my->bfile, offset, size, ptr);
+}
+
+
+typedef struct {
+  bool contiguous;
+  char *urlpath;
+  bool read_at;
+} test_backend;
+
+CUTEST_TEST_DATA(read_at) {
+  blosc2_cparams cparams;
+  blosc2_dparams dparams;
+};
+
+CUTEST_TEST_SETUP(read_at) {
+  blosc_init();
+
+  data->cparams = BLOSC2_CPARAMS_DEFAULTS;
+  data->cparams.typesize = sizeof(int32_t);
+  data->cparams.compcode = BLOSC_BLOSCLZ;
+  data->cparams.clevel = 5;
+  data->cparams.blocksize = 4 * 1024;
+  data->cparams.nthreads = 4;
+  data->dparams = BLOSC2_DPARAMS_DEFAULTS;
+  data->dparams.nthreads = 4;
+
+  CUTEST_PARAMETRIZE(backend, test_backend, CUTEST_DATA(
+      {true, "test_read_at.b2frame", true}, // disk - cframe
+      {true, "test_read_at.b2frame", false}, // disk - cframe, seek + read
+      {false, "test_read_at_s.b2frame", true}, // disk - sframe
+      {false, "test_read_at_s.b2frame", false}, // disk - sframe, seek + read
+  ));
+}
+
+
+/* The built-in backends */
+static int check_backend(const blosc2_io_cb *io_cb) {
+  char *urlpath = "test_read_at.bin";
+  uint8_t buf[FILESIZE];
+  for (int i = 0; i < FILESIZE; ++i) {
+    buf[i] = (uint8_t) (i * 7);
+  }
+  void *fp = io_cb->open(urlpath, "wb", NULL);
+  if (fp == NULL || io_cb->write(buf, 1, FILESIZE, fp) != FILESIZE) {
+    return -1;
+  }
+  io_cb->close(fp);
+
+  fp = io_cb->open(urlpath, "rb", NULL);
+  if (fp == NULL) {
+    return -1;
+  }
+  uint8_t dest[FILESIZE];
+  int rc = 0;
+  // Positional reads do not move the position of the stream
+  if (io_cb->read_at(fp, 100, 50, dest) != 50 || memcmp(dest, buf + 100, 50) != 0) {
+    rc = -1;
+  }
+  if (io_cb->tell(fp) != 0) {
+    rc = -1;
+  }
+  // Short reads at the end of the file
+  if (io_cb->read_at(fp, FILESIZE - 10, 50, dest) != 10 || memcmp(dest, buf + FILESIZE - 10, 10) != 0) {
+    rc = -1;
+  }
+  if (io_cb->read_at(fp, -1, 10, dest) >= 0) {
+    rc = -1;
+  }
+  // Vectored reads, with both adjacent and scattered segments
+  uint8_t dest2[FILESIZE];
+  blosc2_io_segment segments[] = {
+      {.offset = 0, .size = 10, .ptr = dest},
+      {.offset = 10, .size = 20, .ptr = dest + 10},
+      {.offset = 500, .size = 100, .ptr = dest2},
+      {.offset = 200, .size = 1, .ptr = dest2 + 100},
+  };
+  if (io_cb->readv_at(fp, segments, 4) != 131) {
+    rc = -1;
+  }
+  if (memcmp(dest, buf, 30) != 0 || memcmp(dest2, buf + 500, 100) != 0 || dest2[100] != buf[200]) {
+    rc = -1;
+  }
+  io_cb->close(fp);
+  blosc2_remove_urlpath(urlpath);
+
+  return rc;
+}
+
+
+CUTEST_TEST_TEST(read_at) {
+  CUTEST_GET_PARAMETER(backend, test_backend);
+
+  CUTEST_ASSERT("Bad positional reads with stdio", check_backend(&BLOSC2_IO_CB_DEFAULTS) == 0);
+  CUTEST_ASSERT("Bad positional reads with mmap", check_backend(&BLOSC2_IO_CB_MMAP) == 0);
+  CUTEST_ASSERT("Bad positional reads with direct I/O", check_backend(&BLOSC2_IO_CB_DIRECT) == 0);
+
+  blosc2_io_cb io_cb = {0};
+  io_cb.id = backend.read_at ? 170 : 171;
+  io_cb.open = (blosc2_open_cb) test_open;
+  io_cb.close = (blosc2_close_cb) test_close;
+  io_cb.tell = (blosc2_tell_cb) test_tell;
+  io_cb.seek = (blosc2_seek_cb) test_seek;
+  io_cb.write = (blosc2_write_cb) test_write;
+  io_cb.read = (blosc2_read_cb) test_read;
+  io_cb.truncate = (blosc2_truncate_cb) test_truncate;
+  if (backend.read_at) {
+    io_cb.read_at = (blosc2_read_at_cb) test_read_at;
+  }
+  blosc2_register_io_cb(&io_cb);
+
+  blosc2_remove_urlpath(backend.urlpath);
+
+  int32_t nbytes = CHUNKSIZE * sizeof(int32_t);
+  int32_t *data_buffer = malloc(nbytes);
+  int32_t *rec_buffer = malloc(nbytes);
+
+  test_read_at_params params = {0};
+  blosc2_io io = {.id = io_cb.id, .params = &params};
+  blosc2_storage storage = {.cparams=&data->cparams, .dparams=&data->dparams,
+                            .contiguous=backend.contiguous, .urlpath = backend.urlpath, .io=&io};
+  blosc2_schunk *schunk = blosc2_schunk_new(&storage);
+  CUTEST_ASSERT("Error creating the super-chunk", schunk != NULL);
+
+  for (int i = 0; i < NCHUNKS; ++i) {
+    for (int j = 0; j < CHUNKSIZE; ++j) {
+      data_buffer[j] = j * (i + 1);
+    }
+    int nchunks = blosc2_schunk_append_buffer(schunk, data_buffer, nbytes);
+    CUTEST_ASSERT("Error during compression", nchunks == i + 1);
+  }
+
+  // The (lazy) blocks are read by several threads
+  params.read = 0;
+  params.read_at = 0;
+  for (int i = 0; i < NCHUNKS; ++i) {
+    int32_t dbytes = blosc2_schunk_decompress_chunk(schunk, i, rec_buffer, nbytes);
+    CUTEST_ASSERT("Error during decompression", dbytes == nbytes);
+    for (int j = 0; j < CHUNKSIZE; ++j) {
+      CUTEST_ASSERT("Data are not equal", rec_buffer[j] == j * (i + 1));
+    }
+  }
+  if (backend.read_at) {
+    CUTEST_ASSERT("Positional reads are not used", params.read_at > 0);
+    CUTEST_ASSERT("Seek + read should not be used", params.read == 0);
+  }
+  else {
+    CUTEST_ASSERT("Seek + read is not used", params.read > 0);
+  }
+
+  blosc2_schunk_free(schunk);
+  blosc2_remove_urlpath(backend.urlpath);
+  free(data_buffer);
+  free(rec_buffer);
+
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(read_at) {
+  blosc_destroy();
+}
+
+
+int main() {
+  CUTEST_TEST_RUN(read_at)
+}
@@ -0,0 +1,108 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Test that chunks are the same whatever the number of threads compressing them.
+*/
+
+#include "test_common.h"
+#include "cutest.h"
+
+#define CHUNKSIZE (200 * 1000)
+#define NROUNDS 5
+
+
+typedef struct {
+  uint8_t compcode;
+  uint8_t filter;
+  int32_t blocksize;
+  bool use_dict;
+} test_codec_backend;
+
+CUTEST_TEST_DATA(reproducible) {
+  int32_t *data;
+};
+
+CUTEST_TEST_SETUP(reproducible) {
+  blosc_init();
+  data->data = malloc(CHUNKSIZE * sizeof(int32_t));
+  for (int i = 0; i < CHUNKSIZE; i++) {
+    // Blocks compress to rather different sizes
+    data->data[i] = (i % 20000 < 10000) ? i / 7 : (i * 7919) % 1013;
+  }
+
+  CUTEST_PARAMETRIZE(backend, test_codec_backend, CUTEST_DATA(
+      {BLOSC_BLOSCLZ, BLOSC_SHUFFLE, 4 * 1024, false},
+      {BLOSC_LZ4, BLOSC_SHUFFLE, 32 * 1024, false},
+      {BLOSC_LZ4, BLOSC_BITSHUFFLE, 0, false},
+      {BLOSC_ZSTD, BLOSC_SHUFFLE, 16 * 1024, false},
+      {BLOSC_ZSTD, BLOSC_SHUFFLE, 16 * 1024, true},
+  ));
+}
+
+
+static int compress(const test_codec_backend *backend, const int32_t *data, int16_t nthreads, uint8_t *chunk) {
+  int32_t nbytes = CHUNKSIZE * sizeof(int32_t);
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = sizeof(int32_t);
+  cparams.compcode = backend->compcode;
+  cparams.filters[BLOSC2_MAX_FILTERS - 1] = backend->filter;
+  cparams.blocksize = backend->blocksize;
+  cparams.use_dict = backend->use_dict;
+  cparams.nthreads = nthreads;
+  blosc2_context *cctx = blosc2_create_cctx(cparams);
+  int csize = blosc2_compress_ctx(cctx, data, nbytes, chunk, nbytes + BLOSC_MAX_OVERHEAD);
+  blosc2_free_ctx(cctx);
+  return csize;
+}
+
+
+CUTEST_TEST_TEST(reproducible) {
+  CUTEST_GET_PARAMETER(backend, test_codec_backend);
+
+  int32_t nbytes = CHUNKSIZE * sizeof(int32_t);
+  uint8_t *chunk1 = malloc(nbytes + BLOSC_MAX_OVERHEAD);
+  uint8_t *chunk2 = malloc(nbytes + BLOSC_MAX_OVERHEAD);
+  int32_t *dest = malloc(nbytes);
+
+  int csize1 = compress(&backend, data->data, 1, chunk1);
+  CUTEST_ASSERT("Error compressing", csize1 > 0);
+  CUTEST_ASSERT("Data is not compressed", csize1 < nbytes);
+
+  int16_t nthreads[] = {2, 3, 8};
+  for (int i = 0; i < 3; i++) {
+    // Threads finish in a different order every time
+    for (int n = 0; n < NROUNDS; n++) {
+      int csize2 = compress(&backend, data->data, nthreads[i], chunk2);
+      CUTEST_ASSERT("Compressed sizes are not equal", csize2 == csize1);
+      CUTEST_ASSERT("Chunks are not equal", memcmp(chunk1, chunk2, csize1) == 0);
+    }
+  }
+
+  // The same with the threads of the shared pool
+  CUTEST_ASSERT("Error setting the shared pool", blosc2_set_shared_nthreads(3) >= 0);
+  int csize2 = compress(&backend, data->data, 4, chunk2);
+  CUTEST_ASSERT("Error setting the shared pool", blosc2_set_shared_nthreads(0) == 3);
+  CUTEST_ASSERT("Compressed sizes are not equal", csize2 == csize1);
+  CUTEST_ASSERT("Chunks are not equal", memcmp(chunk1, chunk2, csize1) == 0);
+
+  int dsize = blosc2_decompress(chunk2, csize2, dest, nbytes);
+  CUTEST_ASSERT("Error decompressing", dsize == nbytes);
+  CUTEST_ASSERT("Data are not equal", memcmp(data->data, dest, nbytes) == 0);
+
+  free(chunk1);
+  free(chunk2);
+  free(dest);
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(reproducible) {
+  free(data->data);
+  blosc_destroy();
+}
+
+
+int main() {
+  CUTEST_TEST_RUN(reproducible)
+}
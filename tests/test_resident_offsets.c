@@ -0,0 +1,209 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+
+  Test that the chunk offsets kept in memory follow the updates of the frame.
+*/
+
+#include <stdio.h>
+#include "test_common.h"
+
+#define CHUNKSIZE (100)
+#define NCHUNKS (50)
+#define NTHREADS (2)
+
+/* Global vars */
+int tests_run = 0;
+
+
+typedef struct {
+  int offsets_mode;
+  char* urlpath;
+  bool contiguous;
+} test_data;
+
+test_data tdata;
+
+int tmodes[] = {BLOSC2_OFFSETS_AUTO, BLOSC2_OFFSETS_RESIDENT, BLOSC2_OFFSETS_COMPRESSED};
+
+typedef struct {
+  bool contiguous;
+  char *urlpath;
+}test_storage;
+
+test_storage tstorage[] = {
+    {true, NULL},  // memory - cframe
+    {true, "test_resident_offsets.b2frame"}, // disk - cframe
+    {false, "test_resident_offsets_s.b2frame"}, // disk - sframe
+};
+
+
+static void fill_chunk(int32_t* data, int seed) {
+  for (int i = 0; i < CHUNKSIZE; i++) {
+    // Make some of the chunks special ones
+    data[i] = (seed % 7 == 3) ? 0 : i + seed;
+  }
+}
+
+
+static uint8_t* new_chunk(blosc2_schunk* schunk, int seed) {
+  int32_t data[CHUNKSIZE];
+  int32_t isize = CHUNKSIZE * sizeof(int32_t);
+  uint8_t* chunk = malloc(isize + BLOSC_MAX_OVERHEAD);
+
+  fill_chunk(data, seed);
+  blosc2_compress_ctx(schunk->cctx, data, isize, chunk, isize + BLOSC_MAX_OVERHEAD);
+  return chunk;
+}
+
+
+/* Read all the chunks (several times, so that offsets become resident in AUTO mode) */
+static char* check_chunks(blosc2_schunk* schunk, const int* seeds, int nchunks) {
+  int32_t data[CHUNKSIZE];
+  int32_t data_dest[CHUNKSIZE];
+  int32_t isize = CHUNKSIZE * sizeof(int32_t);
+
+  mu_assert("ERROR: bad number of chunks", schunk->nchunks == nchunks);
+  for (int pass = 0; pass < 3; pass++) {
+    for (int nchunk = 0; nchunk < nchunks; nchunk++) {
+      fill_chunk(data, seeds[nchunk]);
+      int dsize = blosc2_schunk_decompress_chunk(schunk, nchunk, data_dest, isize);
+      mu_assert("ERROR: chunk cannot be decompressed correctly", dsize == isize);
+      for (int i = 0; i < CHUNKSIZE; i++) {
+        mu_assert("ERROR: bad roundtrip", data_dest[i] == data[i]);
+      }
+    }
+  }
+  return EXIT_SUCCESS;
+}
+
+
+static char* test_resident_offsets(void) {
+  int32_t data[CHUNKSIZE];
+  int32_t isize = CHUNKSIZE * sizeof(int32_t);
+  int seeds[NCHUNKS + 2];
+  int nchunks = NCHUNKS;
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  blosc2_schunk* schunk;
+  uint8_t* chunk;
+  char* msg;
+  int rc;
+
+  blosc2_remove_urlpath(tdata.urlpath);
+
+  /* Create a super-chunk container */
+  cparams.typesize = sizeof(int32_t);
+  cparams.nthreads = NTHREADS;
+  dparams.nthreads = NTHREADS;
+  blosc2_storage storage = {.cparams=&cparams, .dparams=&dparams,
+                            .urlpath=tdata.urlpath, .contiguous=tdata.contiguous,
+                            .offsets_mode=tdata.offsets_mode};
+  schunk = blosc2_schunk_new(&storage);
+  mu_assert("ERROR: cannot create the super-chunk", schunk != NULL);
+
+  // Feed it with data, reading the chunks while appending
+  for (int nchunk = 0; nchunk < NCHUNKS; nchunk++) {
+    seeds[nchunk] = nchunk;
+    fill_chunk(data, nchunk);
+    rc = blosc2_schunk_append_buffer(schunk, data, isize);
+    mu_assert("ERROR: bad append", rc == nchunk + 1);
+    msg = check_chunks(schunk, seeds, nchunk + 1);
+    if (msg != EXIT_SUCCESS) {
+      return msg;
+    }
+  }
+
+  // Update a chunk
+  seeds[5] = 1000;
+  chunk = new_chunk(schunk, seeds[5]);
+  rc = blosc2_schunk_update_chunk(schunk, 5, chunk, true);
+  free(chunk);
+  mu_assert("ERROR: bad update", rc == nchunks);
+  msg = check_chunks(schunk, seeds, nchunks);
+  if (msg != EXIT_SUCCESS) {
+    return msg;
+  }
+
+  // Insert a chunk
+  memmove(seeds + 11, seeds + 10, (nchunks - 10) * sizeof(int));
+  seeds[10] = 2000;
+  nchunks++;
+  chunk = new_chunk(schunk, seeds[10]);
+  rc = blosc2_schunk_insert_chunk(schunk, 10, chunk, true);
+  free(chunk);
+  mu_assert("ERROR: bad insert", rc == nchunks);
+  msg = check_chunks(schunk, seeds, nchunks);
+  if (msg != EXIT_SUCCESS) {
+    return msg;
+  }
+
+  // Delete a chunk
+  memmove(seeds + 20, seeds + 21, (nchunks - 21) * sizeof(int));
+  nchunks--;
+  rc = blosc2_schunk_delete_chunk(schunk, 20);
+  mu_assert("ERROR: bad delete", rc == nchunks);
+  msg = check_chunks(schunk, seeds, nchunks);
+  if (msg != EXIT_SUCCESS) {
+    return msg;
+  }
+
+  // Reverse the order of the chunks
+  int order[NCHUNKS + 2];
+  int rseeds[NCHUNKS + 2];
+  for (int i = 0; i < nchunks; i++) {
+    order[i] = nchunks - 1 - i;
+    rseeds[i] = seeds[nchunks - 1 - i];
+  }
+  rc = blosc2_schunk_reorder_offsets(schunk, order);
+  mu_assert("ERROR: bad reorder", rc >= 0);
+  msg = check_chunks(schunk, rseeds, nchunks);
+  if (msg != EXIT_SUCCESS) {
+    return msg;
+  }
+
+  /* Free resources */
+  blosc2_schunk_free(schunk);
+  blosc2_remove_urlpath(tdata.urlpath);
+
+  return EXIT_SUCCESS;
+}
+
+static char *all_tests(void) {
+
+  for (int i = 0; i < sizeof(tstorage) / sizeof(test_storage); ++i) {
+    for (int j = 0; j < sizeof(tmodes) / sizeof(int); ++j) {
+      tdata.contiguous = tstorage[i].contiguous;
+      tdata.urlpath = tstorage[i].urlpath;
+      tdata.offsets_mode = tmodes[j];
+      mu_run_test(test_resident_offsets);
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+
+int main(void) {
+  char *result;
+
+  install_blosc_callback_test(); /* optionally install callback test */
+  blosc_init();
+
+  /* Run all the suite */
+  result = all_tests();
+  if (result != EXIT_SUCCESS) {
+    printf(" (%s)\n", result);
+  }
+  else {
+    printf(" ALL TESTS PASSED");
+  }
+  printf("\tTests run: %d\n", tests_run);
+
+  blosc_destroy();
+
+  return result != EXIT_SUCCESS;
+}
@@ -0,0 +1,197 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Test the cache of decompressed blocks of a super-chunk.
+*/
+
+#include "test_common.h"
+#include "cutest.h"
+
+#define CHUNKITEMS (50 * 1000)
+#define BLOCKSIZE (16 * 1024)
+#define NCHUNKS 5
+#define NITEMS (NCHUNKS * CHUNKITEMS)
+#define BLOCKITEMS (BLOCKSIZE / (int)sizeof(int32_t))
+#define NBLOCKS ((CHUNKITEMS - 1) / BLOCKITEMS + 1)
+
+
+typedef struct {
+  bool contiguous;
+  char *urlpath;
+} test_cache_backend;
+
+CUTEST_TEST_DATA(schunk_block_cache) {
+  int32_t *data;
+};
+
+CUTEST_TEST_SETUP(schunk_block_cache) {
+  blosc_init();
+  data->data = malloc(NITEMS * sizeof(int32_t));
+  for (int i = 0; i < NITEMS; i++) {
+    data->data[i] = i / 3 + (i % 1013) * 7 % 11;
+  }
+
+  CUTEST_PARAMETRIZE(nthreads, int16_t, CUTEST_DATA(
+      1,
+      4,
+  ));
+  CUTEST_PARAMETRIZE(backend, test_cache_backend, CUTEST_DATA(
+      {false, NULL},  // memory - schunk
+      {true, NULL},  // memory - cframe
+      {true, "test_schunk_block_cache.b2frame"},  // disk - cframe
+      {false, "test_schunk_block_cache_s.b2frame"},  // disk - sframe
+  ));
+}
+
+
+/* Check the hits and misses of the cache since the last call */
+static bool check_stats(blosc2_schunk *schunk, int64_t *last, int64_t hits, int64_t misses) {
+  int64_t nhits, nmisses;
+  if (blosc2_schunk_get_block_cache_stats(schunk, &nhits, &nmisses) < 0) {
+    return false;
+  }
+  bool ok = nhits - last[0] == hits && nmisses - last[1] == misses;
+  last[0] = nhits;
+  last[1] = nmisses;
+  return ok;
+}
+
+
+CUTEST_TEST_TEST(schunk_block_cache) {
+  CUTEST_GET_PARAMETER(nthreads, int16_t);
+  CUTEST_GET_PARAMETER(backend, test_cache_backend);
+
+  int32_t *items = data->data;
+  int32_t chunk_nbytes = CHUNKITEMS * sizeof(int32_t);
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = sizeof(int32_t);
+  cparams.blocksize = BLOCKSIZE;
+  cparams.nthreads = nthreads;
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  dparams.nthreads = nthreads;
+  blosc2_storage storage = {.cparams=&cparams, .dparams=&dparams,
+                            .urlpath=backend.urlpath, .contiguous=backend.contiguous};
+  blosc2_remove_urlpath(backend.urlpath);
+  blosc2_schunk *schunk = blosc2_schunk_new(&storage);
+  for (int nchunk = 0; nchunk < NCHUNKS; nchunk++) {
+    int rc = blosc2_schunk_append_buffer(schunk, items + nchunk * CHUNKITEMS, chunk_nbytes);
+    CUTEST_ASSERT("Error appending a chunk", rc == nchunk + 1);
+  }
+
+  CUTEST_ASSERT("Stats of a missing cache not detected",
+                blosc2_schunk_get_block_cache_stats(schunk, NULL, NULL) < 0);
+  CUTEST_ASSERT("Negative size not detected", blosc2_schunk_set_block_cache(schunk, -1) < 0);
+  CUTEST_ASSERT("Error setting the cache", blosc2_schunk_set_block_cache(schunk, 64 * BLOCKSIZE) == 0);
+  int64_t last[2] = {0, 0};
+
+  // Point lookups: the block is decompressed once
+  int32_t item;
+  int64_t pos = CHUNKITEMS + 3 * BLOCKITEMS + 5;
+  for (int i = 0; i < 3; i++) {
+    CUTEST_ASSERT("Error getting an item", blosc2_schunk_get_slice_buffer(schunk, pos, pos + 1, &item) == 0);
+    CUTEST_ASSERT("Data are not equal", item == items[pos]);
+  }
+  CUTEST_ASSERT("Wrong hits or misses", check_stats(schunk, last, 2, 1));
+
+  // Whole chunks come out of the cache once all their blocks are there, and until then
+  // all of them are decompressed (so the one already in the cache is not a hit)
+  int32_t *buffer = malloc(NITEMS * sizeof(int32_t));
+  for (int i = 0; i < 2; i++) {
+    memset(buffer, 0, chunk_nbytes);
+    CUTEST_ASSERT("Error decompressing a chunk",
+                  blosc2_schunk_decompress_chunk(schunk, 1, buffer, chunk_nbytes) == chunk_nbytes);
+    CUTEST_ASSERT("Data are not equal", memcmp(buffer, items + CHUNKITEMS, chunk_nbytes) == 0);
+  }
+  CUTEST_ASSERT("Wrong hits or misses", check_stats(schunk, last, NBLOCKS, NBLOCKS));
+
+  // Slices across chunks, with the chunks spread among threads
+  for (int i = 0; i < 2; i++) {
+    CUTEST_ASSERT("Error getting a slice",
+                  blosc2_schunk_get_slice_buffer(schunk, 100, 3 * CHUNKITEMS - 100, buffer) == 0);
+    CUTEST_ASSERT("Data are not equal",
+                  memcmp(buffer, items + 100, (3 * CHUNKITEMS - 200) * sizeof(int32_t)) == 0);
+  }
+  // The blocks of chunks 0 and 2 miss the first time, and chunk 1 is already in the cache
+  CUTEST_ASSERT("Wrong hits or misses", check_stats(schunk, last, 4 * NBLOCKS, 2 * NBLOCKS));
+
+  // Reads with a maskout skip the cache, and the maskout is used by them only
+  bool maskout[NBLOCKS];
+  for (int i = 0; i < NBLOCKS; i++) {
+    maskout[i] = i % 2;
+  }
+  for (int nchunk = 1; nchunk < 4; nchunk += 2) {
+    // Chunk 1 is in the cache, and chunk 3 is not
+    memset(buffer, 0, chunk_nbytes);
+    CUTEST_ASSERT("Error setting the maskout", blosc2_set_maskout(schunk->dctx, maskout, NBLOCKS) == 0);
+    CUTEST_ASSERT("Error decompressing a chunk",
+                  blosc2_schunk_decompress_chunk(schunk, nchunk, buffer, chunk_nbytes) == chunk_nbytes);
+    for (int i = 0; i < NBLOCKS; i += 2) {
+      int32_t nitems = i < NBLOCKS - 1 ? BLOCKITEMS : CHUNKITEMS - i * BLOCKITEMS;
+      CUTEST_ASSERT("Data are not equal", memcmp(buffer + i * BLOCKITEMS, items + nchunk * CHUNKITEMS + i * BLOCKITEMS,
+                                                 nitems * sizeof(int32_t)) == 0);
+    }
+    CUTEST_ASSERT("Error decompressing a chunk",
+                  blosc2_schunk_decompress_chunk(schunk, nchunk, buffer, chunk_nbytes) == chunk_nbytes);
+    CUTEST_ASSERT("Data are not equal", memcmp(buffer, items + nchunk * CHUNKITEMS, chunk_nbytes) == 0);
+  }
+  // Only the reads without a maskout went through the cache (chunk 3 was not there)
+  CUTEST_ASSERT("Wrong hits or misses", check_stats(schunk, last, NBLOCKS, NBLOCKS));
+  CUTEST_ASSERT("Error decompressing a chunk",
+                blosc2_schunk_decompress_chunk(schunk, 3, buffer, chunk_nbytes) == chunk_nbytes);
+  CUTEST_ASSERT("Data are not equal", memcmp(buffer, items + 3 * CHUNKITEMS, chunk_nbytes) == 0);
+  CUTEST_ASSERT("Wrong hits or misses", check_stats(schunk, last, NBLOCKS, 0));
+
+  // Updates, inserts and deletes drop the blocks of the chunks that change
+  int32_t *new_items = malloc(chunk_nbytes);
+  for (int i = 0; i < CHUNKITEMS; i++) {
+    new_items[i] = -i;
+  }
+  uint8_t *chunk = malloc(chunk_nbytes + BLOSC_MAX_OVERHEAD);
+  int cbytes = blosc2_compress_ctx(schunk->cctx, new_items, chunk_nbytes, chunk, chunk_nbytes + BLOSC_MAX_OVERHEAD);
+  CUTEST_ASSERT("Error compressing a chunk", cbytes > 0);
+  CUTEST_ASSERT("Error updating a chunk", blosc2_schunk_update_chunk(schunk, 1, chunk, true) >= 0);
+  CUTEST_ASSERT("Error getting an item", blosc2_schunk_get_slice_buffer(schunk, pos, pos + 1, &item) == 0);
+  CUTEST_ASSERT("Updated data are not read", item == new_items[pos - CHUNKITEMS]);
+  CUTEST_ASSERT("Error inserting a chunk", blosc2_schunk_insert_chunk(schunk, 0, chunk, true) >= 0);
+  CUTEST_ASSERT("Error getting an item", blosc2_schunk_get_slice_buffer(schunk, pos, pos + 1, &item) == 0);
+  CUTEST_ASSERT("Moved data are not read", item == items[pos - CHUNKITEMS]);
+  CUTEST_ASSERT("Error deleting a chunk", blosc2_schunk_delete_chunk(schunk, 0) >= 0);
+  CUTEST_ASSERT("Error decompressing a chunk",
+                blosc2_schunk_decompress_chunk(schunk, 1, buffer, chunk_nbytes) == chunk_nbytes);
+  CUTEST_ASSERT("Moved data are not read", memcmp(buffer, new_items, chunk_nbytes) == 0);
+  free(chunk);
+  free(new_items);
+
+  // The least recently used blocks are dropped first
+  CUTEST_ASSERT("Error setting the cache", blosc2_schunk_set_block_cache(schunk, 2 * BLOCKSIZE) == 0);
+  last[0] = last[1] = 0;
+  int64_t blocks[] = {0, 1, 0, 2, 0, 1};
+  int64_t hits[] = {0, 0, 1, 0, 1, 0};
+  for (int i = 0; i < 6; i++) {
+    pos = 2 * CHUNKITEMS + blocks[i] * BLOCKITEMS;
+    CUTEST_ASSERT("Error getting an item", blosc2_schunk_get_slice_buffer(schunk, pos, pos + 1, &item) == 0);
+    CUTEST_ASSERT("Data are not equal", item == items[pos]);
+    CUTEST_ASSERT("Wrong hits or misses", check_stats(schunk, last, hits[i], 1 - hits[i]));
+  }
+
+  CUTEST_ASSERT("Error disabling the cache", blosc2_schunk_set_block_cache(schunk, 0) == 0);
+  CUTEST_ASSERT("The cache is not disabled", blosc2_schunk_get_block_cache_stats(schunk, NULL, NULL) < 0);
+
+  free(buffer);
+  blosc2_schunk_free(schunk);
+  blosc2_remove_urlpath(backend.urlpath);
+
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(schunk_block_cache) {
+  free(data->data);
+  blosc_destroy();
+}
+
+
+int main() {
+  CUTEST_TEST_RUN(schunk_block_cache)
+}
@@ -0,0 +1,138 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Test the decompression of ranges of chunks of a super-chunk.
+*/
+
+#include "test_common.h"
+#include "cutest.h"
+
+#define CHUNKSIZE (50 * 1000)
+#define NCHUNKS 12
+#define LAST_CHUNKSIZE (CHUNKSIZE / 3)
+
+
+typedef struct {
+  bool contiguous;
+  char *urlpath;
+} test_range_backend;
+
+CUTEST_TEST_DATA(schunk_decompress_range) {
+  int32_t *data;
+};
+
+CUTEST_TEST_SETUP(schunk_decompress_range) {
+  blosc_init();
+  data->data = malloc(CHUNKSIZE * sizeof(int32_t));
+  for (int i = 0; i < CHUNKSIZE; i++) {
+    data->data[i] = i / 3 + (i % 1013) * 7 % 11;
+  }
+
+  CUTEST_PARAMETRIZE(nthreads, int16_t, CUTEST_DATA(
+      1,
+      4,
+  ));
+  CUTEST_PARAMETRIZE(backend, test_range_backend, CUTEST_DATA(
+      {false, NULL},  // memory - schunk
+      {true, NULL},  // memory - cframe
+      {true, "test_decompress_range.b2frame"},  // disk - cframe
+      {false, "test_decompress_range_s.b2frame"},  // disk - sframe
+  ));
+}
+
+
+CUTEST_TEST_TEST(schunk_decompress_range) {
+  CUTEST_GET_PARAMETER(nthreads, int16_t);
+  CUTEST_GET_PARAMETER(backend, test_range_backend);
+
+  int32_t nbytes = CHUNKSIZE * sizeof(int32_t);
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = sizeof(int32_t);
+  cparams.blocksize = 16 * 1024;
+  cparams.nthreads = nthreads;
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  dparams.nthreads = nthreads;
+  blosc2_storage storage = {.cparams=&cparams, .dparams=&dparams,
+                            .urlpath=backend.urlpath, .contiguous=backend.contiguous};
+  blosc2_remove_urlpath(backend.urlpath);
+  blosc2_schunk *schunk = blosc2_schunk_new(&storage);
+
+  // Regular chunks, with special ones in between and a smaller one at the end
+  uint8_t *chunk = malloc(nbytes + BLOSC_EXTENDED_HEADER_LENGTH);
+  for (int nchunk = 0; nchunk < NCHUNKS - 1; nchunk++) {
+    int rc;
+    if (nchunk % 4 == 1) {
+      int csize = blosc2_chunk_zeros(cparams, nbytes, chunk, nbytes + BLOSC_EXTENDED_HEADER_LENGTH);
+      CUTEST_ASSERT("Error creating a special chunk", csize > 0);
+      rc = blosc2_schunk_append_chunk(schunk, chunk, true);
+    }
+    else if (nchunk % 4 == 2) {
+      int32_t value = nchunk;
+      int csize = blosc2_chunk_repeatval(cparams, nbytes, chunk, nbytes + BLOSC_EXTENDED_HEADER_LENGTH, &value);
+      CUTEST_ASSERT("Error creating a special chunk", csize > 0);
+      rc = blosc2_schunk_append_chunk(schunk, chunk, true);
+    }
+    else {
+      data->data[0] = nchunk;
+      rc = blosc2_schunk_append_buffer(schunk, data->data, nbytes);
+    }
+    CUTEST_ASSERT("Error appending a chunk", rc == nchunk + 1);
+  }
+  data->data[0] = NCHUNKS - 1;
+  int rc = blosc2_schunk_append_buffer(schunk, data->data, LAST_CHUNKSIZE * sizeof(int32_t));
+  CUTEST_ASSERT("Error appending a chunk", rc == NCHUNKS);
+  free(chunk);
+
+  // The chunks one at a time
+  int64_t total_nbytes = (int64_t)(NCHUNKS - 1) * nbytes + LAST_CHUNKSIZE * sizeof(int32_t);
+  uint8_t *expected = malloc(NCHUNKS * nbytes);
+  for (int nchunk = 0; nchunk < NCHUNKS; nchunk++) {
+    int dsize = blosc2_schunk_decompress_chunk(schunk, nchunk, expected + nchunk * nbytes, nbytes);
+    CUTEST_ASSERT("Error decompressing a chunk", dsize == (nchunk < NCHUNKS - 1 ? nbytes : LAST_CHUNKSIZE * (int)sizeof(int32_t)));
+  }
+
+  // Whole super-chunk, a range in the middle and a range at the end
+  uint8_t *dest = malloc(NCHUNKS * nbytes);
+  int ranges[][2] = {{0, NCHUNKS}, {1, 7}, {NCHUNKS - 3, NCHUNKS}, {5, 6}, {4, 4}};
+  for (int i = 0; i < 5; i++) {
+    int start = ranges[i][0];
+    int stop = ranges[i][1];
+    int64_t range_nbytes = stop == NCHUNKS ? total_nbytes - (int64_t)start * nbytes : (int64_t)(stop - start) * nbytes;
+    memset(dest, 0xff, NCHUNKS * nbytes);
+    int64_t dsize = blosc2_schunk_decompress_range(schunk, start, stop, dest, NCHUNKS * nbytes);
+    CUTEST_ASSERT("Error decompressing a range", dsize == range_nbytes);
+    CUTEST_ASSERT("Data are not equal", memcmp(dest, expected + start * nbytes, range_nbytes) == 0);
+  }
+  // The destination just fits
+  int64_t dsize = blosc2_schunk_decompress_range(schunk, 0, NCHUNKS, dest, total_nbytes);
+  CUTEST_ASSERT("Error decompressing a range", dsize == total_nbytes);
+
+  // Errors
+  CUTEST_ASSERT("Range out of bounds not detected",
+                blosc2_schunk_decompress_range(schunk, 0, NCHUNKS + 1, dest, NCHUNKS * nbytes) < 0);
+  CUTEST_ASSERT("Reversed range not detected",
+                blosc2_schunk_decompress_range(schunk, 3, 2, dest, NCHUNKS * nbytes) < 0);
+  CUTEST_ASSERT("Small destination not detected",
+                blosc2_schunk_decompress_range(schunk, 0, 4, dest, 3 * nbytes) < 0);
+  CUTEST_ASSERT("Small destination not detected",
+                blosc2_schunk_decompress_range(schunk, 0, 4, dest, 4 * nbytes - 1) < 0);
+
+  free(expected);
+  free(dest);
+  blosc2_schunk_free(schunk);
+  blosc2_remove_urlpath(backend.urlpath);
+
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(schunk_decompress_range) {
+  free(data->data);
+  blosc_destroy();
+}
+
+
+int main() {
+  CUTEST_TEST_RUN(schunk_decompress_range)
+}
@@ -0,0 +1,132 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Test the chunk iterators of super-chunks, which read chunks ahead.
+*/
+
+#include "test_common.h"
+#include "cutest.h"
+
+#define CHUNKITEMS (50 * 1000)
+#define NCHUNKS 10
+
+
+typedef struct {
+  bool contiguous;
+  char *urlpath;
+} test_iter_backend;
+
+CUTEST_TEST_DATA(schunk_iter) {
+  int32_t *data;
+};
+
+CUTEST_TEST_SETUP(schunk_iter) {
+  blosc_init();
+  data->data = malloc(NCHUNKS * CHUNKITEMS * sizeof(int32_t));
+  for (int i = 0; i < NCHUNKS * CHUNKITEMS; i++) {
+    data->data[i] = i / 3 + (i % 1013) * 7 % 11;
+  }
+
+  CUTEST_PARAMETRIZE(nthreads, int16_t, CUTEST_DATA(
+      1,
+      4,
+  ));
+  CUTEST_PARAMETRIZE(depth, int, CUTEST_DATA(
+      1,
+      3,
+  ));
+  CUTEST_PARAMETRIZE(decompress, bool, CUTEST_DATA(
+      true,
+      false,
+  ));
+  CUTEST_PARAMETRIZE(backend, test_iter_backend, CUTEST_DATA(
+      {false, NULL},  // memory - schunk
+      {true, NULL},  // memory - cframe
+      {true, "test_schunk_iter.b2frame"},  // disk - cframe
+      {false, "test_schunk_iter_s.b2frame"},  // disk - sframe
+  ));
+}
+
+
+CUTEST_TEST_TEST(schunk_iter) {
+  CUTEST_GET_PARAMETER(nthreads, int16_t);
+  CUTEST_GET_PARAMETER(depth, int);
+  CUTEST_GET_PARAMETER(decompress, bool);
+  CUTEST_GET_PARAMETER(backend, test_iter_backend);
+
+  int32_t chunk_nbytes = CHUNKITEMS * sizeof(int32_t);
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = sizeof(int32_t);
+  cparams.nthreads = nthreads;
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  dparams.nthreads = nthreads;
+  blosc2_storage storage = {.cparams=&cparams, .dparams=&dparams,
+                            .urlpath=backend.urlpath, .contiguous=backend.contiguous};
+  blosc2_remove_urlpath(backend.urlpath);
+  blosc2_schunk *schunk = blosc2_schunk_new(&storage);
+  for (int nchunk = 0; nchunk < NCHUNKS; nchunk++) {
+    int rc = blosc2_schunk_append_buffer(schunk, data->data + nchunk * CHUNKITEMS, chunk_nbytes);
+    CUTEST_ASSERT("Error appending a chunk", rc == nchunk + 1);
+  }
+
+  // All the chunks, a few of them and none
+  int ranges[3][2] = {{0, NCHUNKS}, {3, 7}, {5, 5}};
+  int32_t *buffer = malloc(chunk_nbytes);
+  for (int r = 0; r < 3; r++) {
+    blosc2_schunk_iter *iter = blosc2_schunk_iter_new(schunk, ranges[r][0], ranges[r][1], depth, decompress);
+    CUTEST_ASSERT("Error creating the iterator", iter != NULL);
+    for (int nchunk = ranges[r][0]; nchunk < ranges[r][1]; nchunk++) {
+      uint8_t *chunk;
+      int size = blosc2_schunk_iter_next(iter, &chunk);
+      CUTEST_ASSERT("Error getting a chunk", size > 0);
+      if (!decompress) {
+        size = blosc2_decompress_ctx(schunk->dctx, chunk, size, buffer, chunk_nbytes);
+        chunk = (uint8_t *)buffer;
+      }
+      CUTEST_ASSERT("Wrong size of chunk", size == chunk_nbytes);
+      CUTEST_ASSERT("Data are not equal",
+                    memcmp(chunk, data->data + nchunk * CHUNKITEMS, chunk_nbytes) == 0);
+    }
+    uint8_t *chunk;
+    CUTEST_ASSERT("More chunks than expected", blosc2_schunk_iter_next(iter, &chunk) == 0);
+    CUTEST_ASSERT("More chunks than expected", blosc2_schunk_iter_next(iter, &chunk) == 0);
+    CUTEST_ASSERT("Error freeing the iterator", blosc2_schunk_iter_free(iter) == 0);
+  }
+  free(buffer);
+
+  // Iterators can be freed before their last chunk, or before their first one
+  for (int nnext = 0; nnext < 2; nnext++) {
+    blosc2_schunk_iter *iter = blosc2_schunk_iter_new(schunk, 0, NCHUNKS, depth, decompress);
+    CUTEST_ASSERT("Error creating the iterator", iter != NULL);
+    uint8_t *chunk;
+    for (int i = 0; i < nnext; i++) {
+      CUTEST_ASSERT("Error getting a chunk", blosc2_schunk_iter_next(iter, &chunk) > 0);
+    }
+    CUTEST_ASSERT("Error freeing the iterator", blosc2_schunk_iter_free(iter) == 0);
+  }
+
+  // Errors
+  CUTEST_ASSERT("Range out of bounds not detected",
+                blosc2_schunk_iter_new(schunk, 0, NCHUNKS + 1, depth, decompress) == NULL);
+  CUTEST_ASSERT("Reversed range not detected",
+                blosc2_schunk_iter_new(schunk, 3, 2, depth, decompress) == NULL);
+  CUTEST_ASSERT("Null depth not detected",
+                blosc2_schunk_iter_new(schunk, 0, NCHUNKS, 0, decompress) == NULL);
+
+  blosc2_schunk_free(schunk);
+  blosc2_remove_urlpath(backend.urlpath);
+
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(schunk_iter) {
+  free(data->data);
+  blosc_destroy();
+}
+
+
+int main() {
+  CUTEST_TEST_RUN(schunk_iter)
+}
@@ -0,0 +1,174 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Test the pool of threads shared by every context.
+*/
+
+#include "test_common.h"
+#include "cutest.h"
+#if !defined(_WIN32)
+#include <pthread.h>
+#endif
+
+#define CHUNKSIZE (200 * 1000)
+#define NCONTEXTS 20
+#define NCALLERS 4
+
+
+typedef struct {
+  int16_t pool_nthreads;
+  int16_t nthreads;
+  uint8_t compcode;
+  uint8_t filter;
+} test_pool_backend;
+
+CUTEST_TEST_DATA(shared_pool) {
+  int32_t *data;
+};
+
+CUTEST_TEST_SETUP(shared_pool) {
+  blosc_init();
+  data->data = malloc(CHUNKSIZE * sizeof(int32_t));
+  for (int i = 0; i < CHUNKSIZE; i++) {
+    data->data[i] = i / 3 + (i * 7919) % 11;
+  }
+
+  CUTEST_PARAMETRIZE(backend, test_pool_backend, CUTEST_DATA(
+      {0, 4, BLOSC_BLOSCLZ, BLOSC_SHUFFLE}, // no shared pool
+      {1, 4, BLOSC_BLOSCLZ, BLOSC_SHUFFLE},
+      {3, 4, BLOSC_LZ4, BLOSC_SHUFFLE},
+      {3, 8, BLOSC_ZSTD, BLOSC_BITSHUFFLE},
+      {8, 2, BLOSC_BLOSCLZ, BLOSC_DELTA},
+  ));
+}
+
+
+/* Compress and decompress with a few contexts in turn */
+static int roundtrip(const test_pool_backend *backend, const int32_t *data, int nrounds) {
+  int32_t nbytes = CHUNKSIZE * sizeof(int32_t);
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = sizeof(int32_t);
+  cparams.compcode = backend->compcode;
+  cparams.filters[BLOSC2_MAX_FILTERS - 1] = backend->filter;
+  cparams.blocksize = 16 * 1024;
+  cparams.nthreads = backend->nthreads;
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  dparams.nthreads = backend->nthreads;
+
+  blosc2_context *cctxs[NCONTEXTS];
+  blosc2_context *dctxs[NCONTEXTS];
+  for (int i = 0; i < NCONTEXTS; i++) {
+    cctxs[i] = blosc2_create_cctx(cparams);
+    dctxs[i] = blosc2_create_dctx(dparams);
+  }
+  uint8_t *chunk = malloc(nbytes + BLOSC_MAX_OVERHEAD);
+  int32_t *dest = malloc(nbytes);
+  int rc = 0;
+  for (int n = 0; rc == 0 && n < nrounds; n++) {
+    int i = n % NCONTEXTS;
+    int csize = blosc2_compress_ctx(cctxs[i], data, nbytes, chunk, nbytes + BLOSC_MAX_OVERHEAD);
+    if (csize <= 0) {
+      rc = -1;
+      break;
+    }
+    // Any other context can decompress it
+    int dsize = blosc2_decompress_ctx(dctxs[(i + 1) % NCONTEXTS], chunk, csize, dest, nbytes);
+    if (dsize != nbytes || memcmp(data, dest, nbytes) != 0) {
+      rc = -1;
+    }
+    // Some blocks only (blocks with deltas need the first one, which getitem does not decompress)
+    int32_t item;
+    if (backend->filter != BLOSC_DELTA &&
+        (blosc2_getitem_ctx(dctxs[i], chunk, csize, CHUNKSIZE / 2 + n, 1, &item, sizeof(item)) != sizeof(item) ||
+         item != data[CHUNKSIZE / 2 + n])) {
+      rc = -1;
+    }
+  }
+  free(chunk);
+  free(dest);
+  for (int i = 0; i < NCONTEXTS; i++) {
+    blosc2_free_ctx(cctxs[i]);
+    blosc2_free_ctx(dctxs[i]);
+  }
+  return rc;
+}
+
+
+#if !defined(_WIN32)
+typedef struct {
+  const test_pool_backend *backend;
+  const int32_t *data;
+  int rc;
+} test_caller;
+
+static void *caller(void *arg) {
+  test_caller *my = (test_caller *) arg;
+  my->rc = roundtrip(my->backend, my->data, 2 * NCONTEXTS);
+  return NULL;
+}
+#endif
+
+
+CUTEST_TEST_TEST(shared_pool) {
+  CUTEST_GET_PARAMETER(backend, test_pool_backend);
+
+  CUTEST_ASSERT("Error setting the shared pool", blosc2_set_shared_nthreads(backend.pool_nthreads) >= 0);
+  CUTEST_ASSERT("Bad number of threads in the pool",
+                blosc2_get_shared_nthreads() == backend.pool_nthreads);
+  CUTEST_ASSERT("Data are not equal", roundtrip(&backend, data->data, 2 * NCONTEXTS) == 0);
+
+#if !defined(_WIN32)
+  // Several threads (de)compressing at once
+  pthread_t threads[NCALLERS];
+  test_caller callers[NCALLERS];
+  for (int i = 0; i < NCALLERS; i++) {
+    callers[i].backend = &backend;
+    callers[i].data = data->data;
+    callers[i].rc = -1;
+    CUTEST_ASSERT("Error creating a thread", pthread_create(&threads[i], NULL, caller, &callers[i]) == 0);
+  }
+  for (int i = 0; i < NCALLERS; i++) {
+    pthread_join(threads[i], NULL);
+    CUTEST_ASSERT("Data are not equal", callers[i].rc == 0);
+  }
+#endif
+
+  // Contexts keep working when the pool is switched off and on again
+  int32_t nbytes = CHUNKSIZE * sizeof(int32_t);
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = sizeof(int32_t);
+  cparams.nthreads = backend.nthreads;
+  blosc2_context *cctx = blosc2_create_cctx(cparams);
+  uint8_t *chunk = malloc(nbytes + BLOSC_MAX_OVERHEAD);
+  int16_t pool_nthreads[] = {0, 2, backend.pool_nthreads};
+  int16_t prev_nthreads = backend.pool_nthreads;
+  for (int i = 0; i < 3; i++) {
+    CUTEST_ASSERT("Error changing the shared pool",
+                  blosc2_set_shared_nthreads(pool_nthreads[i]) == prev_nthreads);
+    prev_nthreads = pool_nthreads[i];
+    int csize = blosc2_compress_ctx(cctx, data->data, nbytes, chunk, nbytes + BLOSC_MAX_OVERHEAD);
+    CUTEST_ASSERT("Error compressing", csize > 0);
+    int32_t *dest = malloc(nbytes);
+    int dsize = blosc2_decompress(chunk, csize, dest, nbytes);
+    CUTEST_ASSERT("Error decompressing", dsize == nbytes);
+    CUTEST_ASSERT("Data are not equal", memcmp(data->data, dest, nbytes) == 0);
+    free(dest);
+  }
+  free(chunk);
+  blosc2_free_ctx(cctx);
+  CUTEST_ASSERT("Bad number of threads", blosc2_set_shared_nthreads(-1) < 0);
+
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(shared_pool) {
+  free(data->data);
+  blosc_destroy();
+}
+
+
+int main() {
+  CUTEST_TEST_RUN(shared_pool)
+}
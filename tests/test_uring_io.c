@@ -0,0 +1,180 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+*/
+
+#include "test_common.h"
+#include "cutest.h"
+
+#define CHUNKSIZE (50 * 1000)
+#define NCHUNKS 10
+#define NSEGMENTS 200
+
+
+typedef struct {
+  bool contiguous;
+  char *urlpath;
+  int nthreads;
+}test_uring_backend;
+
+CUTEST_TEST_DATA(uring_io) {
+  blosc2_cparams cparams;
+  blosc2_dparams dparams;
+};
+
+CUTEST_TEST_SETUP(uring_io) {
+  blosc_init();
+
+  data->cparams = BLOSC2_CPARAMS_DEFAULTS;
+  data->cparams.typesize = sizeof(int32_t);
+  data->cparams.compcode = BLOSC_BLOSCLZ;
+  data->cparams.clevel = 9;
+  data->cparams.blocksize = 8 * 1024;
+  data->cparams.nthreads = 2;
+  data->dparams = BLOSC2_DPARAMS_DEFAULTS;
+
+  CUTEST_PARAMETRIZE(backend, test_uring_backend, CUTEST_DATA(
+      {true, "test_uring_io.b2frame", 1}, // disk - cframe
+      {true, "test_uring_io.b2frame", 4}, // disk - cframe
+      {false, "test_uring_io_s.b2frame", 1}, // disk - sframe
+      {false, "test_uring_io_s.b2frame", 4}, // disk - sframe
+  ));
+}
+
+
+/* More reads than fit in the ring at once */
+static int check_batch(const char *urlpath) {
+  void *fp = blosc2_stdio_uring_open(urlpath, "rb", NULL);
+  if (fp == NULL) {
+    return -1;
+  }
+  int64_t size = 100;
+  uint8_t *expected = malloc(NSEGMENTS * size);
+  uint8_t *buffer = malloc(NSEGMENTS * size);
+  blosc2_io_segment segments[NSEGMENTS];
+  for (int i = 0; i < NSEGMENTS; ++i) {
+    // Scattered and out of order
+    segments[i].offset = ((i * 37) % NSEGMENTS) * size;
+    segments[i].size = i % 10 == 9 ? 0 : size;
+    segments[i].ptr = buffer + i * size;
+  }
+  int rc = 0;
+  for (int i = 0; i < NSEGMENTS; ++i) {
+    if (blosc2_stdio_uring_read_at(fp, segments[i].offset, size, expected + i * size) != size) {
+      rc = -1;
+    }
+  }
+  void *batch = blosc2_stdio_uring_submit(fp, segments, NSEGMENTS);
+  // Wait in any order (if io_uring is not available, there is nothing to wait for)
+  for (int i = NSEGMENTS - 1; batch != NULL && i >= 0; --i) {
+    int64_t rbytes = blosc2_stdio_uring_wait(batch, i);
+    if (rbytes != segments[i].size ||
+        memcmp(segments[i].ptr, expected + i * size, (size_t) segments[i].size) != 0) {
+      rc = -1;
+    }
+  }
+  blosc2_stdio_uring_release(batch);
+  if (blosc2_stdio_uring_readv_at(fp, segments, NSEGMENTS) != (NSEGMENTS - NSEGMENTS / 10) * size) {
+    rc = -1;
+  }
+  blosc2_stdio_uring_close(fp);
+  free(expected);
+  free(buffer);
+  return rc;
+}
+
+
+static int check_chunk(blosc2_schunk *schunk, int nchunk, int value, bool *maskout) {
+  int32_t nbytes = CHUNKSIZE * sizeof(int32_t);
+  int32_t *rec_buffer = malloc(nbytes);
+  int rc = 0;
+
+  if (maskout != NULL) {
+    blosc2_set_maskout(schunk->dctx, maskout, (nbytes + schunk->blocksize - 1) / schunk->blocksize);
+  }
+  int32_t dbytes = blosc2_schunk_decompress_chunk(schunk, nchunk, rec_buffer, nbytes);
+  if (dbytes != nbytes) {
+    rc = -1;
+  }
+  int32_t block_nitems = schunk->blocksize / (int32_t) sizeof(int32_t);
+  for (int j = 0; rc == 0 && j < CHUNKSIZE; ++j) {
+    if (maskout != NULL && maskout[j / block_nitems]) {
+      continue;
+    }
+    if (rec_buffer[j] != j + value) {
+      rc = -1;
+    }
+  }
+  free(rec_buffer);
+  return rc;
+}
+
+
+CUTEST_TEST_TEST(uring_io) {
+  CUTEST_GET_PARAMETER(backend, test_uring_backend);
+
+  /* Free resources */
+  blosc2_remove_urlpath(backend.urlpath);
+
+  int32_t nbytes = CHUNKSIZE * sizeof(int32_t);
+  int32_t *data_buffer = malloc(nbytes);
+
+  /* Create a super-chunk container */
+  data->dparams.nthreads = backend.nthreads;
+  blosc2_io io = {.id = BLOSC2_IO_FILESYSTEM_URING, .params = NULL};
+  blosc2_storage storage = {.cparams=&data->cparams, .dparams=&data->dparams,
+                            .contiguous=backend.contiguous, .urlpath = backend.urlpath, .io=&io};
+
+  blosc2_schunk *schunk = blosc2_schunk_new(&storage);
+  CUTEST_ASSERT("Error creating the super-chunk", schunk != NULL);
+
+  for (int i = 0; i < NCHUNKS; ++i) {
+    for (int j = 0; j < CHUNKSIZE; ++j) {
+      data_buffer[j] = j + i;
+    }
+    int nchunks = blosc2_schunk_append_buffer(schunk, data_buffer, nbytes);
+    CUTEST_ASSERT("Error during compression", nchunks == i + 1);
+  }
+  free(data_buffer);
+
+  // The blocks of each (lazy) chunk are read at once
+  for (int i = 0; i < NCHUNKS; ++i) {
+    CUTEST_ASSERT("Data are not equal", check_chunk(schunk, i, i, NULL) == 0);
+  }
+
+  // Masked out blocks are not read
+  int nblocks = (nbytes + schunk->blocksize - 1) / schunk->blocksize;
+  bool *maskout = calloc(nblocks, sizeof(bool));
+  for (int j = 0; j < nblocks; j += 3) {
+    maskout[j] = true;
+  }
+  CUTEST_ASSERT("Data are not equal", check_chunk(schunk, 3, 3, maskout) == 0);
+  free(maskout);
+
+  if (backend.contiguous) {
+    CUTEST_ASSERT("Bad batch of reads", check_batch(backend.urlpath) == 0);
+  }
+
+  // Reopen it
+  blosc2_schunk_free(schunk);
+  schunk = blosc2_schunk_open_udio(backend.urlpath, &io);
+  CUTEST_ASSERT("Error opening the super-chunk", schunk != NULL);
+  for (int i = 0; i < NCHUNKS; ++i) {
+    CUTEST_ASSERT("Data are not equal", check_chunk(schunk, i, i, NULL) == 0);
+  }
+
+  blosc2_schunk_free(schunk);
+  blosc2_remove_urlpath(backend.urlpath);
+
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(uring_io) {
+  blosc_destroy();
+}
+
+
+int main() {
+  CUTEST_TEST_RUN(uring_io)
+}
@@ -0,0 +1,234 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Test the batching of appends to on-disk frames.
+*/
+
+#include "test_common.h"
+#include "cutest.h"
+
+#define CHUNKSIZE (5 * 1000)
+#define NCHUNKS 50
+
+
+/* A plugin wrapping stdio which counts the opens for writing */
+typedef struct {
+  int32_t nopens;
+} test_write_params;
+
+typedef struct {
+  blosc2_stdio_file *bfile;
+  test_write_params *params;
+} test_file;
+
+void* test_open(const char *urlpath, const char *mode, void *params) {
+  void *bfile = blosc2_stdio_open(urlpath, mode, NULL);
+  if (bfile == NULL) {
+    return NULL;
+  }
+  test_file *my = malloc(sizeof(test_file));
+  my->params = params;
+  my->bfile = bfile;
+  if (strchr(mode, 'w') != NULL || strchr(mode, '+') != NULL) {
+    my->params->nopens++;
+  }
+  return my;
+}
+
+int test_close(void *stream) {
+  test_file *my = (test_file *) stream;
+  int err = blosc2_stdio_close(my->bfile);
+  free(my);
+  return err;
+}
+
+int64_t test_tell(void *stream) {
+  return blosc2_stdio_tell(((test_file *) stream)->bfile);
+}
+
+int test_seek(void *stream, int64_t offset, int whence) {
+  return blosc2_stdio_seek(((test_file *) stream)->bfile, offset, whence);
+}
+
+int64_t test_write(const void *ptr, int64_t size, int64_t nitems, void *stream) {
+  return blosc2_stdio_write(ptr, size, nitems, ((test_file *) stream)->bfile);
+}
+
+int64_t test_read(void *ptr, int64_t size, int64_t nitems, void *stream) {
+  return blosc2_stdio_read(ptr, size, nitems, ((test_file *) stream)->bfile);
+}
+
+int test_truncate(void *stream, int64_t size) {
+  return blosc2_stdio_truncate(((test_file *) stream)->bfile, size);
+}
+
+
+typedef struct {
+  bool contiguous;
+  char *urlpath;
+  int32_t write_buffer_size;
+} test_write_backend;
+
+CUTEST_TEST_DATA(write_buffer) {
+  blosc2_cparams cparams;
+  blosc2_dparams dparams;
+};
+
+CUTEST_TEST_SETUP(write_buffer) {
+  blosc_init();
+
+  data->cparams = BLOSC2_CPARAMS_DEFAULTS;
+  data->cparams.typesize = sizeof(int32_t);
+  data->cparams.compcode = BLOSC_BLOSCLZ;
+  data->cparams.clevel = 5;
+  data->cparams.nthreads = 2;
+  data->dparams = BLOSC2_DPARAMS_DEFAULTS;
+  data->dparams.nthreads = 2;
+
+  CUTEST_PARAMETRIZE(backend, test_write_backend, CUTEST_DATA(
+      {true, "test_write_buffer.b2frame", 0}, // disk - cframe
+      {true, "test_write_buffer.b2frame", 10 * 1000}, // disk - cframe
+      {true, "test_write_buffer.b2frame", 1 << 30}, // disk - cframe, flushed on free
+      {false, "test_write_buffer_s.b2frame", 0}, // disk - sframe
+      {false, "test_write_buffer_s.b2frame", 10 * 1000}, // disk - sframe
+      {false, "test_write_buffer_s.b2frame", 1 << 30}, // disk - sframe, flushed on free
+  ));
+}
+
+
+static int check_chunks(blosc2_schunk *schunk, int nchunks) {
+  int32_t nbytes = CHUNKSIZE * sizeof(int32_t);
+  int32_t *rec_buffer = malloc(nbytes);
+  int rc = schunk->nchunks >= nchunks ? 0 : -1;
+  for (int i = 0; rc == 0 && i < nchunks; ++i) {
+    int32_t dbytes = blosc2_schunk_decompress_chunk(schunk, i, rec_buffer, nbytes);
+    if (dbytes != nbytes) {
+      rc = -1;
+    }
+    for (int j = 0; rc == 0 && j < CHUNKSIZE; ++j) {
+      if (rec_buffer[j] != j * (i + 1)) {
+        rc = -1;
+      }
+    }
+  }
+  free(rec_buffer);
+  return rc;
+}
+
+
+CUTEST_TEST_TEST(write_buffer) {
+  CUTEST_GET_PARAMETER(backend, test_write_backend);
+
+  blosc2_io_cb io_cb = {0};
+  io_cb.id = 174;
+  io_cb.open = (blosc2_open_cb) test_open;
+  io_cb.close = (blosc2_close_cb) test_close;
+  io_cb.tell = (blosc2_tell_cb) test_tell;
+  io_cb.seek = (blosc2_seek_cb) test_seek;
+  io_cb.write = (blosc2_write_cb) test_write;
+  io_cb.read = (blosc2_read_cb) test_read;
+  io_cb.truncate = (blosc2_truncate_cb) test_truncate;
+  blosc2_register_io_cb(&io_cb);
+
+  blosc2_remove_urlpath(backend.urlpath);
+
+  int32_t nbytes = CHUNKSIZE * sizeof(int32_t);
+  int32_t *data_buffer = malloc(nbytes);
+
+  test_write_params params = {0};
+  blosc2_io io = {.id = io_cb.id, .params = &params};
+  blosc2_storage storage = BLOSC2_STORAGE_DEFAULTS;
+  storage.cparams = &data->cparams;
+  storage.dparams = &data->dparams;
+  storage.contiguous = backend.contiguous;
+  storage.urlpath = backend.urlpath;
+  storage.io = &io;
+  storage.write_buffer_size = backend.write_buffer_size;
+  blosc2_schunk *schunk = blosc2_schunk_new(&storage);
+  CUTEST_ASSERT("Error creating the super-chunk", schunk != NULL);
+
+  params.nopens = 0;
+  uint8_t *chunk = NULL;
+  bool needs_free = false;
+  int cbytes = 0;
+  for (int i = 0; i < NCHUNKS; ++i) {
+    for (int j = 0; j < CHUNKSIZE; ++j) {
+      data_buffer[j] = j * (i + 1);
+    }
+    int nchunks = blosc2_schunk_append_buffer(schunk, data_buffer, nbytes);
+    CUTEST_ASSERT("Error during compression", nchunks == i + 1);
+    // Pending chunks can be read too
+    CUTEST_ASSERT("Data are not equal", check_chunks(schunk, i + 1) == 0);
+    if (chunk != NULL) {
+      // Chunks got before an append (which moves or flushes the pending ones) are still valid
+      CUTEST_ASSERT("Error decompressing a chunk", blosc2_decompress(chunk, cbytes, data_buffer, nbytes) == nbytes);
+      CUTEST_ASSERT("Data are not equal", data_buffer[CHUNKSIZE - 1] == (CHUNKSIZE - 1) * i);
+      if (needs_free) {
+        free(chunk);
+      }
+    }
+    cbytes = blosc2_schunk_get_chunk(schunk, i, &chunk, &needs_free);
+    CUTEST_ASSERT("Error getting a chunk", cbytes > 0);
+  }
+  if (needs_free) {
+    free(chunk);
+  }
+  free(data_buffer);
+  // Chunks of sframes have files of their own, so count the frame files only
+  int nopens = params.nopens - (backend.contiguous ? 0 : NCHUNKS);
+  if (backend.write_buffer_size == 0) {
+    CUTEST_ASSERT("Every append should be written", nopens >= NCHUNKS * 3);
+  }
+  else {
+    CUTEST_ASSERT("Appends are not batched", nopens < NCHUNKS);
+  }
+
+  // Changes of the frame other than appends see the pending ones first
+  uint8_t zeros[BLOSC_EXTENDED_HEADER_LENGTH];
+  int csize = blosc2_chunk_zeros(data->cparams, nbytes, zeros, BLOSC_EXTENDED_HEADER_LENGTH);
+  CUTEST_ASSERT("Error creating a chunk of zeros", csize > 0);
+  int nchunks = blosc2_schunk_append_chunk(schunk, zeros, true);
+  CUTEST_ASSERT("Error appending a chunk of zeros", nchunks == NCHUNKS + 1);
+  nchunks = blosc2_schunk_delete_chunk(schunk, NCHUNKS);
+  CUTEST_ASSERT("Error deleting the chunk", nchunks == NCHUNKS);
+  CUTEST_ASSERT("Data are not equal", check_chunks(schunk, NCHUNKS) == 0);
+
+  // The last appends are written out when freeing
+  nchunks = blosc2_schunk_append_chunk(schunk, zeros, true);
+  CUTEST_ASSERT("Error appending a chunk of zeros", nchunks == NCHUNKS + 1);
+  CUTEST_ASSERT("Error freeing the super-chunk", blosc2_schunk_free(schunk) == 0);
+
+  // Reopen it
+  schunk = blosc2_schunk_open_udio(backend.urlpath, &io);
+  CUTEST_ASSERT("Error opening the super-chunk", schunk != NULL);
+  nchunks = blosc2_schunk_delete_chunk(schunk, NCHUNKS);
+  CUTEST_ASSERT("Error deleting the chunk", nchunks == NCHUNKS);
+  CUTEST_ASSERT("Data are not equal", check_chunks(schunk, NCHUNKS) == 0);
+
+  // An explicit flush
+  schunk->storage->write_buffer_size = backend.write_buffer_size;
+  nchunks = blosc2_schunk_append_chunk(schunk, zeros, true);
+  CUTEST_ASSERT("Error appending a chunk of zeros", nchunks == NCHUNKS + 1);
+  CUTEST_ASSERT("Error flushing the super-chunk", blosc2_schunk_flush(schunk) == 0);
+  blosc2_schunk *schunk2 = blosc2_schunk_open_udio(backend.urlpath, &io);
+  CUTEST_ASSERT("Error opening the super-chunk", schunk2 != NULL);
+  CUTEST_ASSERT("Chunks are not flushed", schunk2->nchunks == NCHUNKS + 1);
+  CUTEST_ASSERT("Data are not equal", check_chunks(schunk2, NCHUNKS) == 0);
+  blosc2_schunk_free(schunk2);
+
+  blosc2_schunk_free(schunk);
+  blosc2_remove_urlpath(backend.urlpath);
+
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(write_buffer) {
+  blosc_destroy();
+}
+
+
+int main() {
+  CUTEST_TEST_RUN(write_buffer)
+}